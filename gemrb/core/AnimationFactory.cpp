@@ -27,11 +27,15 @@
 
 namespace GemRB {
 
+static unsigned long indexedRows = 0;
+
 AnimationFactory::AnimationFactory(const char* ResRef)
 	: FactoryObject( ResRef, IE_BAM_CLASS_ID )
 {
 	FLTable = NULL;
 	FrameData = NULL;
+	RowIndex = NULL;
+	RowCount = 0;
 	datarefcount = 0;
 }
 
@@ -50,6 +54,7 @@ AnimationFactory::~AnimationFactory(void)
 	}
 	if (FrameData)
 		free( FrameData);
+	SetRowIndex(NULL, 0);
 }
 
 void AnimationFactory::AddFrame(Sprite2D* frame)
@@ -77,6 +82,23 @@ void AnimationFactory::SetFrameData(unsigned char* FrameData)
 	this->FrameData = FrameData;
 }
 
+void AnimationFactory::SetRowIndex(RLERow* RowIndex, size_t RowCount)
+{
+	if (this->RowIndex) {
+		free(this->RowIndex);
+		indexedRows -= this->RowCount;
+	}
+	this->RowIndex = RowIndex;
+	this->RowCount = RowCount;
+	indexedRows += RowCount;
+}
+
+void AnimationFactory::GetRowIndexStats(unsigned long &rows, unsigned long &bytes)
+{
+	rows = indexedRows;
+	bytes = indexedRows * sizeof(RLERow);
+}
+
 
 Animation* AnimationFactory::GetCycle(unsigned char cycle)
 {
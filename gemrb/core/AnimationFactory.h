@@ -30,12 +30,16 @@
 
 namespace GemRB {
 
+struct RLERow;
+
 class GEM_EXPORT AnimationFactory : public FactoryObject {
 private:
 	std::vector< Sprite2D*> frames;
 	std::vector< CycleEntry> cycles;
 	unsigned short* FLTable;	// Frame Lookup Table
 	unsigned char* FrameData;
+	RLERow* RowIndex;
+	size_t RowCount;
 	int datarefcount;
 public:
 	AnimationFactory(const char* ResRef);
@@ -44,6 +48,8 @@ public:
 	void AddCycle(CycleEntry cycle);
 	void LoadFLT(unsigned short* buffer, int count);
 	void SetFrameData(unsigned char* FrameData);
+	/** takes over the row indices of all the RLE frames */
+	void SetRowIndex(RLERow* RowIndex, size_t RowCount);
 	Animation* GetCycle(unsigned char cycle);
 	/** No descriptions */
 	Sprite2D* GetFrame(unsigned short index, unsigned char cycle=0) const;
@@ -56,6 +62,9 @@ public:
 
 	void IncDataRefCount();
 	void DecDataRefCount();
+
+	/** rows indexed in all the loaded animations and the memory it takes */
+	static void GetRowIndexStats(unsigned long &rows, unsigned long &bytes);
 };
 
 }
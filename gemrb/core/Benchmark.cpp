@@ -0,0 +1,50 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "Benchmark.h"
+
+#include "GameScript/ScriptProfiler.h"
+#include "System/Logging.h"
+#include "System/StringBuffer.h"
+
+namespace GemRB {
+
+Benchmark::Benchmark(const char *subject, const char *what)
+	: subject(subject), what(what)
+{
+}
+
+void Benchmark::Compare(StringBuffer &buffer, void *arg,
+	const char *oldName, Run oldRun, const char *newName, Run newRun) const
+{
+	unsigned __int64 start = ScriptProfiler::Now();
+	unsigned long oldSum = oldRun(arg);
+	unsigned __int64 oldTime = ScriptProfiler::Now() - start;
+
+	start = ScriptProfiler::Now();
+	unsigned long newSum = newRun(arg);
+	unsigned __int64 newTime = ScriptProfiler::Now() - start;
+
+	if (oldSum != newSum) {
+		Log(ERROR, subject, "The benchmark runs differ (%lu and %lu)!", oldSum, newSum);
+	}
+	buffer.appendFormatted("%s: %s, %s %lu us, %s %lu us\n", subject, what,
+		oldName, (unsigned long) oldTime, newName, (unsigned long) newTime);
+}
+
+}
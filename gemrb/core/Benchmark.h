@@ -0,0 +1,60 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file Benchmark.h
+ * Declares Benchmark, the timing shared by the debug benchmarks (Ctrl-U)
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "exports.h"
+
+namespace GemRB {
+
+class StringBuffer;
+
+/**
+ * @class Benchmark
+ * Times the old and the new way of doing the same work and reports both.
+ */
+
+class GEM_EXPORT Benchmark {
+public:
+	/** One way of doing the work. It returns a sum of what it did, so the
+	 *  work isn't optimised away and both ways can be compared. */
+	typedef unsigned long (*Run)(void *arg);
+
+	/** @param subject starts the line and the error log
+	 *  @param what describes the work, without the timings */
+	Benchmark(const char *subject, const char *what);
+
+	/** Runs both ways on arg, complains if their sums differ and appends
+	 *  "subject: what, oldName x us, newName y us" to the buffer */
+	void Compare(StringBuffer &buffer, void *arg,
+		const char *oldName, Run oldRun, const char *newName, Run newRun) const;
+
+private:
+	const char *subject;
+	const char *what;
+};
+
+}
+
+#endif
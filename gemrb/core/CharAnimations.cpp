@@ -377,16 +377,18 @@ void CharAnimations::SetupColors(PaletteType type)
 			return;
 		}
 		*/
+		Palette::MakeWritable(palette[PAL_MAIN]);
 		for (int i = 0; i < colorcount; i++) {
 			core->GetPalette( Colors[i]&255, size,
 				&palette[PAL_MAIN]->col[dest] );
 			dest +=size;
 		}
+		palette[PAL_MAIN] = palette[PAL_MAIN]->Intern();
 
 		if (needmod) {
-			if (!modifiedPalette[PAL_MAIN])
-				modifiedPalette[PAL_MAIN] = new Palette();
+			Palette::MakeWritable(modifiedPalette[PAL_MAIN]);
 			modifiedPalette[PAL_MAIN]->SetupGlobalRGBModification(palette[PAL_MAIN], GlobalColorMod);
+			modifiedPalette[PAL_MAIN] = modifiedPalette[PAL_MAIN]->Intern();
 		} else {
 			gamedata->FreePalette(modifiedPalette[PAL_MAIN], 0);
 		}
@@ -419,16 +421,19 @@ void CharAnimations::SetupColors(PaletteType type)
 		}
 		bool needmod = GlobalColorMod.type != RGBModifier::NONE;
 		if (needmod) {
-			if (!modifiedPalette[type])
-				modifiedPalette[type] = new Palette();
+			Palette::MakeWritable(modifiedPalette[type]);
 			modifiedPalette[type]->SetupGlobalRGBModification(palette[type], GlobalColorMod);
+			modifiedPalette[type] = modifiedPalette[type]->Intern();
 		} else {
 			gamedata->FreePalette(modifiedPalette[type], 0);
 		}
 		return;
 	}
 
-	pal->SetupPaperdollColours(Colors, type);
+	// palettes are shared between actors with the same colours
+	Palette::MakeWritable(palette[type]);
+	palette[type]->SetupPaperdollColours(Colors, type);
+	palette[type] = palette[type]->Intern();
 	if (lockPalette) {
 		return;
 	}
@@ -445,14 +450,14 @@ void CharAnimations::SetupColors(PaletteType type)
 	}
 
 	if (needmod) {
-		if (!modifiedPalette[type])
-			modifiedPalette[type] = new Palette();
+		Palette::MakeWritable(modifiedPalette[type]);
 
 		if (GlobalColorMod.type != RGBModifier::NONE) {
 			modifiedPalette[type]->SetupGlobalRGBModification(palette[type], GlobalColorMod);
 		} else {
 			modifiedPalette[type]->SetupRGBModification(palette[type],ColorMods, type);
 		}
+		modifiedPalette[type] = modifiedPalette[type]->Intern();
 	} else {
 		gamedata->FreePalette(modifiedPalette[type], 0);
 	}
@@ -911,50 +916,121 @@ WSW 003      |      013 ESE
 
 */
 
-Animation** CharAnimations::GetAnimation(unsigned char Stance, unsigned char Orient)
+//alter stance here if it is missing and you know a substitute
+//probably we should feed this result back to the actor?
+unsigned char CharAnimations::ResolveStance(unsigned char Stance, unsigned char &Orient) const
 {
-	if (Stance >= MAX_ANIMS) {
-		error("CharAnimation", "Illegal stance ID\n");
-	}
-
-	//for paletted dragon animations, we need the stance id
-	StanceID = nextStanceID = Stance;
 	int AnimType = GetAnimType();
-
-	//alter stance here if it is missing and you know a substitute
-	//probably we should feed this result back to the actor?
 	switch (AnimType) {
-		case -1: //invalid animation
-			return NULL;
-
 		case IE_ANI_PST_STAND:
-			StanceID=IE_ANI_AWAKE;
+			Stance=IE_ANI_AWAKE;
 			break;
 		case IE_ANI_PST_GHOST:
-			StanceID=IE_ANI_AWAKE;
+			Stance=IE_ANI_AWAKE;
 			Orient=0;
 			break;
 		case IE_ANI_PST_ANIMATION_3: //stc->std
-			if (StanceID==IE_ANI_READY) {
-				StanceID=IE_ANI_AWAKE;
+			if (Stance==IE_ANI_READY) {
+				Stance=IE_ANI_AWAKE;
 			}
 			break;
 		case IE_ANI_PST_ANIMATION_2: //std->stc
-			if (StanceID==IE_ANI_AWAKE) {
-				StanceID=IE_ANI_READY;
+			if (Stance==IE_ANI_AWAKE) {
+				Stance=IE_ANI_READY;
 			}
 			break;
 	}
 	//pst animations don't have separate animation for sleep/die
 	if (AnimType >= IE_ANI_PST_ANIMATION_1) {
-		if (StanceID==IE_ANI_DIE) {
-			StanceID=IE_ANI_TWITCH;
+		if (Stance==IE_ANI_DIE) {
+			Stance=IE_ANI_TWITCH;
 		}
 	}
 
-	StanceID = MaybeOverrideStance(StanceID);
+	return MaybeOverrideStance(Stance);
+}
+
+//gets the file and cycle of a part, returns false if the part is not used
+bool CharAnimations::GetPartResRef(unsigned char StanceID, unsigned char Orient, int part,
+	char* NewResRef, unsigned char& Cycle, EquipResRefData*& equipdat)
+{
+	int actorPartCount = GetActorPartCount();
+	Cycle = 0;
+	if (part < actorPartCount) {
+		// Character animation parts
+
+		if (equipdat) delete equipdat;
+
+		//we need this long for special anims
+		strlcpy( NewResRef, ResRef, sizeof(ieResRef) );
+		GetAnimResRef( StanceID, Orient, NewResRef, Cycle, part, equipdat);
+	} else {
+		// Equipment animation parts
+
+		if (GetSize() == 0) return false;
+
+		if (part == actorPartCount) {
+			if (WeaponRef[0] == 0) return false;
+			// weapon
+			GetEquipmentResRef(WeaponRef,false,NewResRef,Cycle,equipdat);
+		} else if (part == actorPartCount+1) {
+			if (OffhandRef[0] == 0) return false;
+			if (WeaponType == IE_ANI_WEAPON_2H) return false;
+			// off-hand
+			if (WeaponType == IE_ANI_WEAPON_1H) {
+				GetEquipmentResRef(OffhandRef,false,NewResRef,Cycle,
+									 equipdat);
+			} else { // IE_ANI_WEAPON_2W
+				GetEquipmentResRef(OffhandRef,true,NewResRef,Cycle,
+									 equipdat);
+			}
+		} else if (part == actorPartCount+2) {
+			if (HelmetRef[0] == 0) return false;
+			// helmet
+			GetEquipmentResRef(HelmetRef,false,NewResRef,Cycle,equipdat);
+		}
+	}
+	NewResRef[8]=0; //cutting right to size
+	return true;
+}
+
+//queues the files of a stance for background loading, so its first use doesn't stall
+void CharAnimations::PrefetchStance(unsigned char Stance, unsigned char Orient)
+{
+	if (Stance >= MAX_ANIMS || GetAnimType() == -1) {
+		return;
+	}
+	Stance = ResolveStance(Stance, Orient);
+	if (Anims[Stance][Orient]) {
+		return;
+	}
+
+	int partCount = GetTotalPartCount();
+	EquipResRefData* equipdat = 0;
+	for (int part = 0; part < partCount; ++part) {
+		char NewResRef[12];
+		unsigned char Cycle;
+		if (GetPartResRef(Stance, Orient, part, NewResRef, Cycle, equipdat)) {
+			gamedata->RequestFactoryResource(NewResRef, IE_BAM_CLASS_ID, IE_NORMAL);
+		}
+	}
+	delete equipdat;
+}
+
+Animation** CharAnimations::GetAnimation(unsigned char Stance, unsigned char Orient)
+{
+	if (Stance >= MAX_ANIMS) {
+		error("CharAnimation", "Illegal stance ID\n");
+	}
+
+	//for paletted dragon animations, we need the stance id
+	StanceID = nextStanceID = Stance;
+	int AnimType = GetAnimType();
+	if (AnimType == -1) { //invalid animation
+		return NULL;
+	}
+	StanceID = ResolveStance(Stance, Orient);
 
-	//TODO: Implement Auto Resource Loading
 	//setting up the sequencing of animation cycles
 	autoSwitchOnEnd = false;
 	switch (StanceID) {
@@ -1021,42 +1097,9 @@ Animation** CharAnimations::GetAnimation(unsigned char Stance, unsigned char Ori
 		//this is longer than expected so it won't overflow
 		char NewResRef[12];
 		unsigned char Cycle = 0;
-		if (part < actorPartCount) {
-			// Character animation parts
-
-			if (equipdat) delete equipdat;
-
-			//we need this long for special anims
-			strlcpy( NewResRef, ResRef, sizeof(ieResRef) );
-			GetAnimResRef( StanceID, Orient, NewResRef, Cycle, part, equipdat);
-		} else {
-			// Equipment animation parts
-
-			anims[part] = 0;
-			if (GetSize() == 0) continue;
-
-			if (part == actorPartCount) {
-				if (WeaponRef[0] == 0) continue;
-				// weapon
-				GetEquipmentResRef(WeaponRef,false,NewResRef,Cycle,equipdat);
-			} else if (part == actorPartCount+1) {
-				if (OffhandRef[0] == 0) continue;
-				if (WeaponType == IE_ANI_WEAPON_2H) continue;
-				// off-hand
-				if (WeaponType == IE_ANI_WEAPON_1H) {
-					GetEquipmentResRef(OffhandRef,false,NewResRef,Cycle,
-										 equipdat);
-				} else { // IE_ANI_WEAPON_2W
-					GetEquipmentResRef(OffhandRef,true,NewResRef,Cycle,
-										 equipdat);
-				}
-			} else if (part == actorPartCount+2) {
-				if (HelmetRef[0] == 0) continue;
-				// helmet
-				GetEquipmentResRef(HelmetRef,false,NewResRef,Cycle,equipdat);
-			}
+		if (!GetPartResRef(StanceID, Orient, part, NewResRef, Cycle, equipdat)) {
+			continue;
 		}
-		NewResRef[8]=0; //cutting right to size
 
 		AnimationFactory* af = ( AnimationFactory* )
 			gamedata->GetFactoryResource( NewResRef,
@@ -1108,24 +1151,24 @@ Animation** CharAnimations::GetAnimation(unsigned char Stance, unsigned char Ori
 			//if (!palette[PAL_MAIN] && ((GlobalColorMod.type!=RGBModifier::NONE) || (NoPalette()!=1)) ) {
 			if(!palette[ptype]) {
 				// This is the first time we're loading an Animation.
-				// We copy the palette of its first frame into our own palette
-				palette[ptype] = a->GetFrame(0)->GetPalette()->Copy();
+				// We share the palette of its first frame, SetupColors copies it on write
+				palette[ptype] = a->GetFrame(0)->GetPalette()->Intern();
 				// ...and setup the colours properly
 				SetupColors(ptype);
 			}
 		} else if (part == actorPartCount) {
 			if (!palette[PAL_WEAPON]) {
-				palette[PAL_WEAPON] = a->GetFrame(0)->GetPalette()->Copy();
+				palette[PAL_WEAPON] = a->GetFrame(0)->GetPalette()->Intern();
 				SetupColors(PAL_WEAPON);
 			}
 		} else if (part == actorPartCount+1) {
 			if (!palette[PAL_OFFHAND]) {
-				palette[PAL_OFFHAND] = a->GetFrame(0)->GetPalette()->Copy();
+				palette[PAL_OFFHAND] = a->GetFrame(0)->GetPalette()->Intern();
 				SetupColors(PAL_OFFHAND);
 			}
 		} else if (part == actorPartCount+2) {
 			if (!palette[PAL_HELMET]) {
-				palette[PAL_HELMET] = a->GetFrame(0)->GetPalette()->Copy();
+				palette[PAL_HELMET] = a->GetFrame(0)->GetPalette()->Intern();
 				SetupColors(PAL_HELMET);
 			}
 		}
@@ -1332,7 +1375,7 @@ Animation** CharAnimations::GetShadowAnimation(unsigned char stance, unsigned ch
 
 		PaletteType paletteType = PAL_MAIN;
 		if (!palette[paletteType]) {
-			palette[paletteType] = animation->GetFrame(0)->GetPalette()->Copy();
+			palette[paletteType] = animation->GetFrame(0)->GetPalette()->Intern();
 			SetupColors(paletteType);
 		}
 
@@ -195,6 +195,8 @@ public:
 
 	// returns an array of animations of size GetTotalPartCount()
 	Animation** GetAnimation(unsigned char Stance, unsigned char Orient);
+	// starts loading the files of a stance in the background
+	void PrefetchStance(unsigned char Stance, unsigned char Orient);
 	int GetTotalPartCount() const;
 	const int* GetZOrder(unsigned char Orient);
 	Animation** GetShadowAnimation(unsigned char Stance, unsigned char Orient);
@@ -270,6 +272,9 @@ private:
 	void GetEquipmentResRef(const char* equipRef, bool offhand,
 		char* ResRef, unsigned char& Cycle, EquipResRefData* equip);
 	unsigned char MaybeOverrideStance(unsigned char stance) const;
+	unsigned char ResolveStance(unsigned char Stance, unsigned char &Orient) const;
+	bool GetPartResRef(unsigned char StanceID, unsigned char Orient, int part,
+		char* ResRef, unsigned char& Cycle, EquipResRefData*& equip);
 };
 
 }
@@ -22,13 +22,16 @@
 
 #include "win32def.h"
 
+#include "DialogMgr.h"
 #include "GameScript/GameScript.h"
 #include "RNG/RNG_SFMT.h"
 
 namespace GemRB {
 
-Dialog::Dialog(void)
+Dialog::Dialog(DialogMgr *loader)
+	: loader(loader)
 {
+	ResRef[0] = 0;
 	TopLevelCount = 0;
 	Flags = 0;
 	Order = NULL;
@@ -48,17 +51,41 @@ Dialog::~Dialog(void)
 	if (Order) free(Order);
 }
 
+// the state and its condition, without the transitions
+DialogState* Dialog::PeekState(unsigned int index)
+{
+	if (!initialStates[index] && loader) {
+		initialStates[index] = loader->GetDialogState(index);
+	}
+	return initialStates[index];
+}
+
 DialogState* Dialog::GetState(unsigned int index)
 {
 	if (index >= TopLevelCount) {
 		return NULL;
 	}
-	return initialStates[index];
+	DialogState *ds = PeekState(index);
+	if (ds && !ds->transitions && loader) {
+		ds->transitions = loader->GetStateTransitions(index);
+	}
+	return ds;
+}
+
+unsigned int Dialog::GetLoadedStateCount() const
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < TopLevelCount; i++) {
+		if (initialStates[i]) {
+			count++;
+		}
+	}
+	return count;
 }
 
 void Dialog::FreeDialogState(DialogState* ds)
 {
-	for (unsigned int i = 0; i < ds->transitionsCount; i++) {
+	for (unsigned int i = 0; ds->transitions && i < ds->transitionsCount; i++) {
 		DialogTransition *trans = ds->transitions[i];
 		for (size_t j = 0; j < trans->actions.size(); ++j)
 			trans->actions[j]->Release();
@@ -76,7 +103,7 @@ void Dialog::FreeDialogState(DialogState* ds)
 int Dialog::FindFirstState(Scriptable* target)
 {
 	for (unsigned int i = 0; i < TopLevelCount; i++) {
-		Condition *cond = GetState( Order[i] )->condition;
+		Condition *cond = PeekState( Order[i] )->condition;
 		if (cond && cond->Evaluate(target)) {
 			return Order[i];
 		}
@@ -91,13 +118,13 @@ int Dialog::FindRandomState(Scriptable* target)
 	if (!max) return -1;
 	unsigned int pick = RAND(0, max-1);
 	for (i=pick; i < max; i++) {
-		Condition *cond = GetState(i)->condition;
+		Condition *cond = PeekState(i)->condition;
 		if (cond && cond->Evaluate(target)) {
 			return i;
 		}
 	}
 	for (i=0; i < pick; i++) {
-		Condition *cond = GetState(i)->condition;
+		Condition *cond = PeekState(i)->condition;
 		if (cond && cond->Evaluate(target)) {
 			return i;
 		}
@@ -24,6 +24,8 @@
 #include "exports.h"
 #include "globals.h"
 
+#include "Holder.h"
+
 #include <vector>
 
 namespace GemRB {
@@ -39,6 +41,7 @@ namespace GemRB {
 
 class Condition;
 class Action;
+class DialogMgr;
 
 struct DialogTransition {
 	ieDword Flags;
@@ -58,17 +61,27 @@ struct DialogState {
 	unsigned int weight;
 };
 
+/**
+ * @class Dialog
+ * A dialog, shared through the GameData cache. The states are read from
+ * the importer when first needed: FindFirstState and FindRandomState only
+ * compile the state conditions they evaluate, GetState adds the transitions.
+ */
+
 class GEM_EXPORT Dialog {
 public:
-	Dialog(void);
+	Dialog(DialogMgr *loader = NULL);
 	~Dialog(void);
 private:
 	void FreeDialogState(DialogState* ds);
+	DialogState* PeekState(unsigned int index);
 public:
 	void AddState(DialogState* ds);
 	DialogState* GetState(unsigned int index);
 	int FindFirstState(Scriptable* target);
 	int FindRandomState(Scriptable* target);
+	/** the number of states that have been read so far */
+	unsigned int GetLoadedStateCount() const;
 
 	void Release()
 	{
@@ -80,6 +93,8 @@ public:
 	unsigned int TopLevelCount;
 	ieDword* Order;
 	DialogState** initialStates;
+private:
+	Holder<DialogMgr> loader;
 };
 
 }
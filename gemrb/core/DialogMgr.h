@@ -32,8 +32,12 @@ public:
 	DialogMgr(void);
 	virtual ~DialogMgr(void);
 	virtual bool Open(DataStream* stream) = 0;
-	virtual Dialog* GetDialog() const = 0;
+	/** the returned dialog keeps the importer to read its states on demand */
+	virtual Dialog* GetDialog() = 0;
 	virtual Condition* GetCondition(char *string) const = 0;
+	/** reads a state and compiles its condition, but not its transitions */
+	virtual DialogState* GetDialogState(unsigned int index) const = 0;
+	virtual DialogTransition** GetStateTransitions(unsigned int index) const = 0;
 };
 
 }
@@ -25,10 +25,12 @@
 #include "strrefs.h"
 
 #include "DisplayMessage.h"
+#include "Benchmark.h"
 #include "Effect.h"
 #include "Game.h"
 #include "Interface.h"
 #include "Map.h"
+#include "MemoryPool.h"
 #include "SymbolMgr.h"
 #include "Scriptable/Actor.h"
 #include "Spell.h" //needs for the source flags bitfield
@@ -53,12 +55,25 @@ static int effectnames_count = 0;
 static int pstflags = false;
 static bool iwd2fx = false;
 
+static MemoryPool EffectPool("Effect", sizeof(Effect), 512);
+
+void* Effect::operator new(size_t size)
+{
+	return EffectPool.Allocate(size);
+}
+
+void Effect::operator delete(void *ptr)
+{
+	EffectPool.Free(ptr);
+}
+
 static EffectRef fx_unsummon_creature_ref = { "UnsummonCreature", -1 };
 static EffectRef fx_ac_vs_creature_type_ref = { "ACVsCreatureType", -1 };
 static EffectRef fx_spell_focus_ref = { "SpellFocus", -1 };
 static EffectRef fx_spell_resistance_ref = { "SpellResistance", -1 };
 static EffectRef fx_protection_from_display_string_ref = { "Protection:String", -1 };
 static EffectRef fx_variable_ref = { "Variable:StoreLocalVariable", -1 };
+static EffectRef fx_damage_ref = { "Damage", -1 };
 
 //immunity effects
 static EffectRef fx_level_immunity_ref = { "Protection:Spelllevel", -1 };
@@ -342,6 +357,7 @@ void EffectQueue_RegisterOpcodes(int count, const EffectDesc* opcodes)
 EffectQueue::EffectQueue()
 {
 	Owner = NULL;
+	shares = 0;
 }
 
 EffectQueue::~EffectQueue()
@@ -422,6 +438,108 @@ EffectQueue *EffectQueue::CopySelf() const
 	return effects;
 }
 
+#define BENCHMARK_PAYLOAD 6
+#define BENCHMARK_CROWD 60
+#define BENCHMARK_BLASTS 500
+
+// scratch actors outside of any area, for the payloads to land on
+struct Crowd {
+	EffectQueue *payload;
+	Actor *caster;
+	Actor *targets[BENCHMARK_CROWD];
+};
+
+// counts what stuck on the crowd and clears it for the next blast
+static unsigned long DisperseCrowd(Crowd &crowd)
+{
+	unsigned long landed = 0;
+	for (int t = 0; t < BENCHMARK_CROWD; t++) {
+		EffectQueue &fxqueue = crowd.targets[t]->fxqueue;
+		std::list< Effect* >::const_iterator f = fxqueue.GetFirstEffect();
+		Effect *fx;
+		while ((fx = fxqueue.GetNextEffect(f))) {
+			fx->TimingMode = FX_DURATION_JUST_EXPIRED;
+			landed++;
+		}
+		fxqueue.Cleanup();
+	}
+	return landed;
+}
+
+// before: every target got a private copy of the queue, owned by the caster
+static unsigned long LandCopies(void *arg)
+{
+	Crowd &crowd = *(Crowd *) arg;
+	unsigned long landed = 0;
+	for (int b = 0; b < BENCHMARK_BLASTS; b++) {
+		for (int t = 0; t < BENCHMARK_CROWD; t++) {
+			Actor *target = crowd.targets[t];
+			EffectQueue *copy = crowd.payload->CopySelf();
+			copy->SetOwner(crowd.caster);
+			copy->AddAllEffects(target, target->Pos);
+			delete copy;
+		}
+		landed += DisperseCrowd(crowd);
+	}
+	return landed;
+}
+
+// now: the queue is shared and applied on behalf of the caster
+static unsigned long LandShared(void *arg)
+{
+	Crowd &crowd = *(Crowd *) arg;
+	unsigned long landed = 0;
+	for (int b = 0; b < BENCHMARK_BLASTS; b++) {
+		for (int t = 0; t < BENCHMARK_CROWD; t++) {
+			Actor *target = crowd.targets[t];
+			EffectQueue *shared = crowd.payload->Share();
+			shared->AddAllEffects(target, target->Pos, crowd.caster);
+			shared->Release();
+		}
+		landed += DisperseCrowd(crowd);
+	}
+	return landed;
+}
+
+void EffectQueue::Benchmark(StringBuffer &buffer)
+{
+	// a delayed fireball, so the damage never goes off and only the
+	// resolution and the copies that stick on the targets are timed
+	Effect *fx = CreateEffect(fx_damage_ref, 0, 0, FX_DURATION_DELAY_PERMANENT);
+	if (!fx) {
+		buffer.append("Area payloads: there is no damage opcode to benchmark\n");
+		return;
+	}
+	fx->Target = FX_TARGET_PRESET;
+	fx->Duration = 1000;
+	fx->DiceThrown = 10;
+	fx->DiceSides = 6;
+	fx->CasterLevel = 10;
+	EffectQueue payload;
+	for (int i = 0; i < BENCHMARK_PAYLOAD; i++) {
+		payload.AddEffect(fx, false);
+	}
+	delete fx;
+
+	Crowd crowd;
+	crowd.payload = &payload;
+	crowd.caster = new Actor();
+	for (int t = 0; t < BENCHMARK_CROWD; t++) {
+		crowd.targets[t] = new Actor();
+		crowd.targets[t]->Pos = Point((short) (t * 16), 0);
+	}
+
+	char what[64];
+	snprintf(what, sizeof(what), "%d blasts of %d effects on %d targets",
+		BENCHMARK_BLASTS, BENCHMARK_PAYLOAD, BENCHMARK_CROWD);
+	GemRB::Benchmark("Area payloads", what).Compare(buffer, &crowd, "copied", LandCopies, "shared", LandShared);
+
+	for (int t = 0; t < BENCHMARK_CROWD; t++) {
+		delete crowd.targets[t];
+	}
+	delete crowd.caster;
+}
+
 //create a new effect with most of the characteristics of the old effect
 //only opcode and parameters are changed
 //This is used mostly inside effects, when an effect needs to spawn
@@ -751,6 +869,11 @@ all_party:
 //if this returns FX_NOT_APPLIED, then the whole stack was resisted
 //or expired
 int EffectQueue::AddAllEffects(Actor* target, const Point &destination) const
+{
+	return AddAllEffects(target, destination, Owner);
+}
+
+int EffectQueue::AddAllEffects(Actor* target, const Point &destination, Scriptable* owner) const
 {
 	int res = FX_NOT_APPLIED;
 	// pre-roll dice for fx needing them and stow them in the effect
@@ -761,12 +884,15 @@ int EffectQueue::AddAllEffects(Actor* target, const Point &destination) const
 	}
 	std::list< Effect* >::const_iterator f;
 	for ( f = effects.begin(); f != effects.end(); f++ ) {
+		//work on a copy, the queue may be applied to several targets
+		//only the effects that stick get allocated (by fxqueue.AddEffect)
+		Effect fx = **f;
 		//handle resistances and saving throws here
-		(*f)->random_value = random_value;
+		fx.random_value = random_value;
 		//if applyeffect returns true, we stop adding the future effects
 		//this is to simulate iwd2's on the fly spell resistance
 
-		int tmp = AddEffect(*f, Owner, target, destination);
+		int tmp = AddEffect(&fx, owner, target, destination);
 		//lets try without Owner, any crash?
 		//If yes, then try to fix the individual effect
 		//If you use target for Owner here, the wand in chateau irenicus will work
@@ -195,6 +195,8 @@ private:
 	std::list< Effect* > effects;
 	/** Actor which is target of the Effects */
 	Scriptable* Owner;
+	/** Additional holders of the queue, see Share() */
+	unsigned int shares;
 
 public:
 	EffectQueue();
@@ -204,6 +206,11 @@ public:
 	void SetOwner(Scriptable* act) { Owner = act; }
 	/** Returns Actor affected by these effects */
 	Scriptable* GetOwner() const { return Owner; }
+	/** Hands the queue to one more holder (area projectiles) instead of
+	 *  copying it. Shared queues must not be modified anymore. */
+	EffectQueue* Share() { shares++; return this; }
+	/** Drops a holder, the last one deletes the queue */
+	void Release() { if (shares) shares--; else delete this; }
 
 	/** adds an effect to the queue, it could also insert it if flagged so
 	 *  fx should be freed by the caller
@@ -217,7 +224,10 @@ public:
 	 * Effects are matched based on their contents */
 	bool RemoveEffect(Effect* fx);
 
+	/** Applies copies of the effects, the queue itself is left as it is */
 	int AddAllEffects(Actor* target, const Point &dest) const;
+	/** The same on behalf of owner instead of the queue's own, for shared queues */
+	int AddAllEffects(Actor* target, const Point &dest, Scriptable* owner) const;
 	void ApplyAllEffects(Actor* target) const;
 	/** remove effects marked for removal */
 	void Cleanup();
@@ -269,6 +279,8 @@ public:
 	static void HackColorEffects(Actor *Owner, Effect *fx);
 	static Effect *CreateEffect(EffectRef &effect_reference, ieDword param1, ieDword param2, ieWord timing);
 	EffectQueue *CopySelf() const;
+	/** times landing an area payload on a dense crowd, copied per target and shared */
+	static void Benchmark(StringBuffer &buffer);
 	static Effect *CreateEffectCopy(Effect *oldfx, EffectRef &effect_reference, ieDword param1, ieDword param2);
 	static Effect *CreateUnsummonEffect(Effect *fx);
 	//locating opcodes
@@ -30,6 +30,7 @@
 #include "GlobalTimer.h"
 #include "ImageMgr.h"
 #include "Interface.h"
+#include "MemoryPool.h"
 #include "PathFinder.h"
 #include "ScriptEngine.h"
 #include "TileMap.h"
@@ -45,6 +46,7 @@
 #include "Scriptable/Container.h"
 #include "Scriptable/Door.h"
 #include "Scriptable/InfoPoint.h"
+#include "System/StringBuffer.h"
 
 #include <cmath>
 
@@ -583,20 +585,20 @@ void GameControl::DrawInternal(Region& screen)
 
 	// Draw path
 	if (drawPath) {
-		PathNode* node = drawPath;
-		while (true) {
-			Point p( ( node-> x*16) + 8, ( node->y*12 ) + 6 );
-			if (!node->Parent) {
+		size_t length = drawPath->GetLength();
+		Point old;
+		for (size_t i = 0; i < length; i++) {
+			PathNode node = drawPath->GetNode(i);
+			Point p( ( node.x*16) + 8, ( node.y*12 ) + 6 );
+			if (!i) {
 				video->DrawCircle( p.x, p.y, 2, ColorRed );
 			} else {
-				short oldX = ( node->Parent-> x*16) + 8, oldY = ( node->Parent->y*12 ) + 6;
-				video->DrawLine( oldX, oldY, p.x, p.y, ColorGreen );
+				video->DrawLine( old.x, old.y, p.x, p.y, ColorGreen );
 			}
-			if (!node->Next) {
+			if (i == length - 1) {
 				video->DrawCircle( p.x, p.y, 2, ColorGreen );
-				break;
 			}
-			node = node->Next;
+			old = p;
 		}
 	}
 
@@ -777,17 +779,7 @@ bool GameControl::OnKeyRelease(unsigned char Key, unsigned short Mod)
 				break;
 			case 'b': //draw a path to the target (pathfinder debug)
 				//You need to select an origin with ctrl-o first
-				if (drawPath) {
-					PathNode* nextNode = drawPath->Next;
-					PathNode* thisNode = drawPath;
-					while (true) {
-						delete( thisNode );
-						thisNode = nextNode;
-						if (!thisNode)
-							break;
-						nextNode = thisNode->Next;
-					}
-				}
+				delete drawPath;
 				drawPath = core->GetGame()->GetCurrentArea()->FindPath( pfs, p, lastActor?lastActor->size:1 );
 				break;
 			case 'c': //force cast a hardcoded spell
@@ -958,7 +950,24 @@ bool GameControl::OnKeyRelease(unsigned char Key, unsigned short Mod)
 				game->AdvanceTime(core->Time.hour_size);
 				//refresh gui here once we got it
 				break;
-			// u
+			case 'u': //runs the self checks and benchmarks of the core containers
+				{
+					if (Path::Check()) {
+						Log(MESSAGE, "GameControl", "Path checks passed.");
+					}
+					if (area->CheckSight()) {
+						Log(MESSAGE, "GameControl", "Line of sight checks passed.");
+					}
+					if (core->GetVideoDriver()->SelfCheck()) {
+						Log(MESSAGE, "GameControl", "Video driver checks passed.");
+					}
+					StringBuffer buffer;
+					Path::Benchmark(buffer);
+					MemoryPool::Benchmark(buffer);
+					EffectQueue::Benchmark(buffer);
+					Log(MESSAGE, "GameControl", buffer);
+				}
+				break;
 			case 'V': //
 				core->GetDictionary()->DebugDump();
 				break;
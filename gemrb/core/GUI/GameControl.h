@@ -136,7 +136,7 @@ private:
 	bool scrolling;
 	int DebugFlags;
 	Point pfs;
-	PathNode* drawPath;
+	Path* drawPath;
 	unsigned long AIUpdateCounter;
 	unsigned int ScreenFlags;
 	unsigned int DialogueFlags;
@@ -26,12 +26,16 @@
 #include "strrefs.h"
 #include "win32def.h"
 
+#include "AnimationFactory.h"
 #include "DisplayMessage.h"
 #include "GameData.h"
 #include "Interface.h"
 #include "IniSpawn.h"
+#include "Map.h"
 #include "MapMgr.h"
+#include "MemoryPool.h"
 #include "MusicMgr.h"
+#include "Palette.h"
 #include "Particles.h"
 #include "PluginMgr.h"
 #include "ScriptEngine.h"
@@ -86,6 +90,8 @@ struct Injured {
 Game::Game(void) : Scriptable( ST_GLOBAL )
 {
 	protagonist = PM_YES; //set it to 2 for iwd/iwd2 and 0 for pst
+	swapOuts = swapOutTime = 0;
+	swapIns = swapInTime = 0;
 	partysize = 6;
 	Ticks = 0;
 	GameTime = RealTime = 0;
@@ -868,9 +874,16 @@ int Game::DelMap(unsigned int index, int forced)
 		}
 
 		//remove map from memory
+		unsigned long start = GetTickCount();
 		core->SwapoutArea(Maps[index]);
 		delete( Maps[index] );
+		swapOutTime += GetTickCount() - start;
+		swapOuts++;
 		Maps.erase( Maps.begin()+index);
+		//whatever the area held should be back in the pools now
+		StringBuffer buffer;
+		MemoryPool::DumpStats(buffer);
+		Log(DEBUG, "Game", buffer);
 		//current map will be decreased
 		if (MapIndex>(int) index) {
 			MapIndex--;
@@ -925,7 +938,12 @@ int Game::LoadMap(const char* ResRef, bool loadscreen)
 		sE->RunFunction("LoadScreen", "StartLoadScreen");
 		sE->RunFunction("LoadScreen", "SetLoadScreen");
 	}
-	DataStream* ds = gamedata->GetResource( ResRef, IE_ARE_CLASS_ID );
+	unsigned long start = GetTickCount();
+	//a recently left area may still be kept in memory
+	DataStream* ds = gamedata->TakeArea(ResRef);
+	if (!ds) {
+		ds = gamedata->GetResource( ResRef, IE_ARE_CLASS_ID );
+	}
 	if (!ds) {
 		goto failedload;
 	}
@@ -936,6 +954,8 @@ int Game::LoadMap(const char* ResRef, bool loadscreen)
 	if (!newMap) {
 		goto failedload;
 	}
+	swapInTime += GetTickCount() - start;
+	swapIns++;
 
 	core->LoadProgress(100);
 
@@ -2247,6 +2267,24 @@ void Game::dump() const
 
 		buffer.appendFormatted("Name: %s Order %d %s\n",actor->ShortName, actor->InParty, actor->Selected?"x":"-");
 	}
+	unsigned long requested, unique;
+	Palette::GetInternStats(requested, unique);
+	buffer.appendFormatted("Shared palettes: %lu for %lu requests\n", unique, requested);
+	unsigned long rows, bytes;
+	AnimationFactory::GetRowIndexStats(rows, bytes);
+	buffer.appendFormatted("RLE row index: %lu rows in %lu bytes\n", rows, bytes);
+	unsigned long allocated, reused, steps, segments;
+	Map::GetPathStats(allocated, reused, steps, segments);
+	buffer.appendFormatted("Paths: %lu allocated, %lu reused; %lu steps in %lu segments\n", allocated, reused, steps, segments);
+	unsigned long runs, skips;
+	Scriptable::GetScriptSleepStats(runs, skips);
+	buffer.appendFormatted("Script rounds: %lu run, %lu skipped while asleep\n", runs, skips);
+	unsigned long hits, misses, written, kept;
+	gamedata->GetAreaCacheStats(hits, misses, written, kept, bytes);
+	buffer.appendFormatted("Area cache: %lu hits, %lu misses, %lu written out; %lu areas in %lu bytes\n", hits, misses, written, kept, bytes);
+	buffer.appendFormatted("Area swaps: %lu out in %lu ms, %lu in in %lu ms\n", swapOuts, swapOutTime, swapIns, swapInTime);
+	DumpVariableStats(buffer);
+	MemoryPool::DumpStats(buffer);
 	Log(DEBUG, "Game", buffer);
 }
 
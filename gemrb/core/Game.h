@@ -261,6 +261,9 @@ private:
 	ieResRef daymovies[8];
 	ieResRef nightmovies[8];
 	int MapIndex;
+	// time spent moving areas out of and into memory, in ms
+	unsigned long swapOuts, swapOutTime;
+	unsigned long swapIns, swapInTime;
 public:
 	std::vector< Actor*> selected;
 	int version;
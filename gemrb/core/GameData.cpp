@@ -26,6 +26,7 @@
 #include "AnimationMgr.h"
 #include "Cache.h"
 #include "CharAnimations.h"
+#include "DialogMgr.h"
 #include "Effect.h"
 #include "EffectMgr.h"
 #include "Factory.h"
@@ -41,10 +42,13 @@
 #include "Spell.h"
 #include "SpellMgr.h"
 #include "StoreMgr.h"
+#include "Compressor.h"
 #include "VEFObject.h"
 #include "Scriptable/Actor.h"
 #include "System/FileStream.h"
+#include "System/MemoryStream.h"
 
+#include <algorithm>
 #include <cstdio>
 
 namespace GemRB {
@@ -59,6 +63,11 @@ static void ReleaseSpell(void *poi)
 	delete ((Spell *) poi);
 }
 
+static void ReleaseDialog(void *poi)
+{
+	delete ((Dialog *) poi);
+}
+
 static void ReleaseEffect(void *poi)
 {
 	delete ((Effect *) poi);
@@ -72,15 +81,55 @@ static void ReleasePalette(void *poi)
 	((Palette *) poi)->release();
 }
 
+// the lookups are serialised by the ResourceManager, only table parsing
+// runs fully in parallel, so more wouldn't help
+#define MAX_LOADER_THREADS 4
+
+enum LoadState {
+	LOAD_QUEUED,
+	LOAD_READING,
+	LOAD_READ
+};
+
+struct LoadRequest {
+	ieResRef resname;
+	SClass_ID type;
+	unsigned char mode;
+	LoadState state;
+	// the whole file, or NULL if it wasn't found
+	DataStream *stream;
+	// tables are parsed by the loader already, stream stays NULL for them
+	Holder<TableMgr> table;
+	std::vector<std::pair<LoadCallback, void*> > callbacks;
+};
+
 GEM_EXPORT GameData* gamedata;
 
 GameData::GameData()
 {
 	factory = new Factory();
+	areaBudget = 8192 * 1024;
+	areaUsed = 0;
+	areaHits = areaMisses = areaWrites = 0;
+	loaders = NULL;
+	loaderCount = 0;
+	loadersQuit = false;
 }
 
 GameData::~GameData()
 {
+	if (loaders) {
+		loadLock.Lock();
+		loadersQuit = true;
+		loadQueued.Broadcast();
+		loadLock.Unlock();
+		// joins them
+		delete[] loaders;
+	}
+	for (size_t i = 0; i < loadRequests.size(); i++) {
+		delete loadRequests[i]->stream;
+		delete loadRequests[i];
+	}
 	delete factory;
 }
 
@@ -90,12 +139,14 @@ void GameData::ClearCaches()
 	SpellCache.RemoveAll(ReleaseSpell);
 	EffectCache.RemoveAll(ReleaseEffect);
 	PaletteCache.RemoveAll(ReleasePalette);
+	DialogCache.RemoveAll(ReleaseDialog);
 
 	while (!stores.empty()) {
 		Store *store = stores.begin()->second;
 		stores.erase(stores.begin());
 		delete store;
 	}
+	ClearAreas();
 }
 
 Actor *GameData::GetCreature(const char* ResRef, unsigned int PartySlot)
@@ -164,18 +215,29 @@ int GameData::LoadTable(const ieResRef ResRef, bool silent)
 		tables[ind].refcount++;
 		return ind;
 	}
-	//print("(%s) Table not found... Loading from file", ResRef);
-	DataStream* str = GetResource( ResRef, IE_2DA_CLASS_ID, silent );
-	if (!str) {
-		return -1;
+	Holder<TableMgr> tm;
+	// a loader thread may have parsed it already
+	LoadRequest *request = TakeLoadRequest(ResRef, IE_2DA_CLASS_ID);
+	if (request) {
+		tm = request->table;
+		delete request;
 	}
-	PluginHolder<TableMgr> tm(IE_2DA_CLASS_ID);
+	// not prefetched, or retry a missing one to get the usual messages
 	if (!tm) {
-		delete str;
-		return -1;
-	}
-	if (!tm->Open(str)) {
-		return -1;
+		//print("(%s) Table not found... Loading from file", ResRef);
+		DataStream* str = GetResource( ResRef, IE_2DA_CLASS_ID, silent );
+		if (!str) {
+			return -1;
+		}
+		PluginHolder<TableMgr> importer(IE_2DA_CLASS_ID);
+		if (!importer) {
+			delete str;
+			return -1;
+		}
+		if (!importer->Open(str)) {
+			return -1;
+		}
+		tm = importer;
 	}
 	Table t;
 	t.refcount = 1;
@@ -366,6 +428,42 @@ void GameData::FreeSpell(Spell *spl, const ieResRef name, bool free)
 	if (free) delete spl;
 }
 
+Dialog* GameData::GetDialog(const ieResRef resname)
+{
+	Dialog *dlg = (Dialog *) DialogCache.GetResource(resname);
+	if (dlg) {
+		return dlg;
+	}
+	DataStream* str = GetResource(resname, IE_DLG_CLASS_ID);
+	PluginHolder<DialogMgr> dm(IE_DLG_CLASS_ID);
+	if (!dm) {
+		delete str;
+		return NULL;
+	}
+	if (!dm->Open(str)) {
+		return NULL;
+	}
+
+	dlg = dm->GetDialog();
+	if (!dlg) {
+		return NULL;
+	}
+	strnlwrcpy(dlg->ResRef, resname, 8);
+
+	DialogCache.SetAt(resname, (void *) dlg);
+	return dlg;
+}
+
+void GameData::FreeDialog(Dialog *dlg, const ieResRef name)
+{
+	int res;
+
+	res=DialogCache.DecRef((void *) dlg, name, false);
+	if (res<0) {
+		error("Core", "Corrupted Dialog cache encountered (reference count went below zero), Dialog name is: %.8s\n", name);
+	}
+}
+
 Effect* GameData::GetEffect(const ieResRef resname)
 {
 	Effect *effect = (Effect *) EffectCache.GetResource(resname);
@@ -479,16 +577,14 @@ void* GameData::GetFactoryResource(const char* resname, SClass_ID type,
 	switch (type) {
 	case IE_BAM_CLASS_ID:
 	{
+		// it may be on its way already
+		LoadRequest *request = TakeLoadRequest(resname, type);
+		if (request) {
+			return FinishLoadRequest(request, mode, silent);
+		}
 		DataStream* ret = GetResource( resname, type, silent );
 		if (ret) {
-			PluginHolder<AnimationMgr> ani(IE_BAM_CLASS_ID);
-			if (!ani)
-				return NULL;
-			if (!ani->Open(ret))
-				return NULL;
-			AnimationFactory* af = ani->GetAnimationFactory( resname, mode );
-			factory->AddFactoryObject( af );
-			return af;
+			return CreateAnimationFactory(resname, mode, ret);
 		}
 		return NULL;
 	}
@@ -510,6 +606,229 @@ void* GameData::GetFactoryResource(const char* resname, SClass_ID type,
 	}
 }
 
+AnimationFactory* GameData::CreateAnimationFactory(const char* resname, unsigned char mode, DataStream *stream)
+{
+	PluginHolder<AnimationMgr> ani(IE_BAM_CLASS_ID);
+	if (!ani)
+		return NULL;
+	if (!ani->Open(stream))
+		return NULL;
+	AnimationFactory* af = ani->GetAnimationFactory( resname, mode );
+	factory->AddFactoryObject( af );
+	return af;
+}
+
+void GameData::RequestFactoryResource(const char* resname, SClass_ID type,
+	unsigned char mode, LoadCallback callback, void *arg)
+{
+	if (type == IE_BAM_CLASS_ID) {
+		StartLoaders();
+	}
+
+	if (!loaderCount || type != IE_BAM_CLASS_ID || !resname[0] || factory->IsLoaded(resname, type) != -1) {
+		void *resource = GetFactoryResource(resname, type, mode, true);
+		if (callback) {
+			callback(resource, arg);
+		}
+		return;
+	}
+
+	MutexLock lock(loadLock);
+	LoadRequest *request = FindLoadRequest(resname, type);
+	if (!request) {
+		request = new LoadRequest();
+		strnlwrcpy(request->resname, resname, 8);
+		request->type = type;
+		request->mode = mode;
+		request->state = LOAD_QUEUED;
+		request->stream = NULL;
+		loadRequests.push_back(request);
+		loadQueued.Signal();
+	}
+	if (callback) {
+		request->callbacks.push_back(std::make_pair(callback, arg));
+	}
+}
+
+void GameData::StartLoaders()
+{
+	if (loaders) return;
+
+	unsigned int count = std::min(Thread::GetCPUCount(), (unsigned int) MAX_LOADER_THREADS);
+	loaders = new Thread[count];
+	for (unsigned int i = 0; i < count; i++) {
+		if (loaders[i].Start(LoaderThread, this)) {
+			loaderCount++;
+		}
+	}
+	if (!loaderCount) {
+		Log(WARNING, "GameData", "Couldn't start the loader threads, loading synchronously.");
+	}
+}
+
+void GameData::PrefetchTables(const char **resnames, unsigned int count)
+{
+	StartLoaders();
+	if (!loaderCount) return;
+
+	MutexLock lock(loadLock);
+	for (unsigned int i = 0; i < count; i++) {
+		if (GetTableIndex(resnames[i]) != -1 || FindLoadRequest(resnames[i], IE_2DA_CLASS_ID)) {
+			continue;
+		}
+		LoadRequest *request = new LoadRequest();
+		strnlwrcpy(request->resname, resnames[i], 8);
+		request->type = IE_2DA_CLASS_ID;
+		request->mode = IE_NORMAL;
+		request->state = LOAD_QUEUED;
+		request->stream = NULL;
+		loadRequests.push_back(request);
+	}
+	loadQueued.Broadcast();
+}
+
+void GameData::ProcessLoadedResources(unsigned int limit)
+{
+	if (!loaderCount) return;
+
+	unsigned int done = 0;
+	loadLock.Lock();
+	// only the main thread adds or removes requests, so the index stays valid
+	for (size_t i = 0; i < loadRequests.size() && (!limit || done < limit);) {
+		LoadRequest *request = loadRequests[i];
+		if (request->state != LOAD_READ) {
+			i++;
+			continue;
+		}
+		loadRequests.erase(loadRequests.begin() + i);
+		loadLock.Unlock();
+		FinishLoadRequest(request, request->mode, true);
+		done++;
+		loadLock.Lock();
+	}
+	loadLock.Unlock();
+}
+
+// the caller must hold loadLock
+LoadRequest* GameData::FindLoadRequest(const char* resname, SClass_ID type) const
+{
+	for (size_t i = 0; i < loadRequests.size(); i++) {
+		LoadRequest *request = loadRequests[i];
+		if (request->type == type && !strnicmp(request->resname, resname, 8)) {
+			return request;
+		}
+	}
+	return NULL;
+}
+
+// removes a pending request, waiting for it if it is being read
+LoadRequest* GameData::TakeLoadRequest(const char* resname, SClass_ID type)
+{
+	if (!loaderCount) return NULL;
+
+	MutexLock lock(loadLock);
+	LoadRequest *request = FindLoadRequest(resname, type);
+	if (!request) return NULL;
+	while (request->state == LOAD_READING) {
+		loadDone.Wait(loadLock);
+	}
+	loadRequests.erase(std::find(loadRequests.begin(), loadRequests.end(), request));
+	return request;
+}
+
+void* GameData::FinishLoadRequest(LoadRequest *request, unsigned char mode, bool silent)
+{
+	if (request->type == IE_2DA_CLASS_ID) {
+		// a prefetched table nobody asked for after all
+		delete request;
+		return NULL;
+	}
+
+	void *resource = NULL;
+	DataStream *stream = request->stream;
+
+	int fobjindex = factory->IsLoaded(request->resname, request->type);
+	if (fobjindex != -1) {
+		delete stream;
+		resource = factory->GetFactoryObject(fobjindex);
+	} else {
+		// not read yet, or retry a missing one to get the usual messages
+		if (!stream && (request->state == LOAD_QUEUED || !silent)) {
+			stream = GetResource(request->resname, request->type, silent);
+		}
+		if (stream) {
+			resource = CreateAnimationFactory(request->resname, mode, stream);
+		}
+	}
+
+	for (size_t i = 0; i < request->callbacks.size(); i++) {
+		request->callbacks[i].first(resource, request->callbacks[i].second);
+	}
+	delete request;
+	return resource;
+}
+
+void GameData::LoaderThread(void *self)
+{
+	((GameData *) self)->Load();
+}
+
+void GameData::Load()
+{
+	loadLock.Lock();
+	while (true) {
+		LoadRequest *request = NULL;
+		while (!loadersQuit) {
+			for (size_t i = 0; i < loadRequests.size(); i++) {
+				if (loadRequests[i]->state == LOAD_QUEUED) {
+					request = loadRequests[i];
+					break;
+				}
+			}
+			if (request) break;
+			loadQueued.Wait(loadLock);
+		}
+		if (loadersQuit) break;
+
+		request->state = LOAD_READING;
+		loadLock.Unlock();
+
+		DataStream *stream = GetResource(request->resname, request->type, true);
+		DataStream *mem = NULL;
+		Holder<TableMgr> table;
+		if (stream) {
+			// read it all here, so the main thread doesn't wait on the disk
+			unsigned long size = stream->Size();
+			char *data = (char *) malloc(size);
+			if (data && stream->Read(data, size) == (int) size) {
+				mem = new MemoryStream(stream->originalfile, data, size);
+				strlcpy(mem->filename, stream->filename, sizeof(mem->filename));
+			} else {
+				free(data);
+			}
+			delete stream;
+		}
+		if (mem && request->type == IE_2DA_CLASS_ID) {
+			// parse it here too, the main thread only adds it to the tables
+			PluginHolder<TableMgr> tm(IE_2DA_CLASS_ID);
+			if (tm && tm->Open(mem)) {
+				table = tm;
+			} else if (!tm) {
+				delete mem;
+			}
+			mem = NULL;
+		}
+
+		loadLock.Lock();
+		request->table = table;
+		table.release();
+		request->stream = mem;
+		request->state = LOAD_READ;
+		loadDone.Broadcast();
+	}
+	loadLock.Unlock();
+}
+
 Store* GameData::GetStore(const ieResRef ResRef)
 {
 	StoreMap::iterator it = stores.find(ResRef);
@@ -572,4 +891,183 @@ void GameData::SaveAllStores()
 	}
 }
 
+struct GameData::CachedArea {
+	ieResRef ResRef;
+	DataStream *packed;
+	unsigned long size;
+	// not in the cache directory yet
+	bool dirty;
+};
+
+bool GameData::WriteArea(CachedArea *area)
+{
+	FileStream str;
+	if (!str.Create(area->ResRef, IE_ARE_CLASS_ID)) {
+		Log(ERROR, "GameData", "Can't create file while saving area %s.", area->ResRef);
+		return false;
+	}
+	PluginHolder<Compressor> comp(PLUGIN_COMPRESSION_ZLIB);
+	area->packed->Seek(0, GEM_STREAM_START);
+	if (comp->Decompress(&str, area->packed) != GEM_OK) {
+		Log(ERROR, "GameData", "Error saving area %s.", area->ResRef);
+		return false;
+	}
+	area->dirty = false;
+	areaWrites++;
+	return true;
+}
+
+void GameData::TrimAreas(unsigned long budget)
+{
+	//least recently stored first, an area that couldn't be written
+	//is kept over the budget instead of being lost
+	std::list<CachedArea*>::iterator it = areas.end();
+	while (areaUsed > budget && it != areas.begin()) {
+		--it;
+		CachedArea *area = *it;
+		if (area->dirty && !WriteArea(area)) {
+			continue;
+		}
+		areaUsed -= area->packed->Size();
+		delete area->packed;
+		delete area;
+		it = areas.erase(it);
+	}
+}
+
+void GameData::StoreArea(const ieResRef ResRef, DataStream *area)
+{
+	DropArea(ResRef);
+
+	PluginHolder<Compressor> comp(PLUGIN_COMPRESSION_ZLIB);
+	char name[_MAX_PATH];
+	snprintf(name, sizeof(name), "%s.are", ResRef);
+	DataStream *packed = new MemoryStream(name, NULL, 0);
+	area->Seek(0, GEM_STREAM_START);
+	if (!comp || comp->Compress(packed, area) != GEM_OK) {
+		delete packed;
+		//keep it the old way
+		FileStream str;
+		if (!str.Create(ResRef, IE_ARE_CLASS_ID)) {
+			Log(ERROR, "GameData", "Can't create file while saving area %s.", ResRef);
+			delete area;
+			return;
+		}
+		char buffer[4096];
+		area->Seek(0, GEM_STREAM_START);
+		while (area->Remains()) {
+			unsigned int len = std::min((unsigned long) sizeof(buffer), area->Remains());
+			area->Read(buffer, len);
+			str.Write(buffer, len);
+		}
+		delete area;
+		return;
+	}
+	unsigned long unpacked = area->Size();
+	delete area;
+
+	//the compressed stream grew in steps, keep just what it needs
+	//or all of it if there is no memory for the smaller copy
+	unsigned long size = packed->Size();
+	void *data = malloc(size);
+	if (data) {
+		packed->Seek(0, GEM_STREAM_START);
+		packed->Read(data, size);
+		delete packed;
+		packed = new MemoryStream(name, data, size);
+	}
+
+	CachedArea *cached = new CachedArea();
+	CopyResRef(cached->ResRef, ResRef);
+	cached->packed = packed;
+	cached->size = unpacked;
+	cached->dirty = true;
+	areas.push_front(cached);
+	areaUsed += size;
+	TrimAreas(areaBudget);
+}
+
+DataStream* GameData::TakeArea(const ieResRef ResRef)
+{
+	std::list<CachedArea*>::iterator it;
+	for (it = areas.begin(); it != areas.end(); ++it) {
+		CachedArea *area = *it;
+		if (strnicmp(area->ResRef, ResRef, 8)) continue;
+
+		areas.erase(it);
+		areaUsed -= area->packed->Size();
+
+		PluginHolder<Compressor> comp(PLUGIN_COMPRESSION_ZLIB);
+		DataStream *str = new MemoryStream(area->packed->originalfile, malloc(area->size), area->size);
+		area->packed->Seek(0, GEM_STREAM_START);
+		if (comp->Decompress(str, area->packed) != GEM_OK) {
+			Log(ERROR, "GameData", "Error unpacking area %s.", ResRef);
+			delete str;
+			str = NULL;
+		} else {
+			str->Seek(0, GEM_STREAM_START);
+			areaHits++;
+		}
+		delete area->packed;
+		delete area;
+		return str;
+	}
+	areaMisses++;
+	return NULL;
+}
+
+void GameData::DropArea(const ieResRef ResRef)
+{
+	std::list<CachedArea*>::iterator it;
+	for (it = areas.begin(); it != areas.end(); ++it) {
+		CachedArea *area = *it;
+		if (strnicmp(area->ResRef, ResRef, 8)) continue;
+
+		areas.erase(it);
+		areaUsed -= area->packed->Size();
+		delete area->packed;
+		delete area;
+		return;
+	}
+}
+
+bool GameData::SaveAllAreas()
+{
+	bool success = true;
+	std::list<CachedArea*>::iterator it;
+	for (it = areas.begin(); it != areas.end(); ++it) {
+		if ((*it)->dirty && !WriteArea(*it)) {
+			success = false;
+		}
+	}
+	return success;
+}
+
+void GameData::ClearAreas()
+{
+	while (!areas.empty()) {
+		CachedArea *area = areas.front();
+		areas.pop_front();
+		delete area->packed;
+		delete area;
+	}
+	areaUsed = 0;
+}
+
+void GameData::SetAreaCacheSize(int kilobytes)
+{
+	areaBudget = kilobytes > 0 ? (unsigned long) kilobytes * 1024 : 0;
+	TrimAreas(areaBudget);
+}
+
+void GameData::GetAreaCacheStats(unsigned long &hits, unsigned long &misses, unsigned long &written,
+	unsigned long &count, unsigned long &bytes) const
+{
+	hits = areaHits;
+	misses = areaMisses;
+	written = areaWrites;
+	count = (unsigned long) areas.size();
+	bytes = areaUsed;
+}
+
 }
@@ -29,7 +29,9 @@
 #include "Cache.h"
 #include "Holder.h"
 #include "ResourceManager.h"
+#include "System/Thread.h"
 
+#include <list>
 #include <map>
 #include <vector>
 
@@ -40,6 +42,9 @@
 namespace GemRB {
 
 class Actor;
+class AnimationFactory;
+class DataStream;
+class Dialog;
 struct Effect;
 class Factory;
 class Item;
@@ -57,6 +62,11 @@ struct Table {
 	unsigned int refcount;
 };
 
+/** called on the main thread with the finished object, or NULL if it couldn't be loaded */
+typedef void (*LoadCallback)(void *resource, void *arg);
+
+struct LoadRequest;
+
 class GEM_EXPORT GameData : public ResourceManager
 {
 public:
@@ -92,6 +102,9 @@ public:
 	void FreeSpell(Spell *spl, const ieResRef name, bool free=false);
 	Effect* GetEffect(const ieResRef resname);
 	void FreeEffect(Effect *eff, const ieResRef name, bool free=false);
+	/** dialogs stay cached (and their states compiled) after the last FreeDialog */
+	Dialog* GetDialog(const ieResRef resname);
+	void FreeDialog(Dialog *dlg, const ieResRef name);
 
 	/** creates a vvc/bam animation object at point */
 	ScriptedAnimation* GetScriptedAnimation( const char *ResRef, bool doublehint);
@@ -105,21 +118,88 @@ public:
 	/** returns factory resource, currently works only with animations */
 	void* GetFactoryResource(const char* resname, SClass_ID type,
 		unsigned char mode = IE_NORMAL, bool silent=false);
+	/**
+	 * Loads a factory resource in the background. The file is read by a
+	 * loader thread, the factory object (and its sprites) is created on the
+	 * main thread by ProcessLoadedResources and cached, so GetFactoryResource
+	 * will find it. The callback is called then, or right away if the
+	 * resource is already cached. Only BAMs are read in the background,
+	 * the rest is loaded immediately.
+	 */
+	void RequestFactoryResource(const char* resname, SClass_ID type,
+		unsigned char mode = IE_NORMAL, LoadCallback callback = NULL, void *arg = NULL);
+	/**
+	 * Reads and parses the tables on the loader threads, so a later
+	 * LoadTable only has to pick them up. Unclaimed ones are dropped by
+	 * the next ProcessLoadedResources.
+	 */
+	void PrefetchTables(const char **resnames, unsigned int count);
+	/** finishes at most limit (0 for all) of the background loads, on the main thread */
+	void ProcessLoadedResources(unsigned int limit = 0);
 
 	Store* GetStore(const ieResRef ResRef);
 	/// Saves a store to the cache and frees it.
 	void SaveStore(Store* store);
 	/// Saves all stores in the cache
 	void SaveAllStores();
+
+	/**
+	 * Keeps a swapped out area compressed in memory instead of writing it
+	 * to the cache directory, taking over the serialised area. The least
+	 * recently stored areas are written out once the budget is used up.
+	 */
+	void StoreArea(const ieResRef ResRef, DataStream *area);
+	/** returns a stored area and forgets it, NULL if it isn't kept */
+	DataStream* TakeArea(const ieResRef ResRef);
+	/** forgets a stored area without writing it */
+	void DropArea(const ieResRef ResRef);
+	/** writes the stored areas that aren't in the cache directory yet,
+	 *  false if any of them couldn't be written */
+	bool SaveAllAreas();
+	/** forgets all stored areas, for when the cache directory is purged */
+	void ClearAreas();
+	/** sets the budget in kilobytes, 0 disables keeping areas */
+	void SetAreaCacheSize(int kilobytes);
+	bool KeepsAreas() const { return areaBudget > 0; }
+	void GetAreaCacheStats(unsigned long &hits, unsigned long &misses, unsigned long &written,
+		unsigned long &count, unsigned long &bytes) const;
 private:
+	AnimationFactory* CreateAnimationFactory(const char* resname, unsigned char mode, DataStream *stream);
+	LoadRequest* FindLoadRequest(const char* resname, SClass_ID type) const;
+	LoadRequest* TakeLoadRequest(const char* resname, SClass_ID type);
+	// mode is the one asked for by whoever ends up taking the request
+	void* FinishLoadRequest(LoadRequest *request, unsigned char mode, bool silent);
+	void StartLoaders();
+	static void LoaderThread(void *self);
+	void Load();
+	struct CachedArea;
+	bool WriteArea(CachedArea *area);
+	void TrimAreas(unsigned long budget);
+
 	Cache ItemCache;
 	Cache SpellCache;
 	Cache EffectCache;
 	Cache PaletteCache;
+	Cache DialogCache;
 	Factory* factory;
 	std::vector<Table> tables;
 	typedef std::map<const char*, Store*, iless> StoreMap;
 	StoreMap stores;
+
+	// swapped out areas, most recently stored first
+	std::list<CachedArea*> areas;
+	unsigned long areaBudget;
+	unsigned long areaUsed;
+	unsigned long areaHits, areaMisses, areaWrites;
+
+	// background loading
+	Thread *loaders;
+	unsigned int loaderCount;
+	Mutex loadLock;
+	WaitCondition loadQueued;
+	WaitCondition loadDone;
+	std::vector<LoadRequest*> loadRequests;
+	bool loadersQuit;
 };
 
 extern GEM_EXPORT GameData * gamedata;
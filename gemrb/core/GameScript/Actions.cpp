@@ -132,7 +132,7 @@ void GameScript::SG(Scriptable* Sender, Action* parameters)
 
 void GameScript::SetGlobal(Scriptable* Sender, Action* parameters)
 {
-	SetVariable( Sender, parameters->string0Parameter, parameters->int0Parameter );
+	SetVariable( Sender, parameters->var0, parameters->string0Parameter, parameters->int0Parameter );
 }
 
 void GameScript::SetGlobalRandom(Scriptable* Sender, Action* parameters)
@@ -3303,8 +3303,8 @@ void GameScript::GlobalAddGlobal(Scriptable* Sender, Action* parameters)
 /* adding the number to the global, they could be area or locals */
 void GameScript::IncrementGlobal(Scriptable* Sender, Action* parameters)
 {
-	ieDword value = CheckVariable( Sender, parameters->string0Parameter );
-	SetVariable( Sender, parameters->string0Parameter,
+	ieDword value = CheckVariable( Sender, parameters->var0, parameters->string0Parameter );
+	SetVariable( Sender, parameters->var0, parameters->string0Parameter,
 		value + parameters->int0Parameter );
 }
 
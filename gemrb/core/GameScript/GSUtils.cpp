@@ -51,6 +51,7 @@
 #include "Scriptable/InfoPoint.h"
 #include "System/StringBuffer.h"
 
+#include <algorithm>
 #include <cstdio>
 
 namespace GemRB {
@@ -1370,6 +1371,10 @@ void AttackCore(Scriptable *Sender, Scriptable *target, int flags)
 	if ( target->Type == ST_DOOR || target->Type == ST_CONTAINER) {
 		weaponrange += 10;
 	}
+	if (!Sender->CurrentActionTicks) {
+		// the animations can load while we close in
+		actor->PrefetchCombatAnimations(GetOrient(target->Pos, actor->Pos));
+	}
 	if (!(flags&AC_NO_SOUND) ) {
 		if (!Sender->CurrentActionTicks) {
 			//play attack sound for party members
@@ -1732,6 +1737,7 @@ Action* GenerateActionCore(const char *src, const char *str, unsigned short acti
 		if (*src == ',' || *src==')')
 			src++;
 	}
+	CompileVariables(newAction);
 	return newAction;
 }
 
@@ -1867,6 +1873,7 @@ Action *ParamCopy(Action *parameters)
 	newAction->pointParameter = parameters->pointParameter;
 	MEMCPY( newAction->string0Parameter, parameters->string0Parameter );
 	MEMCPY( newAction->string1Parameter, parameters->string1Parameter );
+	newAction->var0 = parameters->var0;
 	for (int c=0;c<3;c++) {
 		newAction->objects[c]= ObjectCopy( parameters->objects[c] );
 	}
@@ -1883,6 +1890,7 @@ Action *ParamCopyNoOverride(Action *parameters)
 	newAction->pointParameter = parameters->pointParameter;
 	MEMCPY( newAction->string0Parameter, parameters->string0Parameter );
 	MEMCPY( newAction->string1Parameter, parameters->string1Parameter );
+	newAction->var0 = parameters->var0;
 	newAction->objects[0]= NULL;
 	newAction->objects[1]= ObjectCopy( parameters->objects[1] );
 	newAction->objects[2]= ObjectCopy( parameters->objects[2] );
@@ -2041,9 +2049,15 @@ Trigger *GenerateTriggerCore(const char *src, const char *str, int trIndex, int
 		if (*src == ',' || *src==')')
 			src++;
 	}
+	CompileVariables(newTrigger);
 	return newTrigger;
 }
 
+//lookups per scope, VS_NONE counts the ones done by name
+static unsigned long scopeLookups[VS_COUNT];
+//lookups of compiled globals, indexed by symbol
+static std::vector<unsigned long> globalLookups;
+
 void SetVariable(Scriptable* Sender, const char* VarName, const char* Context, ieDword value)
 {
 	char newVarName[8+33];
@@ -2132,6 +2146,8 @@ ieDword CheckVariable(Scriptable* Sender, const char* VarName, bool *valid)
 	const char *poi;
 	ieDword value = 0;
 
+	scopeLookups[VS_NONE]++;
+
 	strlcpy( newVarName, VarName, 7 );
 	poi = &VarName[6];
 	//some HoW triggers use a : to separate the scope from the variable name
@@ -2188,6 +2204,8 @@ ieDword CheckVariable(Scriptable* Sender, const char* VarName, const char* Conte
 	char newVarName[8];
 	ieDword value = 0;
 
+	scopeLookups[VS_NONE]++;
+
 	strlcpy(newVarName, Context, 7);
 	if (stricmp( newVarName, "MYAREA" ) == 0) {
 		Sender->GetCurrentArea()->locals->Lookup( VarName, value );
@@ -2233,6 +2251,148 @@ ieDword CheckVariable(Scriptable* Sender, const char* VarName, const char* Conte
 	return value;
 }
 
+//resolves the scope of a merged "SCOPEname" parameter once, so the
+//script doesn't have to compare it and rehash the name on every run
+static void CompileVariable(VariableRef &var, const char *VarName)
+{
+	memset(&var, 0, sizeof(var));
+	if (strnlen(VarName, 6) < 6) {
+		return;
+	}
+
+	const char *poi = &VarName[6];
+	//some HoW triggers use a : to separate the scope from the variable name
+	if (*poi==':') {
+		poi++;
+	}
+	if (!strnicmp(VarName, "MYAREA", 6)) {
+		var.scope = VS_MYAREA;
+	} else if (!strnicmp(VarName, "LOCALS", 6)) {
+		var.scope = VS_LOCALS;
+	} else if (HasKaputz && !strnicmp(VarName, "KAPUTZ", 6)) {
+		var.scope = VS_KAPUTZ;
+	} else if (!strnicmp(VarName, "GLOBAL", 6)) {
+		var.scope = VS_GLOBAL;
+	} else {
+		var.scope = VS_AREA;
+		strnlwrcpy(var.area, VarName, 6);
+	}
+	var.key = Variables::Intern(poi);
+}
+
+void CompileVariables(Trigger *trigger)
+{
+	int flags = triggerflags[trigger->triggerID];
+	if ((flags & (TF_VARIABLE|TF_MERGESTRINGS)) != (TF_VARIABLE|TF_MERGESTRINGS)) {
+		return;
+	}
+	CompileVariable(trigger->var0, trigger->string0Parameter);
+	CompileVariable(trigger->var1, trigger->string1Parameter);
+}
+
+void CompileVariables(Action *action)
+{
+	if (actionflags[action->actionID] & AF_VARIABLE) {
+		CompileVariable(action->var0, action->string0Parameter);
+	}
+}
+
+static Variables *GetVariableScope(Scriptable *Sender, const VariableRef &var)
+{
+	Game *game = core->GetGame();
+	switch (var.scope) {
+	case VS_MYAREA:
+		return Sender->GetCurrentArea()->locals;
+	case VS_LOCALS:
+		return Sender->locals;
+	case VS_KAPUTZ:
+		return game->kaputz;
+	case VS_GLOBAL:
+		if (globalLookups.size() <= var.key.symbol) {
+			globalLookups.resize(var.key.symbol + 1);
+		}
+		globalLookups[var.key.symbol]++;
+		return game->locals;
+	default:
+		Map *map = game->GetMap(game->FindMap(var.area));
+		if (map) {
+			return map->locals;
+		}
+		return NULL;
+	}
+}
+
+ieDword CheckVariable(Scriptable* Sender, const VariableRef &var, const char* VarName, bool *valid)
+{
+	if (var.scope == VS_NONE) {
+		return CheckVariable(Sender, VarName, valid);
+	}
+
+	ieDword value = 0;
+	scopeLookups[var.scope]++;
+	Variables *locals = GetVariableScope(Sender, var);
+	if (locals) {
+		locals->Lookup(var.key, value);
+	} else {
+		if (valid) {
+			*valid=false;
+		}
+		if (InDebug&ID_VARIABLES) {
+			Log(WARNING, "GameScript", "Invalid variable %s in checkvariable",
+				VarName);
+		}
+	}
+	if (InDebug&ID_VARIABLES) {
+		print("CheckVariable %s: %d", VarName, value);
+	}
+	return value;
+}
+
+void SetVariable(Scriptable* Sender, const VariableRef &var, const char* VarName, ieDword value)
+{
+	if (var.scope == VS_NONE) {
+		SetVariable(Sender, VarName, value);
+		return;
+	}
+
+	if (InDebug&ID_VARIABLES) {
+		Log(DEBUG, "GSUtils", "Setting variable(\"%s\", %d)", VarName, value );
+	}
+	scopeLookups[var.scope]++;
+	Variables *locals = GetVariableScope(Sender, var);
+	if (locals) {
+		locals->SetAt(var.key, value, NoCreate);
+	} else if (InDebug&ID_VARIABLES) {
+		Log(WARNING, "GameScript", "Invalid variable %s in setvariable",
+			VarName);
+	}
+}
+
+static bool HotterGlobal(const std::pair<unsigned long, unsigned int> &a,
+	const std::pair<unsigned long, unsigned int> &b)
+{
+	return a.first > b.first;
+}
+
+void DumpVariableStats(StringBuffer &buffer)
+{
+	buffer.appendFormatted("Variable lookups: %lu global, %lu locals, %lu myarea, %lu kaputz, %lu area, %lu by name\n",
+		scopeLookups[VS_GLOBAL], scopeLookups[VS_LOCALS], scopeLookups[VS_MYAREA],
+		scopeLookups[VS_KAPUTZ], scopeLookups[VS_AREA], scopeLookups[VS_NONE]);
+
+	std::vector<std::pair<unsigned long, unsigned int> > hot;
+	for (unsigned int i = 1; i < globalLookups.size(); i++) {
+		if (globalLookups[i]) {
+			hot.push_back(std::make_pair(globalLookups[i], i));
+		}
+	}
+	size_t count = std::min(hot.size(), (size_t) 5);
+	std::partial_sort(hot.begin(), hot.begin() + count, hot.end(), HotterGlobal);
+	for (size_t i = 0; i < count; i++) {
+		buffer.appendFormatted("  %s: %lu\n", Variables::GetSymbolName(hot[i].second), hot[i].first);
+	}
+}
+
 // checks if a variable exists in any context
 bool VariableExists(Scriptable *Sender, const char *VarName, const char *Context)
 {
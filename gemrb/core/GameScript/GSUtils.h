@@ -36,6 +36,9 @@ namespace GemRB {
 #define ID_VARIABLES 4
 #define ID_ACTIONS   8
 #define ID_TRIGGERS  16
+#define ID_PROFILE   32
+#define ID_SIGHT     64
+#define ID_WAKEUP    128
 
 //whoseeswho for GetNearestEnemy:
 #define ENEMY_SEES_ORIGIN 1
@@ -135,6 +138,10 @@ bool CreateMovementEffect(Actor* actor, const char *area, const Point &position,
 GEM_EXPORT void MoveBetweenAreasCore(Actor* actor, const char *area, const Point &position, int face, bool adjust);
 GEM_EXPORT ieDword CheckVariable(Scriptable* Sender, const char* VarName, bool *valid = NULL);
 GEM_EXPORT ieDword CheckVariable(Scriptable* Sender, const char* VarName, const char* Context, bool *valid = NULL);
+ieDword CheckVariable(Scriptable* Sender, const VariableRef &var, const char* VarName, bool *valid = NULL);
+void SetVariable(Scriptable* Sender, const VariableRef &var, const char* VarName, ieDword value);
+void CompileVariables(Trigger *trigger);
+void CompileVariables(Action *action);
 GEM_EXPORT bool VariableExists(Scriptable *Sender, const char *VarName, const char *Context);
 Action* GenerateActionCore(const char *src, const char *str, unsigned short actionID);
 Trigger *GenerateTriggerCore(const char *src, const char *str, int trIndex, int negate);
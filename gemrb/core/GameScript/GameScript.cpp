@@ -22,12 +22,14 @@
 
 #include "GameScript/GSUtils.h"
 #include "GameScript/Matching.h"
+#include "GameScript/ScriptProfiler.h"
 
 #include "win32def.h"
 
 #include "Game.h"
 #include "GameData.h"
 #include "Interface.h"
+#include "MemoryPool.h"
 #include "PluginMgr.h"
 #include "TableMgr.h"
 #include "RNG/RNG_SFMT.h"
@@ -41,6 +43,9 @@ namespace GemRB {
 // 4 - globals
 // 8 - action execution
 //16 - trigger evaluation
+//32 - profiling
+//64 - line of sight cache check
+//128 - sleeping script check
 
 //Make this an ordered list, so we could use bsearch!
 static const TriggerLink triggernames[] = {
@@ -57,15 +62,15 @@ static const TriggerLink triggernames[] = {
 	{"areaflag", GameScript::AreaFlag, 0},
 	{"arearestdisabled", GameScript::AreaRestDisabled, 0},
 	{"areatype", GameScript::AreaType, 0},
-	{"assaltedby", GameScript::AttackedBy, 0},//pst
+	{"assaltedby", GameScript::AttackedBy, TF_EVENT},//pst
 	{"assign", GameScript::Assign, 0},
 	{"atlocation", GameScript::AtLocation, 0},
-	{"attackedby", GameScript::AttackedBy, 0},
-	{"becamevisible", GameScript::BecameVisible, 0},
+	{"attackedby", GameScript::AttackedBy, TF_EVENT},
+	{"becamevisible", GameScript::BecameVisible, TF_EVENT},
 	{"beeninparty", GameScript::BeenInParty, 0},
-	{"bitcheck", GameScript::BitCheck,TF_MERGESTRINGS},
-	{"bitcheckexact", GameScript::BitCheckExact,TF_MERGESTRINGS},
-	{"bitglobal", GameScript::BitGlobal_Trigger,TF_MERGESTRINGS},
+	{"bitcheck", GameScript::BitCheck,TF_MERGESTRINGS|TF_VARIABLE},
+	{"bitcheckexact", GameScript::BitCheckExact,TF_MERGESTRINGS|TF_VARIABLE},
+	{"bitglobal", GameScript::BitGlobal_Trigger,TF_MERGESTRINGS|TF_VARIABLE},
 	{"bouncingspelllevel", GameScript::BouncingSpellLevel, 0},
 	{"breakingpoint", GameScript::BreakingPoint, 0},
 	{"calanderday", GameScript::CalendarDay, 0}, //illiterate developers O_o
@@ -93,8 +98,8 @@ static const TriggerLink triggernames[] = {
 	{"classlevel", GameScript::ClassLevel, 0}, //pst
 	{"classlevelgt", GameScript::ClassLevelGT, 0},
 	{"classlevellt", GameScript::ClassLevelLT, 0},
-	{"clicked", GameScript::Clicked, 0},
-	{"closed", GameScript::Closed, 0},
+	{"clicked", GameScript::Clicked, TF_EVENT},
+	{"closed", GameScript::Closed, TF_EVENT},
 	{"combatcounter", GameScript::CombatCounter, 0},
 	{"combatcountergt", GameScript::CombatCounterGT, 0},
 	{"combatcounterlt", GameScript::CombatCounterLT, 0},
@@ -108,16 +113,16 @@ static const TriggerLink triggernames[] = {
 	{"dead", GameScript::Dead, 0},
 	{"delay", GameScript::Delay, 0},
 	{"detect", GameScript::Detect, 0}, //so far i see no difference
-	{"detected", GameScript::Detected, 0}, //trap or secret door detected
-	{"die", GameScript::Die, 0},
-	{"died", GameScript::Died, 0},
+	{"detected", GameScript::Detected, TF_EVENT}, //trap or secret door detected
+	{"die", GameScript::Die, TF_EVENT},
+	{"died", GameScript::Died, TF_EVENT},
 	{"difficulty", GameScript::Difficulty, 0},
 	{"difficultygt", GameScript::DifficultyGT, 0},
 	{"difficultylt", GameScript::DifficultyLT, 0},
-	{"disarmed", GameScript::Disarmed, 0},
-	{"disarmfailed", GameScript::DisarmFailed, 0},
+	{"disarmed", GameScript::Disarmed, TF_EVENT},
+	{"disarmfailed", GameScript::DisarmFailed, TF_EVENT},
 	{"e", GameScript::E, 0},
-	{"entered", GameScript::Entered, 0},
+	{"entered", GameScript::Entered, TF_EVENT},
 	{"entirepartyonmap", GameScript::EntirePartyOnMap, 0},
 	{"exists", GameScript::Exists, 0},
 	{"extendedstatecheck", GameScript::ExtendedStateCheck, 0},
@@ -126,10 +131,10 @@ static const TriggerLink triggernames[] = {
 	{"extraproficiencylt", GameScript::ExtraProficiencyLT, 0},
 	{"eval", GameScript::Eval, 0},
 	{"faction", GameScript::Faction, 0},
-	{"failedtoopen", GameScript::OpenFailed, 0},
+	{"failedtoopen", GameScript::OpenFailed, TF_EVENT},
 	{"fallenpaladin", GameScript::FallenPaladin, 0},
 	{"fallenranger", GameScript::FallenRanger, 0},
-	{"false", GameScript::False, 0},
+	{"false", GameScript::False, TF_CONSTANT},
 	{"forcemarkedspell", GameScript::ForceMarkedSpell_Trigger, 0},
 	{"frame", GameScript::Frame, 0},
 	{"g", GameScript::G_Trigger, 0},
@@ -137,19 +142,19 @@ static const TriggerLink triggernames[] = {
 	{"general", GameScript::General, 0},
 	{"ggt", GameScript::GGT_Trigger, 0},
 	{"glt", GameScript::GLT_Trigger, 0},
-	{"global", GameScript::Global,TF_MERGESTRINGS},
-	{"globalandglobal", GameScript::GlobalAndGlobal_Trigger,TF_MERGESTRINGS},
-	{"globalband", GameScript::BitCheck,TF_MERGESTRINGS},
-	{"globalbandglobal", GameScript::GlobalBAndGlobal_Trigger,TF_MERGESTRINGS},
-	{"globalbandglobalexact", GameScript::GlobalBAndGlobalExact,TF_MERGESTRINGS},
-	{"globalbitglobal", GameScript::GlobalBitGlobal_Trigger,TF_MERGESTRINGS},
-	{"globalequalsglobal", GameScript::GlobalsEqual,TF_MERGESTRINGS}, //this is the same
-	{"globalgt", GameScript::GlobalGT,TF_MERGESTRINGS},
-	{"globalgtglobal", GameScript::GlobalGTGlobal,TF_MERGESTRINGS},
-	{"globallt", GameScript::GlobalLT,TF_MERGESTRINGS},
-	{"globalltglobal", GameScript::GlobalLTGlobal,TF_MERGESTRINGS},
-	{"globalorglobal", GameScript::GlobalOrGlobal_Trigger,TF_MERGESTRINGS},
-	{"globalsequal", GameScript::GlobalsEqual, 0},
+	{"global", GameScript::Global,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalandglobal", GameScript::GlobalAndGlobal_Trigger,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalband", GameScript::BitCheck,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalbandglobal", GameScript::GlobalBAndGlobal_Trigger,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalbandglobalexact", GameScript::GlobalBAndGlobalExact,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalbitglobal", GameScript::GlobalBitGlobal_Trigger,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalequalsglobal", GameScript::GlobalsEqual,TF_MERGESTRINGS|TF_VARIABLE}, //this is the same
+	{"globalgt", GameScript::GlobalGT,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalgtglobal", GameScript::GlobalGTGlobal,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globallt", GameScript::GlobalLT,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalltglobal", GameScript::GlobalLTGlobal,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalorglobal", GameScript::GlobalOrGlobal_Trigger,TF_MERGESTRINGS|TF_VARIABLE},
+	{"globalsequal", GameScript::GlobalsEqual, TF_VARIABLE},
 	{"globalsgt", GameScript::GlobalsGT, 0},
 	{"globalslt", GameScript::GlobalsLT, 0},
 	{"globaltimerexact", GameScript::GlobalTimerExact, 0},
@@ -160,9 +165,9 @@ static const TriggerLink triggernames[] = {
 	{"happiness", GameScript::Happiness, 0},
 	{"happinessgt", GameScript::HappinessGT, 0},
 	{"happinesslt", GameScript::HappinessLT, 0},
-	{"harmlessclosed", GameScript::HarmlessClosed, 0}, //pst
-	{"harmlessentered", GameScript::HarmlessEntered, 0}, //pst
-	{"harmlessopened", GameScript::HarmlessOpened, 0}, //pst
+	{"harmlessclosed", GameScript::HarmlessClosed, TF_EVENT}, //pst
+	{"harmlessentered", GameScript::HarmlessEntered, TF_EVENT}, //pst
+	{"harmlessopened", GameScript::HarmlessOpened, TF_EVENT}, //pst
 	{"hasbounceeffects", GameScript::HasBounceEffects, 0},
 	{"hasdlc", GameScript::HasDLC, 0},
 	{"hasimmunityeffects", GameScript::HasImmunityEffects, 0},
@@ -182,11 +187,11 @@ static const TriggerLink triggernames[] = {
 	{"havespellparty", GameScript::HaveSpellParty, 0},
 	{"havespellres", GameScript::HaveSpell, 0}, //they share the same ID
 	{"haveusableweaponequipped", GameScript::HaveUsableWeaponEquipped, 0},
-	{"heard", GameScript::Heard, 0},
-	{"help", GameScript::Help_Trigger, 0},
+	{"heard", GameScript::Heard, TF_EVENT},
+	{"help", GameScript::Help_Trigger, TF_EVENT},
 	{"helpex", GameScript::HelpEX, 0},
-	{"hitby", GameScript::HitBy, 0},
-	{"hotkey", GameScript::HotKey, 0},
+	{"hitby", GameScript::HitBy, TF_EVENT},
+	{"hotkey", GameScript::HotKey, TF_EVENT},
 	{"hp", GameScript::HP, 0},
 	{"hpgt", GameScript::HPGT, 0},
 	{"hplost", GameScript::HPLost, 0},
@@ -242,13 +247,13 @@ static const TriggerLink triggernames[] = {
 	{"isweaponranged", GameScript::IsWeaponRanged, 0},
 	{"isweather", GameScript::IsWeather, 0}, //gemrb extension
 	{"itemisidentified", GameScript::ItemIsIdentified, 0},
-	{"joins", GameScript::Joins, 0},
-	{"killed", GameScript::Killed, 0},
+	{"joins", GameScript::Joins, TF_EVENT},
+	{"killed", GameScript::Killed, TF_EVENT},
 	{"kit", GameScript::Kit, 0},
 	{"knowspell", GameScript::KnowSpell, 0}, //gemrb specific
 	{"lastmarkedobject", GameScript::LastMarkedObject_Trigger, 0},
 	{"lastpersontalkedto", GameScript::LastPersonTalkedTo, 0}, //pst
-	{"leaves", GameScript::Leaves, 0},
+	{"leaves", GameScript::Leaves, TF_EVENT},
 	{"level", GameScript::Level, 0},
 	{"levelgt", GameScript::LevelGT, 0},
 	{"levelinclass", GameScript::LevelInClass, 0}, //iwd2
@@ -271,7 +276,7 @@ static const TriggerLink triggernames[] = {
 	{"movementrategt", GameScript::MovementRateGT, 0},
 	{"movementratelt", GameScript::MovementRateLT, 0},
 	{"name", GameScript::CalledByName, 0}, //this is the same too?
-	{"namelessbitthedust", GameScript::NamelessBitTheDust, 0},
+	{"namelessbitthedust", GameScript::NamelessBitTheDust, TF_EVENT},
 	{"nearbydialog", GameScript::NearbyDialog, 0},
 	{"nearbydialogue", GameScript::NearbyDialog, 0},
 	{"nearlocation", GameScript::NearLocation, 0},
@@ -330,13 +335,13 @@ static const TriggerLink triggernames[] = {
 	{"objitemcounteq", GameScript::NumItems, 0},
 	{"objitemcountgt", GameScript::NumItemsGT, 0},
 	{"objitemcountlt", GameScript::NumItemsLT, 0},
-	{"oncreation", GameScript::OnCreation, 0},
+	{"oncreation", GameScript::OnCreation, TF_EVENT},
 	{"onisland", GameScript::OnIsland, 0},
 	{"onscreen", GameScript::OnScreen, 0},
-	{"opened", GameScript::Opened, 0},
-	{"openfailed", GameScript::OpenFailed, 0},
+	{"opened", GameScript::Opened, TF_EVENT},
+	{"openfailed", GameScript::OpenFailed, TF_EVENT},
 	{"openstate", GameScript::OpenState, 0},
-	{"or", GameScript::Or, 0},
+	{"or", GameScript::Or, TF_CONSTANT},
 	{"originalclass", GameScript::OriginalClass, 0},
 	{"outofammo", GameScript::OutOfAmmo, 0},
 	{"ownsfloatermessage", GameScript::OwnsFloaterMessage, 0},
@@ -354,13 +359,13 @@ static const TriggerLink triggernames[] = {
 	{"partylevelvs", GameScript::NumCreatureVsParty, 0},
 	{"partylevelvsgt", GameScript::NumCreatureVsPartyGT, 0},
 	{"partylevelvslt", GameScript::NumCreatureVsPartyLT, 0},
-	{"partymemberdied", GameScript::PartyMemberDied, 0},
-	{"partyrested", GameScript::PartyRested, 0},
+	{"partymemberdied", GameScript::PartyMemberDied, TF_EVENT},
+	{"partyrested", GameScript::PartyRested, TF_EVENT},
 	{"pccanseepoint", GameScript::PCCanSeePoint, 0},
 	{"pcinstore", GameScript::PCInStore, 0},
 	{"personalspacedistance", GameScript::PersonalSpaceDistance, 0},
-	{"picklockfailed", GameScript::PickLockFailed, 0},
-	{"pickpocketfailed", GameScript::PickpocketFailed, 0},
+	{"picklockfailed", GameScript::PickLockFailed, TF_EVENT},
+	{"pickpocketfailed", GameScript::PickpocketFailed, TF_EVENT},
 	{"proficiency", GameScript::Proficiency, 0},
 	{"proficiencygt", GameScript::ProficiencyGT, 0},
 	{"proficiencylt", GameScript::ProficiencyLT, 0},
@@ -376,7 +381,7 @@ static const TriggerLink triggernames[] = {
 	{"realglobaltimerexact", GameScript::RealGlobalTimerExact, 0},
 	{"realglobaltimerexpired", GameScript::RealGlobalTimerExpired, 0},
 	{"realglobaltimernotexpired", GameScript::RealGlobalTimerNotExpired, 0},
-	{"receivedorder", GameScript::ReceivedOrder, 0},
+	{"receivedorder", GameScript::ReceivedOrder, TF_EVENT},
 	{"reputation", GameScript::Reputation, 0},
 	{"reputationgt", GameScript::ReputationGT, 0},
 	{"reputationlt", GameScript::ReputationLT, 0},
@@ -387,12 +392,12 @@ static const TriggerLink triggernames[] = {
 	{"setmarkedspell", GameScript::SetMarkedSpell_Trigger, 0},
 	{"setspelltarget", GameScript::SetSpellTarget, 0},
 	{"specifics", GameScript::Specifics, 0},
-	{"spellcast", GameScript::SpellCast, 0},
-	{"spellcastinnate", GameScript::SpellCastInnate, 0},
-	{"spellcastonme", GameScript::SpellCastOnMe, 0},
-	{"spellcastpriest", GameScript::SpellCastPriest, 0},
+	{"spellcast", GameScript::SpellCast, TF_EVENT},
+	{"spellcastinnate", GameScript::SpellCastInnate, TF_EVENT},
+	{"spellcastonme", GameScript::SpellCastOnMe, TF_EVENT},
+	{"spellcastpriest", GameScript::SpellCastPriest, TF_EVENT},
 	{"statecheck", GameScript::StateCheck, 0},
-	{"stealfailed", GameScript::StealFailed, 0},
+	{"stealfailed", GameScript::StealFailed, TF_EVENT},
 	{"storehasitem", GameScript::StoreHasItem, 0},
 	{"stuffglobalrandom", GameScript::StuffGlobalRandom, 0},//hm, this is a trigger
 	{"subrace", GameScript::SubRace, 0},
@@ -406,35 +411,35 @@ static const TriggerLink triggernames[] = {
 	{"timegt", GameScript::TimeGT, 0},
 	{"timelt", GameScript::TimeLT, 0},
 	{"timeofday", GameScript::TimeOfDay, 0},
-	{"timeractive", GameScript::TimerActive, 0},
-	{"timerexpired", GameScript::TimerExpired, 0},
+	{"timeractive", GameScript::TimerActive, TF_TIMER},
+	{"timerexpired", GameScript::TimerExpired, TF_TIMER},
 	{"timestopcounter", GameScript::TimeStopCounter, 0},
 	{"timestopcountergt", GameScript::TimeStopCounterGT, 0},
 	{"timestopcounterlt", GameScript::TimeStopCounterLT, 0},
 	{"timestopobject", GameScript::TimeStopObject, 0},
-	{"tookdamage", GameScript::TookDamage, 0},
+	{"tookdamage", GameScript::TookDamage, TF_EVENT},
 	{"totalitemcnt", GameScript::TotalItemCnt, 0}, //iwd2
 	{"totalitemcntexclude", GameScript::TotalItemCntExclude, 0}, //iwd2
 	{"totalitemcntexcludegt", GameScript::TotalItemCntExcludeGT, 0}, //iwd2
 	{"totalitemcntexcludelt", GameScript::TotalItemCntExcludeLT, 0}, //iwd2
 	{"totalitemcntgt", GameScript::TotalItemCntGT, 0}, //iwd2
 	{"totalitemcntlt", GameScript::TotalItemCntLT, 0}, //iwd2
-	{"traptriggered", GameScript::TrapTriggered, 0},
-	{"trigger", GameScript::TriggerTrigger, 0},
-	{"triggerclick", GameScript::Clicked, 0}, //not sure
+	{"traptriggered", GameScript::TrapTriggered, TF_EVENT},
+	{"trigger", GameScript::TriggerTrigger, TF_EVENT},
+	{"triggerclick", GameScript::Clicked, TF_EVENT}, //not sure
 	{"triggersetglobal", GameScript::TriggerSetGlobal,0}, //iwd2, but never used
-	{"true", GameScript::True, 0},
-	{"turnedby", GameScript::TurnedBy, 0},
-	{"unlocked", GameScript::Unlocked, 0},
+	{"true", GameScript::True, TF_CONSTANT},
+	{"turnedby", GameScript::TurnedBy, TF_EVENT},
+	{"unlocked", GameScript::Unlocked, TF_EVENT},
 	{"unselectablevariable", GameScript::UnselectableVariable, 0},
 	{"unselectablevariablegt", GameScript::UnselectableVariableGT, 0},
 	{"unselectablevariablelt", GameScript::UnselectableVariableLT, 0},
 	{"unusable",GameScript::Unusable, 0},
 	{"usedexit",GameScript::UsedExit, 0}, //pst unhardcoded trigger for protagonist teleport
 	{"vacant",GameScript::Vacant, 0},
-	{"walkedtotrigger", GameScript::WalkedToTrigger, 0},
-	{"wasindialog", GameScript::WasInDialog, 0},
-	{"xor", GameScript::Xor,TF_MERGESTRINGS},
+	{"walkedtotrigger", GameScript::WalkedToTrigger, TF_EVENT},
+	{"wasindialog", GameScript::WasInDialog, TF_EVENT},
+	{"xor", GameScript::Xor,TF_MERGESTRINGS|TF_VARIABLE},
 	{"xp", GameScript::XP, 0},
 	{"xpgt", GameScript::XPGT, 0},
 	{"xplt", GameScript::XPLT, 0},
@@ -693,7 +698,7 @@ static const ActionLink actionnames[] = {
 	{"incmoraleai", GameScript::IncMoraleAI, 0},
 	{"incrementchapter", GameScript::IncrementChapter, 0},
 	{"incrementextraproficiency", GameScript::IncrementExtraProficiency, 0},
-	{"incrementglobal", GameScript::IncrementGlobal,AF_MERGESTRINGS},
+	{"incrementglobal", GameScript::IncrementGlobal,AF_MERGESTRINGS|AF_VARIABLE},
 	{"incrementglobalonce", GameScript::IncrementGlobalOnce,AF_MERGESTRINGS},
 	{"incrementkillstat", GameScript::IncrementKillStat, 0},
 	{"incrementproficiency", GameScript::IncrementProficiency, 0},
@@ -868,7 +873,7 @@ static const ActionLink actionnames[] = {
 	{"setextendednight", GameScript::SetExtendedNight, 0},
 	{"setfaction", GameScript::SetFaction, 0},
 	{"setgabber", GameScript::SetGabber, 0},
-	{"setglobal", GameScript::SetGlobal,AF_MERGESTRINGS},
+	{"setglobal", GameScript::SetGlobal,AF_MERGESTRINGS|AF_VARIABLE},
 	{"setglobalrandom", GameScript::SetGlobalRandom, AF_MERGESTRINGS},
 	{"setglobaltimer", GameScript::SetGlobalTimer,AF_MERGESTRINGS},
 	{"setglobaltimeronce", GameScript::SetGlobalTimerOnce,AF_MERGESTRINGS},
@@ -1818,6 +1823,65 @@ GameScript::~GameScript(void)
 	}
 }
 
+// works out what a block condition reads, so idle scriptables can sleep
+// until one of those changes instead of evaluating it every script round
+// a block is gated if it can't be true without an event: a plain event
+// trigger or an Or() made only of them; with no pending triggers it
+// is then false no matter what else it reads
+static void ClassifyBlock(ResponseBlock *rB)
+{
+	int wake = 0, quiet = 0;
+	bool gated = false;
+	int ORcount = 0;
+	bool ORgated = true;
+
+	if (rB->condition) {
+		for (size_t i = 0; i < rB->condition->triggers.size(); i++) {
+			const Trigger *tR = rB->condition->triggers[i];
+			short flags = triggerflags[tR->triggerID];
+			if (triggers[tR->triggerID] == GameScript::Or && tR->int0Parameter > 1) {
+				ORcount = tR->int0Parameter;
+				ORgated = true;
+				continue;
+			}
+
+			bool event = false;
+			if (flags & TF_EVENT) {
+				event = !(tR->flags & TF_NEGATE);
+				quiet |= SW_TRIGGERS;
+				wake |= SW_TRIGGERS;
+				// matching a pending trigger against an object depends on
+				// whatever the object resolves to at the time
+				if (tR->objectParameter) {
+					wake |= SW_POLL;
+				}
+			} else if (flags & TF_VARIABLE) {
+				quiet |= SW_VARIABLES;
+				wake |= SW_VARIABLES;
+			} else if (flags & TF_TIMER) {
+				quiet |= SW_TIMERS;
+				wake |= SW_TIMERS;
+			} else if (!(flags & TF_CONSTANT)) {
+				quiet |= SW_POLL;
+				wake |= SW_POLL;
+			}
+
+			if (ORcount) {
+				ORgated &= event;
+				if (!--ORcount && ORgated) {
+					gated = true;
+				}
+				continue;
+			}
+			if (event) {
+				gated = true;
+			}
+		}
+	}
+	rB->wakeFlags = wake;
+	rB->quietWakeFlags = gated ? SW_TRIGGERS : quiet;
+}
+
 Script* GameScript::CacheScript(ieResRef ResRef, bool AIScript)
 {
 	char line[10];
@@ -1852,6 +1916,9 @@ Script* GameScript::CacheScript(ieResRef ResRef, bool AIScript)
 		ResponseBlock* rB = ReadResponseBlock( stream );
 		if (!rB)
 			break;
+		ClassifyBlock(rB);
+		newScript->wakeFlags |= rB->wakeFlags;
+		newScript->quietWakeFlags |= rB->quietWakeFlags;
 		newScript->responseBlocks.push_back( rB );
 		stream->ReadLine( line, 10 );
 	}
@@ -1970,6 +2037,7 @@ static Trigger* ReadTrigger(DataStream* stream)
 		delete tR;
 		return NULL;
 	}
+	CompileVariables(tR);
 	return tR;
 }
 
@@ -2011,10 +2079,21 @@ bool GameScript::Update(bool *continuing, bool *done)
 	bool continueExecution = false;
 	if (continuing) continueExecution = *continuing;
 
+	ScriptStats *stats = NULL;
+	if (InDebug&ID_PROFILE) {
+		stats = ScriptProfiler::GetScriptStats(Name);
+	}
+	ProfileTimer timer(stats ? &stats->total : NULL);
+
 	RandomNumValue=RNG_SFMT::getInstance()->rand();
 	for (size_t a = 0; a < script->responseBlocks.size(); a++) {
 		ResponseBlock* rB = script->responseBlocks[a];
-		if (rB->condition->Evaluate(MySelf)) {
+		bool conditionMet;
+		{
+			ProfileTimer blockTimer(stats ? stats->GetBlock(a) : NULL);
+			conditionMet = rB->condition->Evaluate(MySelf);
+		}
+		if (conditionMet) {
 			//if this isn't a continue-d block, we have to clear the queue
 			//we cannot clear the queue and cannot execute the new block
 			//if we already have stuff on the queue!
@@ -2054,6 +2133,30 @@ bool GameScript::Update(bool *continuing, bool *done)
 	return continueExecution;
 }
 
+int GameScript::GetWakeFlags(bool pending) const
+{
+	if (!script) {
+		return 0;
+	}
+	return pending ? script->wakeFlags : script->quietWakeFlags;
+}
+
+bool GameScript::CanFire()
+{
+	if (!MySelf || !script) {
+		return false;
+	}
+	if (!(MySelf->GetInternalFlag()&IF_ACTIVE)) {
+		return false;
+	}
+	for (size_t a = 0; a < script->responseBlocks.size(); a++) {
+		if (script->responseBlocks[a]->condition->Evaluate(MySelf)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 //IE simply takes the first action's object for cutscene object
 //then adds these actions to its queue:
 // SetInterrupt(false), <actions>, SetInterrupt(true)
@@ -2187,6 +2290,7 @@ Response* GameScript::ReadResponse(DataStream* stream)
 				//just to find bugs faster
 				aC->int0Parameter = -1;
 			}
+			CompileVariables(aC);
 		}
 		rE->actions.push_back( aC );
 		stream->ReadLine( line, 1024 );
@@ -2289,7 +2393,11 @@ int Trigger::Evaluate(Scriptable* Sender)
 		Log(WARNING, "GameScript", "Executing trigger code: 0x%04x %s",
 				triggerID, tmpstr );
 	}
-	int ret = func( Sender, this );
+	int ret;
+	{
+		ProfileTimer timer(InDebug&ID_PROFILE ? ScriptProfiler::GetTriggerStats(triggerID) : NULL);
+		ret = func( Sender, this );
+	}
 	if (flags & TF_NEGATE) {
 		return !ret;
 	}
@@ -2373,6 +2481,9 @@ void GameScript::ExecuteAction(Scriptable* Sender, Action* aC)
 {
 	int actionID = aC->actionID;
 
+	// actions change the world, so the memoised object matches are void
+	InvalidateObjectCache();
+
 	if (aC->objects[0]) {
 		Scriptable *scr = GetActorFromObject(Sender, aC->objects[0]);
 
@@ -2423,6 +2534,7 @@ void GameScript::ExecuteAction(Scriptable* Sender, Action* aC)
 				}
 			}
 		}
+		ProfileTimer timer(InDebug&ID_PROFILE ? ScriptProfiler::GetActionStats(actionID) : NULL);
 		func( Sender, aC );
 	} else {
 		actions[actionID] = NoActionAtAll;
@@ -2534,6 +2646,41 @@ Action* GenerateActionDirect(const char *String, Scriptable *object)
 	return action;
 }
 
+//scripts parse, copy and drop these all the time
+static MemoryPool ObjectPool("Object", sizeof(Object), 512);
+static MemoryPool TriggerPool("Trigger", sizeof(Trigger), 256);
+static MemoryPool ActionPool("Action", sizeof(Action), 256);
+
+void* Object::operator new(size_t size)
+{
+	return ObjectPool.Allocate(size);
+}
+
+void Object::operator delete(void *ptr)
+{
+	ObjectPool.Free(ptr);
+}
+
+void* Trigger::operator new(size_t size)
+{
+	return TriggerPool.Allocate(size);
+}
+
+void Trigger::operator delete(void *ptr)
+{
+	TriggerPool.Free(ptr);
+}
+
+void* Action::operator new(size_t size)
+{
+	return ActionPool.Allocate(size);
+}
+
+void Action::operator delete(void *ptr)
+{
+	ActionPool.Free(ptr);
+}
+
 void Object::dump() const
 {
 	StringBuffer buffer;
@@ -214,8 +214,28 @@ public:
 		delete this;
 	}
 	bool isNull();
+	static void* operator new(size_t size);
+	static void operator delete(void *ptr);
 };
 
+//scope of a compiled script variable
+#define VS_NONE   0 //not compiled, look it up by name
+#define VS_GLOBAL 1
+#define VS_LOCALS 2
+#define VS_MYAREA 3
+#define VS_KAPUTZ 4
+#define VS_AREA   5 //the locals of a named area
+#define VS_COUNT  6
+
+/** a "SCOPEname" variable parameter resolved when the script is compiled */
+struct VariableRef {
+	int scope;
+	ieResRef area;
+	VariableKey key;
+};
+
+GEM_EXPORT void DumpVariableStats(StringBuffer &buffer);
+
 class GEM_EXPORT Trigger : protected Canary {
 public:
 	Trigger()
@@ -225,6 +245,8 @@ public:
 		objectParameter = NULL;
 		memset(string0Parameter, 0, 65);
 		memset(string1Parameter, 0, 65);
+		memset(&var0, 0, sizeof(var0));
+		memset(&var1, 0, sizeof(var1));
 		int0Parameter = 0;
 		int1Parameter = 0;
 		int2Parameter = 0;
@@ -248,6 +270,8 @@ public:
 	char string0Parameter[65];
 	char string1Parameter[65];
 	Object* objectParameter;
+	//the two string parameters of TF_VARIABLE triggers
+	VariableRef var0, var1;
 
 public:
 	void dump() const;
@@ -257,6 +281,8 @@ public:
 	{
 		delete this;
 	}
+	static void* operator new(size_t size);
+	static void operator delete(void *ptr);
 };
 
 class GEM_EXPORT Condition : protected Canary {
@@ -289,6 +315,7 @@ public:
 		objects[2] = NULL;
 		memset(string0Parameter, 0, 65);
 		memset(string1Parameter, 0, 65);
+		memset(&var0, 0, sizeof(var0));
 		int0Parameter = 0;
 		pointParameter.null();
 		int1Parameter = 0;
@@ -318,6 +345,8 @@ public:
 	int int2Parameter;
 	char string0Parameter[65];
 	char string1Parameter[65];
+	//string0Parameter of AF_VARIABLE actions
+	VariableRef var0;
 private:
 	int RefCount;
 public:
@@ -349,6 +378,8 @@ public:
 				actionID);
 		}
 	}
+	static void* operator new(size_t size);
+	static void operator delete(void *ptr);
 };
 
 class GEM_EXPORT Response : protected Canary {
@@ -403,6 +434,7 @@ public:
 	{
 		condition = NULL;
 		responseSet = NULL;
+		wakeFlags = quietWakeFlags = 0;
 	}
 	~ResponseBlock()
 	{
@@ -422,10 +454,23 @@ public:
 public:
 	Condition* condition;
 	ResponseSet* responseSet;
+	//what the condition reads (SW_*), with and without pending triggers
+	int wakeFlags;
+	int quietWakeFlags;
 };
 
+//what the blocks of a script depend on, worked out by CacheScript
+#define SW_TRIGGERS  1 //events added to the scriptable
+#define SW_VARIABLES 2 //game, area or local variables
+#define SW_TIMERS    4 //the scriptable's own script timers
+#define SW_POLL      8 //anything else, has to be evaluated every time
+
 class GEM_EXPORT Script : protected Canary {
 public:
+	Script()
+	{
+		wakeFlags = quietWakeFlags = 0;
+	}
 	~Script()
 	{
 		for (unsigned int i = 0; i < responseBlocks.size(); i++) {
@@ -437,6 +482,9 @@ public:
 	}
 public:
 	std::vector<ResponseBlock*> responseBlocks;
+	//the union of the block flags
+	int wakeFlags;
+	int quietWakeFlags;
 public:
 	void Release()
 	{
@@ -453,6 +501,10 @@ typedef int (* IDSFunction)(Actor *, int parameter);
 #define TF_CONDITION    1 //this isn't a trigger, just a condition (0x4000)
 #define TF_SAVED        2 //trigger is in svtriobj.ids
 #define TF_MERGESTRINGS 8 //same value as actions' mergestring
+#define TF_EVENT       16 //only true if a matching trigger was added to the scriptable
+#define TF_VARIABLE    32 //only reads script variables
+#define TF_TIMER       64 //only reads the scriptable's script timers
+#define TF_CONSTANT   128 //doesn't read anything
 
 struct TriggerLink {
 	const char* Name;
@@ -507,6 +559,7 @@ struct TriggerLink {
 #define AF_DLG_INSTANT  4096 //instant dialog actions
 #define AF_SCR_INSTANT  8192 //instant script actions
 #define AF_INSTANT      (AF_DLG_INSTANT|AF_SCR_INSTANT) //only iwd2 treats them separately; 12288
+#define AF_VARIABLE     16384 //string0Parameter is a variable, compiled into var0
 
 struct ActionLink {
 	const char* Name;
@@ -544,6 +597,10 @@ public:
 public:
 	bool Update(bool *continuing = NULL, bool *done = NULL);
 	void EvaluateAllBlocks();
+	/** what the conditions read (SW_*), pending is set if triggers wait to be processed */
+	int GetWakeFlags(bool pending) const;
+	/** checks if any block would run, without running it */
+	bool CanFire();
 private: //Internal Functions
 	Script* CacheScript(ieResRef ResRef, bool AIScript);
 	ResponseBlock* ReadResponseBlock(DataStream* stream);
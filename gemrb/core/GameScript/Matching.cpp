@@ -30,6 +30,9 @@
 #include "Scriptable/Door.h"
 #include "Scriptable/InfoPoint.h"
 
+#include <cstring>
+#include <vector>
+
 namespace GemRB {
 
 /* return a Targets object with a single scriptable inside */
@@ -131,6 +134,110 @@ static inline bool DoObjectChecks(Map *map, Scriptable *Sender, Actor *target, i
 	return true;
 }
 
+/* the [x.y.z] IDS scan of EvaluateObject */
+static Targets* EvaluateIDSObject(Map *map, Scriptable* Sender, Object* oC, int ga_flags)
+{
+	Targets *tgts = NULL;
+
+	//we need to get a subset of actors from the large array
+	//if this gets slow, we will need some index tables
+	int i = map->GetActorCount(true);
+	while (i--) {
+		Actor *ac = map->GetActor(i, true);
+		if (!ac) continue; // is this check really needed?
+		// don't return Sender in IDS targeting!
+		// unless it's pst, which relies on it in 3012cut2-3012cut7.bcs
+		// FIXME: do we need more fine-grained control?
+		// FIXME: stop abusing old GF flags
+		if (!core->HasFeature(GF_AREA_OVERRIDE)) {
+			if (ac == Sender) continue;
+		}
+		bool filtered = false;
+		if (DoObjectIDSCheck(oC, ac, &filtered)) {
+			// this is needed so eg. Range trigger gets a good object
+			// HACK: our parsing of Attack([0]) is broken
+			if (!filtered) {
+				// if no filters were applied..
+				assert(!tgts);
+				return NULL;
+			}
+			int dist;
+			if (DoObjectChecks(map, Sender, ac, dist, (ga_flags & GA_DETECT) != 0)) {
+				if (!tgts) tgts = new Targets();
+				tgts->AddTarget((Scriptable *) ac, dist, ga_flags);
+			}
+		}
+	}
+
+	return tgts;
+}
+
+/* The same object specifiers are usually evaluated over and over by the
+ * response blocks of one script (See([ENEMY]), Range([PC],10) ...), each time
+ * walking every actor of the area with the visibility and LOS checks.
+ * The unfiltered results are memoised for the current sender and map; any
+ * action, actor list change or new tick drops them (InvalidateObjectCache).
+ * Object filters still run on a copy, since they may depend on sender state
+ * that triggers modify. */
+struct ObjectCacheEntry {
+	int fields[MAX_OBJECT_FIELDS];
+	int ga_flags;
+	Targets *tgts;
+};
+
+static std::vector<ObjectCacheEntry> objectCache;
+// by global ID, a freed sender's address may be reused by a new object
+static ieDword cachedSender = 0;
+static const Map *cachedMap = NULL;
+static ieDword cacheHits = 0;
+static ieDword cacheMisses = 0;
+
+void InvalidateObjectCache()
+{
+	for (size_t i = 0; i < objectCache.size(); i++) {
+		delete objectCache[i].tgts;
+	}
+	objectCache.clear();
+	cachedSender = 0;
+	cachedMap = NULL;
+}
+
+void GetObjectCacheStats(ieDword &hits, ieDword &misses, bool reset)
+{
+	hits = cacheHits;
+	misses = cacheMisses;
+	if (reset) {
+		cacheHits = cacheMisses = 0;
+	}
+}
+
+static Targets* CachedIDSObject(Map *map, Scriptable* Sender, Object* oC, int ga_flags)
+{
+	ieDword senderID = Sender ? Sender->GetGlobalID() : 0;
+	if (senderID != cachedSender || map != cachedMap) {
+		InvalidateObjectCache();
+		cachedSender = senderID;
+		cachedMap = map;
+	}
+
+	for (size_t i = 0; i < objectCache.size(); i++) {
+		const ObjectCacheEntry &entry = objectCache[i];
+		if (entry.ga_flags != ga_flags) continue;
+		if (memcmp(entry.fields, oC->objectFields, sizeof(entry.fields))) continue;
+		cacheHits++;
+		return entry.tgts ? new Targets(*entry.tgts) : NULL;
+	}
+
+	cacheMisses++;
+	Targets *tgts = EvaluateIDSObject(map, Sender, oC, ga_flags);
+	ObjectCacheEntry entry;
+	memcpy(entry.fields, oC->objectFields, sizeof(entry.fields));
+	entry.ga_flags = ga_flags;
+	entry.tgts = tgts ? new Targets(*tgts) : NULL;
+	objectCache.push_back(entry);
+	return tgts;
+}
+
 /* returns actors that match the [x.y.z] expression */
 static Targets* EvaluateObject(Map *map, Scriptable* Sender, Object* oC, int ga_flags)
 {
@@ -191,39 +298,7 @@ static Targets* EvaluateObject(Map *map, Scriptable* Sender, Object* oC, int ga_
 		return NULL;
 	}
 
-	Targets *tgts = NULL;
-
-	//we need to get a subset of actors from the large array
-	//if this gets slow, we will need some index tables
-	int i = map->GetActorCount(true);
-	while (i--) {
-		Actor *ac = map->GetActor(i, true);
-		if (!ac) continue; // is this check really needed?
-		// don't return Sender in IDS targeting!
-		// unless it's pst, which relies on it in 3012cut2-3012cut7.bcs
-		// FIXME: do we need more fine-grained control?
-		// FIXME: stop abusing old GF flags
-		if (!core->HasFeature(GF_AREA_OVERRIDE)) {
-			if (ac == Sender) continue;
-		}
-		bool filtered = false;
-		if (DoObjectIDSCheck(oC, ac, &filtered)) {
-			// this is needed so eg. Range trigger gets a good object
-			// HACK: our parsing of Attack([0]) is broken
-			if (!filtered) {
-				// if no filters were applied..
-				assert(!tgts);
-				return NULL;
-			}
-			int dist;
-			if (DoObjectChecks(map, Sender, ac, dist, (ga_flags & GA_DETECT) != 0)) {
-				if (!tgts) tgts = new Targets();
-				tgts->AddTarget((Scriptable *) ac, dist, ga_flags);
-			}
-		}
-	}
-
-	return tgts;
+	return CachedIDSObject(map, Sender, oC, ga_flags);
 }
 
 Targets* GetAllObjects(Map *map, Scriptable* Sender, Object* oC, int ga_flags)
@@ -48,6 +48,10 @@ bool MatchActor(Scriptable *Sender, ieDword ID, Object* oC);
 int GetObjectCount(Scriptable* Sender, Object* oC);
 int GetObjectLevelCount(Scriptable* Sender, Object* oC);
 
+/* drops the memoised IDS target lists, call whenever the game state may have changed */
+GEM_EXPORT void InvalidateObjectCache();
+GEM_EXPORT void GetObjectCacheStats(ieDword &hits, ieDword &misses, bool reset = false);
+
 }
 
 #endif
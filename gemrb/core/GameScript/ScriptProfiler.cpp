@@ -0,0 +1,205 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ */
+
+#include "GameScript/ScriptProfiler.h"
+
+#include "GameScript/GSUtils.h"
+#include "GameScript/Matching.h"
+
+#include "SymbolMgr.h"
+#include "System/StringBuffer.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#ifndef WIN32
+#include <sys/time.h>
+#include <time.h>
+#endif
+
+namespace GemRB {
+
+typedef std::map<std::string, ScriptStats> ScriptStatsMap;
+
+static ScriptStatsMap scriptStats;
+static ProfileStats triggerStats[MAX_TRIGGERS];
+static ProfileStats actionStats[MAX_ACTIONS];
+
+struct ProfileRow {
+	std::string name;
+	ProfileStats stats;
+
+	ProfileRow(const std::string &name, const ProfileStats &stats)
+		: name(name), stats(stats) {}
+	bool operator<(const ProfileRow &other) const
+	{
+		return stats.time > other.stats.time;
+	}
+};
+
+void ScriptProfiler::Enable(bool enable)
+{
+	if (enable) {
+		if (!(InDebug&ID_PROFILE)) {
+			Reset();
+		}
+		InDebug |= ID_PROFILE;
+	} else {
+		InDebug &= ~ID_PROFILE;
+	}
+}
+
+bool ScriptProfiler::IsEnabled()
+{
+	return (InDebug&ID_PROFILE) != 0;
+}
+
+void ScriptProfiler::Reset()
+{
+	ScriptStatsMap::iterator it;
+	for (it = scriptStats.begin(); it != scriptStats.end(); ++it) {
+		ScriptStats &stats = it->second;
+		stats.total = ProfileStats();
+		std::fill(stats.blocks.begin(), stats.blocks.end(), ProfileStats());
+	}
+	std::fill(triggerStats, triggerStats + MAX_TRIGGERS, ProfileStats());
+	std::fill(actionStats, actionStats + MAX_ACTIONS, ProfileStats());
+
+	ieDword hits, misses;
+	GetObjectCacheStats(hits, misses, true);
+}
+
+ScriptStats *ScriptProfiler::GetScriptStats(const ieResRef resref)
+{
+	return &scriptStats[resref];
+}
+
+ProfileStats *ScriptProfiler::GetTriggerStats(unsigned short triggerID)
+{
+	return &triggerStats[triggerID];
+}
+
+ProfileStats *ScriptProfiler::GetActionStats(unsigned short actionID)
+{
+	return &actionStats[actionID];
+}
+
+unsigned __int64 ScriptProfiler::Now()
+{
+#ifdef WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER count;
+
+	if (!frequency.QuadPart) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&count);
+	//split it, so the multiplication can't overflow on long uptimes
+	unsigned __int64 seconds = count.QuadPart / frequency.QuadPart;
+	unsigned __int64 rest = count.QuadPart % frequency.QuadPart;
+	return seconds * 1000000 + rest * 1000000 / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned __int64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	//no monotonic clock (old OS X), a wall clock step may skew a sample
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned __int64) tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+static void DumpRows(StringBuffer &buffer, const char *title, std::vector<ProfileRow> &rows, unsigned int limit)
+{
+	std::sort(rows.begin(), rows.end());
+	if (limit && rows.size() > limit) {
+		rows.erase(rows.begin() + limit, rows.end());
+	}
+
+	buffer.appendFormatted("%s\n", title);
+	buffer.appendFormatted("  %-40s %10s %12s %10s\n", "Name", "Calls", "Total (ms)", "Avg (us)");
+	for (size_t i = 0; i < rows.size(); i++) {
+		const ProfileStats &stats = rows[i].stats;
+		buffer.appendFormatted("  %-40s %10u %12.3f %10.2f\n", rows[i].name.c_str(),
+			(unsigned int) stats.calls, stats.time / 1000.0, (double) stats.time / stats.calls);
+	}
+}
+
+static std::string SymbolName(Holder<SymbolMgr> table, int id, int altID)
+{
+	const char *name = NULL;
+	if (table) {
+		name = table->GetValue(id);
+		if (!name) {
+			name = table->GetValue(altID);
+		}
+	}
+	char tmp[16];
+	if (!name) {
+		snprintf(tmp, sizeof(tmp), "0x%04x", id);
+		name = tmp;
+	}
+	return name;
+}
+
+void ScriptProfiler::Dump(StringBuffer &buffer, unsigned int limit)
+{
+	std::vector<ProfileRow> rows;
+	std::vector<ProfileRow> blockRows;
+	char tmp[48];
+
+	ScriptStatsMap::const_iterator it;
+	for (it = scriptStats.begin(); it != scriptStats.end(); ++it) {
+		const ScriptStats &stats = it->second;
+		if (stats.total.calls) {
+			rows.push_back(ProfileRow(it->first, stats.total));
+		}
+		for (size_t i = 0; i < stats.blocks.size(); i++) {
+			if (!stats.blocks[i].calls) continue;
+			snprintf(tmp, sizeof(tmp), "%s #%d", it->first.c_str(), (int) i);
+			blockRows.push_back(ProfileRow(tmp, stats.blocks[i]));
+		}
+	}
+	DumpRows(buffer, "Scripts:", rows, limit);
+	DumpRows(buffer, "Response blocks (conditions):", blockRows, limit);
+
+	rows.clear();
+	for (int i = 0; i < MAX_TRIGGERS; i++) {
+		if (!triggerStats[i].calls) continue;
+		rows.push_back(ProfileRow(SymbolName(triggersTable, i, i|0x4000), triggerStats[i]));
+	}
+	DumpRows(buffer, "Triggers:", rows, limit);
+
+	rows.clear();
+	for (int i = 0; i < MAX_ACTIONS; i++) {
+		if (!actionStats[i].calls) continue;
+		rows.push_back(ProfileRow(SymbolName(actionsTable, i, i), actionStats[i]));
+	}
+	DumpRows(buffer, "Actions:", rows, limit);
+
+	ieDword hits, misses;
+	GetObjectCacheStats(hits, misses);
+	buffer.appendFormatted("Object matching cache: %u hits, %u misses\n",
+		(unsigned int) hits, (unsigned int) misses);
+}
+
+}
@@ -0,0 +1,102 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ */
+
+/**
+ * @file ScriptProfiler.h
+ * Call counts and run times of game scripts, triggers and actions
+ * @author The GemRB Project
+ */
+
+#ifndef SCRIPTPROFILER_H
+#define SCRIPTPROFILER_H
+
+#include "exports.h"
+#include "ie_types.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace GemRB {
+
+class StringBuffer;
+
+struct ProfileStats {
+	ieDword calls;
+	unsigned __int64 time; // in microseconds
+
+	ProfileStats() : calls(0), time(0) {}
+};
+
+struct ScriptStats {
+	ProfileStats total;
+	// condition evaluation of each response block
+	std::vector<ProfileStats> blocks;
+
+	ProfileStats *GetBlock(size_t idx)
+	{
+		if (idx >= blocks.size()) {
+			blocks.resize(idx + 1);
+		}
+		return &blocks[idx];
+	}
+};
+
+/**
+ * @class ScriptProfiler
+ * Collects statistics while the ID_PROFILE script debug flag is set.
+ * The entries are never freed, only zeroed on reset, so callers may hold on
+ * to the returned pointers.
+ */
+class GEM_EXPORT ScriptProfiler {
+public:
+	static void Enable(bool enable);
+	static bool IsEnabled();
+	static void Reset();
+	/** prints the most expensive entries of each category, sorted by time */
+	static void Dump(StringBuffer &buffer, unsigned int limit);
+
+	static ScriptStats *GetScriptStats(const ieResRef resref);
+	static ProfileStats *GetTriggerStats(unsigned short triggerID);
+	static ProfileStats *GetActionStats(unsigned short actionID);
+
+	/** a monotonic clock in microseconds */
+	static unsigned __int64 Now();
+};
+
+/** adds the lifetime of the object to the passed stats, does nothing on NULL */
+class ProfileTimer {
+public:
+	ProfileTimer(ProfileStats *stats)
+		: stats(stats), start(stats ? ScriptProfiler::Now() : 0) {}
+	~ProfileTimer()
+	{
+		if (stats) {
+			stats->calls++;
+			stats->time += ScriptProfiler::Now() - start;
+		}
+	}
+private:
+	ProfileStats *stats;
+	unsigned __int64 start;
+};
+
+}
+
+#endif
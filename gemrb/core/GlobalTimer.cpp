@@ -33,6 +33,9 @@ GlobalTimer::GlobalTimer(void)
 {
 	//AI_UPDATE_TIME: how many AI updates in a second
 	interval = ( 1000 / AI_UPDATE_TIME );
+	lastFrameTime = sampleStart = 0;
+	sampleFrames = sampleTicks = sampleMax = 0;
+	memset(&stats, 0, sizeof(stats));
 	Init();
 }
 
@@ -54,6 +57,7 @@ void GlobalTimer::Init()
 	shakeX = shakeY = 0;
 	shakeCounter = 0;
 	startTime = 0; //forcing an update
+	frozen = false;
 	speed = 0;
 	ClearAnimations();
 }
@@ -64,6 +68,8 @@ void GlobalTimer::Freeze()
 	unsigned long advance;
 
 	UpdateAnimations(true);
+	// nothing moves, so draw everything at its real position
+	frozen = true;
 
 	thisTime = GetTickCount();
 	advance = thisTime - startTime;
@@ -151,7 +157,7 @@ void GlobalTimer::DoStep(int count)
 	video->MoveViewportTo(x,y);
 }
 
-bool GlobalTimer::Update()
+unsigned int GlobalTimer::Update()
 {
 	Map *map;
 	Game *game;
@@ -167,48 +173,118 @@ bool GlobalTimer::Update()
 
 	thisTime = GetTickCount();
 
-	if (!startTime) {
+	if (!startTime || frozen) {
 		startTime = thisTime;
-		return false;
+		frozen = false;
+		return 0;
 	}
 
 	advance = thisTime - startTime;
 	if ( advance < interval) {
-		return false;
+		return 0;
 	}
 	ieDword count = advance/interval;
+	if (count > MAX_CATCHUP_TICKS) {
+		// we fell too far behind, rather slow the game down than freeze it
+		stats.droppedTicks += count - MAX_CATCHUP_TICKS;
+		count = MAX_CATCHUP_TICKS;
+		startTime = thisTime;
+	} else {
+		// keep the remainder, so slow frames are made up for later
+		startTime += count * interval;
+	}
+	sampleTicks += count;
+
 	DoStep(count);
 	DoFadeStep(count);
 	if (!gc) {
-		goto end;
+		return count;
 	}
 	game = core->GetGame();
 	if (!game) {
-		goto end;
+		return count;
 	}
 	map = game->GetCurrentArea();
-	if (!map) {
-		goto end;
+	if (map && !(gc->GetDialogueFlags()&DF_IN_DIALOG)) {
+		map->UpdateFog();
 	}
+	return count;
+}
+
+void GlobalTimer::AdvanceTick()
+{
+	Game *game = core->GetGame();
+	GameControl *gc = core->GetGameControl();
+	if (!game || !gc) {
+		return;
+	}
+	Map *map = game->GetCurrentArea();
 	//do spell effects expire in dialogs?
 	//if yes, then we should remove this condition
-	if (!(gc->GetDialogueFlags()&DF_IN_DIALOG) ) {
-		map->UpdateFog();
+	if (map && !(gc->GetDialogueFlags()&DF_IN_DIALOG) ) {
 		map->UpdateEffects();
-		if (thisTime) {
-			//this measures in-world time (affected by effects, actions, etc)
-			game->AdvanceTime(1);
-		}
+		//this measures in-world time (affected by effects, actions, etc)
+		game->AdvanceTime(1);
 	}
 	//this measures time spent in the game (including pauses)
-	if (thisTime) {
-		game->RealTime++;
+	game->RealTime++;
+}
+
+unsigned long GlobalTimer::GetTickProgress() const
+{
+	if (frozen || !startTime) {
+		return interval;
 	}
-end:
-	startTime = thisTime;
-	return true;
+	unsigned long progress = GetTickCount() - startTime;
+	if (progress > interval) {
+		return interval;
+	}
+	return progress;
+}
+
+Point GlobalTimer::Interpolate(const Point &from, const Point &to) const
+{
+	int dx = to.x - from.x;
+	int dy = to.y - from.y;
+	if (!dx && !dy) {
+		return to;
+	}
+	if (abs(dx) > MAX_INTERPOLATION_DISTANCE || abs(dy) > MAX_INTERPOLATION_DISTANCE) {
+		return to;
+	}
+	long progress = (long) GetTickProgress();
+	Point p;
+	p.x = (short) (from.x + dx * progress / (long) interval);
+	p.y = (short) (from.y + dy * progress / (long) interval);
+	return p;
 }
 
+void GlobalTimer::FrameDone()
+{
+	unsigned long thisTime = GetTickCount();
+
+	if (lastFrameTime) {
+		unsigned long frameTime = thisTime - lastFrameTime;
+		if (frameTime > sampleMax) {
+			sampleMax = frameTime;
+		}
+		sampleFrames++;
+	} else {
+		sampleStart = thisTime;
+	}
+	lastFrameTime = thisTime;
+
+	unsigned long elapsed = thisTime - sampleStart;
+	if (elapsed < 1000 || !sampleFrames) {
+		return;
+	}
+	stats.fps = sampleFrames * 1000.0 / elapsed;
+	stats.avgFrameTime = (double) elapsed / sampleFrames;
+	stats.maxFrameTime = sampleMax;
+	stats.ticks = sampleTicks;
+	sampleStart = thisTime;
+	sampleFrames = sampleTicks = sampleMax = 0;
+}
 
 void GlobalTimer::DoFadeStep(ieDword count) {
 	Video *video = core->GetVideoDriver();
@@ -37,11 +37,34 @@ struct AnimationRef
 	unsigned long  time;
 };
 
+// the most game ticks we will simulate in a single frame to catch up,
+// anything beyond this is dropped (eg. after a breakpoint or a long load)
+#define MAX_CATCHUP_TICKS 5
+// larger moves during a tick are jumps, which we don't smooth
+#define MAX_INTERPOLATION_DISTANCE 64
+
+/** rendering statistics, refreshed about once a second for the fps overlay */
+struct FrameStats
+{
+	double fps;
+	double avgFrameTime; // in ms
+	unsigned long maxFrameTime; // slowest frame of the last sample window
+	unsigned long ticks; // game ticks simulated in the last sample window
+	unsigned long droppedTicks; // total ticks thrown away by the catch-up limit
+};
+
 
 class GEM_EXPORT GlobalTimer {
 private:
 	unsigned long startTime;
 	unsigned long interval;
+	bool frozen;
+
+	// frame time accounting
+	unsigned long lastFrameTime;
+	unsigned long sampleStart;
+	unsigned long sampleFrames, sampleTicks, sampleMax;
+	FrameStats stats;
 
 	int fadeToCounter, fadeToMax;
 	int fadeFromCounter, fadeFromMax;
@@ -63,7 +86,18 @@ public:
 public:
 	void Init();
 	void Freeze();
-	bool Update();
+	/** returns the number of fixed length game ticks that are due */
+	unsigned int Update();
+	/** advances the world time by one game tick */
+	void AdvanceTick();
+	/** how far we are into the current tick, from 0 to interval */
+	unsigned long GetTickProgress() const;
+	unsigned long GetTickInterval() const { return interval; }
+	/** returns the point between the positions before and after the last tick */
+	Point Interpolate(const Point &from, const Point &to) const;
+	/** records a finished frame for the statistics */
+	void FrameDone();
+	const FrameStats& GetFrameStats() const { return stats; }
 	bool ViewportIsMoving();
 	void DoStep(int count);
 	void SetMoveViewPort(ieDword x, ieDword y, int spd, bool center);
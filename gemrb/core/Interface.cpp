@@ -51,6 +51,7 @@
 #include "ItemMgr.h"
 #include "KeyMap.h"
 #include "MapMgr.h"
+#include "MemoryPool.h"
 #include "MoviePlayer.h"
 #include "MusicMgr.h"
 #include "Palette.h"
@@ -85,6 +86,8 @@
 #include "RNG/RNG_SFMT.h"
 #include "Scriptable/Container.h"
 #include "System/FileStream.h"
+#include "System/Logger/MessageWindowLogger.h"
+#include "System/MemoryStream.h"
 #include "System/VFS.h"
 #include "System/StringBuffer.h"
 
@@ -92,6 +95,7 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <vector>
 
 namespace GemRB {
@@ -172,7 +176,6 @@ Interface::Interface()
 	pal256 = NULL;
 
 	GUIEnhancements = 0;
-	UseCorruptedHack = false;
 
 	CursorCount = 0;
 	Cursors = NULL;
@@ -192,9 +195,11 @@ Interface::Interface()
 #endif
 	SkipIntroVideos = false;
 	DrawFPS = false;
+	MaxFPS = 30;
 	TouchScrollAreas = false;
 	UseSoftKeyboard = false;
 	KeepCache = false;
+	MovieBenchmark = false;
 	NumFingInfo = 2;
 	NumFingKboard = 3;
 	NumFingScroll = 2;
@@ -321,6 +326,10 @@ void Interface::FreeResRefTable(ieResRef *&table, int &count)
 
 Interface::~Interface(void)
 {
+	//let a save still being written finish, it needs the plugins
+	if (sgiterator) {
+		sgiterator->FinishSave(true);
+	}
 	DragItem(NULL,NULL);
 	delete AreaAliasTable;
 
@@ -456,14 +465,20 @@ Interface::~Interface(void)
 	Map::ReleaseMemory();
 	Actor::ReleaseMemory();
 
+	if (KeepCache) {
+		gamedata->SaveAllAreas();
+	}
 	gamedata->ClearCaches();
 	delete gamedata;
 	gamedata = NULL;
+	//everything holding effects and script objects is gone by now
+	MemoryPool::CheckLeaks();
 
 	// Removing all stuff from Cache, except bifs
 	if (!KeepCache) DelTree((const char *) CachePath, true);
 
 	AudioDriver.release();
+	PCMCache::Clear();
 	video.release();
 }
 
@@ -978,12 +993,9 @@ void Interface::Main()
 
 	Font* fps = GetTextFont();
 	// TODO: if we ever want to support dynamic resolution changes this will break
-	const Region fpsRgn( 0, Height - 30, 100, 30 );
-	wchar_t fpsstring[20] = {L"???.??? fps"};
+	const Region fpsRgn( 0, Height - 30, 200, 30 );
+	wchar_t fpsstring[40] = {L"???.??? fps"};
 
-	unsigned long frame = 0, time, timebase;
-	timebase = GetTickCount();
-	double frames = 0.0;
 	Palette* palette = new Palette( ColorWhite, ColorBlack );
 	do {
 		//don't change script when quitting is pending
@@ -998,16 +1010,18 @@ void Interface::Main()
 		HandleGUIBehaviour();
 
 		GameLoop();
+		// create a few of the prefetched animations, the rest waits for the next frame
+		gamedata->ProcessLoadedResources(4);
+		// report a save once it is on disk
+		sgiterator->FinishSave(false);
+		// show the queued messages in the message window
+		FlushMessageWindowLogger();
 		DrawWindows(true);
+		timer->FrameDone();
 		if (DrawFPS) {
-			frame++;
-			time = GetTickCount();
-			if (time - timebase > 1000) {
-				frames = ( frame * 1000.0 / ( time - timebase ) );
-				timebase = time;
-				frame = 0;
-				swprintf(fpsstring, sizeof(fpsstring)/sizeof(fpsstring[0]), L"%.3f fps", frames);
-			}
+			const FrameStats& stats = timer->GetFrameStats();
+			swprintf(fpsstring, sizeof(fpsstring)/sizeof(fpsstring[0]), L"%.3f fps %.1f/%lu ms %lu tps",
+				stats.fps, stats.avgFrameTime, stats.maxFrameTime, stats.ticks);
 			video->DrawRect( fpsRgn, ColorBlack );
 			fps->Print( fpsRgn, String(fpsstring), palette,
 					   IE_FONT_ALIGN_LEFT | IE_FONT_ALIGN_MIDDLE | IE_FONT_SINGLE_LINE );
@@ -1190,7 +1204,6 @@ int Interface::LoadSprites()
 
 int Interface::LoadFonts()
 {
-	Log(MESSAGE, "Core", "Loading Fonts...");
 	AutoTable tab("fonts");
 	if (!tab) {
 		Log(ERROR, "Core", "Cannot find fonts.2da.");
@@ -1253,6 +1266,59 @@ int Interface::LoadFonts()
 	return GEM_OK;
 }
 
+/* the tables read by the phases of Init, roughly in order */
+static const char *StartupTables[] = {
+	"strings", "itemtype", "slottype", "itemdata", "randitem",
+	"strmod", "strmodex", "intmod", "hpconbon", "lorebon", "dexmod", "chrmodst", "wisxpbon",
+	"reputati", "wmaplay", "gametime", "splspec", "wildmag", "dmgtypes", "modal", "script"
+};
+
+/* remembers how long each phase of Init took, for ReportStartupPhases */
+struct StartupPhaseTime {
+	const char *name;
+	unsigned long time;
+
+	bool operator<(const StartupPhaseTime &other) const
+	{
+		return time > other.time;
+	}
+};
+
+static std::vector<StartupPhaseTime> startupPhases;
+static unsigned long startupPhaseStart = 0;
+
+// ends the running phase and starts a new one, unless name is NULL
+static void StartupPhase(const char *name)
+{
+	unsigned long now = GetTickCount();
+	if (!startupPhases.empty()) {
+		startupPhases.back().time = now - startupPhaseStart;
+	}
+	startupPhaseStart = now;
+	if (!name) return;
+
+	Log(MESSAGE, "Core", "%s", name);
+	StartupPhaseTime phase = { name, 0 };
+	startupPhases.push_back(phase);
+}
+
+static void ReportStartupPhases()
+{
+	unsigned long total = 0;
+	for (size_t i = 0; i < startupPhases.size(); i++) {
+		total += startupPhases[i].time;
+	}
+	std::sort(startupPhases.begin(), startupPhases.end());
+
+	StringBuffer buffer;
+	buffer.appendFormatted("Startup took %lu ms, the slowest phases were:", total);
+	for (size_t i = 0; i < startupPhases.size() && i < 8; i++) {
+		buffer.appendFormatted("\n  %6lu ms  %s", startupPhases[i].time, startupPhases[i].name);
+	}
+	Log(MESSAGE, "Core", buffer);
+	startupPhases.clear();
+}
+
 int Interface::Init(InterfaceConfig* config)
 {
 	if (!config) {
@@ -1263,7 +1329,7 @@ int Interface::Init(InterfaceConfig* config)
 	plugin_flags = new Variables();
 	plugin_flags->SetType( GEM_VARIABLES_INT );
 
-	Log(MESSAGE, "Core", "Initializing the Event Manager...");
+	StartupPhase("Initializing the Event Manager...");
 	evntmgr = new EventMgr();
 
 	lists = new Variables();
@@ -1288,6 +1354,7 @@ int Interface::Init(InterfaceConfig* config)
 			var ( atoi( value ) ); \
 		value = NULL;
 
+	CONFIG_INT("AreaCacheSize", gamedata->SetAreaCacheSize);
 	CONFIG_INT("Bpp", Bpp =);
 	vars->SetAt("BitsPerPixel", Bpp); //put into vars so that reading from game.ini wont overwrite
 	CONFIG_INT("CaseSensitive", CaseSensitive =);
@@ -1303,9 +1370,12 @@ int Interface::Init(InterfaceConfig* config)
 	CONFIG_INT("TouchScrollAreas", TouchScrollAreas = );
 	CONFIG_INT("Height", Height = );
 	CONFIG_INT("KeepCache", KeepCache = );
+	CONFIG_INT("MaxFPS", MaxFPS = );
 	CONFIG_INT("MaxPartySize", MaxPartySize = );
+	CONFIG_INT("MovieBenchmark", MovieBenchmark = );
 	vars->SetAt("MaxPartySize", MaxPartySize); // for simple GUIScript access
 	CONFIG_INT("MultipleQuickSaves", MultipleQuickSaves = );
+	CONFIG_INT("PCMCacheSize", PCMCache::SetSize);
 	CONFIG_INT("RepeatKeyDelay", evntmgr->SetRKDelay);
 	CONFIG_INT("SaveAsOriginal", SaveAsOriginal = );
 	CONFIG_INT("ScriptDebugMode", SetScriptDebugMode);
@@ -1445,7 +1515,7 @@ int Interface::Init(InterfaceConfig* config)
 	}
 	if (!KeepCache) DelTree((const char *) CachePath, false);
 
-	Log(MESSAGE, "Core", "Starting Plugin Manager...");
+	StartupPhase("Starting Plugin Manager...");
 	PluginMgr *plugin = PluginMgr::Get();
 #if TARGET_OS_MAC
 	// search the bundle plugins first
@@ -1466,7 +1536,7 @@ int Interface::Init(InterfaceConfig* config)
 	plugin->RunInitializers();
 
 	Log(MESSAGE, "Core", "GemRB Core Initialization...");
-	Log(MESSAGE, "Core", "Initializing Video Driver...");
+	StartupPhase("Initializing Video Driver...");
 	video = ( Video * ) PluginMgr::Get()->GetDriver(&Video::ID, VideoDriverName.c_str());
 	if (!video) {
 		Log(FATAL, "Core", "No Video Driver Available.");
@@ -1494,7 +1564,7 @@ int Interface::Init(InterfaceConfig* config)
 	SetInfoTextColor(defcolor);
 
 	{
-		Log(MESSAGE, "Core", "Initializing Search Path...");
+		StartupPhase("Initializing Search Path...");
 		if (!IsAvailable( PLUGIN_RESOURCE_DIRECTORY )) {
 			Log(FATAL, "Core", "no DirectoryImporter!");
 			return GEM_ERROR;
@@ -1566,7 +1636,7 @@ int Interface::Init(InterfaceConfig* config)
 	}
 
 	{
-		Log(MESSAGE, "Core", "Initializing KEY Importer...");
+		StartupPhase("Initializing KEY Importer...");
 		char ChitinPath[_MAX_PATH];
 		PathJoin( ChitinPath, GamePath, "chitin.key", NULL );
 		if (!gamedata->AddSource(ChitinPath, "chitin.key", PLUGIN_RESOURCE_KEY)) {
@@ -1575,7 +1645,7 @@ int Interface::Init(InterfaceConfig* config)
 		}
 	}
 
-	Log(MESSAGE, "Core", "Initializing GUI Script Engine...");
+	StartupPhase("Initializing GUI Script Engine...");
 	guiscript = PluginHolder<ScriptEngine>(IE_GUI_SCRIPT_CLASS_ID);
 	if (guiscript == NULL) {
 		Log(FATAL, "Core", "Missing GUI Script Engine.");
@@ -1599,7 +1669,12 @@ int Interface::Init(InterfaceConfig* config)
 	// Purposely add the font directory last since we will only ever need it at engine load time.
 	if (CustomFontPath[0]) gamedata->AddSource(CustomFontPath, "CustomFonts", PLUGIN_RESOURCE_DIRECTORY);
 
-	Log(MESSAGE, "Core", "Reading Game Options...");
+	// the search path is complete, so the loader threads can parse the
+	// tables of the later phases while the ones in between run
+	StartupPhase("Prefetching startup tables...");
+	gamedata->PrefetchTables(StartupTables, sizeof(StartupTables) / sizeof(StartupTables[0]));
+
+	StartupPhase("Reading Game Options...");
 	if (!LoadGemRBINI()) {
 		Log(FATAL, "Core", "Cannot Load INI.");
 		return GEM_ERROR;
@@ -1638,24 +1713,24 @@ int Interface::Init(InterfaceConfig* config)
 	}
 	GameNameResRef[i] = 0;
 
-	Log(MESSAGE, "Core", "Reading Encoding Table...");
+	StartupPhase("Reading Encoding Table...");
 	if (!LoadEncoding()) {
 		Log(ERROR, "Core", "Cannot Load Encoding.");
 	}
 
-	Log(MESSAGE, "Core", "Creating Projectile Server...");
+	StartupPhase("Creating Projectile Server...");
 	projserv = new ProjectileServer();
 	if (!projserv->GetHighestProjectileNumber()) {
 		Log(ERROR, "Core", "No projectiles are available...");
 	}
 
-	Log(MESSAGE, "Core", "Checking for Dialogue Manager...");
+	StartupPhase("Checking for Dialogue Manager...");
 	if (!IsAvailable( IE_TLK_CLASS_ID )) {
 		Log(FATAL, "Core", "No TLK Importer Available.");
 		return GEM_ERROR;
 	}
 	strings = PluginHolder<StringMgr>(IE_TLK_CLASS_ID);
-	Log(MESSAGE, "Core", "Loading Dialog.tlk file...");
+	StartupPhase("Loading Dialog.tlk file...");
 	char strpath[_MAX_PATH];
 	PathJoin(strpath, GamePath, "dialog.tlk", NULL);
 	FileStream* fs = FileStream::OpenFile(strpath);
@@ -1668,7 +1743,7 @@ int Interface::Init(InterfaceConfig* config)
 	// does the language use an extra tlk?
 	if (strings->HasAltTLK()) {
 		strings2 = PluginHolder<StringMgr>(IE_TLK_CLASS_ID);
-		Log(MESSAGE, "Core", "Loading DialogF.tlk file...");
+		StartupPhase("Loading DialogF.tlk file...");
 		char strpath[_MAX_PATH];
 		PathJoin(strpath, GamePath, "dialogf.tlk", NULL);
 		FileStream* fs = FileStream::OpenFile(strpath);
@@ -1682,7 +1757,7 @@ int Interface::Init(InterfaceConfig* config)
 	}
 
 	{
-		Log(MESSAGE, "Core", "Loading Palettes...");
+		StartupPhase("Loading Palettes...");
 		ResourceHolder<ImageMgr> pal16im(Palette16);
 		if (pal16im)
 			pal16 = pal16im->GetImage();
@@ -1704,31 +1779,33 @@ int Interface::Init(InterfaceConfig* config)
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Initializing stock sounds...");
+	StartupPhase("Initializing stock sounds...");
 	DSCount = ReadResRefTable ("defsound", DefSound);
 	if (DSCount == 0) {
 		Log(FATAL, "Core", "Cannot find defsound.2da.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Broadcasting Event Manager...");
+	StartupPhase("Broadcasting Event Manager...");
 	video->SetEventMgr( evntmgr );
-	Log(MESSAGE, "Core", "Initializing Window Manager...");
+	StartupPhase("Initializing Window Manager...");
 	windowmgr = PluginHolder<WindowMgr>(IE_CHU_CLASS_ID);
 	if (windowmgr == NULL) {
 		Log(FATAL, "Core", "Failed to load Window Manager.");
 		return GEM_ERROR;
 	}
 
+	StartupPhase("Loading sprites...");
 	int ret = LoadSprites();
 	if (ret) return ret;
 
+	StartupPhase("Loading Fonts...");
 	ret = LoadFonts();
 	if (ret) return ret;
 
 	QuitFlag = QF_CHANGESCRIPT;
 
-	Log(MESSAGE, "Core", "Starting up the Sound Driver...");
+	StartupPhase("Starting up the Sound Driver...");
 	AudioDriver = ( Audio * ) PluginMgr::Get()->GetDriver(&Audio::ID, AudioDriverName.c_str());
 	if (AudioDriver == NULL) {
 		Log(FATAL, "Core", "Failed to load sound driver.");
@@ -1739,7 +1816,7 @@ int Interface::Init(InterfaceConfig* config)
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Allocating SaveGameIterator...");
+	StartupPhase("Allocating SaveGameIterator...");
 	sgiterator = new SaveGameIterator();
 	if (sgiterator == NULL) {
 		Log(FATAL, "Core", "Failed to allocate SaveGameIterator.");
@@ -1751,7 +1828,7 @@ int Interface::Init(InterfaceConfig* config)
 	vars->SetAt( "GUIEnhancements", (unsigned long)GUIEnhancements );
 	vars->SetAt( "TouchScrollAreas", (unsigned long)TouchScrollAreas );
 
-	Log(MESSAGE, "Core", "Initializing Token Dictionary...");
+	StartupPhase("Initializing Token Dictionary...");
 	tokens = new Variables();
 	if (!tokens) {
 		Log(FATAL, "Core", "Failed to allocate Token dictionary.");
@@ -1759,14 +1836,14 @@ int Interface::Init(InterfaceConfig* config)
 	}
 	tokens->SetType( GEM_VARIABLES_STRING );
 
-	Log(MESSAGE, "Core", "Initializing Music Manager...");
+	StartupPhase("Initializing Music Manager...");
 	music = PluginHolder<MusicMgr>(IE_MUS_CLASS_ID);
 	if (!music) {
 		Log(FATAL, "Core", "Failed to load Music Manager.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Loading music list...");
+	StartupPhase("Loading music list...");
 	if (HasFeature( GF_HAS_SONGLIST )) {
 		ret = ReadMusicTable("songlist", 1);
 	} else {
@@ -1781,7 +1858,7 @@ int Interface::Init(InterfaceConfig* config)
 
 	int resdata = HasFeature( GF_RESDATA_INI );
 	if (resdata || HasFeature(GF_SOUNDS_INI) ) {
-		Log(MESSAGE, "Core", "Loading resource data File...");
+		StartupPhase("Loading resource data File...");
 		INIresdata = PluginHolder<DataFileMgr>(IE_INI_CLASS_ID);
 		DataStream* ds = gamedata->GetResource(resdata? "resdata":"sounds", IE_INI_CLASS_ID);
 		if (!INIresdata->Open(ds)) {
@@ -1790,7 +1867,7 @@ int Interface::Init(InterfaceConfig* config)
 	}
 
 	if (HasFeature( GF_HAS_PARTY_INI )) {
-		Log(MESSAGE, "Core", "Loading precreated teams setup...");
+		StartupPhase("Loading precreated teams setup...");
 		INIparty = PluginHolder<DataFileMgr>(IE_INI_CLASS_ID);
 		char tINIparty[_MAX_PATH];
 		PathJoin( tINIparty, GamePath, "Party.ini", NULL );
@@ -1805,7 +1882,7 @@ int Interface::Init(InterfaceConfig* config)
 	}
 
 	if (HasFeature( GF_HAS_BEASTS_INI )) {
-		Log(MESSAGE, "Core", "Loading beasts definition File...");
+		StartupPhase("Loading beasts definition File...");
 		INIbeasts = PluginHolder<DataFileMgr>(IE_INI_CLASS_ID);
 		char tINIbeasts[_MAX_PATH];
 		PathJoin( tINIbeasts, GamePath, "beast.ini", NULL );
@@ -1815,7 +1892,7 @@ int Interface::Init(InterfaceConfig* config)
 			Log(WARNING, "Core", "Failed to load beast definitions.");
 		}
 
-		Log(MESSAGE, "Core", "Loading quests definition File...");
+		StartupPhase("Loading quests definition File...");
 		INIquests = PluginHolder<DataFileMgr>(IE_INI_CLASS_ID);
 		char tINIquests[_MAX_PATH];
 		PathJoin( tINIquests, GamePath, "quests.ini", NULL );
@@ -1829,97 +1906,97 @@ int Interface::Init(InterfaceConfig* config)
 	calendar = NULL;
 	keymap = NULL;
 
-	Log(MESSAGE, "Core", "Bringing up the Global Timer...");
+	StartupPhase("Bringing up the Global Timer...");
 	timer = new GlobalTimer();
 	if (!timer) {
 		Log(FATAL, "Core", "Failed to create global timer.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Initializing effects...");
+	StartupPhase("Initializing effects...");
 	ret = Init_EffectQueue();
 	if (!ret) {
 		Log(FATAL, "Core", "Failed to initialize effects.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Initializing Inventory Management...");
+	StartupPhase("Initializing Inventory Management...");
 	ret = InitItemTypes();
 	if (!ret) {
 		Log(FATAL, "Core", "Failed to initialize inventory.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Initializing string constants...");
+	StartupPhase("Initializing string constants...");
 	displaymsg = new DisplayMessage();
 	if (!displaymsg) {
 		Log(FATAL, "Core", "Failed to initialize string constants.");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Initializing random treasure...");
+	StartupPhase("Initializing random treasure...");
 	ret = ReadRandomItems();
 	if (!ret) {
 		Log(WARNING, "Core", "Failed to initialize random treasure.");
 	}
 
-	Log(MESSAGE, "Core", "Initializing ability tables...");
+	StartupPhase("Initializing ability tables...");
 	ret = ReadAbilityTables();
 	if (!ret) {
 		Log(FATAL, "Core", "Failed to initialize ability tables...");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Reading reputation mod table...");
+	StartupPhase("Reading reputation mod table...");
 	ret = ReadReputationModTable();
 	if (!ret) {
 		Log(WARNING, "Core", "Failed to read reputation mod table.");
 	}
 
 	if ( gamedata->Exists("WMAPLAY", IE_2DA_CLASS_ID) ) {
-		Log(MESSAGE, "Core", "Initializing area aliases...");
+		StartupPhase("Initializing area aliases...");
 		ret = ReadAreaAliasTable( "WMAPLAY" );
 		if (!ret) {
 			Log(WARNING, "Core", "Failed to load area aliases...");
 		}
 	}
 
-	Log(MESSAGE, "Core", "Reading game time table...");
+	StartupPhase("Reading game time table...");
 	ret = ReadGameTimeTable();
 	if (!ret) {
 		Log(FATAL, "Core", "Failed to read game time table...");
 		return GEM_ERROR;
 	}
 
-	Log(MESSAGE, "Core", "Reading special spells table...");
+	StartupPhase("Reading special spells table...");
 	ret = ReadSpecialSpells();
 	if (!ret) {
 		Log(WARNING, "Core", "Failed to load special spells.");
 	}
 
+	StartupPhase("Reading damage type table...");
 	ret = ReadDamageTypeTable();
-	Log(MESSAGE, "Core", "Reading damage type table...");
 	if (!ret) {
-		Log(WARNING, "Core", "Reading damage type table...");
+		Log(WARNING, "Core", "Failed to read damage type table.");
 	}
 
-	Log(MESSAGE, "Core", "Reading modal states table...");
+	StartupPhase("Reading modal states table...");
 	ret = ReadModalStates();
 	if (!ret) {
 		Log(ERROR, "Core", "Failed to modal states table...");
 	}
 
-	Log(MESSAGE, "Core", "Reading game script tables...");
+	StartupPhase("Reading game script tables...");
 	InitializeIEScript();
 
-	Log(MESSAGE, "Core", "Initializing keymap tables...");
+	StartupPhase("Initializing keymap tables...");
 	keymap = new KeyMap();
 	ret = keymap->InitializeKeyMap("keymap.ini", "keymap");
 	if (!ret) {
 		Log(WARNING, "Core", "Failed to initialize keymaps.");
 	}
 
-	Log(MESSAGE, "Core", "Setting up the Console...");
+	StartupPhase("Setting up the Console...");
 	console = new Console(Region(0, 0, Width, 25));
 	Sprite2D* cursor = GetCursorSprite();
 	if (!cursor) {
@@ -1927,7 +2004,9 @@ int Interface::Init(InterfaceConfig* config)
 	} else
 		console->SetCursor (cursor);
 
+	StartupPhase(NULL);
 	Log(MESSAGE, "Core", "Core Initialization Complete!");
+	ReportStartupPhases();
 	return GEM_OK;
 }
 
@@ -2962,14 +3041,16 @@ void Interface::GameLoop(void)
 		update_scripts = !(gc->GetDialogueFlags() & DF_FREEZE_SCRIPTS);
 	}
 
-	bool do_update = GSUpdate(update_scripts);
+	unsigned int ticks = GSUpdate(update_scripts);
 
 	if (game) {
 		if ( gc && (game->selected.size() > 0) ) {
 			gc->ChangeMap(GetFirstSelectedPC(true), false);
 		}
 		//in multi player (if we ever get to it), only the server must call this
-		if (do_update) {
+		//run all the ticks that are due, so a slow frame doesn't slow down the game
+		while (ticks--) {
+			timer->AdvanceTick();
 			// the game object will run the area scripts as well
 			game->UpdateScripts();
 		}
@@ -3715,15 +3796,15 @@ bool Interface::InCutSceneMode() const
 	return false;
 }
 
-/** Updates the Game Script Engine State */
-bool Interface::GSUpdate(bool update_scripts)
+/** Updates the Game Script Engine State, returns the number of ticks to run */
+unsigned int Interface::GSUpdate(bool update_scripts)
 {
 	if(update_scripts) {
 		return timer->Update();
 	}
 	else {
 		timer->Freeze();
-		return false;
+		return 0;
 	}
 }
 
@@ -3795,6 +3876,7 @@ void Interface::LoadGame(SaveGame *sg, int ver_override)
 	WorldMapArray* new_worldmap = NULL;
 
 	LoadProgress(10);
+	gamedata->ClearAreas();
 	if (!KeepCache) DelTree((const char *) CachePath, true);
 	LoadProgress(15);
 
@@ -4405,6 +4487,9 @@ void Interface::RemoveFromCache(const ieResRef resref, SClass_ID ClassID)
 
 	PathJoinExt(filename, CachePath, resref, TypeExt(ClassID));
 	unlink ( filename);
+	if (ClassID == IE_ARE_CLASS_ID) {
+		gamedata->DropArea(resref);
+	}
 }
 
 //this function checks if the path is eligible as a cache
@@ -4859,9 +4944,7 @@ int Interface::GetMouseScrollSpeed() {
 
 ieStrRef Interface::GetRumour(const ieResRef dlgref)
 {
-	PluginHolder<DialogMgr> dm(IE_DLG_CLASS_ID);
-	dm->Open(gamedata->GetResource(dlgref, IE_DLG_CLASS_ID));
-	Dialog *dlg = dm->GetDialog();
+	Dialog *dlg = gamedata->GetDialog(dlgref);
 
 	if (!dlg) {
 		Log(ERROR, "Interface", "Cannot load dialog: %s", dlgref);
@@ -4874,7 +4957,7 @@ ieStrRef Interface::GetRumour(const ieResRef dlgref)
 	if (i>=0 ) {
 		ret = dlg->GetState( i )->StrRef;
 	}
-	delete dlg;
+	gamedata->FreeDialog(dlg, dlgref);
 	return ret;
 }
 
@@ -5045,7 +5128,7 @@ Effect *Interface::GetEffect(const ieResRef resname, int level, const Point &p)
 }
 
 // dealing with saved games
-int Interface::SwapoutArea(Map *map)
+int Interface::SwapoutArea(Map *map, bool toDisk)
 {
 	//refuse to save ambush areas, for example
 	if (map->AreaFlags & AF_NOSAVE) {
@@ -5061,16 +5144,29 @@ int Interface::SwapoutArea(Map *map)
 	}
 	int size = mm->GetStoredFileSize (map);
 	if (size > 0) {
-		//created streams are always autofree (close file on destruct)
-		//this one will be destructed when we return from here
-		FileStream str;
-
-		str.Create( map->GetScriptName(), IE_ARE_CLASS_ID );
-		int ret = mm->PutArea (&str, map);
+		DataStream *str;
+		bool keep = !toDisk && gamedata->KeepsAreas();
+		if (keep) {
+			char name[_MAX_PATH];
+			snprintf(name, sizeof(name), "%s.are", map->GetScriptName());
+			str = new MemoryStream(name, malloc(size), size);
+		} else {
+			FileStream *fs = new FileStream();
+			fs->Create( map->GetScriptName(), IE_ARE_CLASS_ID );
+			str = fs;
+			//an older copy in memory would shadow this one
+			gamedata->DropArea(map->GetScriptName());
+		}
+		int ret = mm->PutArea (str, map);
 		if (ret <0) {
+			delete str;
 			Log(WARNING, "Core", "Area removed: %s",
 				map->GetScriptName());
 			RemoveFromCache(map->GetScriptName(), IE_ARE_CLASS_ID);
+		} else if (keep) {
+			gamedata->StoreArea(map->GetScriptName(), str);
+		} else {
+			delete str;
 		}
 	} else {
 		Log(WARNING, "Core", "Area removed: %s",
@@ -5118,7 +5214,7 @@ int Interface::WriteCharacter(const char *name, Actor *actor)
 	return 0;
 }
 
-int Interface::WriteGame(const char *folder)
+int Interface::WriteGame(DataStream *str)
 {
 	PluginHolder<SaveGameMgr> gm(IE_GAM_CLASS_ID);
 	if (gm == NULL) {
@@ -5127,24 +5223,19 @@ int Interface::WriteGame(const char *folder)
 
 	int size = gm->GetStoredFileSize (game);
 	if (size > 0) {
-		//created streams are always autofree (close file on destruct)
-		//this one will be destructed when we return from here
-		FileStream str;
-
-		str.Create( folder, GameNameResRef, IE_GAM_CLASS_ID );
-		int ret = gm->PutGame (&str, game);
+		int ret = gm->PutGame (str, game);
 		if (ret <0) {
-			Log(WARNING, "Core", "Game cannot be saved: %s", folder);
+			Log(WARNING, "Core", "Game cannot be saved: %s", GameNameResRef);
 			return -1;
 		}
 	} else {
-		Log(WARNING, "Core", "Internal error, game cannot be saved: %s", folder);
+		Log(WARNING, "Core", "Internal error, game cannot be saved: %s", GameNameResRef);
 		return -1;
 	}
 	return 0;
 }
 
-int Interface::WriteWorldMap(const char *folder)
+int Interface::WriteWorldMap(DataStream *str1, DataStream *str2)
 {
 	PluginHolder<WorldMapMgr> wmm(IE_WMP_CLASS_ID);
 	if (wmm == NULL) {
@@ -5167,35 +5258,21 @@ int Interface::WriteWorldMap(const char *folder)
 	if ((size1 < 0) || (size2<0) ) {
 		ret=-1;
 	} else {
-		//created streams are always autofree (close file on destruct)
-		//this one will be destructed when we return from here
-		FileStream str1;
-		FileStream str2;
-
-		str1.Create( folder, WorldMapName[0], IE_WMP_CLASS_ID );
-		if (!worldmap->IsSingle()) {
-			str2.Create( folder, WorldMapName[1], IE_WMP_CLASS_ID );
-		}
-		ret = wmm->PutWorldMap (&str1, &str2, worldmap);
+		ret = wmm->PutWorldMap (str1, str2, worldmap);
 	}
 	if (ret <0) {
-		Log(WARNING, "Core", "Internal error, worldmap cannot be saved: %s", folder);
+		Log(WARNING, "Core", "Internal error, worldmap cannot be saved: %s", WorldMapName[0]);
 		return -1;
 	}
 	return 0;
 }
 
-int Interface::CompressSave(const char *folder)
+int Interface::ReadSaveFiles(std::vector<DataStream*> &files)
 {
-	FileStream str;
-
-	str.Create( folder, GameNameResRef, IE_SAV_CLASS_ID );
 	DirectoryIterator dir(CachePath);
 	if (!dir) {
 		return -1;
 	}
-	PluginHolder<ArchiveImporter> ai(IE_SAV_CLASS_ID);
-	ai->CreateArchive( &str);
 
 	//.tot and .toh should be saved last, because they are updated when an .are is saved
 	int priority=2;
@@ -5212,8 +5289,17 @@ int Interface::CompressSave(const char *folder)
 				FileStream fs;
 				if (!fs.Open(dtmp)) {
 					Log(ERROR, "Interface", "Failed to open \"%s\".", dtmp);
+					continue;
+				}
+				//read it all now, the archive is compressed off the main thread
+				unsigned long size = fs.Size();
+				void *data = malloc(size);
+				if (size && (!data || fs.Read(data, size) != (int) size)) {
+					Log(ERROR, "Interface", "Failed to read \"%s\".", dtmp);
+					free(data);
+					return -1;
 				}
-				ai->AddToSaveGame(&str, &fs);
+				files.push_back(new MemoryStream(dtmp, data, size));
 			}
 		} while (++dir);
 		//reopen list for the second round
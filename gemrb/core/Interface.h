@@ -554,7 +554,7 @@ public:
 	/** returns true if in cutscene mode */
 	bool InCutSceneMode() const;
 	/** Updates the Game Script Engine State */
-	bool GSUpdate(bool update_scripts);
+	unsigned int GSUpdate(bool update_scripts);
 	/** Get the Party INI Interpreter */
 	DataFileMgr * GetPartyINI() const
 	{
@@ -704,15 +704,18 @@ public:
 	int ApplyEffectQueue(EffectQueue *fxqueue, Actor *actor, Scriptable *caster, Point p);
 	Effect *GetEffect(const ieResRef resname, int level, const Point &p);
 	/** dumps an area object to the cache */
-	int SwapoutArea(Map *map);
+	/** saves the area to the cache, in memory unless it is needed on disk */
+	int SwapoutArea(Map *map, bool toDisk = false);
 	/** saves (exports a character to the characters folder */
 	int WriteCharacter(const char *name, Actor *actor);
-	/** saves the game object to the destination folder */
-	int WriteGame(const char *folder);
-	/** saves the worldmap object to the destination folder */
-	int WriteWorldMap(const char *folder);
-	/** saves the .are and .sto files to the destination folder */
-	int CompressSave(const char *folder);
+	/** serialises the game object into the stream */
+	int WriteGame(DataStream *str);
+	/** serialises the worldmap object, the second stream is only used
+	 *  for split worldmaps */
+	int WriteWorldMap(DataStream *str1, DataStream *str2);
+	/** reads the .are and .sto files of the cache in archive order,
+	 *  the caller frees the streams */
+	int ReadSaveFiles(std::vector<DataStream*> &files);
 	/** toggles the pause. returns either PAUSE_ON or PAUSE_OFF to reflect the script state after toggling. */
 	PauseSetting TogglePause();
 	/** returns true the passed pause setting was applied. false otherwise. */
@@ -817,9 +820,10 @@ public:
 	int MouseFeedback;
 	int GUIEnhancements;
 	int MaxPartySize;
+	unsigned int MaxFPS;
 	bool KeepCache;
+	bool MovieBenchmark;
 	bool MultipleQuickSaves;
-	bool UseCorruptedHack;
 
 	Variables *plugin_flags;
 	/** The Main program loop */
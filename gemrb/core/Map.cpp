@@ -47,8 +47,10 @@
 #include "Video.h"
 #include "WorldMap.h"
 #include "strrefs.h"
+#include "voodooconst.h"
 #include "ie_cursors.h"
 #include "GameScript/GSUtils.h"
+#include "GameScript/Matching.h"
 #include "GUI/GameControl.h"
 #include "GUI/Window.h"
 #include "RNG/RNG_SFMT.h"
@@ -56,9 +58,12 @@
 #include "Scriptable/Door.h"
 #include "Scriptable/InfoPoint.h"
 #include "System/StringBuffer.h"
+#include "System/WorkerPool.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <functional>
 
 namespace GemRB {
 
@@ -66,6 +71,13 @@ namespace GemRB {
 
 #define ANI_PRI_BACKGROUND	-9999
 
+//size of the trap and travel region broadphase cells, in pixels
+#define TRIGGER_GRID_CELL 256
+//threads for precomputing the line of sight, besides the main one
+#define MAX_SIGHT_WORKERS 3
+//the cached lines of sight are dropped beyond this many
+#define SIGHT_CACHE_LIMIT 65536
+
 // TODO: fix this hardcoded resource reference
 static ieResRef PortalResRef={"EF03TPR3"};
 static unsigned int PortalTime = 15;
@@ -84,6 +96,8 @@ static Variables Spawns;
 static int LargeFog;
 static TerrainSounds *terrainsounds=NULL;
 static int tsndcount = -1;
+static WorkerPool *sightWorkers = NULL;
+static bool sightWorkersInited = false;
 
 static void ReleaseSpawnGroup(void *poi)
 {
@@ -113,6 +127,9 @@ void Map::ReleaseMemory()
 		delete [] terrainsounds;
 		terrainsounds = NULL;
 	}
+	delete sightWorkers;
+	sightWorkers = NULL;
+	sightWorkersInited = false;
 }
 
 static inline AnimationObjectType SelectObject(Actor *actor, int q, AreaAnimation *a, VEFObject *sca, Particles *spark, Projectile *pro, Container *pile)
@@ -336,6 +353,7 @@ Map::Map(void)
 	SmallMap = NULL;
 	MapSet = NULL;
 	SrchMap = NULL;
+	ActorMap = NULL;
 	Walls = NULL;
 	WallCount = 0;
 	queue[PR_SCRIPT] = NULL;
@@ -349,6 +367,9 @@ Map::Map(void)
 	//Qcount[PR_IGNORE] = 0;
 	lastActorCount[PR_SCRIPT] = 0;
 	lastActorCount[PR_DISPLAY] = 0;
+	triggerGridWidth = triggerGridHeight = 0;
+	triggerTests = triggerTestsSkipped = 0;
+	sightHits = sightMisses = sightPrecomputed = 0;
 	//no one needs this
 	//lastActorCount[PR_IGNORE] = 0;
 	if (!PathFinderInited) {
@@ -378,8 +399,11 @@ Map::~Map(void)
 {
 	unsigned int i;
 
+	InvalidateObjectCache();
+
 	free( MapSet );
 	free( SrchMap );
+	free( ActorMap );
 	free( MaterialMap );
 
 	//close the current container if it was owned by this map, this avoids a crash
@@ -453,6 +477,9 @@ Map::~Map(void)
 		free( Walls );
 	}
 	WallCount=0;
+	for (i = 0; i < pathPool.size(); i++) {
+		delete pathPool[i];
+	}
 }
 
 void Map::ChangeTileMap(Image* lm, Sprite2D* sm)
@@ -480,6 +507,7 @@ void Map::AddTileMap(TileMap* tm, Image* lm, Bitmap* sr, Sprite2D* sm, Bitmap* h
 	//Internal Searchmap
 	int y = sr->GetHeight();
 	SrchMap = (unsigned short *) calloc(Width * Height, sizeof(unsigned short));
+	ActorMap = (SearchMapOccupancy *) calloc(Width * Height, sizeof(SearchMapOccupancy));
 	MaterialMap = (unsigned short *) calloc(Width * Height, sizeof(unsigned short));
 	while(y--) {
 		int x=sr->GetWidth();
@@ -670,8 +698,23 @@ void Map::DrawPortal(InfoPoint *ip, int enable)
 
 void Map::UpdateScripts()
 {
-	bool has_pcs = false;
+	// anything could have happened since the last tick
+	InvalidateObjectCache();
+	// the lines of sight stay valid until the searchmap changes,
+	// but don't let them pile up on busy maps
+	if (sightCache.size() > SIGHT_CACHE_LIMIT) {
+		ClearSightCache();
+	}
+
+	// walking and teleports keep the picking grid current themselves,
+	// this catches the direct position and size changes
 	size_t i=actors.size();
+	while (i--) {
+		UpdateActorIndex(actors[i]);
+	}
+
+	bool has_pcs = false;
+	i=actors.size();
 	while (i--) {
 		if (actors[i]->InParty) {
 			has_pcs = true;
@@ -697,6 +740,11 @@ void Map::UpdateScripts()
 		return;
 	}
 
+	// the scripts below run serially in the usual order, but the lines
+	// of sight their object matching and See() checks need are traced
+	// in parallel here first
+	PrecomputeSight();
+
 	// fuzzie added this check because some area scripts (eg, AR1600 when
 	// escaping Brynnlaw) were executing after they were meant to be done,
 	// and this seems the nicest way of handling that for now - it's quite
@@ -803,6 +851,10 @@ void Map::UpdateScripts()
 	// taking steps.
 	bool more_steps = true;
 	ieDword time = game->Ticks; // make sure everything moves at the same time
+	q=Qcount[PR_SCRIPT];
+	while (q--) {
+		queue[PR_SCRIPT][q]->SavePrevPos(time);
+	}
 	while (more_steps) {
 		more_steps = false;
 
@@ -812,6 +864,8 @@ void Map::UpdateScripts()
 			more_steps = !DoStepForActor(actor, actor->speed, time);
 		}
 	}
+	// distances and LOS of the memoised targets are stale now
+	InvalidateObjectCache();
 
 	//Check if we need to start some door scripts
 	int doorCount = 0;
@@ -832,6 +886,8 @@ void Map::UpdateScripts()
 	}
 
 	//Check if we need to start some trap scripts
+	BuildTriggerGrid();
+	std::vector<int> candidates;
 	int ipCount = 0;
 	while (true) {
 		//For each InfoPoint in the map
@@ -854,10 +910,11 @@ void Map::UpdateScripts()
 		}
 
 		if (wasActive) {
-			q=Qcount[PR_SCRIPT];
 			ieDword exitID = ip->GetGlobalID();
-			while (q--) {
-				Actor* actor = queue[PR_SCRIPT][q];
+			//only the actors near the region, in the usual order
+			GetTriggerCandidates(ip, candidates);
+			for (size_t c = 0; c < candidates.size(); c++) {
+				Actor* actor = queue[PR_SCRIPT][candidates[c]];
 				if (ip->Type == ST_PROXIMITY) {
 					if(ip->Entered(actor)) {
 						//if trap triggered, then mark actor
@@ -876,6 +933,8 @@ void Map::UpdateScripts()
 					//Well, i don't know why is it here, but lets try this
 					if (ip->Entered(actor)) {
 						UseExit(actor, ip);
+						//it moved, so the grid is stale
+						BuildTriggerGrid();
 					}
 				}
 			}
@@ -913,41 +972,66 @@ bool Map::DoStepForActor(Actor *actor, int speed, ieDword time) {
 	}
 
 	bool no_more_steps = true;
-	if (actor->BlocksSearchMap()) {
+	if (!actor->BlocksSearchMap()) {
 		ClearSearchMapFor(actor);
-
-		PathNode * step = actor->GetNextStep();
-		if (step && step->Next) {
+	} else {
+		const Path *path = actor->GetNextStep() ? actor->GetPath() : NULL;
+		if (path && path->HasNext()) {
+			//we shouldn't block ourselves
+			ClearSearchMapFor(actor);
 			//we should actually wait for a short time and check then
-			if (GetBlocked(step->Next->x*16+8,step->Next->y*12+6,actor->size)) {
+			PathNode next = path->GetNext();
+			if (GetBlocked(next.x*16+8,next.y*12+6,actor->size)) {
 				actor->NewPath();
 			}
 		}
 	}
 	if (!(actor->GetBase(IE_STATE_ID)&STATE_CANTMOVE) ) {
 		no_more_steps = actor->DoStep( speed, time );
-		if (actor->BlocksSearchMap()) {
-			BlockSearchMap( actor->Pos, actor->size, actor->IsPartyMember()?PATH_MAP_PC:PATH_MAP_NPC);
-		}
 	}
+	if (actor->BlocksSearchMap()) {
+		BlockSearchMapFor(actor);
+	}
+	UpdateActorIndex(actor);
 
 	return no_more_steps;
 }
 
 void Map::ClearSearchMapFor( Movable *actor ) {
-	Actor** nearActors = GetAllActorsInRadius(actor->Pos, GA_NO_DEAD|GA_NO_LOS|GA_NO_UNSCHEDULED, MAX_CIRCLE_SIZE*2*16);
-	BlockSearchMap( actor->Pos, actor->size, PATH_MAP_FREE);
+	if (!actor->footprintSize) {
+		return;
+	}
+	UpdateOccupancy(actor->footprintPos, actor->footprintSize, actor->footprintValue, -1);
+	actor->footprintSize = 0;
+}
 
-	// Restore the searchmap areas of any nearby actors that could
-	// have been cleared by this BlockSearchMap(..., 0).
-	// (Necessary since blocked areas of actors may overlap.)
-	int i=0;
-	while(nearActors[i]!=NULL) {
-		if(nearActors[i]!=actor && nearActors[i]->BlocksSearchMap())
-			BlockSearchMap( nearActors[i]->Pos, nearActors[i]->size, nearActors[i]->IsPartyMember()?PATH_MAP_PC:PATH_MAP_NPC);
-		++i;
+void Map::BlockSearchMapFor( Movable *actor ) {
+	unsigned int size = actor->size;
+	if (size > MAX_CIRCLESIZE) size = MAX_CIRCLESIZE;
+	if (size < 2) size = 2;
+	unsigned char value = PATH_MAP_NPC;
+	if (actor->Type == ST_ACTOR && ((Actor *) actor)->IsPartyMember()) {
+		value = PATH_MAP_PC;
+	}
+
+	// standing still, nothing to update
+	if (actor->footprintSize == size && actor->footprintValue == value &&
+		actor->footprintPos.x/16 == actor->Pos.x/16 && actor->footprintPos.y/12 == actor->Pos.y/12) {
+		return;
 	}
-	free(nearActors);
+	ClearSearchMapFor(actor);
+	UpdateOccupancy(actor->Pos, size, value, 1);
+	actor->footprintPos = actor->Pos;
+	actor->footprintSize = (unsigned char) size;
+	actor->footprintValue = value;
+}
+
+void Map::UpdateActorIndex( Movable *actor ) {
+	//the rectangle Selectable::IsOver checks before the ellipse
+	int csize = actor->size;
+	if (csize < 2) csize = 2;
+	Region bbox(actor->Pos.x - (csize-1)*16, actor->Pos.y - (csize-1)*12, (csize-1)*32, (csize-1)*24);
+	actorIndex.Update(actor, bbox);
 }
 
 void Map::DrawHighlightables()
@@ -1499,6 +1583,10 @@ void Map::AddActor(Actor* actor, bool init)
 	strnlwrcpy(actor->Area, scriptName, 8);
 	if (!HasActor(actor)) {
 		actors.push_back( actor );
+		UpdateActorIndex(actor);
+		InvalidateObjectCache();
+		//a footprint from another area is meaningless here
+		actor->footprintSize = 0;
 	}
 	if (init) {
 		actor->SetMap(this);
@@ -1546,6 +1634,8 @@ void Map::DeleteActor(int i)
 	}
 	//remove the actor from the area's actor list
 	actors.erase( actors.begin()+i );
+	actorIndex.Remove(actor);
+	InvalidateObjectCache();
 }
 
 Scriptable *Map::GetScriptableByGlobalID(ieDword objectID)
@@ -1640,9 +1730,14 @@ Actor* Map::GetActorByGlobalID(ieDword objectID)
 */
 Actor* Map::GetActor(const Point &p, int flags)
 {
-	size_t i = actors.size();
+	const PickIndex::Cell *cell = actorIndex.Query(p);
+	if (!cell) {
+		return NULL;
+	}
+	//newest first, like the actor list
+	size_t i = cell->size();
 	while (i--) {
-		Actor* actor = actors[i];
+		Actor* actor = (Actor *) (*cell)[i].object;
 
 		if (!actor->IsOver( p ))
 			continue;
@@ -2005,7 +2100,10 @@ unsigned int Map::GetBlocked(unsigned int x, unsigned int y)
 	if (y>=Height || x>=Width) {
 		return 0;
 	}
-	unsigned int ret = SrchMap[y*Width+x];
+	unsigned int pos = y*Width+x;
+	unsigned int ret = SrchMap[pos];
+	if (ActorMap[pos].pc) ret |= PATH_MAP_PC;
+	if (ActorMap[pos].npc) ret |= PATH_MAP_NPC;
 	if (ret&(PATH_MAP_DOOR_IMPASSABLE|PATH_MAP_ACTOR)) {
 		ret&=~PATH_MAP_PASSABLE;
 	}
@@ -2168,7 +2266,13 @@ void Map::GenerateQueues()
 		}
 
 		//we ignore priority 2
-		if (priority>=PR_IGNORE) continue;
+		if (priority>=PR_IGNORE) {
+			//unscheduled actors don't stand in the way
+			if (!actor->Schedule(gametime, false)) {
+				ClearSearchMapFor(actor);
+			}
+			continue;
+		}
 
 		queue[priority][Qcount[priority]] = actor;
 		Qcount[priority]++;
@@ -2349,6 +2453,8 @@ void Map::RemoveActor(Actor* actor)
 			actor->SetMap(NULL);
 			CopyResRef(actor->Area, "");
 			actors.erase( actors.begin()+i );
+			actorIndex.Remove(actor);
+			InvalidateObjectCache();
 			return;
 		}
 	}
@@ -2397,6 +2503,8 @@ void Map::dump(bool show_actors) const
 	buffer.appendFormatted( "Weather: %s\n", YESNO(AreaType & AT_WEATHER ) );
 	buffer.appendFormatted( "Area Type: %d\n", AreaType & (AT_CITY|AT_FOREST|AT_DUNGEON) );
 	buffer.appendFormatted( "Can rest: %s\n", YESNO(AreaType & AT_CAN_REST) );
+	buffer.appendFormatted( "Region checks: %lu done, %lu skipped by the grid\n", triggerTests, triggerTestsSkipped );
+	buffer.appendFormatted( "Line of sight: %lu cached, %lu traced, %lu precomputed\n", sightHits, sightMisses, sightPrecomputed );
 
 	if (show_actors) {
 		buffer.append("\n");
@@ -2547,8 +2655,51 @@ void Map::AdjustPosition(Point &goal, unsigned int radiusx, unsigned int radiusy
 	}
 }
 
+//released paths kept around per map, more would just sit there
+#define PATH_POOL_SIZE 64
+
+static unsigned long pathsAllocated = 0;
+static unsigned long pathsReused = 0;
+static unsigned long pathSteps = 0;
+static unsigned long pathSegments = 0;
+
+Path* Map::AllocatePath()
+{
+	if (pathPool.empty()) {
+		pathsAllocated++;
+		return new Path();
+	}
+	pathsReused++;
+	Path *path = pathPool.back();
+	pathPool.pop_back();
+	return path;
+}
+
+void Map::ReleasePath(Path *path)
+{
+	if (!path) {
+		return;
+	}
+	pathSteps += path->GetLength();
+	pathSegments += path->GetSegmentCount();
+	if (pathPool.size() >= PATH_POOL_SIZE) {
+		delete path;
+		return;
+	}
+	path->Clear();
+	pathPool.push_back(path);
+}
+
+void Map::GetPathStats(unsigned long &allocated, unsigned long &reused, unsigned long &steps, unsigned long &segments)
+{
+	allocated = pathsAllocated;
+	reused = pathsReused;
+	steps = pathSteps;
+	segments = pathSegments;
+}
+
 //run away from dX, dY (ie.: find the best path of limited length that brings us the farthest from dX, dY)
-PathNode* Map::RunAway(const Point &s, const Point &d, unsigned int size, unsigned int PathLen, int flags)
+Path* Map::RunAway(const Point &s, const Point &d, unsigned int size, unsigned int PathLen, int flags)
 {
 	Point start(s.x/16, s.y/12);
 	Point goal (d.x/16, d.y/12);
@@ -2602,23 +2753,19 @@ PathNode* Map::RunAway(const Point &s, const Point &d, unsigned int size, unsign
 	}
 
 	//find path backwards from best to start
-	PathNode* StartNode = new PathNode;
-	PathNode* Return = StartNode;
-	StartNode->Next = NULL;
-	StartNode->x = best.x;
-	StartNode->y = best.y;
+	Path* Return = AllocatePath();
+	PathNode node;
+	node.x = best.x;
+	node.y = best.y;
 	if (flags) {
-		StartNode->orient = GetOrient( start, best );
+		node.orient = GetOrient( start, best );
 	} else {
-		StartNode->orient = GetOrient( best, start );
+		node.orient = GetOrient( best, start );
 	}
+	Return->Append(node);
 	Point p = best;
 	unsigned int pos2 = start.y * Width + start.x;
 	while (( pos = p.y * Width + p.x ) != pos2) {
-		Return = new PathNode;
-		StartNode->Parent = Return;
-		Return->Next = StartNode;
-		StartNode = Return;
 		unsigned int level = MapSet[pos];
 		unsigned int diff = 0;
 		Point n;
@@ -2630,20 +2777,21 @@ PathNode* Map::RunAway(const Point &s, const Point &d, unsigned int size, unsign
 		Leveldown( p.x + 1, p.y + 1, level, n, diff );
 		Leveldown( p.x + 1, p.y - 1, level, n, diff );
 		Leveldown( p.x - 1, p.y - 1, level, n, diff );
-		Return->x = n.x;
-		Return->y = n.y;
+		node.x = n.x;
+		node.y = n.y;
 
 		if (flags) {
-			Return->orient = GetOrient( p, n );
+			node.orient = GetOrient( p, n );
 		} else {
-			Return->orient = GetOrient( n, p );
+			node.orient = GetOrient( n, p );
 		}
+		Return->Append(node);
 		p = n;
 		if (!diff) {
 			break;
 		}
 	}
-	Return->Parent = NULL;
+	Return->Reverse();
 	return Return;
 }
 
@@ -2688,13 +2836,13 @@ bool Map::TargetUnreachable(const Point &s, const Point &d, unsigned int size)
 /* Use this function when you target something by a straight line projectile (like a lightning bolt, arrow, etc)
 */
 
-PathNode* Map::GetLine(const Point &start, const Point &dest, int flags)
+Path* Map::GetLine(const Point &start, const Point &dest, int flags)
 {
 	int Orientation = GetOrient(start, dest);
 	return GetLine(start, dest, 1, Orientation, flags);
 }
 
-PathNode* Map::GetLine(const Point &start, int Steps, int Orientation, int flags)
+Path* Map::GetLine(const Point &start, int Steps, int Orientation, int flags)
 {
 	Point dest=start;
 
@@ -2721,15 +2869,16 @@ PathNode* Map::GetLine(const Point &start, int Steps, int Orientation, int flags
 	return GetLine(start, dest, 2, Orientation, flags);
 }
 
-PathNode* Map::GetLine(const Point &start, const Point &dest, int Speed, int Orientation, int flags)
+Path* Map::GetLine(const Point &start, const Point &dest, int Speed, int Orientation, int flags)
 {
-	PathNode* StartNode = new PathNode;
-	PathNode *Return = StartNode;
-	StartNode->Next = NULL;
-	StartNode->Parent = NULL;
-	StartNode->x = start.x;
-	StartNode->y = start.y;
-	StartNode->orient = Orientation;
+	Path *Return = AllocatePath();
+	PathNode node;
+	node.x = start.x;
+	node.y = start.y;
+	node.orient = Orientation;
+	Return->Append(node);
+	//the last node keeps moving until the next one is started
+	bool pending = false;
 
 	int Count = 0;
 	int Max = Distance(start,dest);
@@ -2742,38 +2891,39 @@ PathNode* Map::GetLine(const Point &start, const Point &dest, int Speed, int Ori
 		//maybe there is a better way, but i needed a quick hack to fix
 		//the crash in projectiles
 		if ((signed) p.x<0 || (signed) p.y<0) {
-			return Return;
+			break;
 		}
 		if ((ieWord) p.x>Width*16 || (ieWord) p.y>Height*12) {
-			return Return;
+			break;
 		}
 
 		if (!Count) {
-			StartNode->Next = new PathNode;
-			StartNode->Next->Parent = StartNode;
-			StartNode = StartNode->Next;
-			StartNode->Next = NULL;
+			if (pending) {
+				Return->Append(node);
+			}
+			pending = true;
 			Count=Speed;
 		} else {
 			Count--;
 		}
 
-		StartNode->x = p.x;
-		StartNode->y = p.y;
-		StartNode->orient = Orientation;
+		node.x = p.x;
+		node.y = p.y;
+		node.orient = Orientation;
 		bool wall = !( GetBlocked( p ) & PATH_MAP_PASSABLE );
-		if (wall) switch (flags) {
-			case GL_REBOUND:
-				Orientation = (Orientation + 8) &15;
-				//recalculate dest (mirror it)
-				break;
-			case GL_PASS:
-				break;
-			default: //premature end
-				return Return;
+		if (wall && flags != GL_REBOUND && flags != GL_PASS) {
+			//premature end
+			break;
+		}
+		if (wall && flags == GL_REBOUND) {
+			Orientation = (Orientation + 8) &15;
+			//recalculate dest (mirror it)
 		}
 	}
 
+	if (pending) {
+		Return->Append(node);
+	}
 	return Return;
 }
 
@@ -2785,7 +2935,7 @@ PathNode* Map::GetLine(const Point &start, const Point &dest, int Speed, int Ori
  * instead, but don't change this one without testing with combat and dialog,
  * you can't predict the goal point for those, you *must* path!
  */
-PathNode* Map::FindPathNear(const Point &s, const Point &d, unsigned int size, unsigned int MinDistance, bool sight)
+Path* Map::FindPathNear(const Point &s, const Point &d, unsigned int size, unsigned int MinDistance, bool sight)
 {
 	// adjust the start/goal points to be searchmap locations
 	Point start( s.x/16, s.y/12 );
@@ -2861,28 +3011,27 @@ PathNode* Map::FindPathNear(const Point &s, const Point &d, unsigned int size, u
 	}
 
 	// find path from goal to start
-	PathNode* StartNode = new PathNode;
-	PathNode* Return = StartNode;
-	StartNode->Next = NULL;
-	StartNode->Parent = NULL;
+	Path* Return = AllocatePath();
+	PathNode node;
 	if (!found_path) {
 		// this is not really great, we should be finding the path that
 		// went nearest to where we wanted
-		StartNode->x = start.x;
-		StartNode->y = start.y;
-		StartNode->orient = GetOrient( goal, start );
+		node.x = start.x;
+		node.y = start.y;
+		node.orient = GetOrient( goal, start );
+		Return->Append(node);
 		return Return;
 	}
-	StartNode->x = goal.x;
-	StartNode->y = goal.y;
+	node.x = goal.x;
+	node.y = goal.y;
 	bool fixup_orient = false;
 	if (orig_goal != goal) {
-		StartNode->orient = GetOrient( orig_goal, goal );
+		node.orient = GetOrient( orig_goal, goal );
 	} else {
 		// we pathed all the way to original goal!
 		// we don't know correct orientation until we find previous step
 		fixup_orient = true;
-		StartNode->orient = GetOrient( goal, start );
+		node.orient = GetOrient( goal, start );
 	}
 	Point p = goal;
 	pos2 = start.y * Width + start.x;
@@ -2899,28 +3048,26 @@ PathNode* Map::FindPathNear(const Point &s, const Point &d, unsigned int size, u
 		Leveldown( p.x + 1, p.y - 1, level, n, diff );
 		Leveldown( p.x - 1, p.y - 1, level, n, diff );
 		if (!diff)
-			return Return;
+			break;
 
 		if (fixup_orient) {
 			// don't change orientation at end of path? this seems best
-			StartNode->orient = GetOrient( p, n );
+			node.orient = GetOrient( p, n );
 		}
+		Return->Append(node);
 
-		Return = new PathNode;
-		Return->Next = StartNode;
-		Return->Next->Parent = Return;
-		StartNode = Return;
-
-		StartNode->x = n.x;
-		StartNode->y = n.y;
-		StartNode->orient = GetOrient( p, n );
+		node.x = n.x;
+		node.y = n.y;
+		node.orient = GetOrient( p, n );
 		p = n;
 	}
+	Return->Append(node);
+	Return->Reverse();
 
 	return Return;
 }
 
-PathNode* Map::FindPath(const Point &s, const Point &d, unsigned int size, int MinDistance)
+Path* Map::FindPath(const Point &s, const Point &d, unsigned int size, int MinDistance)
 {
 	Point start( s.x/16, s.y/12 );
 	Point goal ( d.x/16, d.y/12 );
@@ -2965,23 +3112,18 @@ PathNode* Map::FindPath(const Point &s, const Point &d, unsigned int size, int M
 	}
 
 	//find path from start to goal
-	PathNode* StartNode = new PathNode;
-	PathNode* Return = StartNode;
-	StartNode->Next = NULL;
-	StartNode->Parent = NULL;
-	StartNode->x = start.x;
-	StartNode->y = start.y;
-	StartNode->orient = GetOrient( goal, start );
+	Path* Return = AllocatePath();
+	PathNode node;
+	node.x = start.x;
+	node.y = start.y;
+	node.orient = GetOrient( goal, start );
+	Return->Append(node);
 	if (pos != pos2) {
 		return Return;
 	}
 	Point p = start;
 	pos2 = goal.y * Width + goal.x;
 	while (( pos = p.y * Width + p.x ) != pos2) {
-		StartNode->Next = new PathNode;
-		StartNode->Next->Parent = StartNode;
-		StartNode = StartNode->Next;
-		StartNode->Next = NULL;
 		unsigned int level = MapSet[pos];
 		unsigned int diff = 0;
 		Point n;
@@ -2994,26 +3136,26 @@ PathNode* Map::FindPath(const Point &s, const Point &d, unsigned int size, int M
 		Leveldown( p.x + 1, p.y - 1, level, n, diff );
 		Leveldown( p.x - 1, p.y - 1, level, n, diff );
 		if (!diff)
-			return Return;
-		StartNode->x = n.x;
-		StartNode->y = n.y;
-		StartNode->orient = GetOrient( n, p );
+			break;
+		node.x = n.x;
+		node.y = n.y;
+		node.orient = GetOrient( n, p );
+		Return->Append(node);
 		p = n;
 	}
 	//stepping back on the calculated path
 	if (MinDistance) {
-		while (StartNode->Parent) {
+		while (Return->GetLength() > 1) {
+			PathNode parent = Return->GetNode(Return->GetLength() - 2);
 			Point tar;
 
-			tar.x=StartNode->Parent->x*16;
-			tar.y=StartNode->Parent->y*12;
+			tar.x=parent.x*16;
+			tar.y=parent.y*12;
 			int dist = Distance(tar,d);
 			if (dist+14>=MinDistance) {
 				break;
 			}
-			StartNode = StartNode->Parent;
-			delete StartNode->Next;
-			StartNode->Next = NULL;
+			Return->PopBack();
 		}
 	}
 	return Return;
@@ -3041,8 +3183,190 @@ bool Map::IsVisible(const Point &pos, int explored)
 	return (VisibleBitmap[by] & bi)!=0;
 }
 
+static inline ieDword SightCell(const Point &p)
+{
+	return ((ieDword) (p.y/12) << 16) | ((ieDword) (p.x/16) & 0xffff);
+}
+
+static inline Point SightPoint(ieDword cell)
+{
+	return Point((short) ((cell & 0xffff) * 16), (short) ((cell >> 16) * 12));
+}
+
+static WorkerPool *GetSightWorkers()
+{
+	if (!sightWorkersInited) {
+		sightWorkersInited = true;
+		unsigned int cpus = Thread::GetCPUCount();
+		if (cpus > 1) {
+			sightWorkers = new WorkerPool(std::min(cpus - 1, (unsigned int) MAX_SIGHT_WORKERS));
+		}
+	}
+	if (sightWorkers && !sightWorkers->GetWorkerCount()) {
+		return NULL;
+	}
+	return sightWorkers;
+}
+
+struct SightResult {
+	std::pair<ieDword, ieDword> cells;
+	bool visible;
+};
+
+struct SightTask {
+	Map *map;
+	Actor **senders;
+	bool skipCached;
+	std::vector<std::vector<SightResult> > results;
+};
+
+//runs on the workers, only reading the searchmap, the sight cache and the actors
+void Map::PrecomputeSightFor(void *arg, unsigned int index)
+{
+	SightTask *task = (SightTask *) arg;
+	Map *map = task->map;
+	Actor *sender = task->senders[index];
+	std::vector<SightResult> &results = task->results[index];
+
+	unsigned int range = sender->Modified[IE_VISUALRANGE];
+	SightResult result;
+	for (size_t i = 0; i < map->actors.size(); i++) {
+		Actor *target = map->actors[i];
+		if (target == sender) continue;
+
+		// the same range checks as object matching (DoObjectChecks) and CanSee
+		if (SquaredMapDistance(sender, target) <= range*range) {
+			result.cells = std::make_pair(SightCell(sender->Pos), SightCell(target->Pos));
+			if (!task->skipCached || !map->sightCache.count(result.cells)) {
+				result.visible = map->TraceLOS(sender->Pos, target->Pos);
+				results.push_back(result);
+			}
+		}
+		if (Distance(target->Pos, sender->Pos) <= range*VOODOO_CANSEE_F) {
+			result.cells = std::make_pair(SightCell(target->Pos), SightCell(sender->Pos));
+			if (!task->skipCached || !map->sightCache.count(result.cells)) {
+				result.visible = map->TraceLOS(target->Pos, sender->Pos);
+				results.push_back(result);
+			}
+		}
+	}
+}
+
+void Map::PrecomputeSight()
+{
+	// with a single core the cache still fills up as the scripts ask
+	WorkerPool *pool = GetSightWorkers();
+	int count = Qcount[PR_SCRIPT];
+	if (!pool || !count) {
+		return;
+	}
+
+	// only the actors that moved to another cell or see further since
+	// their last precompute can need lines that aren't cached yet,
+	// anything else is traced on demand
+	std::vector<Actor *> senders;
+	for (int i = 0; i < count; i++) {
+		Actor *actor = queue[PR_SCRIPT][i];
+		if (actor->GetCurrentArea() != this) continue;
+		std::pair<ieDword, unsigned int> stamp(SightCell(actor->Pos), actor->Modified[IE_VISUALRANGE]);
+		std::pair<ieDword, unsigned int> &last = sightStamps[actor->GetGlobalID()];
+		if (last == stamp) continue;
+		last = stamp;
+		senders.push_back(actor);
+	}
+	if (senders.empty()) {
+		return;
+	}
+
+	SightTask task;
+	task.map = this;
+	task.senders = &senders[0];
+	task.skipCached = true;
+	task.results.resize(senders.size());
+	pool->Run(PrecomputeSightFor, &task, (unsigned int) senders.size());
+
+	for (size_t i = 0; i < senders.size(); i++) {
+		const std::vector<SightResult> &results = task.results[i];
+		for (size_t j = 0; j < results.size(); j++) {
+			sightCache.insert(std::make_pair(results[j].cells, results[j].visible));
+		}
+		sightPrecomputed += results.size();
+	}
+}
+
+void Map::ClearSightCache()
+{
+	sightCache.clear();
+	sightStamps.clear();
+}
+
+bool Map::CheckSight()
+{
+	bool ok = true;
+	SightMap::const_iterator it;
+	for (it = sightCache.begin(); it != sightCache.end(); ++it) {
+		Point s = SightPoint(it->first.first);
+		Point d = SightPoint(it->first.second);
+		if (it->second != TraceLOS(s, d)) {
+			Log(ERROR, "Map", "Cached line of sight differs for [%d.%d] -> [%d.%d]!",
+				s.x, s.y, d.x, d.y);
+			ok = false;
+		}
+	}
+
+	// a full precompute for everyone, ignoring the cache
+	if (actors.empty()) {
+		return ok;
+	}
+	SightTask task;
+	task.map = this;
+	task.senders = &actors[0];
+	task.skipCached = false;
+	task.results.resize(actors.size());
+	WorkerPool *pool = GetSightWorkers();
+	if (pool) {
+		pool->Run(PrecomputeSightFor, &task, (unsigned int) actors.size());
+	} else {
+		for (unsigned int i = 0; i < actors.size(); i++) {
+			PrecomputeSightFor(&task, i);
+		}
+	}
+	for (size_t i = 0; i < actors.size(); i++) {
+		const std::vector<SightResult> &results = task.results[i];
+		for (size_t j = 0; j < results.size(); j++) {
+			Point s = SightPoint(results[j].cells.first);
+			Point d = SightPoint(results[j].cells.second);
+			if (results[j].visible != TraceLOS(s, d)) {
+				Log(ERROR, "Map", "Precomputed line of sight differs for [%d.%d] -> [%d.%d]!",
+					s.x, s.y, d.x, d.y);
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
 //point a is visible from point b (searchmap)
+//the answer only depends on the cells, so it is remembered until the searchmap changes
 bool Map::IsVisibleLOS(const Point &s, const Point &d)
+{
+	std::pair<ieDword, ieDword> cells(SightCell(s), SightCell(d));
+	SightMap::iterator it = sightCache.lower_bound(cells);
+	if (it != sightCache.end() && it->first == cells) {
+		sightHits++;
+		if ((InDebug&ID_SIGHT) && it->second != TraceLOS(s, d)) {
+			Log(ERROR, "Map", "Cached line of sight differs for [%d.%d] -> [%d.%d]!",
+				s.x, s.y, d.x, d.y);
+		}
+		return it->second;
+	}
+	sightMisses++;
+	bool visible = TraceLOS(s, d);
+	sightCache.insert(it, std::make_pair(cells, visible));
+	return visible;
+}
+
+bool Map::TraceLOS(const Point &s, const Point &d)
 {
 	int sX=s.x/16;
 	int sY=s.y/12;
@@ -3448,8 +3772,8 @@ void Map::UpdateFog()
 	}
 }
 
-//Valid values are - PATH_MAP_FREE, PATH_MAP_PC, PATH_MAP_NPC
-void Map::BlockSearchMap(const Point &Pos, unsigned int size, unsigned int value)
+//adds delta to the actor counts of the cells under a footprint
+void Map::UpdateOccupancy(const Point &Pos, unsigned int size, unsigned int value, int delta)
 {
 	// We block a circle of radius size-1 around (px,py)
 	// Note that this does not exactly match BG2. BG2's approximations of
@@ -3459,42 +3783,106 @@ void Map::BlockSearchMap(const Point &Pos, unsigned int size, unsigned int value
 	// This means that an actor can get closer to a wall than to another
 	// actor. This matches the behaviour of the original BG2.
 
-	if (size > MAX_CIRCLESIZE) size = MAX_CIRCLESIZE;
-	if (size < 2) size = 2;
-	unsigned int ppx = Pos.x/16;
-	unsigned int ppy = Pos.y/12;
-	unsigned int r=(size-1)*(size-1)+1;
-	for (unsigned int i=0; i<size; i++) {
-		for (unsigned int j=0; j<size; j++) {
-			if (i*i+j*j <= r) {
-				unsigned int ppxpi = ppx+i;
-				unsigned int ppypj = ppy+j;
-				unsigned int ppxmi = ppx-i;
-				unsigned int ppymj = ppy-j;
-				if ((ppxpi<Width) && (ppypj<Height)) {
-					unsigned int pos = ppypj*Width+ppxpi;
-					SrchMap[pos] = (SrchMap[pos]&PATH_MAP_NOTACTOR) | value;
-				}
+	int ppx = Pos.x/16;
+	int ppy = Pos.y/12;
+	int reach = (int) size-1;
+	int r = reach*reach+1;
+	for (int j = -reach; j <= reach; j++) {
+		int y = ppy+j;
+		if (y < 0 || y >= (int) Height) continue;
+		for (int i = -reach; i <= reach; i++) {
+			int x = ppx+i;
+			if (x < 0 || x >= (int) Width || i*i+j*j > r) continue;
+			SearchMapOccupancy &cell = ActorMap[y*Width+x];
+			if (value == PATH_MAP_PC) {
+				cell.pc = (ieWord) (cell.pc + delta);
+			} else {
+				cell.npc = (ieWord) (cell.npc + delta);
+			}
+		}
+	}
+}
 
-				if ((ppxpi<Width) && (ppymj<Height)) {
-					unsigned int pos = (ppymj)*Width+ppxpi;
-					SrchMap[pos] = (SrchMap[pos]&PATH_MAP_NOTACTOR) | value;
-				}
+//the broadphase cells overlapped by rgn, clamped to the map
+void Map::GetTriggerGridCells(const Region &rgn, int &x1, int &y1, int &x2, int &y2) const
+{
+	x1 = std::max(rgn.x, 0) / TRIGGER_GRID_CELL;
+	y1 = std::max(rgn.y, 0) / TRIGGER_GRID_CELL;
+	x2 = std::max(rgn.x + rgn.w, 0) / TRIGGER_GRID_CELL;
+	y2 = std::max(rgn.y + rgn.h, 0) / TRIGGER_GRID_CELL;
+	x2 = std::min(x2, triggerGridWidth - 1);
+	y2 = std::min(y2, triggerGridHeight - 1);
+}
 
-				if ((ppxmi<Width) && (ppypj<Height)) {
-					unsigned int pos = (ppypj)*Width+ppxmi;
-					SrchMap[pos] = (SrchMap[pos]&PATH_MAP_NOTACTOR) | value;
-				}
+//sorts the scripted actors into the cells they can reach a region from
+void Map::BuildTriggerGrid()
+{
+	triggerGridWidth = (int) (Width * 16 + TRIGGER_GRID_CELL - 1) / TRIGGER_GRID_CELL;
+	triggerGridHeight = (int) (Height * 12 + TRIGGER_GRID_CELL - 1) / TRIGGER_GRID_CELL;
+	triggerGrid.resize(triggerGridWidth * triggerGridHeight);
+	for (size_t i = 0; i < triggerGrid.size(); i++) {
+		triggerGrid[i].clear();
+	}
 
-				if ((ppxmi<Width) && (ppymj<Height)) {
-					unsigned int pos = (ppymj)*Width+ppxmi;
-					SrchMap[pos] = (SrchMap[pos]&PATH_MAP_NOTACTOR) | value;
-				}
+	//going backwards keeps each cell in queue order
+	int q = Qcount[PR_SCRIPT];
+	while (q--) {
+		Actor *actor = queue[PR_SCRIPT][q];
+		//PersonalDistance subtracts this
+		int reach = std::max(actor->size, 0) * 10;
+		Region rgn(actor->Pos.x - reach, actor->Pos.y - reach, 2 * reach, 2 * reach);
+		int x1, y1, x2, y2;
+		GetTriggerGridCells(rgn, x1, y1, x2, y2);
+		for (int y = y1; y <= y2; y++) {
+			for (int x = x1; x <= x2; x++) {
+				triggerGrid[y * triggerGridWidth + x].push_back(q);
 			}
 		}
 	}
 }
 
+//the actors that could be in the region, see InfoPoint::Entered
+void Map::GetTriggerCandidates(const InfoPoint *ip, std::vector<int> &candidates)
+{
+	Region bounds = ip->outline->BBox;
+	std::vector<Point> points;
+	if (ip->Type == ST_TRAVEL) {
+		points.push_back(ip->TrapLaunch);
+		points.push_back(ip->TalkPos);
+	}
+	if (ip->GetUsePoint()) {
+		points.push_back(ip->UsePoint);
+	}
+	for (size_t i = 0; i < points.size(); i++) {
+		int x2 = std::max(bounds.x + bounds.w, (int) points[i].x);
+		int y2 = std::max(bounds.y + bounds.h, (int) points[i].y);
+		bounds.x = std::min(bounds.x, (int) points[i].x);
+		bounds.y = std::min(bounds.y, (int) points[i].y);
+		bounds.w = x2 - bounds.x;
+		bounds.h = y2 - bounds.y;
+	}
+	bounds.x -= MAX_OPERATING_DISTANCE;
+	bounds.y -= MAX_OPERATING_DISTANCE;
+	bounds.w += 2 * MAX_OPERATING_DISTANCE;
+	bounds.h += 2 * MAX_OPERATING_DISTANCE;
+
+	candidates.clear();
+	int x1, y1, x2, y2;
+	GetTriggerGridCells(bounds, x1, y1, x2, y2);
+	for (int y = y1; y <= y2; y++) {
+		for (int x = x1; x <= x2; x++) {
+			const std::vector<int> &cell = triggerGrid[y * triggerGridWidth + x];
+			candidates.insert(candidates.end(), cell.begin(), cell.end());
+		}
+	}
+	//big actors may be in several of the cells
+	std::sort(candidates.begin(), candidates.end(), std::greater<int>());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	triggerTests += candidates.size();
+	triggerTestsSkipped += Qcount[PR_SCRIPT] - candidates.size();
+}
+
 Spawn* Map::GetSpawn(const char* Name)
 {
 	for (size_t i = 0; i < spawns.size(); i++) {
@@ -4096,15 +4484,21 @@ short unsigned int Map::GetInternalSearchMap(int x, int y) const
 	if ((unsigned)x >= Width || (unsigned)y >= Height) {
 		return 0;
 	}
-	return SrchMap[x+y*Width];
+	unsigned short ret = SrchMap[x+y*Width];
+	if (ActorMap[x+y*Width].pc) ret |= PATH_MAP_PC;
+	if (ActorMap[x+y*Width].npc) ret |= PATH_MAP_NPC;
+	return ret;
 }
 
+//the actor bits are kept in ActorMap
 void Map::SetInternalSearchMap(int x, int y, int value)
 {
 	if ((unsigned)x >= Width || (unsigned)y >= Height) {
 		return;
 	}
-	SrchMap[x+y*Width] = value;
+	SrchMap[x+y*Width] = value & PATH_MAP_NOTACTOR;
+	// doors can block the sight
+	ClearSightCache();
 }
 
 void Map::SetBackground(const ieResRef &bgResRef, ieDword duration)
@@ -25,9 +25,11 @@
 #include "globals.h"
 
 #include "Interface.h"
+#include "PickIndex.h"
 #include "Scriptable/Scriptable.h"
 
 #include <algorithm>
+#include <map>
 #include <queue>
 
 namespace GemRB {
@@ -44,7 +46,7 @@ class IniSpawn;
 class MapReverb;
 class Palette;
 class Particles;
-struct PathNode;
+class Path;
 class Projectile;
 class ScriptedAnimation;
 class SpriteCover;
@@ -144,6 +146,12 @@ struct Entrance {
 	ieWord Face;
 };
 
+// actor footprints overlap, so they are counted instead of flagged
+struct SearchMapOccupancy {
+	ieWord pc;
+	ieWord npc;
+};
+
 class MapNote {
 	void swap(MapNote& mn) {
 		if (&mn == this) return;
@@ -321,11 +329,14 @@ private:
 	ieWord trackDiff;
 	unsigned short* MapSet;
 	unsigned short* SrchMap; //internal searchmap
+	SearchMapOccupancy* ActorMap; //how many actors stand on each searchmap cell
 	unsigned short* MaterialMap;
 	std::queue< unsigned int> InternalStack;
 	unsigned int Width, Height;
 	std::list< AreaAnimation*> animations;
 	std::vector< Actor*> actors;
+	//the actors by selection circle, for GetActor(Point)
+	PickIndex actorIndex;
 	Wall_Polygon **Walls;
 	unsigned int WallCount;
 	std::list< VEFObject*> vvcCells;
@@ -338,6 +349,19 @@ private:
 	Actor** queue[QUEUE_COUNT];
 	int Qcount[QUEUE_COUNT];
 	unsigned int lastActorCount[QUEUE_COUNT];
+	//broadphase for the trap and travel region checks:
+	//script queue indices of the actors that can reach each cell
+	std::vector<std::vector<int> > triggerGrid;
+	int triggerGridWidth, triggerGridHeight;
+	unsigned long triggerTests, triggerTestsSkipped;
+	//line of sight between searchmap cells, it only changes with the searchmap
+	typedef std::map<std::pair<ieDword, ieDword>, bool> SightMap;
+	SightMap sightCache;
+	//cell and visual range of each actor when its sight was last precomputed
+	std::map<ieDword, std::pair<ieDword, unsigned int> > sightStamps;
+	unsigned long sightHits, sightMisses, sightPrecomputed;
+	//emptied paths, handed out again by AllocatePath
+	std::vector<Path*> pathPool;
 public:
 	Map(void);
 	~Map(void);
@@ -482,31 +506,42 @@ public:
 	/* explore map from given point in map coordinates */
 	void ExploreMapChunk(const Point &Pos, int range, int los);
 	/* block or unblock searchmap with value */
-	void BlockSearchMap(const Point &Pos, unsigned int size, unsigned int value);
+	/* marks the cells under the actor as occupied, updating its old footprint */
+	void BlockSearchMapFor(Movable *actor);
+	/* removes the footprint of the actor, if any */
 	void ClearSearchMapFor(Movable *actor);
+	/* moves the actor to its current cells in the picking grid */
+	void UpdateActorIndex(Movable *actor);
 	/* update VisibleBitmap by resolving vision of all explore actors */
 	void UpdateFog();
 	//PathFinder
 	/* Finds the nearest passable point */
 	void AdjustPosition(Point &goal, unsigned int radiusx=0, unsigned int radiusy=0);
+	/* gets an empty path, reusing a released one if possible */
+	Path* AllocatePath();
+	/* takes back a path that is no longer needed */
+	void ReleasePath(Path *path);
+	static void GetPathStats(unsigned long &allocated, unsigned long &reused, unsigned long &steps, unsigned long &segments);
 	/* Finds the path which leads the farthest from d */
-	PathNode* RunAway(const Point &s, const Point &d, unsigned int size, unsigned int PathLen, int flags);
+	Path* RunAway(const Point &s, const Point &d, unsigned int size, unsigned int PathLen, int flags);
 	/* Returns true if there is no path to d */
 	bool TargetUnreachable(const Point &s, const Point &d, unsigned int size);
 	/* returns true if there is enemy visible */
 	bool AnyPCSeesEnemy();
 	/* Finds straight path from s, length l and orientation o, f=1 passes wall, f=2 rebounds from wall*/
-	PathNode* GetLine(const Point &start, const Point &dest, int flags);
-	PathNode* GetLine(const Point &start, int Steps, int Orientation, int flags);
-	PathNode* GetLine(const Point &start, const Point &dest, int speed, int Orientation, int flags);
+	Path* GetLine(const Point &start, const Point &dest, int flags);
+	Path* GetLine(const Point &start, int Steps, int Orientation, int flags);
+	Path* GetLine(const Point &start, const Point &dest, int speed, int Orientation, int flags);
 	/* Finds the path which leads to near d */
-	PathNode* FindPathNear(const Point &s, const Point &d, unsigned int size, unsigned int MinDistance = 0, bool sight = true);
+	Path* FindPathNear(const Point &s, const Point &d, unsigned int size, unsigned int MinDistance = 0, bool sight = true);
 	/* Finds the path which leads to d */
-	PathNode* FindPath(const Point &s, const Point &d, unsigned int size, int MinDistance = 0);
+	Path* FindPath(const Point &s, const Point &d, unsigned int size, int MinDistance = 0);
 	/* returns false if point isn't visible on visibility/explored map */
 	bool IsVisible(const Point &s, int explored);
 	/* returns false if point d cannot be seen from point d due to searchmap */
 	bool IsVisibleLOS(const Point &s, const Point &d);
+	/* compares the cached and the precomputed lines of sight with serial traces */
+	bool CheckSight();
 	/* returns edge direction of map boundary, only worldmap regions */
 	int WhichEdge(const Point &s);
 
@@ -566,8 +601,16 @@ private:
 	Container *GetNextPile (int &index) const;
 	void DrawPile (Region screen, int pileidx);
 	void DrawSearchMap(const Region &screen);
+	void UpdateOccupancy(const Point &Pos, unsigned int size, unsigned int value, int delta);
+	void GetTriggerGridCells(const Region &rgn, int &x1, int &y1, int &x2, int &y2) const;
+	void BuildTriggerGrid();
+	void GetTriggerCandidates(const InfoPoint *ip, std::vector<int> &candidates);
 	void GenerateQueues();
 	void SortQueues();
+	void PrecomputeSight();
+	static void PrecomputeSightFor(void *task, unsigned int index);
+	void ClearSightCache();
+	bool TraceLOS(const Point &s, const Point &d);
 	//Actor* GetRoot(int priority, int &index);
 	void DeleteActor(int i);
 	void Leveldown(unsigned int px, unsigned int py, unsigned int& level,
@@ -0,0 +1,304 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "MemoryPool.h"
+
+#include "Benchmark.h"
+#include "Effect.h"
+#include "GameScript/GameScript.h"
+#include "System/Logging.h"
+#include "System/StringBuffer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace GemRB {
+
+//the pools are statics themselves, so this must not need a constructor
+MemoryPool *MemoryPool::pools = NULL;
+
+#ifdef MEMORYPOOL_DEBUG
+//what freed blocks are filled with, past their free list link
+#define POOL_POISON 0xdd
+
+static void PoisonBlock(void *block, size_t size)
+{
+	memset((char *) block + sizeof(void *), POOL_POISON, size - sizeof(void *));
+}
+
+static bool IsPoisoned(const void *block, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *) block;
+	for (size_t i = sizeof(void *); i < size; i++) {
+		if (bytes[i] != POOL_POISON) {
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+MemoryPool::MemoryPool(const char *name, size_t size, size_t slabSize)
+{
+	this->name = name;
+	//every block must be able to hold the free list link and keep the
+	//alignment of the next one
+	const size_t align = sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *);
+	if (size < sizeof(void *)) {
+		size = sizeof(void *);
+	}
+	blockSize = (size + align - 1) / align * align;
+	this->slabSize = slabSize;
+	freeList = NULL;
+	live = peak = total = 0;
+	nextPool = pools;
+	pools = this;
+}
+
+MemoryPool::~MemoryPool()
+{
+	//static destruction order is undefined, so leave the slabs alone
+	//if anything could still be freed into them
+	if (!live) {
+		for (size_t i = 0; i < slabs.size(); i++) {
+			free(slabs[i]);
+		}
+	}
+	MemoryPool **pool = &pools;
+	while (*pool) {
+		if (*pool == this) {
+			*pool = nextPool;
+			break;
+		}
+		pool = &(*pool)->nextPool;
+	}
+}
+
+void* MemoryPool::Allocate(size_t size)
+{
+	if (size > blockSize) {
+		error("MemoryPool", "%s pool asked for %lu bytes, its blocks hold %lu.\n", name, (unsigned long) size, (unsigned long) blockSize);
+	}
+	if (!freeList) {
+		char *slab = (char *) malloc(blockSize * slabSize);
+		if (!slab) {
+			error("MemoryPool", "Out of memory growing the %s pool.\n", name);
+		}
+		slabs.push_back(slab);
+		//thread the new blocks onto the free list, first block first
+		for (size_t i = slabSize; i--; ) {
+			void *block = slab + i * blockSize;
+			*(void **) block = freeList;
+			freeList = block;
+#ifdef MEMORYPOOL_DEBUG
+			PoisonBlock(block, blockSize);
+#endif
+		}
+	}
+	void *block = freeList;
+	freeList = *(void **) block;
+#ifdef MEMORYPOOL_DEBUG
+	if (!IsPoisoned(block, blockSize)) {
+		Log(ERROR, "MemoryPool", "A freed %s object at %p was written to!", name, block);
+	}
+#endif
+	live++;
+	total++;
+	if (live > peak) {
+		peak = live;
+	}
+	return block;
+}
+
+void MemoryPool::Free(void *ptr)
+{
+	if (!ptr) {
+		return;
+	}
+#ifdef MEMORYPOOL_DEBUG
+	PoisonBlock(ptr, blockSize);
+#endif
+	*(void **) ptr = freeList;
+	freeList = ptr;
+	live--;
+}
+
+void MemoryPool::DumpStats(StringBuffer &buffer)
+{
+	for (MemoryPool *pool = pools; pool; pool = pool->nextPool) {
+		buffer.appendFormatted("%s pool: %lu live, %lu peak, %lu allocated in total, %lu slabs\n",
+			pool->name, pool->live, pool->peak, pool->total, (unsigned long) pool->slabs.size());
+	}
+}
+
+void MemoryPool::CheckLeaks()
+{
+	for (MemoryPool *pool = pools; pool; pool = pool->nextPool) {
+		if (pool->live) {
+			Log(WARNING, "MemoryPool", "%lu %s objects were not freed!", pool->live, pool->name);
+		}
+	}
+}
+
+
+#define BENCHMARK_SLOTS 1024
+#define BENCHMARK_OPERATIONS 1000000
+
+//the pooled types, created and freed in the mix they had in this session
+enum TraceType { TRACE_EFFECT, TRACE_ACTION, TRACE_TRIGGER, TRACE_OBJECT, TRACE_TYPES };
+static const char *TracePools[TRACE_TYPES] = { "Effect", "Action", "Trigger", "Object" };
+
+MemoryPool* MemoryPool::Find(const char *name)
+{
+	for (MemoryPool *pool = pools; pool; pool = pool->nextPool) {
+		if (!strcmp(pool->GetName(), name)) {
+			return pool;
+		}
+	}
+	return NULL;
+}
+
+//the global ::new and ::delete skip the class operators and go to the heap
+static void *CreateTraced(int type, bool pooled)
+{
+	switch (type) {
+		case TRACE_EFFECT:
+			return pooled ? new Effect() : ::new Effect();
+		case TRACE_ACTION:
+			return pooled ? new Action(true) : ::new Action(true);
+		case TRACE_TRIGGER:
+			return pooled ? new Trigger() : ::new Trigger();
+		default:
+			return pooled ? new Object() : ::new Object();
+	}
+}
+
+static void DestroyTraced(int type, void *ptr, bool pooled)
+{
+	switch (type) {
+		case TRACE_EFFECT:
+			if (pooled) delete (Effect *) ptr; else ::delete (Effect *) ptr;
+			break;
+		case TRACE_ACTION:
+			if (pooled) delete (Action *) ptr; else ::delete (Action *) ptr;
+			break;
+		case TRACE_TRIGGER:
+			if (pooled) delete (Trigger *) ptr; else ::delete (Trigger *) ptr;
+			break;
+		default:
+			if (pooled) delete (Object *) ptr; else ::delete (Object *) ptr;
+			break;
+	}
+}
+
+// a deterministic mix of creations and frees with a changing live set,
+// like scripts and effects coming and going during a fight
+struct Trace {
+	unsigned long weights[TRACE_TYPES];
+	unsigned int slotCounts[TRACE_TYPES];
+};
+
+// returns how many objects it created
+static unsigned long ReplayTrace(const Trace &trace, bool pooled)
+{
+	const unsigned long *weights = trace.weights;
+	const unsigned int *slotCounts = trace.slotCounts;
+	std::vector<void *> slots[TRACE_TYPES];
+	unsigned long weightSum = 0;
+	int type;
+	for (type = 0; type < TRACE_TYPES; type++) {
+		slots[type].resize(slotCounts[type], NULL);
+		weightSum += weights[type];
+	}
+
+	unsigned long created = 0;
+	unsigned int seed = 1;
+	for (int i = 0; i < BENCHMARK_OPERATIONS; i++) {
+		seed = seed * 1103515245 + 12345;
+		unsigned long pick = (seed >> 4) % weightSum;
+		for (type = 0; pick >= weights[type]; type++) {
+			pick -= weights[type];
+		}
+		void *&slot = slots[type][(seed >> 8) % slotCounts[type]];
+		if (slot) {
+			DestroyTraced(type, slot, pooled);
+			slot = NULL;
+		} else {
+			slot = CreateTraced(type, pooled);
+			created++;
+		}
+	}
+	for (type = 0; type < TRACE_TYPES; type++) {
+		for (size_t j = 0; j < slots[type].size(); j++) {
+			if (slots[type][j]) {
+				DestroyTraced(type, slots[type][j], pooled);
+			}
+		}
+	}
+	return created;
+}
+
+static unsigned long ReplayOnHeap(void *arg)
+{
+	return ReplayTrace(*(const Trace *) arg, false);
+}
+
+static unsigned long ReplayInPools(void *arg)
+{
+	return ReplayTrace(*(const Trace *) arg, true);
+}
+
+void MemoryPool::Benchmark(StringBuffer &buffer)
+{
+	// the counters so far decide the mix and how many stay alive
+	Trace trace;
+	unsigned long before[TRACE_TYPES], peaks[TRACE_TYPES], totals[TRACE_TYPES];
+	MemoryPool *traced[TRACE_TYPES];
+	int type;
+	for (type = 0; type < TRACE_TYPES; type++) {
+		traced[type] = Find(TracePools[type]);
+		if (!traced[type]) {
+			buffer.appendFormatted("Pools: there is no %s pool to benchmark\n", TracePools[type]);
+			return;
+		}
+		trace.weights[type] = traced[type]->GetTotal() ? traced[type]->GetTotal() : 1;
+		unsigned long peak = traced[type]->GetPeak();
+		trace.slotCounts[type] = (unsigned int) (peak < 16 ? 16 : peak > BENCHMARK_SLOTS ? BENCHMARK_SLOTS : peak);
+		before[type] = traced[type]->live;
+		peaks[type] = traced[type]->peak;
+		totals[type] = traced[type]->total;
+	}
+
+	char what[128];
+	snprintf(what, sizeof(what), "%d operations on effects, actions, triggers and objects (%u/%u/%u/%u live at most)",
+		BENCHMARK_OPERATIONS, trace.slotCounts[TRACE_EFFECT], trace.slotCounts[TRACE_ACTION],
+		trace.slotCounts[TRACE_TRIGGER], trace.slotCounts[TRACE_OBJECT]);
+	GemRB::Benchmark("Pools", what).Compare(buffer, &trace, "heap", ReplayOnHeap, "pools", ReplayInPools);
+
+	// the benchmark doesn't count towards the stats of the game
+	for (type = 0; type < TRACE_TYPES; type++) {
+		if (traced[type]->live != before[type]) {
+			Log(ERROR, "MemoryPool", "The benchmark trace leaked %s objects!", TracePools[type]);
+		}
+		traced[type]->peak = peaks[type];
+		traced[type]->total = totals[type];
+	}
+}
+
+}
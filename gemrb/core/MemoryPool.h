@@ -0,0 +1,89 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file MemoryPool.h
+ * Declares MemoryPool, a free list allocator for small, short lived objects
+ */
+
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+
+#include "exports.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace GemRB {
+
+class StringBuffer;
+
+// debug builds fill freed blocks and check them when they are reused
+//#define MEMORYPOOL_DEBUG
+#if defined(_DEBUG) && !defined(MEMORYPOOL_DEBUG)
+#define MEMORYPOOL_DEBUG
+#endif
+
+/**
+ * @class MemoryPool
+ * Hands out fixed size blocks carved from larger slabs. Freed blocks go
+ * on a free list and are handed out again, the slabs themselves are only
+ * released with the pool. Classes use it through their own operator new
+ * and delete, so the places creating and freeing them stay unchanged.
+ *
+ * A freed block is handed out again sooner than the heap would, which
+ * hides stale pointers from the Canary checks. With MEMORYPOOL_DEBUG the
+ * freed blocks are poisoned, so stale reads fail those checks, and stale
+ * writes are reported when the block is handed out again.
+ */
+
+class GEM_EXPORT MemoryPool {
+public:
+	MemoryPool(const char *name, size_t size, size_t slabSize = 256);
+	~MemoryPool();
+
+	void* Allocate(size_t size);
+	void Free(void *ptr);
+
+	const char* GetName() const { return name; }
+	unsigned long GetLive() const { return live; }
+	unsigned long GetPeak() const { return peak; }
+	unsigned long GetTotal() const { return total; }
+
+	/** appends the counters of every pool to the buffer */
+	static void DumpStats(StringBuffer &buffer);
+	/** complains about the pools still having blocks handed out */
+	static void CheckLeaks();
+	/** times an allocation trace of the pooled script and effect types through their pools and through the heap */
+	static void Benchmark(StringBuffer &buffer);
+private:
+	const char *name;
+	size_t blockSize;
+	size_t slabSize;
+	std::vector<char *> slabs;
+	void *freeList;
+	unsigned long live, peak, total;
+	MemoryPool *nextPool;
+
+	static MemoryPool *pools;
+	static MemoryPool* Find(const char *name);
+};
+
+}
+
+#endif
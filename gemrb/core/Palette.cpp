@@ -22,8 +22,16 @@
 
 #include "Interface.h"
 
+#include <map>
+
 namespace GemRB {
 
+typedef std::multimap<unsigned int, Palette *> PaletteMap;
+
+// weak references, palettes remove themselves when they are destroyed
+static PaletteMap internedPalettes;
+static unsigned long internRequests = 0;
+
 #define MINCOL 2
 #define MUL    2
 
@@ -32,6 +40,8 @@ Palette::Palette(const Color &color, const Color &back)
 	alpha = false;
 	refcount = 1;
 	named = false;
+	interned = false;
+	hash = 0;
 
 	front = color;
 	this->back = back;
@@ -90,6 +100,95 @@ Palette* Palette::Copy()
 	return pal;
 }
 
+// FNV-1a over the colours
+static unsigned int HashColors(const Color *col, bool alpha)
+{
+	const unsigned char *data = (const unsigned char *) col;
+	unsigned int h = 2166136261u;
+	for (unsigned int i = 0; i < 256 * sizeof(Color); i++) {
+		h = (h ^ data[i]) * 16777619u;
+	}
+	return alpha ? ~h : h;
+}
+
+static inline bool SameColors(const Palette *a, const Palette *b)
+{
+	return a->alpha == b->alpha &&
+		!memcmp(a->col, b->col, sizeof(a->col)) &&
+		!memcmp(&a->front, &b->front, sizeof(a->front)) &&
+		!memcmp(&a->back, &b->back, sizeof(a->back));
+}
+
+Palette* Palette::Intern()
+{
+	if (named || interned) {
+		return this;
+	}
+	internRequests++;
+
+	unsigned int h = HashColors(col, alpha);
+	std::pair<PaletteMap::iterator, PaletteMap::iterator> range = internedPalettes.equal_range(h);
+	for (PaletteMap::iterator it = range.first; it != range.second; ++it) {
+		if (SameColors(it->second, this)) {
+			it->second->acquire();
+			release();
+			return it->second;
+		}
+	}
+
+	// someone else may still change this one, so keep our own
+	Palette *pal = this;
+	if (IsShared()) {
+		pal = new Palette(col, alpha);
+		pal->front = front;
+		pal->back = back;
+		release();
+	}
+	pal->interned = true;
+	pal->hash = h;
+	internedPalettes.insert(std::make_pair(h, pal));
+	return pal;
+}
+
+void Palette::Forget()
+{
+	std::pair<PaletteMap::iterator, PaletteMap::iterator> range = internedPalettes.equal_range(hash);
+	for (PaletteMap::iterator it = range.first; it != range.second; ++it) {
+		if (it->second == this) {
+			internedPalettes.erase(it);
+			break;
+		}
+	}
+	interned = false;
+}
+
+void Palette::MakeWritable(Palette *&pal)
+{
+	if (!pal) {
+		pal = new Palette();
+		return;
+	}
+	if (pal->named) {
+		return;
+	}
+	if (pal->IsShared()) {
+		Palette *copy = new Palette(pal->col, pal->alpha);
+		copy->front = pal->front;
+		copy->back = pal->back;
+		pal->release();
+		pal = copy;
+	} else if (pal->interned) {
+		// the only user, it just has to leave the table
+		pal->Forget();
+	}
+}
+
+void Palette::GetInternStats(unsigned long &requested, unsigned long &unique)
+{
+	requested = internRequests;
+	unique = internedPalettes.size();
+}
+
 void Palette::SetupPaperdollColours(const ieDword* Colors, unsigned int type)
 {
 	unsigned int s = 8*type;
@@ -56,6 +56,8 @@ public:
 		alpha = alpha_;
 		refcount = 1;
 		named = false;
+		interned = false;
+		hash = 0;
 		memset(&front, 0, sizeof(front));
 		memset(&back, 0, sizeof(back));
 	}
@@ -63,6 +65,8 @@ public:
 		alpha = false;
 		refcount = 1;
 		named = false;
+		interned = false;
+		hash = 0;
 		memset(&col, 0, sizeof(col));
 		memset(&front, 0, sizeof(front));
 		memset(&back, 0, sizeof(back));
@@ -80,14 +84,21 @@ public:
 
 	void release() {
 		assert(refcount > 0);
-		if (!--refcount)
+		if (!--refcount) {
+			if (interned)
+				Forget();
 			delete this;
+		}
 	}
 
 	bool IsShared() const {
 		return (refcount > 1);
 	}
 
+	bool IsInterned() const {
+		return interned;
+	}
+
 	void CreateShadedAlphaChannel();
 	void Brighten();
 
@@ -99,8 +110,22 @@ public:
 
 	Palette* Copy();
 
+	/**
+	 * Returns the shared palette with the same colours, taking over this
+	 * reference. Interned palettes must not be modified, use MakeWritable.
+	 * Named (cached) palettes are returned unchanged. Main thread only.
+	 */
+	Palette* Intern();
+	/** creates pal or replaces it with a private copy if it is shared */
+	static void MakeWritable(Palette *&pal);
+	static void GetInternStats(unsigned long &requested, unsigned long &unique);
+
 private:
+	void Forget();
+
 	unsigned int refcount;
+	bool interned;
+	unsigned int hash;
 
 };
 
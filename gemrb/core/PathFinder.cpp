@@ -0,0 +1,396 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "PathFinder.h"
+
+#include "Benchmark.h"
+#include "System/Logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+namespace GemRB {
+
+#define MAX_SEGMENT_COUNT 0xffff
+
+Path::Path()
+{
+	length = 0;
+	lookupSegment = lookupBase = 0;
+	started = false;
+	current = segment = offset = 0;
+	step.x = step.y = 0;
+	step.orient = 0;
+}
+
+void Path::Clear()
+{
+	segments.clear();
+	length = 0;
+	lookupSegment = lookupBase = 0;
+	started = false;
+	current = segment = offset = 0;
+}
+
+void Path::Append(const PathNode &node)
+{
+	length++;
+	if (!segments.empty()) {
+		Segment &last = segments.back();
+		if (last.orient == node.orient && last.count < MAX_SEGMENT_COUNT) {
+			if (last.count == 1) {
+				//the second node decides where the run goes
+				last.dx = (short) (node.x - last.x);
+				last.dy = (short) (node.y - last.y);
+			}
+			//only extend the run if the node is where its next step would be
+			if (node.x == (unsigned short) (last.x + last.count * last.dx) &&
+				node.y == (unsigned short) (last.y + last.count * last.dy)) {
+				last.count++;
+				return;
+			}
+		}
+	}
+
+	Segment seg;
+	seg.x = node.x;
+	seg.y = node.y;
+	seg.dx = seg.dy = 0;
+	seg.count = 1;
+	seg.orient = node.orient;
+	segments.push_back(seg);
+}
+
+void Path::Append(const Path &path)
+{
+	for (size_t i = 0; i < path.segments.size(); i++) {
+		const Segment &seg = path.segments[i];
+		PathNode node;
+		node.orient = seg.orient;
+		for (unsigned int j = 0; j < seg.count; j++) {
+			node.x = (unsigned short) (seg.x + j * seg.dx);
+			node.y = (unsigned short) (seg.y + j * seg.dy);
+			Append(node);
+		}
+	}
+	if (started) {
+		Seek(current);
+	}
+}
+
+void Path::Prepend(const PathNode &node)
+{
+	Segment seg;
+	seg.x = node.x;
+	seg.y = node.y;
+	seg.dx = seg.dy = 0;
+	seg.count = 1;
+	seg.orient = node.orient;
+	segments.insert(segments.begin(), seg);
+	length++;
+	lookupSegment = lookupBase = 0;
+	Seek(started ? current + 1 : 0);
+}
+
+void Path::Reverse()
+{
+	std::reverse(segments.begin(), segments.end());
+	for (size_t i = 0; i < segments.size(); i++) {
+		Segment &seg = segments[i];
+		seg.x = (unsigned short) (seg.x + (seg.count - 1) * seg.dx);
+		seg.y = (unsigned short) (seg.y + (seg.count - 1) * seg.dy);
+		seg.dx = (short) -seg.dx;
+		seg.dy = (short) -seg.dy;
+	}
+	lookupSegment = lookupBase = 0;
+	Seek(0);
+}
+
+void Path::PopBack()
+{
+	assert(length);
+	Segment &last = segments.back();
+	if (!--last.count) {
+		segments.pop_back();
+	}
+	length--;
+	lookupSegment = lookupBase = 0;
+	if (current >= length) {
+		current = length ? length - 1 : 0;
+	}
+	Seek(current);
+}
+
+void Path::SetOrient(size_t index, unsigned int orient)
+{
+	assert(index < length);
+	Seek(index);
+	Segment &seg = segments[segment];
+	if (seg.orient == orient) {
+		Seek(current);
+		return;
+	}
+	if (seg.count == 1) {
+		seg.orient = orient;
+		Seek(current);
+		return;
+	}
+
+	//split the node off its segment
+	Segment before = seg, node = seg, after = seg;
+	before.count = (unsigned short) offset;
+	node.x = (unsigned short) (seg.x + offset * seg.dx);
+	node.y = (unsigned short) (seg.y + offset * seg.dy);
+	node.count = 1;
+	node.orient = orient;
+	after.x = (unsigned short) (node.x + seg.dx);
+	after.y = (unsigned short) (node.y + seg.dy);
+	after.count = (unsigned short) (seg.count - offset - 1);
+
+	size_t pos = segment;
+	segments.erase(segments.begin() + pos);
+	if (after.count) {
+		segments.insert(segments.begin() + pos, after);
+	}
+	segments.insert(segments.begin() + pos, node);
+	if (before.count) {
+		segments.insert(segments.begin() + pos, before);
+	}
+	lookupSegment = lookupBase = 0;
+	Seek(current);
+}
+
+PathNode Path::GetNode(size_t index) const
+{
+	assert(index < length);
+	if (index < lookupBase) {
+		lookupSegment = lookupBase = 0;
+	}
+	while (index - lookupBase >= segments[lookupSegment].count) {
+		lookupBase += segments[lookupSegment].count;
+		lookupSegment++;
+	}
+	const Segment &seg = segments[lookupSegment];
+	index -= lookupBase;
+	PathNode node;
+	node.x = (unsigned short) (seg.x + index * seg.dx);
+	node.y = (unsigned short) (seg.y + index * seg.dy);
+	node.orient = seg.orient;
+	return node;
+}
+
+void Path::Seek(size_t index)
+{
+	current = index;
+	segment = 0;
+	offset = index;
+	while (segment < segments.size() && offset >= segments[segment].count) {
+		offset -= segments[segment].count;
+		segment++;
+	}
+	UpdateStep();
+}
+
+void Path::UpdateStep()
+{
+	if (segment >= segments.size()) {
+		return;
+	}
+	const Segment &seg = segments[segment];
+	step.x = (unsigned short) (seg.x + offset * seg.dx);
+	step.y = (unsigned short) (seg.y + offset * seg.dy);
+	step.orient = seg.orient;
+}
+
+void Path::Start()
+{
+	started = true;
+	Seek(0);
+}
+
+bool Path::Advance()
+{
+	if (!HasNext()) {
+		return false;
+	}
+	current++;
+	if (++offset == segments[segment].count) {
+		segment++;
+		offset = 0;
+	}
+	UpdateStep();
+	return true;
+}
+
+
+static bool CheckNode(const Path &path, size_t index, unsigned short x, unsigned short y)
+{
+	PathNode node = path.GetNode(index);
+	if (node.x == x && node.y == y) {
+		return true;
+	}
+	Log(ERROR, "Path", "Node %d is at %d.%d instead of %d.%d.",
+		(int) index, node.x, node.y, x, y);
+	return false;
+}
+
+bool Path::Check()
+{
+	Path path;
+	PathNode node;
+	node.orient = 0;
+	bool ok = true;
+
+	//collinear steps make one segment
+	for (node.x = 10; node.x < 13; node.x++) {
+		node.y = 10;
+		path.Append(node);
+	}
+	if (path.GetSegmentCount() != 1) {
+		Log(ERROR, "Path", "Collinear steps took %d segments.", (int) path.GetSegmentCount());
+		ok = false;
+	}
+	//the same orientation after a gap starts a new one
+	node.x = 14;
+	path.Append(node);
+	//which the next step can extend in a new direction
+	node.x = 15;
+	node.y = 11;
+	path.Append(node);
+	node.x = 16;
+	node.y = 12;
+	path.Append(node);
+	if (path.GetSegmentCount() != 2) {
+		Log(ERROR, "Path", "The gap left %d segments instead of 2.", (int) path.GetSegmentCount());
+		ok = false;
+	}
+	ok &= CheckNode(path, 0, 10, 10);
+	ok &= CheckNode(path, 2, 12, 10);
+	ok &= CheckNode(path, 3, 14, 10);
+	ok &= CheckNode(path, 5, 16, 12);
+	return ok;
+}
+
+
+// how paths were stored before, one heap node per step
+struct ListNode {
+	ListNode *Parent;
+	ListNode *Next;
+	unsigned short x;
+	unsigned short y;
+	unsigned int orient;
+};
+
+#define BENCHMARK_ROUTES 2000
+#define BENCHMARK_ROUTE_LENGTH 200
+
+// straight runs in random directions, like the pathfinder returns them
+static void MakeRoute(std::vector<PathNode> &route, unsigned int seed)
+{
+	static const short stepX[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+	static const short stepY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+	PathNode node;
+	node.x = node.y = 1000;
+	node.orient = 0;
+	route.clear();
+	while (route.size() < BENCHMARK_ROUTE_LENGTH) {
+		seed = seed * 1103515245 + 12345;
+		unsigned int orient = (seed >> 16) & 7;
+		unsigned int run = 4 + ((seed >> 20) & 15);
+		for (unsigned int i = 0; i < run && route.size() < BENCHMARK_ROUTE_LENGTH; i++) {
+			node.x = (unsigned short) (node.x + stepX[orient]);
+			node.y = (unsigned short) (node.y + stepY[orient]);
+			node.orient = orient;
+			route.push_back(node);
+		}
+	}
+}
+
+// before: a heap node per step, linked up and walked
+static unsigned long WalkLists(void *arg)
+{
+	const std::vector<PathNode> &route = *(const std::vector<PathNode> *) arg;
+	unsigned long sum = 0;
+	for (int r = 0; r < BENCHMARK_ROUTES; r++) {
+		ListNode *head = NULL, *tail = NULL;
+		for (size_t i = 0; i < route.size(); i++) {
+			ListNode *node = new ListNode;
+			node->x = route[i].x;
+			node->y = route[i].y;
+			node->orient = route[i].orient;
+			node->Parent = tail;
+			node->Next = NULL;
+			if (tail) {
+				tail->Next = node;
+			} else {
+				head = node;
+			}
+			tail = node;
+		}
+		for (ListNode *step = head; step; step = step->Next) {
+			sum += step->x + step->y + step->orient;
+		}
+		while (head) {
+			ListNode *next = head->Next;
+			delete head;
+			head = next;
+		}
+	}
+	return sum;
+}
+
+static void FillPath(Path &path, const std::vector<PathNode> &route)
+{
+	path.Clear();
+	for (size_t i = 0; i < route.size(); i++) {
+		path.Append(route[i]);
+	}
+}
+
+// now: one path reused like the released paths of a map
+static unsigned long WalkPaths(void *arg)
+{
+	const std::vector<PathNode> &route = *(const std::vector<PathNode> *) arg;
+	unsigned long sum = 0;
+	Path path;
+	for (int r = 0; r < BENCHMARK_ROUTES; r++) {
+		FillPath(path, route);
+		path.Start();
+		do {
+			const PathNode &step = path.GetStep();
+			sum += step.x + step.y + step.orient;
+		} while (path.Advance());
+	}
+	return sum;
+}
+
+void Path::Benchmark(StringBuffer &buffer)
+{
+	std::vector<PathNode> route;
+	MakeRoute(route, 1);
+	Path path;
+	FillPath(path, route);
+
+	char what[64];
+	snprintf(what, sizeof(what), "%d routes of %d steps (%d segments)",
+		BENCHMARK_ROUTES, (int) route.size(), (int) path.GetSegmentCount());
+	GemRB::Benchmark("Paths", what).Compare(buffer, &route, "lists", WalkLists, "paths", WalkPaths);
+}
+
+}
@@ -20,8 +20,15 @@
 #ifndef PATHFINDER_H
 #define PATHFINDER_H
 
+#include "exports.h"
+
+#include <cstddef>
+#include <vector>
+
 namespace GemRB {
 
+class StringBuffer;
+
 //searchmap conversion bits
 
 enum {
@@ -44,13 +51,73 @@ enum {
 };
 
 struct PathNode {
-	PathNode* Parent;
-	PathNode* Next;
 	unsigned short x;
 	unsigned short y;
 	unsigned int orient;
 };
 
+/**
+ * A path stored as one buffer with its own cursor. Runs of steps with the
+ * same orientation and spacing are kept as a single segment, the nodes are
+ * only expanded when asked for.
+ */
+class GEM_EXPORT Path {
+private:
+	struct Segment {
+		unsigned short x, y; // first node
+		short dx, dy; // offset from one node to the next
+		unsigned short count;
+		unsigned int orient;
+	};
+	std::vector<Segment> segments;
+	size_t length;
+	// where the last GetNode lookup ended, so walking the nodes in order is cheap
+	mutable size_t lookupSegment, lookupBase;
+
+	// the cursor, both as a node index and as segment and offset
+	bool started;
+	size_t current, segment, offset;
+	PathNode step;
+
+	void Seek(size_t index);
+	void UpdateStep();
+public:
+	Path();
+
+	/** empties the path, but keeps the buffer */
+	void Clear();
+	bool Empty() const { return length == 0; }
+	size_t GetLength() const { return length; }
+	size_t GetSegmentCount() const { return segments.size(); }
+
+	void Append(const PathNode &node);
+	void Append(const Path &path);
+	void Prepend(const PathNode &node);
+	/** for the searches that walk back from the goal */
+	void Reverse();
+	void PopBack();
+	void SetOrient(size_t index, unsigned int orient);
+	PathNode GetNode(size_t index) const;
+	PathNode Back() const { return GetNode(length - 1); }
+
+	/** the cursor stays before the first node until started */
+	bool IsStarted() const { return started; }
+	void Start();
+	/** moves to the next node, false if there is none */
+	bool Advance();
+	const PathNode &GetStep() const { return step; }
+	bool HasNext() const { return current + 1 < length; }
+	PathNode GetNext() const { return GetNode(current + 1); }
+	/** the nodes left after the current one */
+	size_t GetRemaining() const { return length - current - 1; }
+	size_t GetPosition() const { return current; }
+
+	/** verifies how nodes are merged into segments, logs the failures */
+	static bool Check();
+	/** times building and walking routes as linked nodes and as paths */
+	static void Benchmark(StringBuffer &buffer);
+};
+
 }
 
 #endif
@@ -0,0 +1,151 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "PickIndex.h"
+
+#include <cstddef>
+
+namespace GemRB {
+
+//anything left of or above the area ends up in the first row/column
+static inline int CellOf(int coord)
+{
+	if (coord < 0) return 0;
+	return coord / PICK_CELL_SIZE;
+}
+
+PickIndex::PickIndex()
+{
+	cols = rows = 0;
+	nextSerial = 0;
+}
+
+PickIndex::~PickIndex()
+{
+}
+
+void PickIndex::Clear()
+{
+	cells.clear();
+	spans.clear();
+	cols = rows = 0;
+	nextSerial = 0;
+}
+
+void PickIndex::Grow(int newCols, int newRows)
+{
+	if (newCols <= cols && newRows <= rows) {
+		return;
+	}
+	if (newCols < cols) newCols = cols;
+	if (newRows < rows) newRows = rows;
+
+	std::vector<Cell> grown(newCols * newRows);
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < cols; x++) {
+			grown[y * newCols + x].swap(cells[y * cols + x]);
+		}
+	}
+	cells.swap(grown);
+	cols = newCols;
+	rows = newRows;
+}
+
+void PickIndex::Link(Scriptable *object, const Span &span)
+{
+	Entry entry;
+	entry.serial = span.serial;
+	entry.object = object;
+
+	Grow(span.x2 + 1, span.y2 + 1);
+	for (int y = span.y1; y <= span.y2; y++) {
+		for (int x = span.x1; x <= span.x2; x++) {
+			Cell &cell = cells[y * cols + x];
+			Cell::iterator it = cell.end();
+			//usually appending, moved objects may have to go further back
+			while (it != cell.begin() && (it - 1)->serial > entry.serial) {
+				--it;
+			}
+			cell.insert(it, entry);
+		}
+	}
+}
+
+void PickIndex::Unlink(Scriptable *object, const Span &span)
+{
+	for (int y = span.y1; y <= span.y2; y++) {
+		for (int x = span.x1; x <= span.x2; x++) {
+			Cell &cell = cells[y * cols + x];
+			for (Cell::iterator it = cell.begin(); it != cell.end(); ++it) {
+				if (it->object == object) {
+					cell.erase(it);
+					break;
+				}
+			}
+		}
+	}
+}
+
+void PickIndex::Update(Scriptable *object, const Region &bbox)
+{
+	Span span;
+	span.x1 = CellOf(bbox.x);
+	span.y1 = CellOf(bbox.y);
+	span.x2 = CellOf(bbox.x + bbox.w);
+	span.y2 = CellOf(bbox.y + bbox.h);
+
+	SpanMap::iterator it = spans.find(object);
+	if (it == spans.end()) {
+		span.serial = nextSerial++;
+		spans[object] = span;
+		Link(object, span);
+		return;
+	}
+
+	Span &old = it->second;
+	//still in the same cells, this is the common case for walking actors
+	if (old.x1 == span.x1 && old.y1 == span.y1 && old.x2 == span.x2 && old.y2 == span.y2) {
+		return;
+	}
+	span.serial = old.serial;
+	Unlink(object, old);
+	old = span;
+	Link(object, span);
+}
+
+void PickIndex::Remove(Scriptable *object)
+{
+	SpanMap::iterator it = spans.find(object);
+	if (it == spans.end()) {
+		return;
+	}
+	Unlink(object, it->second);
+	spans.erase(it);
+}
+
+const PickIndex::Cell *PickIndex::Query(const Point &p) const
+{
+	int x = CellOf(p.x);
+	int y = CellOf(p.y);
+	if (x >= cols || y >= rows) {
+		return NULL;
+	}
+	return &cells[y * cols + x];
+}
+
+}
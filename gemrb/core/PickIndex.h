@@ -0,0 +1,88 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file PickIndex.h
+ * Declares PickIndex, a grid for finding the objects under the cursor
+ * @author The GemRB Project
+ */
+
+#ifndef PICKINDEX_H
+#define PICKINDEX_H
+
+#include "exports.h"
+
+#include "Region.h"
+
+#include <map>
+#include <vector>
+
+namespace GemRB {
+
+class Scriptable;
+
+//size of a grid cell in area pixels
+#define PICK_CELL_SIZE 128
+
+/**
+ * @class PickIndex
+ * A uniform grid over the bounding boxes of area objects. Every object is
+ * listed in each cell its box touches, so a point lookup only has to test
+ * the handful of objects sharing its cell. The entries of a cell are kept
+ * in insertion order, which lets the callers return the same object a
+ * linear scan of their own lists would.
+ */
+
+class GEM_EXPORT PickIndex {
+public:
+	struct Entry {
+		unsigned int serial;
+		Scriptable *object;
+	};
+	typedef std::vector<Entry> Cell;
+
+	PickIndex();
+	~PickIndex();
+
+	/** adds the object or moves it to a new (inclusive) bounding box */
+	void Update(Scriptable *object, const Region &bbox);
+	void Remove(Scriptable *object);
+	void Clear();
+	/** returns the candidates for a point, oldest first, or NULL */
+	const Cell *Query(const Point &p) const;
+
+private:
+	struct Span {
+		unsigned int serial;
+		int x1, y1, x2, y2;
+	};
+	typedef std::map<Scriptable *, Span> SpanMap;
+
+	void Grow(int cols, int rows);
+	void Link(Scriptable *object, const Span &span);
+	void Unlink(Scriptable *object, const Span &span);
+
+	std::vector<Cell> cells;
+	int cols, rows;
+	SpanMap spans;
+	unsigned int nextSerial;
+};
+
+}
+
+#endif
@@ -61,8 +61,8 @@ Projectile::Projectile()
 	Orientation = 0;
 	NewOrientation = 0;
 	path = NULL;
-	step = NULL;
 	timeStartStep = 0;
+	PrevPosTick = 0;
 	phase = P_UNINITED;
 	effects = NULL;
 	children = NULL;
@@ -95,10 +95,13 @@ Projectile::~Projectile()
 	if (autofree) {
 		free(Extension);
 	}
-	delete effects;
+	if (effects) {
+		effects->Release();
+	}
 
 	gamedata->FreePalette(palette, PaletteRes);
-	ClearPath();
+	//the area may be gone already, so don't return it to the pool
+	delete path;
 
 	if (travel_handle) {
 		//allow an explosion sound to finish completely
@@ -245,7 +248,9 @@ void Projectile::SetupPalette(Animation *anim[], Palette *&pal, const ieByte *gr
 	}
 	GetPaletteCopy(anim, pal);
 	if (pal) {
+		Palette::MakeWritable(pal);
 		pal->SetupPaperdollColours(Colors, 0);
+		pal = pal->Intern();
 	}
 }
 
@@ -269,12 +274,14 @@ void Projectile::SetBlend(int brighten)
 	GetPaletteCopy(travel, palette);
 	if (!palette)
 		return;
+	Palette::MakeWritable(palette);
 	if (!palette->alpha) {
 		palette->CreateShadedAlphaChannel();
 	}
 	if (brighten) {
 		palette->Brighten();
 	}
+	palette = palette->Intern();
 }
 
 //create another projectile with type-1 (iterate magic missiles and call lightning)
@@ -452,7 +459,6 @@ Actor *Projectile::GetTarget()
 			return target;
 		}
 		if (original == target && !effects->HasHostileEffects()) {
-			effects->SetOwner(target);
 			return target;
 		}
 
@@ -470,16 +476,11 @@ Actor *Projectile::GetTarget()
 				return NULL;
 			}
 		}
-		effects->SetOwner(original);
 		return target;
 	} else {
 		Log(DEBUG, "Projectile", "GetTarget: Target not set or dummy, using caster!");
 	}
-	target = area->GetActorByGlobalID(Caster);
-	if (target) {
-		effects->SetOwner(target);
-	}
-	return target;
+	return area->GetActorByGlobalID(Caster);
 }
 
 void Projectile::SetDelay(int delay)
@@ -615,13 +616,14 @@ void Projectile::Payload()
 			}
 
 			if (effects) {
-				effects->SetOwner(Owner);
-				effects->AddAllEffects(target, Destination);
+				effects->AddAllEffects(target, Destination, Owner);
 			}
 		}
 	}
 
-	delete effects;
+	if (effects) {
+		effects->Release();
+	}
 	effects = NULL;
 }
 
@@ -855,11 +857,11 @@ void Projectile::DoStep(unsigned int walk_speed)
 	//path won't be calculated if speed==0
 	walk_speed=1500/walk_speed;
 	ieDword time = core->GetGame()->Ticks;
-	if (!step) {
-		step = path;
+	if (!path->IsStarted()) {
+		path->Start();
 	}
-	while (step->Next && (( time - timeStartStep ) >= walk_speed)) {
-		step = step->Next;
+	while (path->HasNext() && (( time - timeStartStep ) >= walk_speed)) {
+		path->Advance();
 		if (!walk_speed) {
 			timeStartStep = time;
 			break;
@@ -867,14 +869,15 @@ void Projectile::DoStep(unsigned int walk_speed)
 		timeStartStep = timeStartStep + walk_speed;
 	}
 
-	SetOrientation (step->orient, false);
+	const PathNode &step = path->GetStep();
+	SetOrientation (step.orient, false);
 
-	Pos.x=step->x;
-	Pos.y=step->y;
+	Pos.x=step.x;
+	Pos.y=step.y;
 	if (travel_handle) {
 		travel_handle->SetPos(Pos.x, Pos.y);
 	}
-	if (!step->Next) {
+	if (!path->HasNext()) {
 		ClearPath();
 		NewOrientation = Orientation;
 		ChangePhase();
@@ -888,18 +891,19 @@ void Projectile::DoStep(unsigned int walk_speed)
 		drawSpark = 1;
 	}
 
-	if (step->Next->x > step->x)
+	PathNode next = path->GetNext();
+	if (next.x > step.x)
 		Pos.x += ( unsigned short )
-			( ( step->Next->x - Pos.x ) * ( time - timeStartStep ) / walk_speed );
+			( ( next.x - Pos.x ) * ( time - timeStartStep ) / walk_speed );
 	else
 		Pos.x -= ( unsigned short )
-			( ( Pos.x - step->Next->x ) * ( time - timeStartStep ) / walk_speed );
-	if (step->Next->y > step->y)
+			( ( Pos.x - next.x ) * ( time - timeStartStep ) / walk_speed );
+	if (next.y > step.y)
 		Pos.y += ( unsigned short )
-			( ( step->Next->y - Pos.y ) * ( time - timeStartStep ) / walk_speed );
+			( ( next.y - Pos.y ) * ( time - timeStartStep ) / walk_speed );
 	else
 		Pos.y -= ( unsigned short )
-			( ( Pos.y - step->Next->y ) * ( time - timeStartStep ) / walk_speed );
+			( ( Pos.y - next.y ) * ( time - timeStartStep ) / walk_speed );
 
 }
 
@@ -988,14 +992,12 @@ void Projectile::MoveTo(Map *map, const Point &Des)
 
 void Projectile::ClearPath()
 {
-	PathNode* thisNode = path;
-	while (thisNode) {
-		PathNode* nextNode = thisNode->Next;
-		delete( thisNode );
-		thisNode = nextNode;
+	if (area) {
+		area->ReleasePath(path);
+	} else {
+		delete path;
 	}
 	path = NULL;
-	step = NULL;
 }
 
 int Projectile::CalculateTargetFlag()
@@ -1067,14 +1069,15 @@ void Projectile::CheckTrigger(unsigned int radius)
 	}
 }
 
+//the payload is only read from now on, so the projectiles can share it
 void Projectile::SetEffectsCopy(EffectQueue *eq)
 {
-	if(effects) delete effects;
+	if(effects) effects->Release();
 	if(!eq) {
 		effects=NULL;
 		return;
 	}
-	effects = eq->CopySelf();
+	effects = eq->Share();
 }
 
 void Projectile::LineTarget()
@@ -1085,26 +1088,23 @@ void Projectile::LineTarget()
 
 	Actor *original = area->GetActorByGlobalID(Caster);
 	Actor *prev = NULL;
-	PathNode *iter = path;
-	while(iter) {
-		Point pos(iter->x,iter->y);
+	size_t length = path ? path->GetLength() : 0;
+	for (size_t i = 0; i < length; i++) {
+		PathNode iter = path->GetNode(i);
+		Point pos(iter.x,iter.y);
 		Actor *target = area->GetActorInRadius(pos, CalculateTargetFlag(), 1);
 		if (target && target->GetGlobalID()!=Caster && prev!=target) {
 			prev = target;
 	 		int res = effects->CheckImmunity ( target );
 			if (res>0) {
-				EffectQueue *eff = effects->CopySelf();
-				eff->SetOwner(original);
 				if(ExtFlags&PEF_RGB) {
 					target->SetColorMod(0xff, RGBModifier::ADD, ColorSpeed,
 						RGB >> 8, RGB >> 16, RGB >> 24);
 				}
 
-				eff->AddAllEffects(target, target->Pos);
-				delete eff;
+				effects->AddAllEffects(target, target->Pos, original);
 			}
 		}
-		iter = iter->Next;
 	}
 }
 
@@ -1243,6 +1243,8 @@ int Projectile::Update()
 	}
 
 	if (phase == P_TRAVEL || phase == P_TRAVEL2) {
+		PrevPos = Pos;
+		PrevPosTick = core->GetGame()->Ticks;
 		DoStep(Speed);
 	}
 	return 1;
@@ -1617,12 +1619,13 @@ void Projectile::DrawLine(const Region &screen, int face, ieDword flag)
 {
 	Video *video = core->GetVideoDriver();
 	Game *game = core->GetGame();
-	PathNode *iter = path;
 	Sprite2D *frame = travel[face]->NextFrame();
 	Color tint2 = tint;
 	if (game) game->ApplyGlobalTint(tint2, flag);
-	while(iter) {
-		Point pos(iter->x, iter->y);
+	size_t length = path ? path->GetLength() : 0;
+	for (size_t i = 0; i < length; i++) {
+		PathNode iter = path->GetNode(i);
+		Point pos(iter.x, iter.y);
 
 		if (SFlags&PSF_FLYING) {
 			pos.y-=FLY_HEIGHT;
@@ -1631,7 +1634,6 @@ void Projectile::DrawLine(const Region &screen, int face, ieDword flag)
 		pos.y+=screen.y;
 
 		video->BlitGameSprite( frame, pos.x, pos.y, flag, tint2, NULL, palette, &screen);
-		iter = iter->Next;
 	}
 }
 
@@ -1664,6 +1666,9 @@ void Projectile::DrawTravel(const Region &screen)
 		SetPos(face, GetTravelPos(face), GetShadowPos(face));
 	}
 	Point pos = Pos;
+	if (PrevPosTick == game->Ticks) {
+		pos = core->timer->Interpolate(PrevPos, Pos);
+	}
 	pos.x+=screen.x;
 	pos.y+=screen.y;
 
@@ -1812,7 +1817,9 @@ void Projectile::StaticTint(const Color &newtint)
 void Projectile::Cleanup()
 {
 	//neutralise the payload
-	delete effects;
+	if (effects) {
+		effects->Release();
+	}
 	effects = NULL;
 	//diffuse the projectile
 	phase=P_EXPIRED;
@@ -233,11 +233,13 @@ protected:
 	ieDword timeStartStep;
 	//attributes from moveable object
 	unsigned char Orientation, NewOrientation;
-	PathNode* path; //whole path
-	PathNode* step; //actual step
+	Path* path; //whole path, with the actual step
 	//similar to normal actors
 	Map *area;
 	Point Pos;
+	// position before the last update, for smoother drawing
+	Point PrevPos;
+	ieDword PrevPosTick;
 	int ZPos;
 	Point Destination;
 	Point Origin;
@@ -276,11 +278,11 @@ public:
 	void Cleanup();
 
 	//inliners to protect data consistency
-	inline PathNode * GetNextStep() {
-		if (!step) {
+	inline const PathNode * GetNextStep() {
+		if (path && !path->IsStarted()) {
 			DoStep((unsigned int) ~0);
 		}
-		return step;
+		return path ? &path->GetStep() : NULL;
 	}
 
 	inline Point GetDestination() const { return Destination; }
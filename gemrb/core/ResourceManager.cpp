@@ -46,6 +46,7 @@ bool ResourceManager::AddSource(const char *path, const char *description, Plugi
 		return false;
 	}
 
+	MutexLock lock(searchLock);
 	if (flags & RM_REPLACE_SAME_SOURCE) {
 		for (size_t i = 0; i < searchPath.size(); i++) {
 			if (!stricmp(description, searchPath[i]->GetDescription())) {
@@ -72,11 +73,14 @@ bool ResourceManager::Exists(const char *ResRef, SClass_ID type, bool silent) co
 	if (ResRef[0] == '\0')
 		return false;
 	// TODO: check various caches
+	searchLock.Lock();
 	for (size_t i = 0; i < searchPath.size(); i++) {
 		if (searchPath[i]->HasResource( ResRef, type )) {
+			searchLock.Unlock();
 			return true;
 		}
 	}
+	searchLock.Unlock();
 	if (!silent) {
 		Log(WARNING, "ResourceManager", "'%s.%s' not found...",
 			ResRef, core->TypeExt(type));
@@ -90,13 +94,16 @@ bool ResourceManager::Exists(const char *ResRef, const TypeID *type, bool silent
 		return false;
 	// TODO: check various caches
 	const std::vector<ResourceDesc> &types = PluginMgr::Get()->GetResourceDesc(type);
+	searchLock.Lock();
 	for (size_t j = 0; j < types.size(); j++) {
 		for (size_t i = 0; i < searchPath.size(); i++) {
 			if (searchPath[i]->HasResource(ResRef, types[j])) {
+				searchLock.Unlock();
 				return true;
 			}
 		}
 	}
+	searchLock.Unlock();
 	if (!silent) {
 		StringBuffer buffer;
 		buffer.appendFormatted("Couldn't find '%s'... ", ResRef);
@@ -111,6 +118,7 @@ DataStream* ResourceManager::GetResource(const char* ResRef, SClass_ID type, boo
 {
 	if (ResRef[0] == '\0')
 		return NULL;
+	searchLock.Lock();
 	for (size_t i = 0; i < searchPath.size(); i++) {
 		DataStream *ds = searchPath[i]->GetResource(ResRef, type);
 		if (ds) {
@@ -118,9 +126,11 @@ DataStream* ResourceManager::GetResource(const char* ResRef, SClass_ID type, boo
 				Log(MESSAGE, "ResourceManager", "Found '%s.%s' in '%s'.",
 					ResRef, core->TypeExt(type), searchPath[i]->GetDescription());
 			}
+			searchLock.Unlock();
 			return ds;
 		}
 	}
+	searchLock.Unlock();
 	if (!silent) {
 		Log(ERROR, "ResourceManager", "Couldn't find '%s.%s'.",
 			ResRef, core->TypeExt(type));
@@ -137,23 +147,33 @@ Resource* ResourceManager::GetResource(const char* ResRef, const TypeID *type, b
 	}
 	const std::vector<ResourceDesc> &types = PluginMgr::Get()->GetResourceDesc(type);
 	for (size_t j = 0; j < types.size(); j++) {
-		for (size_t i = 0; i < searchPath.size(); i++) {
+		for (size_t i = 0; ; i++) {
+			// not held while creating the resource, since that may load others
+			char description[_MAX_PATH];
+			searchLock.Lock();
+			if (i >= searchPath.size()) {
+				searchLock.Unlock();
+				break;
+			}
 			DataStream *str = searchPath[i]->GetResource(ResRef, types[j]);
-			if (!str && useCorrupt && core->UseCorruptedHack) {
-				// don't look at other paths if requested
-				core->UseCorruptedHack = false;
-				return NULL;
+			if (str && !silent) {
+				strlcpy(description, searchPath[i]->GetDescription(), sizeof(description));
 			}
-			core->UseCorruptedHack = false;
-			if (str) {
-				Resource *res = types[j].Create(str);
-				if (res) {
-					if (!silent) {
-						Log(MESSAGE, "ResourceManager", "Found '%s.%s' in '%s'.",
-							ResRef, types[j].GetExt(), searchPath[i]->GetDescription());
-					}
-					return res;
+			searchLock.Unlock();
+			if (!str) {
+				continue;
+			}
+			Resource *res = types[j].Create(str);
+			if (res) {
+				if (!silent) {
+					Log(MESSAGE, "ResourceManager", "Found '%s.%s' in '%s'.",
+						ResRef, types[j].GetExt(), description);
 				}
+				return res;
+			}
+			if (useCorrupt) {
+				// found, but unusable; don't look at other paths if requested
+				return NULL;
 			}
 		}
 	}
@@ -25,6 +25,7 @@
 #include "exports.h"
 
 #include "Holder.h"
+#include "System/Thread.h"
 
 #include <vector>
 
@@ -64,11 +65,13 @@ public:
 
 	/** Returns stream associated to given resource */
 	DataStream* GetResource(const char* resname, SClass_ID type, bool silent = false) const;
-	/** Returns Resource object associated to given resource */
+	/** Returns Resource object associated to given resource, useCorrupt stops at the first match even if it fails to load */
 	Resource* GetResource(const char* resname, const TypeID *type, bool silent = false, bool useCorrupt = false) const;
 
 private:
 	std::vector<Holder<ResourceSource> > searchPath;
+	/** the sources are also searched by the background loaders */
+	mutable Mutex searchLock;
 };
 
 }
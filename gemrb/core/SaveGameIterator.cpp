@@ -24,6 +24,7 @@
 #include "strrefs.h"
 #include "win32def.h"
 
+#include "ArchiveImporter.h"
 #include "DisplayMessage.h"
 #include "GameData.h" // For ResourceHolder
 #include "ImageMgr.h"
@@ -34,8 +35,10 @@
 #include "Sprite2D.h"
 #include "TableMgr.h"
 #include "GUI/GameControl.h"
+#include "GameScript/ScriptProfiler.h"
 #include "Scriptable/Actor.h"
 #include "System/FileStream.h"
+#include "System/MemoryStream.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -177,10 +180,12 @@ const char* SaveGame::GetGameDate() const
 
 SaveGameIterator::SaveGameIterator(void)
 {
+	saveJob = NULL;
 }
 
 SaveGameIterator::~SaveGameIterator(void)
 {
+	FinishSave(true);
 }
 
 /* mission pack save */
@@ -279,8 +284,14 @@ static bool IsSaveGameSlot(const char* Path, const char* slotname)
 	return true;
 }
 
+static bool IsBeingWritten(const SaveJob *job, const char *slot);
+
 bool SaveGameIterator::RescanSaveGames()
 {
+	// a save still being written would show up half done, so it is left
+	// out until its job is done instead of waiting for it here
+	FinishSave(false);
+
 	// delete old entries
 	save_slots.clear();
 
@@ -303,7 +314,7 @@ bool SaveGameIterator::RescanSaveGames()
 	std::set<char*,iless> slots;
 	do {
 		const char *name = dir.GetName();
-		if (dir.IsDirectory() && IsSaveGameSlot( Path, name )) {
+		if (dir.IsDirectory() && IsSaveGameSlot( Path, name ) && !IsBeingWritten(saveJob, name)) {
 			slots.insert(strdup(name));
 		}
 	} while (++dir);
@@ -325,6 +336,8 @@ const std::vector<Holder<SaveGame> >& SaveGameIterator::GetSaveGames()
 
 Holder<SaveGame> SaveGameIterator::GetSaveGame(const char *name)
 {
+	// the slot may be the one still being written, which the scan leaves out
+	FinishSave(true);
 	RescanSaveGames();
 
 	for (std::vector<Holder<SaveGame> >::iterator i = save_slots.begin(); i != save_slots.end(); i++) {
@@ -412,62 +425,256 @@ void SaveGameIterator::PruneQuickSave(const char *folder)
 	}
 }
 
-/** Save game to given directory */
-static bool DoSaveGame(const char *Path)
+/** writes a serialised game or worldmap to a new file */
+static bool FlushBuffer(const MemoryStream &buffer, const char *folder, SClass_ID type)
+{
+	FileStream outfile;
+	if (!outfile.Create(folder, buffer.filename, type)) {
+		return false;
+	}
+	unsigned long size = buffer.Size();
+	return !size || outfile.Write(buffer.GetData(), size) == (int) size;
+}
+
+/** Everything a save needs, taken on the main thread, so the game may go on
+ * while it is being compressed and written */
+struct SaveJob {
+	char Path[_MAX_PATH];
+	ieResRef GameName;
+	int strref;
+	std::vector<DataStream*> files;
+	//the game and worldmap get serialised into these
+	MemoryStream gam, wmp1, wmp2;
+	std::vector<Sprite2D*> portraits;
+	Sprite2D *preview;
+	PluginHolder<ArchiveImporter> ai;
+	PluginHolder<ImageWriter> im;
+
+	//how long each part of the save took, in microseconds
+	unsigned long areaTime, cacheTime, gameTime, worldMapTime, previewTime, writeTime;
+
+	Mutex lock;
+	bool done;
+	bool success;
+
+	SaveJob(const char *path)
+		: gam(core->GameNameResRef, NULL, 0), wmp1(core->WorldMapName[0], NULL, 0), wmp2(core->WorldMapName[1], NULL, 0),
+		preview(NULL), ai(IE_SAV_CLASS_ID), im(PLUGIN_IMAGE_WRITER_BMP),
+		areaTime(0), cacheTime(0), gameTime(0), worldMapTime(0), previewTime(0), writeTime(0),
+		done(false), success(false)
+	{
+		strlcpy(Path, path, sizeof(Path));
+		CopyResRef(GameName, core->GameNameResRef);
+		strref = STR_SAVESUCCEED;
+	}
+	~SaveJob()
+	{
+		for (size_t i = 0; i < files.size(); i++) {
+			delete files[i];
+		}
+		for (size_t i = 0; i < portraits.size(); i++) {
+			Sprite2D::FreeSprite(portraits[i]);
+		}
+		Sprite2D::FreeSprite(preview);
+	}
+};
+
+static bool IsBeingWritten(const SaveJob *job, const char *slot)
+{
+	if (!job) {
+		return false;
+	}
+	const char *name = strrchr(job->Path, PathDelimiter);
+	return name && !strcmp(name + 1, slot);
+}
+
+static unsigned long TimeSince(unsigned __int64 &start)
 {
+	unsigned __int64 now = ScriptProfiler::Now();
+	unsigned long elapsed = (unsigned long) (now - start);
+	start = now;
+	return elapsed;
+}
+
+/** Takes the snapshot of the game for saving it to the given directory
+ * The game, worldmap and areas are serialised here, because their objects
+ * keep changing once the game goes on. Only the writing is left to the
+ * save thread, the timings logged by FinishSave show what that saves. */
+static SaveJob* SnapshotGame(const char *Path)
+{
+	unsigned __int64 start = ScriptProfiler::Now();
 	Game *game = core->GetGame();
 	//saving areas to cache currently in memory
 	unsigned int mc = (unsigned int) game->GetLoadedMapCount();
 	while (mc--) {
 		Map *map = game->GetMap(mc);
-		if (core->SwapoutArea(map)) {
-			return false;
+		if (core->SwapoutArea(map, true)) {
+			return NULL;
 		}
 	}
+	unsigned long areaTime = TimeSince(start);
 
 	gamedata->SaveAllStores();
+	//the save would miss the areas that couldn't be written
+	if (!gamedata->SaveAllAreas()) {
+		return NULL;
+	}
 
-	//compress files in cache named: .STO and .ARE
-	//no .CRE would be saved in cache
-	if (core->CompressSave(Path)) {
-		return false;
+	SaveJob *job = new SaveJob(Path);
+	job->areaTime = areaTime;
+	if (!job->ai) {
+		Log(ERROR, "SaveGameIterator", "Couldn't create the SAV archiver!");
+		delete job;
+		return NULL;
+	}
+	if (!job->im) {
+		Log(ERROR, "SaveGameIterator", "Couldn't create the BMPWriter!");
+		delete job;
+		return NULL;
 	}
 
-	//Create .gam file from Game() object
-	if (core->WriteGame(Path)) {
-		return false;
+	//read the files in cache named: .STO and .ARE
+	//no .CRE would be saved in cache
+	if (core->ReadSaveFiles(job->files)) {
+		delete job;
+		return NULL;
 	}
+	job->cacheTime = TimeSince(start);
 
-	//Create .wmp file from WorldMap() object
-	if (core->WriteWorldMap(Path)) {
-		return false;
+	//serialise the Game() object for the .gam file
+	if (core->WriteGame(&job->gam)) {
+		delete job;
+		return NULL;
 	}
+	job->gameTime = TimeSince(start);
 
-	PluginHolder<ImageWriter> im(PLUGIN_IMAGE_WRITER_BMP);
-	if (!im) {
-		Log(ERROR, "SaveGameIterator", "Couldn't create the BMPWriter!");
-		return false;
+	//serialise the WorldMap() object for the .wmp file(s)
+	if (core->WriteWorldMap(&job->wmp1, &job->wmp2)) {
+		delete job;
+		return NULL;
 	}
+	job->worldMapTime = TimeSince(start);
 
-	//Create portraits
+	//portraits
 	for (int i = 0; i < game->GetPartySize( false ); i++) {
-		Sprite2D* portrait = core->GetGameControl()->GetPortraitPreview( i );
-		if (portrait) {
+		job->portraits.push_back(core->GetGameControl()->GetPortraitPreview( i ));
+	}
+
+	// area preview
+	job->preview = core->GetGameControl()->GetPreview();
+	job->previewTime = TimeSince(start);
+
+	return job;
+}
+
+/** Compresses and writes the snapshot, this runs on the save thread */
+void SaveGameIterator::SaveThread(void *arg)
+{
+	SaveJob *job = (SaveJob *) arg;
+	const char *Path = job->Path;
+	bool success = true;
+	unsigned __int64 start = ScriptProfiler::Now();
+
+	//create the .sav archive from the cache files
+	FileStream str;
+	if (str.Create( Path, job->GameName, IE_SAV_CLASS_ID )) {
+		job->ai->CreateArchive( &str);
+		for (size_t i = 0; i < job->files.size(); i++) {
+			job->ai->AddToSaveGame(&str, job->files[i]);
+		}
+	} else {
+		success = false;
+	}
+
+	success = FlushBuffer(job->gam, Path, IE_GAM_CLASS_ID) && success;
+	success = FlushBuffer(job->wmp1, Path, IE_WMP_CLASS_ID) && success;
+	//the second worldmap is only filled for split worldmaps
+	if (job->wmp2.Size()) {
+		success = FlushBuffer(job->wmp2, Path, IE_WMP_CLASS_ID) && success;
+	}
+	if (!success) {
+		Log(WARNING, "SaveGameIterator", "Game cannot be saved: %s", Path);
+	}
+
+	//write portraits
+	for (size_t i = 0; i < job->portraits.size(); i++) {
+		if (job->portraits[i]) {
 			char FName[_MAX_PATH];
-			snprintf( FName, sizeof(FName), "PORTRT%d", i );
+			snprintf( FName, sizeof(FName), "PORTRT%d", (int) i );
 			FileStream outfile;
 			outfile.Create( Path, FName, IE_BMP_CLASS_ID );
-			im->PutImage( &outfile, portrait );
+			job->im->PutImage( &outfile, job->portraits[i] );
 		}
 	}
 
-	// Create area preview
-	Sprite2D* preview = core->GetGameControl()->GetPreview();
-	FileStream outfile;
-	outfile.Create( Path, core->GameNameResRef, IE_BMP_CLASS_ID );
-	im->PutImage( &outfile, preview );
+	// write area preview
+	if (job->preview) {
+		FileStream outfile;
+		outfile.Create( Path, job->GameName, IE_BMP_CLASS_ID );
+		job->im->PutImage( &outfile, job->preview );
+	}
 
-	return true;
+	unsigned long writeTime = TimeSince(start);
+	MutexLock lock(job->lock);
+	job->writeTime = writeTime;
+	job->success = success;
+	job->done = true;
+}
+
+static void DisplaySaveMessage(int strref)
+{
+	displaymsg->DisplayConstantString(strref, DMC_BG2XPGREEN);
+	GameControl *gc = core->GetGameControl();
+	if (gc) {
+		gc->SetDisplayText(strref, 30);
+	}
+}
+
+/** Snapshots the game and hands it over to the save thread */
+int SaveGameIterator::StartSave(const char *Path, int strref)
+{
+	SaveJob *job = SnapshotGame(Path);
+	if (!job) {
+		DisplaySaveMessage(STR_CANTSAVE);
+		return -1;
+	}
+
+	job->strref = strref;
+	saveJob = job;
+	if (!saveThread.Start(SaveThread, job)) {
+		//no thread, no problem, just do it here
+		Log(WARNING, "SaveGameIterator", "Couldn't start the save thread, saving synchronously.");
+		SaveThread(job);
+		FinishSave(true);
+	}
+	return 0;
+}
+
+void SaveGameIterator::FinishSave(bool wait)
+{
+	if (!saveJob) {
+		return;
+	}
+	if (!wait) {
+		MutexLock lock(saveJob->lock);
+		if (!saveJob->done) {
+			return;
+		}
+	}
+	saveThread.Join();
+
+	// the main thread only stops for the snapshot, a synchronous save
+	// stopped it for the writing as well
+	unsigned long snapshotTime = saveJob->areaTime + saveJob->cacheTime + saveJob->gameTime
+		+ saveJob->worldMapTime + saveJob->previewTime;
+	Log(DEBUG, "SaveGameIterator", "Save snapshot: %lu us on the main thread (areas %lu, cache %lu, game %lu, worldmap %lu, previews %lu), writing: %lu us on the save thread (%lu us in one go)",
+		snapshotTime, saveJob->areaTime, saveJob->cacheTime, saveJob->gameTime, saveJob->worldMapTime,
+		saveJob->previewTime, saveJob->writeTime, snapshotTime + saveJob->writeTime);
+
+	// Save succesful / Quick-save succesful
+	DisplaySaveMessage(saveJob->success ? saveJob->strref : STR_CANTSAVE);
+	delete saveJob;
+	saveJob = NULL;
 }
 
 static int CanSave()
@@ -588,6 +795,9 @@ int SaveGameIterator::CreateSaveGame(int index, bool mqs)
 		qsave = atoi(tab->QueryField(index, 1));
 	}
 
+	// the slots may only change once the last save is done
+	FinishSave(true);
+
 	if (mqs) {
 		assert(qsave);
 		PruneQuickSave(slotname);
@@ -605,37 +815,13 @@ int SaveGameIterator::CreateSaveGame(int index, bool mqs)
 		}
 	}
 	char Path[_MAX_PATH];
-	GameControl *gc = core->GetGameControl();
-
 	if (!CreateSavePath(Path, index, slotname)) {
-		displaymsg->DisplayConstantString(STR_CANTSAVE, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_CANTSAVE, 30);
-		}
-		return -1;
-	}
-
-	if (!DoSaveGame(Path)) {
-		displaymsg->DisplayConstantString(STR_CANTSAVE, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_CANTSAVE, 30);
-		}
+		DisplaySaveMessage(STR_CANTSAVE);
 		return -1;
 	}
 
-	// Save succesful / Quick-save succesful
-	if (qsave) {
-		displaymsg->DisplayConstantString(STR_QSAVESUCCEED, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_QSAVESUCCEED, 30);
-		}
-	} else {
-		displaymsg->DisplayConstantString(STR_SAVESUCCEED, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_SAVESUCCEED, 30);
-		}
-	}
-	return 0;
+	// Save succesful / Quick-save succesful is reported once it is written
+	return StartSave(Path, qsave ? STR_QSAVESUCCEED : STR_SAVESUCCEED);
 }
 
 int SaveGameIterator::CreateSaveGame(Holder<SaveGame> save, const char *slotname)
@@ -644,10 +830,11 @@ int SaveGameIterator::CreateSaveGame(Holder<SaveGame> save, const char *slotname
 		return -1;
 	}
 
+	FinishSave(true);
+
 	if (int cansave = CanSave())
 		return cansave;
 
-	GameControl *gc = core->GetGameControl();
 	int index;
 
 	if (save) {
@@ -670,27 +857,11 @@ int SaveGameIterator::CreateSaveGame(Holder<SaveGame> save, const char *slotname
 
 	char Path[_MAX_PATH];
 	if (!CreateSavePath(Path, index, slotname)) {
-		displaymsg->DisplayConstantString(STR_CANTSAVE, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_CANTSAVE, 30);
-		}
+		DisplaySaveMessage(STR_CANTSAVE);
 		return -1;
 	}
 
-	if (!DoSaveGame(Path)) {
-		displaymsg->DisplayConstantString(STR_CANTSAVE, DMC_BG2XPGREEN);
-		if (gc) {
-			gc->SetDisplayText(STR_CANTSAVE, 30);
-		}
-		return -1;
-	}
-
-	// Save succesful
-	displaymsg->DisplayConstantString(STR_SAVESUCCEED, DMC_BG2XPGREEN);
-	if (gc) {
-		gc->SetDisplayText(STR_SAVESUCCEED, 30);
-	}
-	return 0;
+	return StartSave(Path, STR_SAVESUCCEED);
 }
 
 void SaveGameIterator::DeleteSaveGame(Holder<SaveGame> game)
@@ -698,6 +869,7 @@ void SaveGameIterator::DeleteSaveGame(Holder<SaveGame> game)
 	if (!game) {
 		return;
 	}
+	FinishSave(true);
 
 	core->DelTree( game->GetPath(), false ); //remove all files from folder
 	rmdir( game->GetPath() );
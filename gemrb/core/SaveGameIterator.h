@@ -25,26 +25,39 @@
 
 #include "SaveGame.h"
 
+#include "System/Thread.h"
+
 #include <vector>
 
 namespace GemRB {
 
+struct SaveJob;
+
 #define SAVEGAME_DIRECTORY_MATCHER "%d - %[A-Za-z0-9- _+*#%&|()=!?':;]"
 
 class GEM_EXPORT SaveGameIterator {
 private:
 	typedef std::vector<Holder<SaveGame> > charlist;
 	charlist save_slots;
+	// the save being written in the background
+	Thread saveThread;
+	SaveJob *saveJob;
 
 public:
 	SaveGameIterator(void);
 	~SaveGameIterator(void);
+	/** doesn't wait for a save being written, it is listed once done */
 	const charlist& GetSaveGames();
 	void DeleteSaveGame(Holder<SaveGame>);
 	int CreateSaveGame(Holder<SaveGame>, const char *slotname);
 	int CreateSaveGame(int index, bool mqs = false);
+	/** waits for a save being written, it could be the one asked for */
 	Holder<SaveGame> GetSaveGame(const char *slotname);
+	/** reports a finished background save, waits for it if asked to */
+	void FinishSave(bool wait);
 private:
+	int StartSave(const char *Path, int strref);
+	static void SaveThread(void *arg);
 	bool RescanSaveGames();
 	static Holder<SaveGame> BuildSaveGame(const char *slotname);
 	void PruneQuickSave(const char *folder);
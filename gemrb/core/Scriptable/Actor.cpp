@@ -6119,6 +6119,28 @@ void Actor::FaceTarget( Scriptable *target)
 	SetOrientation( GetOrient( target->Pos, Pos ), false );
 }
 
+void Actor::PrefetchCombatAnimations(unsigned char orient) const
+{
+	if (!anims) return;
+
+	anims->PrefetchStance(IE_ANI_READY, orient);
+	if (AttackStance != IE_ANI_ATTACK) {
+		anims->PrefetchStance(AttackStance, orient);
+		return;
+	}
+	// SetStance picks one of these at random
+	const ieWord *chances = GetAttackMoveChances();
+	if (chances[0]) {
+		anims->PrefetchStance(IE_ANI_ATTACK_BACKSLASH, orient);
+	}
+	if (chances[1]) {
+		anims->PrefetchStance(IE_ANI_ATTACK_SLASH, orient);
+	}
+	if (chances[0] + chances[1] < 100) {
+		anims->PrefetchStance(IE_ANI_ATTACK_JAB, orient);
+	}
+}
+
 //in case of LastTarget = 0
 void Actor::StopAttack()
 {
@@ -7851,8 +7873,10 @@ void Actor::Draw(const Region &screen)
 		return;
 	}
 
-	int cx = Pos.x;
-	int cy = Pos.y;
+	// smoothed between game ticks
+	Point drawPos = GetDrawPos();
+	int cx = drawPos.x;
+	int cy = drawPos.y;
 	int explored = Modified[IE_DONOTJUMP]&DNJ_UNHINDERED;
 	//check the deactivation condition only if needed
 	//this fixes dead actors disappearing from fog of war (they should be permanently visible)
@@ -7965,7 +7989,7 @@ void Actor::Draw(const Region &screen)
 		}
 	}
 	if (drawcircle) {
-		DrawCircle(vp);
+		DrawCircle(vp, drawPos);
 		drawtarget = ((Selected || Over) && !(InternalFlags&IF_NORETICLE) && Modified[IE_EA] <= EA_CONTROLLABLE && GetPathLength());
 	}
 	if (drawtarget) {
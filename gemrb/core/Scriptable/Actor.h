@@ -629,6 +629,8 @@ public:
 	void AttackedBy(Actor *actor);
 	/* reorients to face target (for immediate attack) */
 	void FaceTarget(Scriptable *actor);
+	/* starts loading the stances a fight will need */
+	void PrefetchCombatAnimations(unsigned char orient) const;
 	/* returns the number of attacks (handles monk barehanded bonus) */
 	ieDword GetNumberOfAttacks();
 	/* starts combat round*/
@@ -27,6 +27,8 @@
 #include "DisplayMessage.h"
 #include "Game.h"
 #include "GameData.h"
+#include "GlobalTimer.h"
+#include "PathFinder.h"
 #include "Projectile.h"
 #include "Spell.h"
 #include "Sprite2D.h"
@@ -49,6 +51,9 @@ static bool pst_flags = false;
 static ieResRef UncannyDodgeBonus = {"UNCANNY"};
 static unsigned short ClearActionsID = 133; // same for all games
 
+unsigned long Scriptable::scriptRuns = 0;
+unsigned long Scriptable::scriptSkips = 0;
+
 /***********************
  *  Scriptable Class   *
  ***********************/
@@ -102,6 +107,12 @@ Scriptable::Scriptable(ScriptableType type)
 	}
 
 	WaitCounter = 0;
+	scriptsAsleep = false;
+	sleepWakeFlags = 0;
+	sleepScriptCount = 0;
+	sleepActive = false;
+	sleepChangeCount = 0;
+	sleepTimer = 0;
 	if (Type == ST_ACTOR) {
 		InternalFlags = IF_VISIBLE | IF_USEDSAVE;
 		if (startActive) {
@@ -176,6 +187,8 @@ void Scriptable::SetMap(Map *map)
 		error("Scriptable", "Invalid map set!\n");
 	}
 	area = map;
+	// MYAREA variables now come from elsewhere
+	WakeScripts();
 }
 
 //ai is nonzero if this is an actor currently in the party
@@ -188,6 +201,7 @@ void Scriptable::SetScript(const ieResRef aScript, int idx, bool ai)
 	}
 	delete Scripts[idx];
 	Scripts[idx] = NULL;
+	WakeScripts();
 	// NONE is an 'invalid' script name, never used seriously
 	// This hack is to prevent flooding of the console
 	if (aScript[0] && stricmp(aScript, "NONE") ) {
@@ -204,6 +218,7 @@ void Scriptable::SetScript(int index, GameScript* script)
 	}
 	delete Scripts[index];
 	Scripts[index] = script;
+	WakeScripts();
 }
 
 void Scriptable::SetSpellResRef(ieResRef resref) {
@@ -418,15 +433,27 @@ void Scriptable::ExecuteScript(int scriptCount)
 		changed |= act->OverrideActions();
 	}
 
-	bool continuing = false, done = false;
-	for (scriptlevel = 0;scriptlevel<scriptCount;scriptlevel++) {
-		GameScript *Script = Scripts[scriptlevel];
-		if (Script) {
-			changed |= Script->Update(&continuing, &done);
+	// idle scriptables whose conditions can't have changed since the last
+	// round would just evaluate them all to false again, so skip that
+	bool idle = !CurrentAction && !GetNextAction();
+	if (idle && ScriptsAsleep(scriptCount)) {
+		scriptSkips++;
+	} else {
+		scriptRuns++;
+		bool continuing = false, done = false;
+		for (scriptlevel = 0;scriptlevel<scriptCount;scriptlevel++) {
+			GameScript *Script = Scripts[scriptlevel];
+			if (Script) {
+				changed |= Script->Update(&continuing, &done);
+			}
+
+			/* scripts are not concurrent, see WAITPC override script for example */
+			if (done) break;
 		}
 
-		/* scripts are not concurrent, see WAITPC override script for example */
-		if (done) break;
+		if (idle && !changed) {
+			PutScriptsToSleep(scriptCount);
+		}
 	}
 
 	if (changed)
@@ -668,15 +695,85 @@ void Scriptable::SetInternalFlag(unsigned int value, int mode)
 	core->SetBits(InternalFlags, value, mode);
 }
 
+bool Scriptable::ScriptsAsleep(int scriptCount)
+{
+	if (!scriptsAsleep) {
+		return false;
+	}
+	if (scriptCount != sleepScriptCount || sleepActive != ((InternalFlags & IF_ACTIVE) != 0)) {
+		scriptsAsleep = false;
+	} else if ((sleepWakeFlags & SW_VARIABLES) && sleepChangeCount != Variables::GetChangeCount()) {
+		scriptsAsleep = false;
+	} else if (sleepTimer && sleepTimer <= core->GetGame()->GameTime) {
+		scriptsAsleep = false;
+	} else if (InDebug&ID_WAKEUP) {
+		scriptsAsleep = CheckScriptsAsleep(scriptCount);
+	}
+	return scriptsAsleep;
+}
+
+// called after a round that ran no block, the same conditions would all
+// fail again until an event arrives or something they read changes
+void Scriptable::PutScriptsToSleep(int scriptCount)
+{
+	int wake = 0;
+	for (int i = 0; i < scriptCount; i++) {
+		if (Scripts[i]) {
+			wake |= Scripts[i]->GetWakeFlags(!triggers.empty());
+		}
+	}
+	if (wake & SW_POLL) {
+		return;
+	}
+
+	sleepTimer = 0;
+	if (wake & SW_TIMERS) {
+		ieDword now = core->GetGame()->GameTime;
+		std::map<ieDword,ieDword>::const_iterator tit;
+		for (tit = script_timers.begin(); tit != script_timers.end(); ++tit) {
+			if (tit->second > now && (!sleepTimer || tit->second < sleepTimer)) {
+				sleepTimer = tit->second;
+			}
+		}
+	}
+	scriptsAsleep = true;
+	sleepWakeFlags = wake;
+	sleepScriptCount = scriptCount;
+	sleepActive = (InternalFlags & IF_ACTIVE) != 0;
+	sleepChangeCount = Variables::GetChangeCount();
+}
+
+// ID_WAKEUP: evaluate the conditions of sleeping scripts anyway and complain
+// if polling would have run a block; returns false in that case to recover
+bool Scriptable::CheckScriptsAsleep(int scriptCount)
+{
+	for (int i = 0; i < scriptCount; i++) {
+		if (Scripts[i] && Scripts[i]->CanFire()) {
+			Log(ERROR, "Scriptable", "%s: script %s was asleep, but has a true block!",
+				scriptName, Scripts[i]->GetName());
+			return false;
+		}
+	}
+	return true;
+}
+
+void Scriptable::GetScriptSleepStats(unsigned long &runs, unsigned long &skips)
+{
+	runs = scriptRuns;
+	skips = scriptSkips;
+}
+
 void Scriptable::InitTriggers()
 {
 	triggers.clear();
+	WakeScripts();
 }
 
 void Scriptable::AddTrigger(TriggerEntry trigger)
 {
 	triggers.push_back(trigger);
 	ImmediateEvent();
+	WakeScripts();
 
 	assert(trigger.triggerID < MAX_TRIGGERS);
 	if (triggerflags[trigger.triggerID] & TF_SAVED) {
@@ -1666,6 +1763,7 @@ bool Scriptable::TimerExpired(ieDword ID)
 void Scriptable::StartTimer(ieDword ID, ieDword expiration)
 {
 	ieDword newTime = core->GetGame()->GameTime + expiration*AI_UPDATE_TIME;
+	WakeScripts();
 	std::map<ieDword,ieDword>::iterator tit = script_timers.find(ID);
 	if (tit != script_timers.end()) {
 		tit->second = newTime;
@@ -1707,7 +1805,7 @@ void Selectable::SetBBox(const Region &newBBox)
 	BBox = newBBox;
 }
 
-void Selectable::DrawCircle(const Region &vp)
+void Selectable::DrawCircle(const Region &vp, const Point &pos)
 {
 	/* BG2 colours ground circles as follows:
 	dark green for unselected party members
@@ -1744,13 +1842,13 @@ void Selectable::DrawCircle(const Region &vp)
 	}
 
 	if (sprite) {
-		core->GetVideoDriver()->BlitSprite( sprite, Pos.x - vp.x, Pos.y - vp.y, true );
+		core->GetVideoDriver()->BlitSprite( sprite, pos.x - vp.x, pos.y - vp.y, true );
 	} else {
 		// for size >= 2, radii are (size-1)*16, (size-1)*12
 		// for size == 1, radii are 12, 9
 		int csize = (size - 1) * 4;
 		if (csize < 4) csize = 3;
-		core->GetVideoDriver()->DrawEllipse( (ieWord) (Pos.x - vp.x), (ieWord) (Pos.y - vp.y),
+		core->GetVideoDriver()->DrawEllipse( (ieWord) (pos.x - vp.x), (ieWord) (pos.y - vp.y),
 		(ieWord) (csize * 4), (ieWord) (csize * 3), *col );
 	}
 }
@@ -1977,8 +2075,8 @@ Movable::Movable(ScriptableType type)
 	NewOrientation = 0;
 	StanceID = 0;
 	path = NULL;
-	step = NULL;
 	timeStartStep = 0;
+	PrevPosTick = 0;
 	lastFrame = NULL;
 	Area[0] = 0;
 	AttackMovements[0] = 100;
@@ -1987,38 +2085,31 @@ Movable::Movable(ScriptableType type)
 	HomeLocation.x = 0;
 	HomeLocation.y = 0;
 	maxWalkDistance = 0;
+	footprintSize = 0;
+	footprintValue = 0;
 }
 
 Movable::~Movable(void)
 {
-	if (path) {
-		ClearPath();
-	}
+	//the area may be gone already, so don't return it to the pool
+	delete path;
 }
 
 int Movable::GetPathLength()
 {
-	PathNode *node = GetNextStep(0);
-	if (!node) return 0;
-
-	int i = 0;
-	while (node->Next) {
-		i++;
-		node = node->Next;
-	}
-	return i;
+	if (!GetNextStep()) return 0;
+	return (int) path->GetRemaining();
 }
 
-PathNode *Movable::GetNextStep(int x)
+const PathNode *Movable::GetNextStep()
 {
-	if (!step) {
+	if (path && !path->IsStarted()) {
 		DoStep((unsigned int) ~0);
 	}
-	PathNode *node = step;
-	while(node && x--) {
-		node = node->Next;
+	if (!path) {
+		return NULL;
 	}
-	return node;
+	return &path->GetStep();
 }
 
 Point Movable::GetMostLikelyPosition()
@@ -2030,9 +2121,9 @@ Point Movable::GetMostLikelyPosition()
 //actually, sometimes middle path would be better, if
 //we stand in Destination already
 	int halfway = GetPathLength()/2;
-	PathNode *node = GetNextStep(halfway);
-	if (node) {
-		return Point((ieWord) ((node->x*16)+8), (ieWord) ((node->y*12)+6) );
+	if (path) {
+		PathNode node = path->GetNode(path->GetPosition() + halfway);
+		return Point((ieWord) ((node.x*16)+8), (ieWord) ((node.y*12)+6) );
 	}
 	return Destination;
 }
@@ -2143,22 +2234,23 @@ bool Movable::DoStep(unsigned int walk_speed, ieDword time)
 		StanceID = IE_ANI_READY;
 		return true;
 	}
-	if (!step) {
-		step = path;
+	if (!path->IsStarted()) {
+		path->Start();
 		timeStartStep = time;
-	} else if (step->Next && (( time - timeStartStep ) >= walk_speed)) {
-		//print("[New Step] : Orientation = %d", step->orient);
-		step = step->Next;
+	} else if (path->HasNext() && (( time - timeStartStep ) >= walk_speed)) {
+		//print("[New Step] : Orientation = %d", path->GetStep().orient);
+		path->Advance();
 		timeStartStep = timeStartStep + walk_speed;
 	}
-	SetOrientation (step->orient, true);
+	const PathNode &step = path->GetStep();
+	SetOrientation (step.orient, true);
 	StanceID = IE_ANI_WALK;
 	if ((Type == ST_ACTOR) && (InternalFlags & IF_RUNNING)) {
 		StanceID = IE_ANI_RUN;
 	}
-	Pos.x = ( step->x * 16 ) + 8;
-	Pos.y = ( step->y * 12 ) + 6;
-	if (!step->Next) {
+	Pos.x = ( step.x * 16 ) + 8;
+	Pos.y = ( step.y * 12 ) + 6;
+	if (!path->HasNext()) {
 		// we reached our destination, we are done
 		ClearPath();
 		NewOrientation = Orientation;
@@ -2172,10 +2264,26 @@ bool Movable::DoStep(unsigned int walk_speed, ieDword time)
 		// we didn't finish all pending steps, yet
 		return false;
 	}
-	AdjustPositionTowards(Pos, time - timeStartStep, walk_speed, step->x, step->y, step->Next->x, step->Next->y);
+	PathNode next = path->GetNext();
+	AdjustPositionTowards(Pos, time - timeStartStep, walk_speed, step.x, step.y, next.x, next.y);
 	return true;
 }
 
+void Movable::SavePrevPos(ieDword time)
+{
+	PrevPos = Pos;
+	PrevPosTick = time;
+}
+
+Point Movable::GetDrawPos() const
+{
+	// we didn't move during the last tick
+	if (PrevPosTick != core->GetGame()->Ticks) {
+		return Pos;
+	}
+	return core->timer->Interpolate(PrevPos, Pos);
+}
+
 void Movable::AddWayPoint(const Point &Des)
 {
 	if (!path) {
@@ -2185,16 +2293,12 @@ void Movable::AddWayPoint(const Point &Des)
 	Destination = Des;
 	//it is tempting to use 'step' here, as it could
 	//be about half of the current path already
-	PathNode *endNode = path;
-	while(endNode->Next) {
-		endNode = endNode->Next;
-	}
-	Point p(endNode->x, endNode->y);
+	PathNode endNode = path->Back();
+	Point p(endNode.x, endNode.y);
 	area->ClearSearchMapFor(this);
-	PathNode *path2 = area->FindPath( p, Des, size );
-	endNode->Next = path2;
-	//probably it is wise to connect it both ways?
-	path2->Parent = endNode;
+	Path *path2 = area->FindPath( p, Des, size );
+	path->Append(*path2);
+	area->ReleasePath(path2);
 }
 
 void Movable::FixPosition()
@@ -2226,17 +2330,20 @@ void Movable::WalkTo(const Point &Des, int distance)
 	}
 
 	// the prev_step stuff is a naive attempt to allow re-pathing while moving
-	PathNode *prev_step = NULL;
+	PathNode prev_step;
+	bool has_prev_step = false;
 	unsigned char old_stance = StanceID;
-	if (step && step->Next) {
+	if (path && path->IsStarted() && path->HasNext()) {
 		// don't interrupt in the middle of a step; path from the next one
-		prev_step = new PathNode(*step);
-		from.x = ( step->Next->x * 16 ) + 8;
-		from.y = ( step->Next->y * 12 ) + 6;
+		prev_step = path->GetStep();
+		has_prev_step = true;
+		PathNode next = path->GetNext();
+		from.x = ( next.x * 16 ) + 8;
+		from.y = ( next.y * 12 ) + 6;
 	}
 
 	ClearPath();
-	if (!prev_step) {
+	if (!has_prev_step) {
 		FixPosition();
 		from = Pos;
 	}
@@ -2251,33 +2358,28 @@ void Movable::WalkTo(const Point &Des, int distance)
 	if (path) {
 		Destination = Des;
 
-		if (prev_step) {
+		if (has_prev_step) {
 			// we want to smoothly continue, please
 			// this all needs more thought! but it seems to work okay
 			StanceID = old_stance;
 
-			if (path->Next) {
+			if (path->GetLength() > 1) {
 				// this is a terrible hack to make up for the
 				// pathfinder orienting the first node wrong
 				// should be fixed in pathfinder and not here!
-				Point next, follow;
-				next.x = path->x; next.y = path->y;
-				follow.x = path->Next->x;
-				follow.y = path->Next->y;
-				path->orient = GetOrient(follow, next);
+				PathNode first = path->GetNode(0);
+				PathNode second = path->GetNode(1);
+				Point next(first.x, first.y), follow(second.x, second.y);
+				path->SetOrient(0, GetOrient(follow, next));
 			}
 
 			// then put the prev_step at the beginning of the path
-			prev_step->Next = path;
-			path->Parent = prev_step;
-			path = prev_step;
-
-			step = path;
+			path->Prepend(prev_step);
+			path->Start();
 		}
 	} else {
 		// pathing failed
-		if (prev_step) {
-			delete( prev_step );
+		if (has_prev_step) {
 			FixPosition();
 		}
 	}
@@ -2344,8 +2446,9 @@ void Movable::MoveTo(const Point &Des)
 	Pos = Des;
 	Destination = Des;
 	if (BlocksSearchMap()) {
-		area->BlockSearchMap( Pos, size, IsPC()?PATH_MAP_PC:PATH_MAP_NPC);
+		area->BlockSearchMapFor(this);
 	}
+	area->UpdateActorIndex(this);
 }
 
 void Movable::Stop()
@@ -2364,14 +2467,12 @@ void Movable::ClearPath()
 		StanceID = IE_ANI_AWAKE;
 	}
 	InternalFlags&=~IF_NORETICLE;
-	PathNode* thisNode = path;
-	while (thisNode) {
-		PathNode* nextNode = thisNode->Next;
-		delete( thisNode );
-		thisNode = nextNode;
+	if (area) {
+		area->ReleasePath(path);
+	} else {
+		delete path;
 	}
 	path = NULL;
-	step = NULL;
 	//don't call ReleaseCurrentAction
 }
 
@@ -40,6 +40,7 @@ class Highlightable;
 class InfoPoint;
 class Map;
 class Movable;
+class Path;
 struct PathNode;
 class Scriptable;
 class Selectable;
@@ -213,6 +214,14 @@ private:
 	unsigned long WaitCounter;
 	std::map<ieDword,ieDword> script_timers;
 	ieDword globalID;
+	// idle scripts sleep until something they read changes (SW_* flags)
+	bool scriptsAsleep;
+	int sleepWakeFlags;
+	int sleepScriptCount;
+	bool sleepActive;
+	ieDword sleepChangeCount;
+	ieDword sleepTimer;
+	static unsigned long scriptRuns, scriptSkips;
 protected: //let Actor access this
 	std::list<TriggerEntry> triggers;
 	Map *area;
@@ -318,6 +327,9 @@ public:
 	void SetScriptName(const char* text);
 	//call this to enable script running as soon as possible
 	void ImmediateEvent();
+	//makes sleeping scripts evaluate again on the next script round
+	void WakeScripts() { scriptsAsleep = false; }
+	static void GetScriptSleepStats(unsigned long &runs, unsigned long &skips);
 	bool IsPC() const;
 	virtual void Update();
 	void TickScripting();
@@ -372,6 +384,9 @@ private:
 	bool HandleHardcodedSurge(ieResRef surgeSpellRef, Spell *spl, Actor *caster);
 	void ResetCastingState(Actor* caster);
 	void DisplaySpellCastMessage(ieDword tgt, Spell *spl);
+	bool ScriptsAsleep(int scriptCount);
+	void PutScriptsToSleep(int scriptCount);
+	bool CheckScriptsAsleep(int scriptCount);
 };
 
 class GEM_EXPORT Selectable : public Scriptable {
@@ -391,7 +406,7 @@ private:
 	SpriteCover* cover;
 public:
 	void SetBBox(const Region &newBBox);
-	void DrawCircle(const Region &vp);
+	void DrawCircle(const Region &vp, const Point &pos);
 	bool IsOver(const Point &Pos) const;
 	void SetOver(bool over);
 	bool IsSelected() const;
@@ -453,10 +468,12 @@ private: //these seem to be sensitive, so get protection
 	unsigned char Orientation, NewOrientation;
 	ieWord AttackMovements[3];
 
-	PathNode* path; //whole path
-	PathNode* step; //actual step
+	Path* path; //whole path, with the actual step
 protected:
 	ieDword timeStartStep;
+	// position before the last game tick, for smoother drawing
+	Point PrevPos;
+	ieDword PrevPosTick;
 public:
 	Movable(ScriptableType type);
 	virtual ~Movable(void);
@@ -465,16 +482,14 @@ public:
 	ieResRef Area;
 	Point HomeLocation;//spawnpoint, return here after rest
 	ieWord maxWalkDistance;//maximum random walk distance from home
+	// the searchmap cells counted as occupied by us, see Map::BlockSearchMapFor
+	Point footprintPos;
+	unsigned char footprintSize; //0 if none
+	unsigned char footprintValue; //PATH_MAP_PC or PATH_MAP_NPC
 public:
-	PathNode *GetNextStep(int x);
 	int GetPathLength();
-//inliners to protect data consistency
-	inline PathNode * GetNextStep() {
-		if (!step) {
-			DoStep((unsigned int) ~0);
-		}
-		return step;
-	}
+	const PathNode *GetNextStep();
+	const Path *GetPath() const { return path; }
 
 	unsigned char GetNextFace();
 
@@ -496,6 +511,7 @@ public:
 
 	void SetStance(unsigned int arg);
 	void SetAttackMoveChances(ieWord *amc);
+	const ieWord *GetAttackMoveChances() const { return AttackMovements; }
 	virtual bool DoStep(unsigned int walk_speed, ieDword time = 0);
 	void AddWayPoint(const Point &Des);
 	void RunAwayFrom(const Point &Des, int PathLength, int flags);
@@ -509,6 +525,10 @@ public:
 
 	/* returns the most likely position of this actor */
 	Point GetMostLikelyPosition();
+	/* stores the current position before a new game tick moves us */
+	void SavePrevPos(ieDword time);
+	/* returns the position interpolated between the last two game ticks */
+	Point GetDrawPos() const;
 	virtual bool BlocksSearchMap() const = 0;
 };
 
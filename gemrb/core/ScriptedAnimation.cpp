@@ -490,7 +490,9 @@ void ScriptedAnimation::SetPalette(int gradient, int start)
 	}
 	core->GetPalette( gradient&255, PALSIZE, NewPal );
 
+	Palette::MakeWritable(palette);
 	memcpy( &palette->col[start], NewPal, PALSIZE*sizeof( Color ) );
+	palette = palette->Intern();
 	if (twin) {
 		twin->SetPalette(gradient, start);
 	}
@@ -724,7 +726,9 @@ void ScriptedAnimation::PreparePalette()
 		if (!palette)
 			return;
 		if (!palette->alpha) {
+			Palette::MakeWritable(palette);
 			palette->CreateShadedAlphaChannel();
+			palette = palette->Intern();
 		}
 	}
 }
@@ -778,7 +782,9 @@ void ScriptedAnimation::AlterPalette(const RGBModifier& mod)
 	GetPaletteCopy();
 	if (!palette)
 		return;
+	Palette::MakeWritable(palette);
 	palette->SetupGlobalRGBModification(palette,mod);
+	palette = palette->Intern();
 	if (twin) {
 		twin->AlterPalette(mod);
 	}
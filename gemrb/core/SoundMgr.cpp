@@ -20,6 +20,12 @@
 
 #include "SoundMgr.h"
 
+#include "System/Thread.h"
+
+#include <cstdlib>
+#include <list>
+#include <string>
+
 namespace GemRB {
 
 const TypeID SoundMgr::ID = { "SoundMgr" };
@@ -33,4 +39,120 @@ SoundMgr::~SoundMgr(void)
 {
 }
 
+struct CachedPCM : public PCMCache::Entry {
+	std::string key;
+	int users;
+	bool evicted;
+};
+
+static std::list<CachedPCM *> pcmEntries; // most recently used first
+static unsigned long pcmBudget = 16384 * 1024;
+static unsigned long pcmUsed = 0;
+static Mutex pcmLock;
+
+static inline unsigned long PCMBytes(int samples)
+{
+	return (unsigned long) samples * sizeof(short);
+}
+
+static void FreePCM(CachedPCM *entry)
+{
+	free(entry->data);
+	delete entry;
+}
+
+// the caller holds pcmLock
+static void TrimPCM(unsigned long budget)
+{
+	while (pcmUsed > budget && !pcmEntries.empty()) {
+		CachedPCM *entry = pcmEntries.back();
+		pcmEntries.pop_back();
+		pcmUsed -= PCMBytes(entry->samples);
+		if (entry->users) {
+			// still playing, the last Release frees it
+			entry->evicted = true;
+		} else {
+			FreePCM(entry);
+		}
+	}
+}
+
+void PCMCache::SetSize(int kilobytes)
+{
+	MutexLock lock(pcmLock);
+	pcmBudget = kilobytes > 0 ? (unsigned long) kilobytes * 1024 : 0;
+	TrimPCM(pcmBudget);
+}
+
+bool PCMCache::Fits(int samples)
+{
+	MutexLock lock(pcmLock);
+	return samples > 0 && PCMBytes(samples) <= pcmBudget;
+}
+
+const PCMCache::Entry *PCMCache::Acquire(const char *key, int samples, int channels, int samplerate)
+{
+	MutexLock lock(pcmLock);
+	std::list<CachedPCM *>::iterator it;
+	for (it = pcmEntries.begin(); it != pcmEntries.end(); ++it) {
+		CachedPCM *entry = *it;
+		if (entry->key != key) continue;
+		// the same name in another directory
+		if (entry->samples != samples || entry->channels != channels || entry->samplerate != samplerate) {
+			return NULL;
+		}
+		pcmEntries.erase(it);
+		pcmEntries.push_front(entry);
+		entry->users++;
+		return entry;
+	}
+	return NULL;
+}
+
+void PCMCache::Release(const Entry *released)
+{
+	MutexLock lock(pcmLock);
+	CachedPCM *entry = (CachedPCM *) released;
+	entry->users--;
+	if (entry->evicted && !entry->users) {
+		FreePCM(entry);
+	}
+}
+
+void PCMCache::Store(const char *key, short *data, int samples, int channels, int samplerate)
+{
+	MutexLock lock(pcmLock);
+	unsigned long size = PCMBytes(samples);
+	if (size > pcmBudget) {
+		free(data);
+		return;
+	}
+	std::list<CachedPCM *>::iterator it;
+	for (it = pcmEntries.begin(); it != pcmEntries.end(); ++it) {
+		// someone else finished decoding it first
+		if ((*it)->key == key) {
+			free(data);
+			return;
+		}
+	}
+
+	CachedPCM *entry = new CachedPCM();
+	entry->data = data;
+	entry->samples = samples;
+	entry->channels = channels;
+	entry->samplerate = samplerate;
+	entry->key = key;
+	entry->users = 0;
+	entry->evicted = false;
+	pcmEntries.push_front(entry);
+	pcmUsed += size;
+	TrimPCM(pcmBudget);
+}
+
+void PCMCache::Clear()
+{
+	MutexLock lock(pcmLock);
+	TrimPCM(0);
+}
+
 }
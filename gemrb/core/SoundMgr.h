@@ -63,6 +63,32 @@ protected:
 	int samplerate;
 };
 
+/**
+ * Decoded samples of recently played sounds, shared by the sound plugins,
+ * so looping music and ambients are only decoded once. Entries are keyed
+ * by resource name and dropped in least recently used order once the
+ * total goes over the budget. It is also used from the music threads.
+ */
+class GEM_EXPORT PCMCache {
+public:
+	struct Entry {
+		short *data;
+		int samples, channels, samplerate;
+	};
+
+	/** sets the budget in kilobytes, 0 disables the cache */
+	static void SetSize(int kilobytes);
+	/** returns true if a sound of this many samples would be kept */
+	static bool Fits(int samples);
+	/** returns a matching entry, which stays valid until released */
+	static const Entry *Acquire(const char *key, int samples, int channels, int samplerate);
+	static void Release(const Entry *entry);
+	/** takes over the malloc'd data */
+	static void Store(const char *key, short *data, int samples, int channels, int samplerate);
+	/** drops every entry that isn't in use */
+	static void Clear();
+};
+
 }
 
 #endif
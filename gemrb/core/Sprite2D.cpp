@@ -32,6 +32,7 @@ Sprite2D::Sprite2D(int Width, int Height, int Bpp, const void* pixels)
 	freePixels = (pixels != NULL);
 	BAM = false;
 	RLE = false;
+	rleRows = NULL;
 	XPos = 0;
 	YPos = 0;
 	RefCount = 1;
@@ -53,6 +54,7 @@ Sprite2D::Sprite2D(const Sprite2D &obj)
 
 	pixels = obj.pixels;
 	freePixels = false;
+	rleRows = obj.rleRows;
 }
 
 Sprite2D::~Sprite2D()
@@ -42,6 +42,15 @@ namespace GemRB {
 
 class AnimationFactory;
 
+/**
+ * Where a row of an RLE sprite starts: the offset of the run holding its
+ * first pixel and how many pixels of that run still belong to earlier rows.
+ */
+struct RLERow {
+	ieDword offset;
+	ieDword skip;
+};
+
 /**
  * @class Sprite2D
  * Class representing bitmap data.
@@ -62,6 +71,8 @@ public:
 	bool RLE; // in theory this could apply to more than BAMs, but currently does not.
 	ieDword renderFlags;
 	const void* pixels;
+	// optional, lets RLE blits and lookups start at any row
+	const RLERow* rleRows;
 
 	Sprite2D(int Width, int Height, int Bpp, const void* pixels);
 	Sprite2D(const Sprite2D &obj);
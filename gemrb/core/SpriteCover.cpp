@@ -29,6 +29,8 @@ SpriteCover::SpriteCover()
 {
 	pixels = 0;
 	worldx = worldy = XPos = YPos = Width = Height = flags = 0;
+	static unsigned int lastSerial = 0;
+	serial = ++lastSerial;
 }
 
 SpriteCover::~SpriteCover()
@@ -31,6 +31,8 @@ public:
 	int worldx, worldy; // world coords for which the cover has been computed
 	int XPos, YPos, Width, Height;
 	int flags;
+	// never reused, unlike the address, so drivers can cache by it
+	unsigned int serial;
 	SpriteCover(void);
 	~SpriteCover(void);
 
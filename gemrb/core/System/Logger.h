@@ -59,8 +59,10 @@ public:
 	virtual void destroy();
 
 	bool SetLogLevel(log_level);
+	log_level GetLogLevel() const { return myLevel; }
 	void log(log_level, const char* owner, const char* message, log_color color);
 protected:
+	/** called from any thread logging, implementations do their own locking */
 	virtual void LogInternal(log_level, const char*, const char*, log_color)=0;
 };
 
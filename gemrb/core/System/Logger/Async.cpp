@@ -0,0 +1,153 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "System/Logger/Async.h"
+
+#include "System/Logging.h"
+
+#include <cstdio>
+
+namespace GemRB {
+
+AsyncLogger::AsyncLogger(Logger* logger)
+	: Logger(logger->GetLogLevel()), logger(logger)
+{
+	head = count = 0;
+	busy = quit = false;
+	dropped = reported = 0;
+	if (!writer.Start(WriterThread, this)) {
+		logger->log(WARNING, "Logger", "Could not start the log writer thread, logging synchronously.", YELLOW);
+	}
+}
+
+AsyncLogger::~AsyncLogger()
+{}
+
+void AsyncLogger::destroy()
+{
+	mutex.Lock();
+	quit = true;
+	queued.Signal();
+	mutex.Unlock();
+	// the writer drains the queue before exiting
+	writer.Join();
+
+	if (dropped != reported) {
+		char msg[64];
+		snprintf(msg, sizeof(msg), "Log queue full, dropped %lu messages.", dropped - reported);
+		logger->log(WARNING, "Logger", msg, YELLOW);
+	}
+	logger->destroy();
+	delete this;
+}
+
+unsigned long AsyncLogger::GetDroppedCount()
+{
+	MutexLock lock(mutex);
+	return dropped;
+}
+
+void AsyncLogger::LogInternal(log_level level, const char* owner, const char* message, log_color color)
+{
+	if (!writer.IsRunning()) {
+		logger->log(level, owner, message, color);
+		return;
+	}
+
+	MutexLock lock(mutex);
+	if (count == LOG_QUEUE_SIZE) {
+		if (level > MESSAGE) {
+			dropped++;
+			return;
+		}
+		while (count == LOG_QUEUE_SIZE) {
+			written.Wait(mutex);
+		}
+	}
+
+	if (dropped != reported && count < LOG_QUEUE_SIZE - 1) {
+		char msg[64];
+		snprintf(msg, sizeof(msg), "Log queue full, dropped %lu messages.", dropped - reported);
+		reported = dropped;
+		Push(WARNING, "Logger", msg, YELLOW);
+	}
+	Push(level, owner, message, color);
+
+	// we are probably about to exit, don't lose anything
+	if (level <= FATAL) {
+		while (count || busy) {
+			written.Wait(mutex);
+		}
+	}
+}
+
+void AsyncLogger::Push(log_level level, const char* owner, const char* message, log_color color)
+{
+	// reusing the strings of the slot avoids most allocations
+	Record &record = queue[(head + count) % LOG_QUEUE_SIZE];
+	record.level = level;
+	record.color = color;
+	record.owner.assign(owner);
+	record.message.assign(message);
+	count++;
+	queued.Signal();
+}
+
+void AsyncLogger::WriterThread(void *self)
+{
+	((AsyncLogger *) self)->Write();
+}
+
+void AsyncLogger::Write()
+{
+	Record record;
+
+	mutex.Lock();
+	while (true) {
+		while (!count && !quit) {
+			queued.Wait(mutex);
+		}
+		if (!count) break;
+
+		Record &slot = queue[head];
+		record.level = slot.level;
+		record.color = slot.color;
+		record.owner.swap(slot.owner);
+		record.message.swap(slot.message);
+		head = (head + 1) % LOG_QUEUE_SIZE;
+		count--;
+		busy = true;
+		written.Broadcast();
+		mutex.Unlock();
+
+		logger->log(record.level, record.owner.c_str(), record.message.c_str(), record.color);
+
+		mutex.Lock();
+		busy = false;
+		written.Broadcast();
+	}
+	mutex.Unlock();
+}
+
+Logger* createAsyncLogger(Logger* logger)
+{
+	if (!logger) return NULL;
+	return new AsyncLogger(logger);
+}
+
+}
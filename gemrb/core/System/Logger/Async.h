@@ -0,0 +1,74 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef LOGGER_ASYNC_H
+#define LOGGER_ASYNC_H
+
+#include "System/Logger.h"
+#include "System/Thread.h"
+
+#include <string>
+
+namespace GemRB {
+
+// number of queued messages before low priority ones get dropped
+#define LOG_QUEUE_SIZE 4096
+
+/**
+ * Hands the messages to a writer thread, so slow terminals or log files
+ * don't stall the game. The wrapped logger is only called from that thread.
+ * When the queue is full, COMBAT and DEBUG messages are dropped and counted,
+ * the rest wait for space. FATAL messages flush the queue.
+ */
+class GEM_EXPORT AsyncLogger : public Logger {
+public:
+	AsyncLogger(Logger* logger);
+	virtual ~AsyncLogger();
+	virtual void destroy();
+
+	unsigned long GetDroppedCount();
+protected:
+	virtual void LogInternal(log_level, const char* owner, const char* message, log_color color);
+private:
+	struct Record {
+		log_level level;
+		log_color color;
+		std::string owner;
+		std::string message;
+	};
+
+	void Push(log_level, const char* owner, const char* message, log_color color);
+	static void WriterThread(void *self);
+	void Write();
+
+	Logger* logger;
+	Thread writer;
+	Mutex mutex;
+	WaitCondition queued;
+	WaitCondition written;
+	Record queue[LOG_QUEUE_SIZE];
+	unsigned int head, count;
+	bool busy, quit;
+	unsigned long dropped, reported;
+};
+
+Logger* createAsyncLogger(Logger*);
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 
 #include "System/DataStream.h"
 #include "System/FileStream.h"
+#include "System/Logger/Async.h"
 #include "System/Logging.h"
 
 #ifndef STATIC_LINK
@@ -57,13 +58,13 @@ static void addLogger()
 	FileStream* log_file = new FileStream();
 	PathJoin(log_path, core->GamePath, "GemRB.log", NULL);
 	if (log_file->Create(log_path)) {
-		AddLogger(createFileLogger(log_file));
+		AddLogger(createAsyncLogger(createFileLogger(log_file)));
 	} else {
 		PathJoin(log_path, core->CachePath, "GemRB.log", NULL);
 		if (log_file->Create(log_path)) {
-			AddLogger(createFileLogger(log_file));
+			AddLogger(createAsyncLogger(createFileLogger(log_file)));
 		} else if (log_file->Create("/tmp/GemRB.log")) {
-			AddLogger(createFileLogger(log_file));
+			AddLogger(createAsyncLogger(createFileLogger(log_file)));
 		} else {
 			Log (WARNING, "Logger", "Could not create a log file, skipping!");
 		}
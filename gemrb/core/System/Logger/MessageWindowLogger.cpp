@@ -34,12 +34,34 @@ MessageWindowLogger::MessageWindowLogger( log_level level)
 
 MessageWindowLogger::~MessageWindowLogger()
 {
-	PrintStatus(false);
-	assert(mwl == this);
-	mwl = NULL;
+	if (mwl == this) {
+		mwl = NULL;
+	}
 }
 
 void MessageWindowLogger::LogInternal(log_level level, const char* owner, const char* message, log_color color)
+{
+	Record record;
+	record.level = level;
+	record.color = color;
+	record.owner = owner;
+	record.message = message;
+	MutexLock lock(mutex);
+	pending.push_back(record);
+}
+
+void MessageWindowLogger::Flush()
+{
+	std::vector<Record> records;
+	mutex.Lock();
+	records.swap(pending);
+	mutex.Unlock();
+	for (size_t i = 0; i < records.size(); i++) {
+		Display(records[i].level, records[i].owner.c_str(), records[i].message.c_str(), records[i].color);
+	}
+}
+
+void MessageWindowLogger::Display(log_level level, const char* owner, const char* message, log_color color)
 {
 	GameControl* gc = core->GetGameControl();
 	if (displaymsg && gc && !(gc->GetDialogueFlags()&DF_IN_DIALOG)) {
@@ -88,9 +110,9 @@ void MessageWindowLogger::LogInternal(log_level level, const char* owner, const
 void MessageWindowLogger::PrintStatus(bool toggle)
 {
 	if (toggle) {
-		LogInternal( INTERNAL, "Logger", "MessageWindow logging active.", LIGHT_GREEN);
+		Display( INTERNAL, "Logger", "MessageWindow logging active.", LIGHT_GREEN);
 	} else {
-		LogInternal( INTERNAL, "Logger", "MessageWindow logging disabled.", LIGHT_RED);
+		Display( INTERNAL, "Logger", "MessageWindow logging disabled.", LIGHT_RED);
 	}
 }
 
@@ -105,4 +127,21 @@ Logger* getMessageWindowLogger( bool create )
 	return mwl;
 }
 
+void removeMessageWindowLogger()
+{
+	if (!mwl) return;
+	mwl->Flush();
+	mwl->PrintStatus(false);
+	// the logging keeps removed loggers until shutdown, drop our claim now
+	RemoveLogger(mwl);
+	mwl = NULL;
+}
+
+void FlushMessageWindowLogger()
+{
+	if (mwl) {
+		mwl->Flush();
+	}
+}
+
 }
@@ -19,22 +19,46 @@
 #define __GemRB__MessageWindowLogger__
 
 #include "System/Logger.h" // for log_color
+#include "System/Thread.h"
+
+#include <string>
+#include <vector>
 
 namespace GemRB {
 
+// messages can come from any thread, so they are only queued here
+// and shown from the main loop by Flush
 class GEM_EXPORT MessageWindowLogger : public Logger {
 public:
 	MessageWindowLogger( log_level = WARNING ); // this logger has a diffrent default level than its base class.
 	virtual ~MessageWindowLogger();
+
+	void Flush();
 protected:
 	void LogInternal(log_level level, const char* owner, const char* message, log_color color);
 private:
+	struct Record {
+		log_level level;
+		log_color color;
+		std::string owner;
+		std::string message;
+	};
+
+	void Display(log_level level, const char* owner, const char* message, log_color color);
 	void PrintStatus(bool);
+	friend void removeMessageWindowLogger();
+
+	Mutex mutex;
+	std::vector<Record> pending;
 };
 
 // if create is true then getMessageWindowLogger will create and attach the message window logger
 // if it doesnt exist; otherwise simply returns a pointer to the logger.
 GEM_EXPORT Logger* getMessageWindowLogger( bool create = false);
+// detaches the message window logger, a later getMessageWindowLogger(true) makes a new one
+GEM_EXPORT void removeMessageWindowLogger();
+// shows the queued messages, if the message window logger exists; main thread only
+GEM_EXPORT void FlushMessageWindowLogger();
 }
 
 #endif /* defined(__GemRB__MessageWindowLogger__) */
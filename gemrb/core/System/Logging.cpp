@@ -19,81 +19,127 @@
 #include "System/Logging.h"
 
 #include "System/Logger.h"
+#include "System/Logger/Async.h"
 #include "System/StringBuffer.h"
+#include "System/Thread.h"
 
 #if defined(__sgi)
 #  include <stdarg.h>
 #else
 #  include <cstdarg>
 #endif
+#include <cstdlib>
 #include <vector>
 
 namespace GemRB {
 
-static std::vector<Logger*> theLogger;
+#define MAX_LOGGERS 16
+
+// any thread may log, so the hot path takes no lock: the slots are only
+// ever set or cleared as a whole and each logger serialises itself.
+// Removed loggers are kept until shutdown, another thread may still be
+// inside one of them.
+static Logger* volatile theLogger[MAX_LOGGERS];
+static std::vector<Logger*> retiredLoggers;
+// only for adding and removing
+static Mutex loggerLock;
 
 void ShutdownLogging()
 {
-	for (size_t i = 0; i < theLogger.size(); ++i) {
-		theLogger[i]->destroy();
+	loggerLock.Lock();
+	std::vector<Logger*> loggers;
+	loggers.swap(retiredLoggers);
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		Logger *logger = theLogger[i];
+		if (logger) {
+			loggers.push_back(logger);
+			theLogger[i] = NULL;
+		}
+	}
+	loggerLock.Unlock();
+	for (size_t i = 0; i < loggers.size(); ++i) {
+		loggers[i]->destroy();
 	}
-	theLogger.clear();
 }
 
 void InitializeLogging()
 {
-	AddLogger(createDefaultLogger());
+	AddLogger(createAsyncLogger(createDefaultLogger()));
 }
 
 void AddLogger(Logger* logger)
 {
-	if (logger)
-		theLogger.push_back(logger);
+	if (!logger) return;
+	MutexLock lock(loggerLock);
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		if (!theLogger[i]) {
+			theLogger[i] = logger;
+			return;
+		}
+	}
+	logger->destroy();
 }
 
 void RemoveLogger(Logger* logger)
 {
-	if (logger) {
-		std::vector<Logger*>::iterator itr = theLogger.begin();
-		while (itr != theLogger.end()) {
-			if (*itr == logger) {
-				itr = theLogger.erase(itr);
-			} else {
-				itr++;
-			}
+	if (!logger) return;
+	MutexLock lock(loggerLock);
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		if (theLogger[i] == logger) {
+			theLogger[i] = NULL;
 		}
-		logger->destroy();
-		logger = NULL;
 	}
+	retiredLoggers.push_back(logger);
+}
+
+// the most verbose level any logger is interested in
+static log_level MaxLogLevel()
+{
+	log_level max = INTERNAL;
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		Logger *logger = theLogger[i];
+		if (logger && logger->GetLogLevel() > max) {
+			max = logger->GetLogLevel();
+		}
+	}
+	return max;
 }
 
 static void vLog(log_level level, const char* owner, const char* message, log_color color, va_list ap)
 {
-	if (theLogger.empty())
+	// check before formatting, most debug messages end up here
+	if (level > MaxLogLevel())
 		return;
 
-	// Copied from System/StringBuffer.cpp
+	// most messages fit, so only format a second time for long ones
+	char stackbuf[1024];
+	char *buf = stackbuf;
 #ifndef __va_copy
-	// Don't try to be smart.
-	// Assume this is long enough. If not, message will be truncated.
 	// MSVC6 has old vsnprintf that doesn't give length
-	const size_t len = 4095;
+	// and doesn't terminate the string when truncating
+	vsnprintf(stackbuf, sizeof(stackbuf), message, ap);
+	stackbuf[sizeof(stackbuf) - 1] = 0;
 #else
-    va_list ap_copy;
-    // __va_copy should always be defined
-    // va_copy is only defined by C99 (C++11 and up)
-    __va_copy(ap_copy, ap);
-    const size_t len = vsnprintf(NULL, 0, message, ap_copy);
-    va_end(ap_copy);
+	va_list ap_copy;
+	// __va_copy should always be defined
+	// va_copy is only defined by C99 (C++11 and up)
+	__va_copy(ap_copy, ap);
+	int len = vsnprintf(stackbuf, sizeof(stackbuf), message, ap_copy);
+	va_end(ap_copy);
+	if (len >= (int) sizeof(stackbuf)) {
+		buf = (char *) malloc(len + 1);
+		vsnprintf(buf, len + 1, message, ap);
+	}
 #endif
 
-#if defined(__GNUC__)
-	__extension__ // Variable-length arrays
-#endif
-	char buf[len+1];
-	vsnprintf(buf, len + 1, message, ap);
-	for (size_t i = 0; i < theLogger.size(); ++i) {
-		theLogger[i]->log(level, owner, buf, color);
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		Logger *logger = theLogger[i];
+		if (logger) {
+			logger->log(level, owner, buf, color);
+		}
+	}
+	if (buf != stackbuf) {
+		free(buf);
 	}
 }
 
@@ -127,8 +173,11 @@ void Log(log_level level, const char* owner, const char* message, ...)
 
 void Log(log_level level, const char* owner, StringBuffer const& buffer)
 {
-	for (size_t i = 0; i < theLogger.size(); ++i) {
-		theLogger[i]->log(level, owner, buffer.get().c_str(), WHITE);
+	for (int i = 0; i < MAX_LOGGERS; ++i) {
+		Logger *logger = theLogger[i];
+		if (logger) {
+			logger->log(level, owner, buffer.get().c_str(), WHITE);
+		}
 	}
 }
 
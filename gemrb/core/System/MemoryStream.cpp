@@ -31,6 +31,7 @@ MemoryStream::MemoryStream(char *name, void* data, unsigned long size)
 	: data((char*)data)
 {
 	this->size = size;
+	capacity = size;
 	ExtractFileFromPath(filename, name);
 	strlcpy(originalfile, name, _MAX_PATH);
 }
@@ -65,12 +66,23 @@ int MemoryStream::Read(void* dest, unsigned int length)
 
 int MemoryStream::Write(const void* src, unsigned int length)
 {
-	if (Pos+length>size ) {
-		//error("MemoryStream", "We don't support appending to memory streams yet.");
-		return GEM_ERROR;
+	if (Pos+length>capacity) {
+		unsigned long grown = capacity ? capacity * 2 : 4096;
+		while (grown < Pos+length) {
+			grown *= 2;
+		}
+		char *tmp = (char *) realloc(data, grown);
+		if (!tmp) {
+			return GEM_ERROR;
+		}
+		data = tmp;
+		capacity = grown;
 	}
 	memcpy(data+Pos, src, length);
 	Pos += length;
+	if (Pos>size) {
+		size = Pos;
+	}
 	return length;
 }
 
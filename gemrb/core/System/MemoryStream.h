@@ -31,14 +31,18 @@ class GEM_EXPORT MemoryStream : public DataStream
 {
 private:
 	char *data;
+	unsigned long capacity;
 public:
 	MemoryStream(char *name, void* data, unsigned long size);
 	~MemoryStream();
 	DataStream* Clone();
 
 	int Read(void* dest, unsigned int length);
+	/** writing past the end grows the buffer */
 	int Write(const void* src, unsigned int length);
 	int Seek(int pos, int startpos);
+	/** the contents, Size() bytes of them */
+	const char* GetData() const { return data; }
 };
 
 }
@@ -0,0 +1,196 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "System/Thread.h"
+
+#ifndef WIN32
+# include <unistd.h>
+#endif
+
+namespace GemRB {
+
+#ifdef WIN32
+
+Mutex::Mutex()
+{
+	InitializeCriticalSection(&mutex);
+}
+
+Mutex::~Mutex()
+{
+	DeleteCriticalSection(&mutex);
+}
+
+void Mutex::Lock()
+{
+	EnterCriticalSection(&mutex);
+}
+
+void Mutex::Unlock()
+{
+	LeaveCriticalSection(&mutex);
+}
+
+WaitCondition::WaitCondition()
+{
+	InitializeConditionVariable(&cond);
+}
+
+WaitCondition::~WaitCondition()
+{}
+
+void WaitCondition::Wait(Mutex &mutex)
+{
+	SleepConditionVariableCS(&cond, &mutex.mutex, INFINITE);
+}
+
+void WaitCondition::Signal()
+{
+	WakeConditionVariable(&cond);
+}
+
+void WaitCondition::Broadcast()
+{
+	WakeAllConditionVariable(&cond);
+}
+
+DWORD WINAPI Thread::Run(LPVOID self)
+{
+	Thread *t = (Thread *) self;
+	t->func(t->arg);
+	return 0;
+}
+
+bool Thread::Start(Function f, void *a)
+{
+	if (running) return false;
+	func = f;
+	arg = a;
+	thread = CreateThread(NULL, 0, Run, this, 0, NULL);
+	running = thread != NULL;
+	return running;
+}
+
+void Thread::Join()
+{
+	if (!running) return;
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	running = false;
+}
+
+unsigned int Thread::GetCPUCount()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+Mutex::Mutex()
+{
+	pthread_mutex_init(&mutex, NULL);
+}
+
+Mutex::~Mutex()
+{
+	pthread_mutex_destroy(&mutex);
+}
+
+void Mutex::Lock()
+{
+	pthread_mutex_lock(&mutex);
+}
+
+void Mutex::Unlock()
+{
+	pthread_mutex_unlock(&mutex);
+}
+
+WaitCondition::WaitCondition()
+{
+	pthread_cond_init(&cond, NULL);
+}
+
+WaitCondition::~WaitCondition()
+{
+	pthread_cond_destroy(&cond);
+}
+
+void WaitCondition::Wait(Mutex &mutex)
+{
+	pthread_cond_wait(&cond, &mutex.mutex);
+}
+
+void WaitCondition::Signal()
+{
+	pthread_cond_signal(&cond);
+}
+
+void WaitCondition::Broadcast()
+{
+	pthread_cond_broadcast(&cond);
+}
+
+void *Thread::Run(void *self)
+{
+	Thread *t = (Thread *) self;
+	t->func(t->arg);
+	return NULL;
+}
+
+bool Thread::Start(Function f, void *a)
+{
+	if (running) return false;
+	func = f;
+	arg = a;
+	running = pthread_create(&thread, NULL, Run, this) == 0;
+	return running;
+}
+
+void Thread::Join()
+{
+	if (!running) return;
+	pthread_join(thread, NULL);
+	running = false;
+}
+
+unsigned int Thread::GetCPUCount()
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (count > 0) {
+		return (unsigned int) count;
+	}
+#endif
+	return 1;
+}
+
+#endif
+
+Thread::Thread()
+	: running(false), func(NULL), arg(NULL)
+{}
+
+Thread::~Thread()
+{
+	Join();
+}
+
+}
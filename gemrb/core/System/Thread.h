@@ -0,0 +1,122 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file Thread.h
+ * Minimal threading primitives for the core (plugins may use SDL instead)
+ * @author The GemRB Project
+ */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "exports.h"
+
+#ifdef WIN32
+# include "win32def.h"
+#else
+# include <pthread.h>
+#endif
+
+namespace GemRB {
+
+class GEM_EXPORT Mutex {
+public:
+	Mutex();
+	~Mutex();
+
+	void Lock();
+	void Unlock();
+
+private:
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+
+#ifdef WIN32
+	CRITICAL_SECTION mutex;
+#else
+	pthread_mutex_t mutex;
+#endif
+	friend class WaitCondition;
+};
+
+/** locks the mutex for the lifetime of the object */
+class MutexLock {
+public:
+	MutexLock(Mutex &mutex) : mutex(mutex) { mutex.Lock(); }
+	~MutexLock() { mutex.Unlock(); }
+private:
+	Mutex &mutex;
+};
+
+class GEM_EXPORT WaitCondition {
+public:
+	WaitCondition();
+	~WaitCondition();
+
+	/** the mutex must be locked by the caller */
+	void Wait(Mutex &mutex);
+	void Signal();
+	void Broadcast();
+
+private:
+	WaitCondition(const WaitCondition&);
+	WaitCondition& operator=(const WaitCondition&);
+
+#ifdef WIN32
+	CONDITION_VARIABLE cond;
+#else
+	pthread_cond_t cond;
+#endif
+};
+
+class GEM_EXPORT Thread {
+public:
+	typedef void (*Function)(void *);
+
+	Thread();
+	~Thread();
+
+	/** runs func(arg) on a new thread, returns false if it couldn't be created */
+	bool Start(Function func, void *arg);
+	/** waits for the thread to finish */
+	void Join();
+	bool IsRunning() const { return running; }
+
+	/** a hint for sizing worker pools, at least 1 */
+	static unsigned int GetCPUCount();
+
+private:
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+
+	bool running;
+	Function func;
+	void *arg;
+#ifdef WIN32
+	HANDLE thread;
+	static DWORD WINAPI Run(LPVOID self);
+#else
+	pthread_t thread;
+	static void *Run(void *self);
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "System/WorkerPool.h"
+
+#include <cstddef>
+
+namespace GemRB {
+
+WorkerPool::WorkerPool(unsigned int threads)
+	: workers(NULL), started(0), job(NULL), arg(NULL),
+	count(0), next(0), pending(0), quit(false)
+{
+	if (!threads) return;
+	workers = new Thread[threads];
+	while (started < threads && workers[started].Start(WorkerThread, this)) {
+		started++;
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	mutex.Lock();
+	quit = true;
+	wake.Broadcast();
+	mutex.Unlock();
+	// the Thread destructors join
+	delete[] workers;
+}
+
+void WorkerPool::WorkerThread(void *self)
+{
+	((WorkerPool *) self)->Work();
+}
+
+void WorkerPool::Work()
+{
+	mutex.Lock();
+	while (true) {
+		while (!quit && next >= count) {
+			wake.Wait(mutex);
+		}
+		if (quit) break;
+		RunOne();
+	}
+	mutex.Unlock();
+}
+
+void WorkerPool::RunOne()
+{
+	unsigned int index = next++;
+	mutex.Unlock();
+	job(arg, index);
+	mutex.Lock();
+	if (!--pending) {
+		finished.Broadcast();
+	}
+}
+
+void WorkerPool::Run(Job newJob, void *newArg, unsigned int newCount)
+{
+	if (!newCount) return;
+
+	MutexLock lock(mutex);
+	job = newJob;
+	arg = newArg;
+	count = newCount;
+	next = 0;
+	pending = newCount;
+	wake.Broadcast();
+
+	while (next < count) {
+		RunOne();
+	}
+	while (pending) {
+		finished.Wait(mutex);
+	}
+	job = NULL;
+	arg = NULL;
+	count = next = 0;
+}
+
+}
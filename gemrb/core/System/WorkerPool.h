@@ -0,0 +1,64 @@
+/* GemRB - Infinity Engine Emulator
+ * Copyright (C) 2016 The GemRB Project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include "System/Thread.h"
+
+namespace GemRB {
+
+/**
+ * A fixed set of threads for splitting up a loop. Run hands out the
+ * indices one by one, works on them itself too and returns when all of
+ * them are done, so a pool without workers simply runs the loop.
+ */
+class GEM_EXPORT WorkerPool {
+public:
+	typedef void (*Job)(void *arg, unsigned int index);
+
+	WorkerPool(unsigned int threads);
+	~WorkerPool();
+
+	/** calls job(arg, i) for every i below count, in no particular order */
+	void Run(Job job, void *arg, unsigned int count);
+	unsigned int GetWorkerCount() const { return started; }
+
+private:
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+
+	static void WorkerThread(void *self);
+	void Work();
+	/** the mutex must be locked, it is unlocked while the job runs */
+	void RunOne();
+
+	Thread *workers;
+	unsigned int started;
+	Mutex mutex;
+	WaitCondition wake;
+	WaitCondition finished;
+	Job job;
+	void *arg;
+	unsigned int count, next, pending;
+	bool quit;
+};
+
+}
+
+#endif
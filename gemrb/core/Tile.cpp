@@ -20,6 +20,9 @@
 
 #include "Tile.h"
 
+#include "Game.h"
+#include "Interface.h"
+
 namespace GemRB {
 
 Tile::Tile(Animation* anim, Animation* sec)
@@ -31,6 +34,23 @@ Tile::Tile(Animation* anim, Animation* sec)
 	memset(HeightMap, 0, sizeof(HeightMap));
 	memset(LightMap, 0, sizeof(LightMap));
 	memset(NLightMap, 0, sizeof(NLightMap));
+	secondary = 0xffff;
+	fps = ANI_DEFAULT_FRAMERATE;
+	framePos = 0;
+	frameTicks = 0;
+}
+
+Tile::Tile(const unsigned short* indices, int count, unsigned short secondary, unsigned char fps)
+	: frames(indices, indices + count), secondary(secondary), fps(fps)
+{
+	tileIndex = om = 0;
+	anim[0] = anim[1] = NULL;
+	framePos = 0;
+	frameTicks = 0;
+	memset(SearchMap, 0, sizeof(SearchMap));
+	memset(HeightMap, 0, sizeof(HeightMap));
+	memset(LightMap, 0, sizeof(LightMap));
+	memset(NLightMap, 0, sizeof(NLightMap));
 }
 
 Tile::~Tile(void)
@@ -39,4 +59,29 @@ Tile::~Tile(void)
 	delete( anim[1] );
 }
 
+void Tile::Unload()
+{
+	if (!CanUnload()) return;
+	if (anim[0]) {
+		Game *game = core->GetGame();
+		framePos = anim[0]->pos;
+		frameTicks = game ? game->Ticks : 0;
+	}
+	delete( anim[0] );
+	delete( anim[1] );
+	anim[0] = anim[1] = NULL;
+}
+
+void Tile::RestorePhase()
+{
+	unsigned int count = (unsigned int) frames.size();
+	if (!anim[0] || count < 2) return;
+	unsigned long elapsed = 0;
+	Game *game = core->GetGame();
+	if (game && game->Ticks > frameTicks) {
+		elapsed = game->Ticks - frameTicks;
+	}
+	anim[0]->pos = (unsigned int) ((framePos + elapsed * fps / 1000) % count);
+}
+
 }
@@ -26,11 +26,15 @@
 
 #include "Animation.h"
 
+#include <vector>
+
 namespace GemRB {
 
 class GEM_EXPORT Tile {
 public:
 	Tile(Animation* anim, Animation* sec = NULL);
+	/** a tile whose animations are only loaded when needed, see TileOverlay */
+	Tile(const unsigned short* indices, int count, unsigned short secondary, unsigned char fps);
 	~Tile(void);
 	unsigned char tileIndex;
 	unsigned char om;
@@ -39,6 +43,21 @@ public:
 	Color LightMap[16];
 	Color NLightMap[16];
 	Animation* anim[2];
+
+	// tileset indices of the frames, empty if the animations were passed directly
+	std::vector<unsigned short> frames;
+	unsigned short secondary; // 0xffff if there is no secondary (door) tile
+	unsigned char fps;
+	// animation phase, kept across Unload so animated tiles don't restart
+	unsigned int framePos;
+	unsigned long frameTicks;
+
+	bool IsLoaded() const { return anim[0] != NULL; }
+	bool CanUnload() const { return !frames.empty(); }
+	/** frees the animations of a lazily loaded tile */
+	void Unload();
+	/** continues the animation of a reloaded tile where it would be by now */
+	void RestorePhase();
 };
 
 }
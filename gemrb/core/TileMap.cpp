@@ -27,6 +27,8 @@
 #include "Scriptable/Door.h"
 #include "Scriptable/InfoPoint.h"
 
+#include <algorithm>
+
 namespace GemRB {
 
 TileMap::TileMap(void)
@@ -108,6 +110,16 @@ Door* TileMap::AddDoor(const char *ID, const char* Name, unsigned int Flags,
 	door->SetName( ID );
 	door->SetScriptName( Name );
 	doors.push_back( door );
+
+	//index both states, so opening and closing doesn't have to touch the grid
+	Region bbox = open->BBox;
+	int x2 = std::max(bbox.x + bbox.w, closed->BBox.x + closed->BBox.w);
+	int y2 = std::max(bbox.y + bbox.h, closed->BBox.y + closed->BBox.h);
+	bbox.x = std::min(bbox.x, closed->BBox.x);
+	bbox.y = std::min(bbox.y, closed->BBox.y);
+	bbox.w = x2 - bbox.x;
+	bbox.h = y2 - bbox.y;
+	regions.Update(door, bbox);
 	return door;
 }
 
@@ -121,10 +133,17 @@ Door* TileMap::GetDoor(unsigned int idx) const
 
 Door* TileMap::GetDoor(const Point &p) const
 {
-	for (size_t i = 0; i < doors.size(); i++) {
+	const PickIndex::Cell *cell = regions.Query(p);
+	if (!cell) {
+		return NULL;
+	}
+	for (size_t i = 0; i < cell->size(); i++) {
 		Gem_Polygon *doorpoly;
 
-		Door* door = doors[i];
+		if ((*cell)[i].object->Type != ST_DOOR) {
+			continue;
+		}
+		Door* door = (Door *) (*cell)[i].object;
 		if (door->Flags&DOOR_HIDDEN) {
 			continue;
 		}
@@ -419,6 +438,7 @@ void TileMap::DrawFogOfWar(ieByte* explored_mask, ieByte* visible_mask, Region v
 void TileMap::AddContainer(Container *c)
 {
 	containers.push_back(c);
+	regions.Update(c, c->outline->BBox);
 }
 
 Container* TileMap::GetContainer(unsigned int idx) const
@@ -444,8 +464,15 @@ Container* TileMap::GetContainer(const char* Name) const
 //in this case, empty piles won't be found!
 Container* TileMap::GetContainer(const Point &position, int type) const
 {
-	for (size_t i = 0; i < containers.size(); i++) {
-		Container* c = containers[i];
+	const PickIndex::Cell *cell = regions.Query(position);
+	if (!cell) {
+		return NULL;
+	}
+	for (size_t i = 0; i < cell->size(); i++) {
+		if ((*cell)[i].object->Type != ST_CONTAINER) {
+			continue;
+		}
+		Container* c = (Container *) (*cell)[i].object;
 		if (type!=-1) {
 			if (c->Type!=type) {
 				continue;
@@ -513,6 +540,7 @@ int TileMap::CleanupContainer(Container *container)
 	for (size_t i = 0; i < containers.size(); i++) {
 		if (containers[i]==container) {
 			containers.erase(containers.begin()+i);
+			regions.Remove(container);
 			delete container;
 			return 1;
 		}
@@ -548,14 +576,23 @@ InfoPoint* TileMap::AddInfoPoint(const char* Name, unsigned short Type,
 	ip->outline = outline;
 	//ip->Active = true; //set active on creation
 	infoPoints.push_back( ip );
+	regions.Update(ip, outline->BBox);
 	return ip;
 }
 
 //if detectable is set, then only detectable infopoints will be returned
 InfoPoint* TileMap::GetInfoPoint(const Point &p, bool detectable) const
 {
-	for (size_t i = 0; i < infoPoints.size(); i++) {
-		InfoPoint* ip = infoPoints[i];
+	const PickIndex::Cell *cell = regions.Query(p);
+	if (!cell) {
+		return NULL;
+	}
+	for (size_t i = 0; i < cell->size(); i++) {
+		Scriptable *object = (*cell)[i].object;
+		if (object->Type != ST_PROXIMITY && object->Type != ST_TRIGGER && object->Type != ST_TRAVEL) {
+			continue;
+		}
+		InfoPoint* ip = (InfoPoint *) object;
 		//these flags disable any kind of user interaction
 		//scripts can still access an infopoint by name
 		if (ip->Flags&(INFO_DOOR|TRAP_DEACTIVATED) )
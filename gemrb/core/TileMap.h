@@ -23,6 +23,7 @@
 
 #include "exports.h"
 
+#include "PickIndex.h"
 #include "Polygon.h"
 #include "TileOverlay.h"
 
@@ -44,6 +45,8 @@ private:
 	std::vector< Container*> containers;
 	std::vector< InfoPoint*> infoPoints;
 	std::vector< TileObject*> tiles;
+	//doors, containers and infopoints by bounding box, for the point lookups
+	PickIndex regions;
 	bool LargeMap;
 public:
 	TileMap(void);
@@ -21,10 +21,15 @@
 #include "TileOverlay.h"
 
 //#include "Game.h" // needed only for TILE_GREY below
+#include "GameData.h"
 #include "GlobalTimer.h"
 #include "Interface.h"
+#include "PluginMgr.h"
+#include "TileSetMgr.h"
 #include "Video.h"
 
+#include <algorithm>
+
 namespace GemRB {
 
 bool RedrawTile = false;
@@ -34,6 +39,8 @@ TileOverlay::TileOverlay(int Width, int Height)
 	w = Width;
 	h = Height;
 	count = 0;
+	resident = 0;
+	tisname[0] = 0;
 	tiles = ( Tile * * ) malloc( w * h * sizeof( Tile * ) );
 }
 
@@ -48,6 +55,87 @@ TileOverlay::~TileOverlay(void)
 void TileOverlay::AddTile(Tile* tile)
 {
 	tiles[count++] = tile;
+	if (tile->IsLoaded()) {
+		resident++;
+	}
+}
+
+void TileOverlay::SetTileSet(const ieResRef resref)
+{
+	CopyResRef(tisname, resref);
+	tileset.release();
+}
+
+// reopens the tileset, so a loaded area doesn't keep its file open
+bool TileOverlay::OpenTileSet()
+{
+	if (tileset) {
+		return true;
+	}
+	if (!tisname[0]) {
+		return false;
+	}
+	DataStream *str = gamedata->GetResource(tisname, IE_TIS_CLASS_ID);
+	if (!str) {
+		return false;
+	}
+	PluginHolder<TileSetMgr> tis(IE_TIS_CLASS_ID);
+	if (!tis->Open(str)) {
+		return false;
+	}
+	tileset = tis;
+	return true;
+}
+
+bool TileOverlay::LoadTile(Tile* tile)
+{
+	if (tile->IsLoaded()) {
+		return true;
+	}
+	if (!OpenTileSet()) {
+		return false;
+	}
+	tileset->LoadTile(tile);
+	if (!tile->IsLoaded()) {
+		return false;
+	}
+	resident++;
+	// nothing left to load until something gets evicted
+	if (resident == count) {
+		tileset.release();
+	}
+	return true;
+}
+
+// loads a few of the tiles that will come into view when scrolling
+// returns true once the whole ring is loaded
+bool TileOverlay::Prefetch(const Region &ring)
+{
+	int budget = TILE_PREFETCH_LIMIT;
+	for (int y = ring.y; y < ring.y + ring.h; y++) {
+		for (int x = ring.x; x < ring.x + ring.w; x++) {
+			Tile *tile = tiles[y * w + x];
+			if (tile->IsLoaded()) continue;
+			LoadTile(tile);
+			if (!--budget) return false;
+		}
+	}
+	return true;
+}
+
+// frees the tiles outside of the prefetch ring
+void TileOverlay::Evict(const Region &ring)
+{
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			if (ring.PointInside(Point(x, y))) continue;
+			Tile *tile = tiles[y * w + x];
+			if (tile->IsLoaded() && tile->CanUnload()) {
+				tile->Unload();
+				resident--;
+			}
+		}
+	}
 }
 
 void TileOverlay::BumpViewport(const Region &viewport, Region &vp)
@@ -89,9 +177,25 @@ void TileOverlay::Draw(Region viewport, std::vector< TileOverlay*> &overlays, in
 	int dx = ( vp.x + vp.w + 63 ) / 64;
 	int dy = ( vp.y + vp.h + 63 ) / 64;
 
+	// on big areas only the tiles around the viewport are kept in memory
+	Region ring;
+	if (tisname[0]) {
+		ring.x = std::max(sx - TILE_PREFETCH_RING, 0);
+		ring.y = std::max(sy - TILE_PREFETCH_RING, 0);
+		ring.w = std::min(dx + TILE_PREFETCH_RING, w) - ring.x;
+		ring.h = std::min(dy + TILE_PREFETCH_RING, h) - ring.y;
+		// allow twice the ring, so scrolling back and forth doesn't reload
+		if (resident > 2 * ring.w * ring.h) {
+			Evict(ring);
+		}
+	}
+
 	for (int y = sy; y < dy && y < h; y++) {
 		for (int x = sx; x < dx && x < w; x++) {
 			Tile* tile = tiles[( y* w ) + x];
+			if (!LoadTile(tile)) {
+				continue;
+			}
 
 			//draw door tiles if there are any
 			Animation* anim = tile->anim[tile->tileIndex];
@@ -111,7 +215,7 @@ void TileOverlay::Draw(Region viewport, std::vector< TileOverlay*> &overlays, in
 				TileOverlay * ov = overlays[z];
 				if (ov && ov->count > 0) {
 					Tile *ovtile = ov->tiles[0]; //allow only 1x1 tiles now
-					if (tile->om & mask) {
+					if ((tile->om & mask) && ov->LoadTile(ovtile)) {
 						if (RedrawTile) {
 							vid->BlitTile( ovtile->anim[0]->NextFrame(),
 						                   tile->anim[0]->NextFrame(),
@@ -134,6 +238,11 @@ void TileOverlay::Draw(Region viewport, std::vector< TileOverlay*> &overlays, in
 			}
 		}
 	}
+
+	// close the tileset while scrolling stays within the loaded tiles
+	if (tisname[0] && Prefetch(ring)) {
+		tileset.release();
+	}
 }
 
 }
@@ -22,27 +22,48 @@
 #define TILEOVERLAY_H
 
 #include "exports.h"
+#include "ie_types.h"
 
+#include "Holder.h"
 #include "Tile.h"
 
 #include <vector>
 
 namespace GemRB {
 
+class TileSetMgr;
+
 extern bool RedrawTile;
 
+// tiles around the viewport that are loaded ahead of scrolling
+#define TILE_PREFETCH_RING 2
+// how many of those are loaded per frame at most
+#define TILE_PREFETCH_LIMIT 16
+
 class GEM_EXPORT TileOverlay {
 public:
 	int w, h;
 	//std::vector<Tile*> tiles;
 	Tile** tiles;
 	int count;
+private:
+	// source of the lazily loaded tiles, only open while some are missing
+	ieResRef tisname;
+	Holder<TileSetMgr> tileset;
+	int resident;
 public:
 	TileOverlay(int Width, int Height);
 	~TileOverlay(void);
 	void AddTile(Tile* tile);
+	/** tiles without animations will be loaded from this tileset when drawn */
+	void SetTileSet(const ieResRef resref);
 	void Draw(Region viewport, std::vector< TileOverlay*> &overlays, int flags);
 	void BumpViewport(const Region &viewport, Region &vp);
+private:
+	bool OpenTileSet();
+	bool LoadTile(Tile* tile);
+	bool Prefetch(const Region &ring);
+	void Evict(const Region &ring);
 };
 
 }
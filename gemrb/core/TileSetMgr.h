@@ -34,6 +34,8 @@ public:
 	virtual bool Open(DataStream* stream) = 0;
 	virtual Tile* GetTile(unsigned short* indexes, int count,
 		unsigned short* secondary = NULL) = 0;
+	/** creates the animations of a tile made with the lazy Tile constructor */
+	virtual void LoadTile(Tile* tile) = 0;
 };
 
 }
@@ -23,29 +23,59 @@
 #include "Interface.h" // for LoadInitialValues
 #include "System/FileStream.h" // for LoadInitialValues
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace GemRB {
 
-/////////////////////////////////////////////////////////////////////////////
-// private inlines 
-inline bool Variables::MyCopyKey(char*& dest, const char* key) const
+ieDword Variables::m_nChangeCount = 0;
+
+//interned game variable names, symbol n is at n-1
+typedef std::map<std::string, unsigned int> SymbolMap;
+static SymbolMap symbolIds;
+static std::vector<const char *> symbolNames;
+
+//the original engine ignores spaces and case in variable names
+static int NormaliseKey(char *dest, const char *key)
 {
 	int i, j;
 
-	//use j
-	for (i = 0,j = 0; key[i] && j < MAX_VARIABLE_LENGTH - 1; i++)
+	for (i = 0, j = 0; key[i] && j < MAX_VARIABLE_LENGTH - 1; i++) {
 		if (key[i] != ' ') {
-			j++;
+			dest[j++] = (char) tolower( key[i] );
 		}
-	dest = (char *) malloc(j + 1);
-	if (!dest) {
-		return false;
 	}
-	for (i = 0,j = 0; key[i] && j < MAX_VARIABLE_LENGTH - 1; i++) {
+	dest[j] = 0;
+	return j;
+}
+
+static unsigned int HashVariable(const char *key)
+{
+	unsigned int nHash = 0;
+	//the original engine ignores spaces in variable names
+	//stop where NormaliseKey does, so interned keys land in the same bucket
+	for (int i = 0, j = 0; key[i] && j < MAX_VARIABLE_LENGTH - 1; i++) {
 		if (key[i] != ' ') {
-			dest[j++] = (char) tolower( key[i] );
+			nHash = ( nHash << 5 ) + nHash + tolower( key[i] );
+			j++;
 		}
 	}
-	dest[j] = 0;
+	return nHash;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// private inlines 
+inline bool Variables::MyCopyKey(char*& dest, const char* key) const
+{
+	char normal[MAX_VARIABLE_LENGTH];
+	int len = NormaliseKey(normal, key);
+
+	dest = (char *) malloc(len + 1);
+	if (!dest) {
+		return false;
+	}
+	memcpy(dest, normal, len + 1);
 	return true;
 }
 
@@ -68,13 +98,7 @@ inline unsigned int Variables::MyCompareKey(const char* key, const char *str) co
 
 inline unsigned int Variables::MyHashKey(const char* key) const
 {
-	unsigned int nHash = 0;
-	for (int i = 0; key[i] && i < MAX_VARIABLE_LENGTH; i++) {
-		//the original engine ignores spaces in variable names
-		if (key[i] != ' ')
-			nHash = ( nHash << 5 ) + nHash + tolower( key[i] );
-	}
-	return nHash;
+	return HashVariable(key);
 }
 /////////////////////////////////////////////////////////////////////////////
 // functions
@@ -95,7 +119,7 @@ Variables::iterator Variables::GetNextAssoc(iterator rNextPosition, const char*&
 	Variables::MyAssoc* pAssocNext;
 	if (( pAssocNext = pAssocRet->pNext ) == NULL) {
 		// go to next bucket
-		for (unsigned int nBucket = pAssocRet->nHashValue + 1;
+		for (unsigned int nBucket = pAssocRet->nHashValue % m_nHashTableSize + 1;
 			nBucket < m_nHashTableSize;
 			nBucket++)
 			if (( pAssocNext = m_pHashTable[nBucket] ) != NULL)
@@ -144,6 +168,41 @@ void Variables::InitHashTable(unsigned int nHashSize, bool bAllocNow)
 	m_nHashTableSize = nHashSize;
 }
 
+//doubles the bucket count, the chains are relinked by their stored hash
+void Variables::Rehash(unsigned int nHashSize)
+{
+	Variables::MyAssoc** table = (Variables::MyAssoc **) calloc(nHashSize, sizeof( Variables::MyAssoc * ));
+	for (unsigned int nBucket = 0; nBucket < m_nHashTableSize; nBucket++) {
+		Variables::MyAssoc* pAssoc = m_pHashTable[nBucket];
+		while (pAssoc) {
+			Variables::MyAssoc* pNext = pAssoc->pNext;
+			unsigned int nNew = pAssoc->nHashValue % nHashSize;
+			pAssoc->pNext = table[nNew];
+			table[nNew] = pAssoc;
+			pAssoc = pNext;
+		}
+	}
+	free(m_pHashTable);
+	m_pHashTable = table;
+	m_nHashTableSize = nHashSize;
+}
+
+//puts a new association into its bucket, growing the table first if
+//the chains would get longer than two entries on average
+void Variables::LinkAssoc(Variables::MyAssoc* pAssoc, unsigned int nHash)
+{
+	if (m_pHashTable == NULL) {
+		InitHashTable( m_nHashTableSize );
+	} else if ((unsigned int) m_nCount > 2 * m_nHashTableSize) {
+		Rehash( 2 * m_nHashTableSize + 1 );
+	}
+
+	unsigned int nBucket = nHash % m_nHashTableSize;
+	pAssoc->nHashValue = nHash;
+	pAssoc->pNext = m_pHashTable[nBucket];
+	m_pHashTable[nBucket] = pAssoc;
+}
+
 void Variables::RemoveAll(ReleaseFun fun)
 {
 	if (m_pHashTable != NULL) {
@@ -170,6 +229,10 @@ void Variables::RemoveAll(ReleaseFun fun)
 		}
 	}
 
+	if (m_lParseKey && m_nCount) {
+		m_nChangeCount++;
+	}
+
 	// free hash table
 	free(m_pHashTable);
 	m_pHashTable = NULL;
@@ -211,8 +274,12 @@ Variables::MyAssoc* Variables::NewAssoc(const char* key)
 	m_pFreeList = m_pFreeList->pNext;
 	m_nCount++;
 	assert( m_nCount > 0 ); // make sure we don't overflow
+	pAssoc->symbol = 0;
 	if (m_lParseKey) {
 		MyCopyKey( pAssoc->key, key );
+		if (pAssoc->key) {
+			pAssoc->symbol = Intern( pAssoc->key ).symbol;
+		}
 	} else {
 		int len;
 		len = strnlen( key, MAX_VARIABLE_LENGTH - 1 );
@@ -249,7 +316,7 @@ void Variables::FreeAssoc(Variables::MyAssoc* pAssoc)
 Variables::MyAssoc* Variables::GetAssocAt(const char* key, unsigned int& nHash) const
 	// find association (or return NULL)
 {
-	nHash = MyHashKey( key ) % m_nHashTableSize;
+	nHash = MyHashKey( key );
 
 	if (m_pHashTable == NULL) {
 		return NULL;
@@ -257,7 +324,7 @@ Variables::MyAssoc* Variables::GetAssocAt(const char* key, unsigned int& nHash)
 
 	// see if it exists
 	Variables::MyAssoc* pAssoc;
-	for (pAssoc = m_pHashTable[nHash];
+	for (pAssoc = m_pHashTable[nHash % m_nHashTableSize];
 		pAssoc != NULL;
 		pAssoc = pAssoc->pNext) {
 		if (m_lParseKey) {
@@ -274,6 +341,25 @@ Variables::MyAssoc* Variables::GetAssocAt(const char* key, unsigned int& nHash)
 	return NULL;
 }
 
+Variables::MyAssoc* Variables::GetAssocAt(const VariableKey &key) const
+{
+	if (m_pHashTable == NULL || !key.symbol) {
+		return NULL;
+	}
+	assert( m_lParseKey );
+
+	Variables::MyAssoc* pAssoc;
+	for (pAssoc = m_pHashTable[key.hash % m_nHashTableSize];
+		pAssoc != NULL;
+		pAssoc = pAssoc->pNext) {
+		if (pAssoc->symbol == key.symbol) {
+			return pAssoc;
+		}
+	}
+
+	return NULL;
+}
+
 int Variables::GetValueLength(const char* key) const
 {
 	unsigned int nHash;
@@ -338,6 +424,18 @@ bool Variables::Lookup(const char* key, ieDword& rValue) const
 	return true;
 }
 
+bool Variables::Lookup(const VariableKey &key, ieDword& rValue) const
+{
+	assert(m_type==GEM_VARIABLES_INT);
+	Variables::MyAssoc* pAssoc = GetAssocAt( key );
+	if (pAssoc == NULL) {
+		return false;
+	} // not in map
+
+	rValue = pAssoc->Value.nValue;
+	return true;
+}
+
 void Variables::SetAtCopy(const char* key, const char* value)
 {
 	size_t len = strlen(value)+1;
@@ -367,14 +465,10 @@ void Variables::SetAt(const char* key, char* value)
 
 	assert( m_type == GEM_VARIABLES_STRING );
 	if (( pAssoc = GetAssocAt( key, nHash ) ) == NULL) {
-		if (m_pHashTable == NULL)
-			InitHashTable( m_nHashTableSize );
-
 		// it doesn't exist, add a new Association
 		pAssoc = NewAssoc( key );
 		// put into hash table
-		pAssoc->pNext = m_pHashTable[nHash];
-		m_pHashTable[nHash] = pAssoc;
+		LinkAssoc( pAssoc, nHash );
 	} else {
 		if (pAssoc->Value.sValue) {
 			free( pAssoc->Value.sValue );
@@ -385,7 +479,6 @@ void Variables::SetAt(const char* key, char* value)
 	//set value only if we have a key
 	if (pAssoc->key) {
 		pAssoc->Value.sValue = value;
-		pAssoc->nHashValue = nHash;
 	}
 }
 
@@ -396,14 +489,10 @@ void Variables::SetAt(const char* key, void* value)
 
 	assert( m_type == GEM_VARIABLES_POINTER );
 	if (( pAssoc = GetAssocAt( key, nHash ) ) == NULL) {
-		if (m_pHashTable == NULL)
-			InitHashTable( m_nHashTableSize );
-
 		// it doesn't exist, add a new Association
 		pAssoc = NewAssoc( key );
 		// put into hash table
-		pAssoc->pNext = m_pHashTable[nHash];
-		m_pHashTable[nHash] = pAssoc;
+		LinkAssoc( pAssoc, nHash );
 	} else {
 		if (pAssoc->Value.sValue) {
 			free( pAssoc->Value.sValue );
@@ -414,7 +503,6 @@ void Variables::SetAt(const char* key, void* value)
 	//set value only if we have a key
 	if (pAssoc->key) {
 		pAssoc->Value.pValue = value;
-		pAssoc->nHashValue = nHash;
 	}
 
 }
@@ -432,19 +520,37 @@ void Variables::SetAt(const char* key, ieDword value, bool nocreate)
 			return;
 		}
 
-		if (m_pHashTable == NULL)
-			InitHashTable( m_nHashTableSize );
-
 		// it doesn't exist, add a new Association
 		pAssoc = NewAssoc( key );
 		// put into hash table
-		pAssoc->pNext = m_pHashTable[nHash];
-		m_pHashTable[nHash] = pAssoc;
+		LinkAssoc( pAssoc, nHash );
+		if (m_lParseKey) {
+			m_nChangeCount++;
+		}
+	} else if (m_lParseKey && pAssoc->Value.nValue != value) {
+		m_nChangeCount++;
 	}
 	//set value only if we have a key
 	if (pAssoc->key) {
 		pAssoc->Value.nValue = value;
-		pAssoc->nHashValue = nHash;
+	}
+}
+
+void Variables::SetAt(const VariableKey &key, ieDword value, bool nocreate)
+{
+	assert( m_type == GEM_VARIABLES_INT );
+	if (!key.symbol) {
+		return;
+	}
+	Variables::MyAssoc* pAssoc = GetAssocAt( key );
+	if (pAssoc == NULL) {
+		//rare, creating goes through the name
+		SetAt( GetSymbolName(key.symbol), value, nocreate );
+		return;
+	}
+	if (pAssoc->Value.nValue != value) {
+		m_nChangeCount++;
+		pAssoc->Value.nValue = value;
 	}
 }
 
@@ -455,6 +561,7 @@ void Variables::Remove(const char* key)
 
 	pAssoc = GetAssocAt( key, nHash );
 	if (!pAssoc) return; // not in there
+	nHash %= m_nHashTableSize;
 
 	if (pAssoc == m_pHashTable[nHash]) {
 		// head
@@ -473,6 +580,43 @@ void Variables::Remove(const char* key)
 	}
 	pAssoc->pNext = 0;
 	FreeAssoc(pAssoc);
+	if (m_lParseKey) {
+		m_nChangeCount++;
+	}
+}
+
+VariableKey Variables::Intern(const char *key)
+{
+	char normal[MAX_VARIABLE_LENGTH];
+	VariableKey ret;
+
+	NormaliseKey(normal, key);
+	ret.hash = HashVariable(normal);
+	SymbolMap::const_iterator it = symbolIds.find(normal);
+	if (it != symbolIds.end()) {
+		ret.symbol = it->second;
+		return ret;
+	}
+
+	//names are never released, there are only as many as the scripts use
+	char *name = strdup(normal);
+	symbolNames.push_back(name);
+	ret.symbol = (unsigned int) symbolNames.size();
+	symbolIds[normal] = ret.symbol;
+	return ret;
+}
+
+const char *Variables::GetSymbolName(unsigned int symbol)
+{
+	if (!symbol || symbol > symbolNames.size()) {
+		return "";
+	}
+	return symbolNames[symbol - 1];
+}
+
+unsigned int Variables::GetSymbolCount()
+{
+	return (unsigned int) symbolNames.size();
 }
 
 void Variables::LoadInitialValues(const char* name)
@@ -39,6 +39,12 @@ typedef void (*ReleaseFun)(void *);
 #define GEM_VARIABLES_STRING   1
 #define GEM_VARIABLES_POINTER  2
 
+/** a game variable name interned by Variables::Intern, 0 is no symbol */
+struct VariableKey {
+	unsigned int symbol;
+	unsigned int hash;
+};
+
 class GEM_EXPORT Variables {
 protected:
 	// Association
@@ -50,7 +56,8 @@ protected:
 			char* sValue;
 			void* pValue;
 		} Value;
-		unsigned long nHashValue;
+		unsigned long nHashValue; //the full hash, not the bucket
+		unsigned int symbol; //only in parsed key tables
 		friend class Variables;
 	};
 	struct MemBlock {
@@ -61,7 +68,8 @@ public:
 	typedef MyAssoc *iterator;
 public:
 	// Construction
-	Variables(int nBlockSize = 10, int nHashTableSize = 2049);
+	//tables start small and grow as needed, most only hold a few locals
+	Variables(int nBlockSize = 10, int nHashTableSize = 17);
 	void LoadInitialValues(const char* name);
 
 	// Attributes
@@ -93,6 +101,7 @@ public:
 	bool Lookup(const char* key, ieDword& rValue) const;
 	bool Lookup(const char* key, char*& dest) const;
 	bool Lookup(const char* key, void*& dest) const;
+	bool Lookup(const VariableKey &key, ieDword& rValue) const;
 
 	// Operations
 	void SetAtCopy(const char* key, const char* newValue);
@@ -100,6 +109,7 @@ public:
 	void SetAt(const char* key, char* newValue);
 	void SetAt(const char* key, void* newValue);
 	void SetAt(const char* key, ieDword newValue, bool nocreate=false);
+	void SetAt(const VariableKey &key, ieDword newValue, bool nocreate=false);
 	void Remove(const char* key);
 	void RemoveAll(ReleaseFun fun);
 	void InitHashTable(unsigned int hashSize, bool bAllocNow = true);
@@ -107,6 +117,19 @@ public:
 	iterator GetNextAssoc(iterator rNextPosition, const char*& rKey,
 		ieDword& rValue) const;
 
+	/** bumped whenever a numeric value in a parsed key (game variable)
+	 * table changes, sleeping scripts compare it to see if they must wake */
+	static ieDword GetChangeCount()
+	{
+		return m_nChangeCount;
+	}
+
+	/** normalises a game variable name (no spaces, lowercase) and returns
+	 * its symbol, the same name always yields the same symbol and hash */
+	static VariableKey Intern(const char *key);
+	static const char *GetSymbolName(unsigned int symbol);
+	static unsigned int GetSymbolCount();
+
 	// Debugging
 	void DebugDump();
 	// Implementation
@@ -119,10 +142,14 @@ protected:
 	MemBlock* m_pBlocks;
 	int m_nBlockSize;
 	int m_type; //could be string or ieDword 
+	static ieDword m_nChangeCount;
 
 	Variables::MyAssoc* NewAssoc(const char* key);
 	void FreeAssoc(Variables::MyAssoc*);
 	Variables::MyAssoc* GetAssocAt(const char*, unsigned int&) const;
+	Variables::MyAssoc* GetAssocAt(const VariableKey &key) const;
+	void LinkAssoc(Variables::MyAssoc*, unsigned int nHash);
+	void Rehash(unsigned int nHashSize);
 	inline bool MyCopyKey(char*& dest, const char* key) const;
 	inline unsigned int MyCompareKey(const char* key, const char *str) const;
 	inline unsigned int MyHashKey(const char*) const;
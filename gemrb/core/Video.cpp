@@ -44,6 +44,8 @@ Video::Video(void)
 	// MOUSE_GRAYED and MOUSE_DISABLED are the first 2 bits so shift the config value away from those.
 	// we care only about 2 bits at the moment so mask out the remainder
 	MouseFlags = ((core->MouseFeedback & 0x3) << 2);
+	// the simulation runs on its own fixed timestep, this only caps the rendering rate
+	frameLimit = core->MaxFPS ? 1000 / core->MaxFPS : 0;
 
 	// Initialize gamma correction tables
 	for (int i = 0; i < 256; i++) {
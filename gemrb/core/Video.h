@@ -108,6 +108,8 @@ protected:
 	Palette *subtitlepal;
 	Region subtitleregion;
 	Color fadeColor;
+	// minimal duration of a frame in ms, 0 means no limit
+	unsigned long frameLimit;
 protected:
 	Region ClippedDrawingRect(const Region& target, const Region* clip = NULL) const;
 public:
@@ -140,6 +142,8 @@ public:
 	virtual Sprite2D* CreatePalettedSprite(int w, int h, int bpp, void* pixels,
 										   Color* palette, bool cK = false, int index = 0) = 0;
 	virtual bool SupportsBAMSprites() { return false; }
+	/** compares optimised drawing routines with the ones they replaced */
+	virtual bool SelfCheck() { return true; }
 
 	virtual void BlitTile(const Sprite2D* spr, const Sprite2D* mask, int x, int y,
 						  const Region* clip, unsigned int flags) = 0;
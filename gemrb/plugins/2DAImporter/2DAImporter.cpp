@@ -41,6 +41,21 @@ p2DAImporter::~p2DAImporter(void)
 	}
 }
 
+// strtok for space separated fields, but safe to use from the loader threads
+static char* NextToken(char *&cursor)
+{
+	while (*cursor == ' ')
+		cursor++;
+	if (!*cursor)
+		return NULL;
+	char *token = cursor;
+	while (*cursor && *cursor != ' ')
+		cursor++;
+	if (*cursor)
+		*cursor++ = 0;
+	return token;
+}
+
 bool p2DAImporter::Open(DataStream* str)
 {
 	if (str == NULL) {
@@ -61,7 +76,8 @@ bool p2DAImporter::Open(DataStream* str)
 	}
 	Signature[0] = 0;
 	str->ReadLine( Signature, sizeof(Signature) );
-	char* token = strtok( Signature, " " );
+	char* cursor = Signature;
+	char* token = NextToken( cursor );
 	if (token) {
 		strlcpy(defVal, token, sizeof(defVal));
 	} else { // no whitespace
@@ -85,19 +101,20 @@ bool p2DAImporter::Open(DataStream* str)
 		ptrs.push_back( line );
 		if (colHead) {
 			colHead = false;
-			char* str = strtok( line, " " );
-			while (str != NULL) {
+			cursor = line;
+			char* str;
+			while (( str = NextToken( cursor ) ) != NULL) {
 				colNames.push_back( str );
-				str = strtok( NULL, " " );
 			}
 		} else {
-			char* str = strtok( line, " " );
+			cursor = line;
+			char* str = NextToken( cursor );
 			if (str == NULL)
 				continue;
 			rowNames.push_back( str );
 			RowEntry r;
 			rows.push_back( r );
-			while (( str = strtok( NULL, " " ) ) != NULL) {
+			while (( str = NextToken( cursor ) ) != NULL) {
 				rows[row].push_back( str );
 			}
 			row++;
@@ -20,6 +20,8 @@
 
 #include "general.h"
 
+#include "System/String.h"
+
 using namespace GemRB;
 
 bool ACMReader::Open(DataStream* stream)
@@ -62,6 +64,16 @@ bool ACMReader::Open(DataStream* stream)
 	//levels = hdr.levels;
 	//subblocks = hdr.subblocks;
 
+	strnlwrcpy(key, str->filename, sizeof(key) - 1);
+	cached = PCMCache::Acquire(key, samples, channels, samplerate);
+	if (cached) {
+		return true;
+	}
+	if (PCMCache::Fits(samples)) {
+		recording = (short *) malloc(sizeof(short) * samples);
+		recorded = 0;
+	}
+
 	block_size = ( 1 << levels ) * subblocks;
 	//using malloc for simple arrays (supposed to be faster)
 	block = (int *) malloc(sizeof(int)*block_size);
@@ -94,6 +106,15 @@ int ACMReader::make_new_samples()
 
 int ACMReader::read_samples(short* buffer, int count)
 {
+	if (cached) {
+		if (count > samples_left) {
+			count = samples_left;
+		}
+		memcpy(buffer, cached->data + samples - samples_left, sizeof(short) * count);
+		samples_left -= count;
+		return count;
+	}
+
 	int res = 0;
 	while (res < count) {
 		if (samples_ready == 0) {
@@ -102,11 +123,27 @@ int ACMReader::read_samples(short* buffer, int count)
 			if (!make_new_samples())
 				break;
 		}
-		*buffer = ( short ) ( ( *values ) >> levels );
-		values++;
-		buffer++;
-		res += 1;
-		samples_ready--;
+		int chunk = count - res;
+		if (chunk > samples_ready) {
+			chunk = samples_ready;
+		}
+		for (int i = 0; i < chunk; i++) {
+			buffer[i] = ( short ) ( values[i] >> levels );
+		}
+		if (recording) {
+			memcpy(recording + recorded, buffer, sizeof(short) * chunk);
+			recorded += chunk;
+		}
+		values += chunk;
+		buffer += chunk;
+		res += chunk;
+		samples_ready -= chunk;
+	}
+
+	//the whole sound went through, keep it for the next time
+	if (recording && recorded == samples) {
+		PCMCache::Store(key, recording, samples, channels, samplerate);
+		recording = NULL;
 	}
 	return res;
 }
@@ -43,13 +43,19 @@ private:
 	int samples_ready;
 	CValueUnpacker* unpacker; // ACM-stream unpacker
 	CSubbandDecoder* decoder; // IP's subband decoder
+	const PCMCache::Entry* cached; // decoded earlier, nothing to unpack
+	short* recording; // the output so far, for the cache
+	int recorded;
+	char key[16];
 
 	int make_new_samples();
 public:
 	ACMReader()
 		: samples_left(0), levels(0), subblocks(0), block_size(0), block(NULL), values(NULL),
-		samples_ready( 0 ), unpacker( NULL ), decoder( NULL )
+		samples_ready( 0 ), unpacker( NULL ), decoder( NULL ), cached( NULL ),
+		recording( NULL ), recorded( 0 )
 	{
+		key[0] = 0;
 	}
 	virtual ~ACMReader()
 	{
@@ -59,13 +65,22 @@ public:
 	{
 		if (block) {
 			free(block);
+			block = NULL;
 		}
 		if (unpacker) {
 			delete unpacker;
+			unpacker = NULL;
 		}
 		if (decoder) {
 			delete decoder;
+			decoder = NULL;
 		}
+		if (cached) {
+			PCMCache::Release(cached);
+			cached = NULL;
+		}
+		free(recording);
+		recording = NULL;
 	}
 
 	bool Open(DataStream* stream);
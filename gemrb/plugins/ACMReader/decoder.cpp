@@ -22,6 +22,10 @@
 
 #include <cstdlib>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 int CSubbandDecoder::init_decoder()
 {
 	int memory_size = ( levels == 0 ) ? 0 : ( 3 * ( block_size >> 1 ) - 2 );
@@ -129,49 +133,50 @@ void CSubbandDecoder::sub_4d3fcc(short* memory, int* buffer, int sb_size,
 		}
 	}
 }
+// The columns of a subband are independent, so the rows are walked in the
+// outer loop and the columns in the inner one, which runs 4 at a time with
+// SSE2. The history is planar: all the db_0 values, then all the db_1 ones.
 void CSubbandDecoder::sub_4d420c(int* memory, int* buffer, int sb_size,
 	int blocks)
 {
-	int row_0, row_1, row_2 = 0, row_3 = 0, db_0, db_1;
-	int i;
-	int sb_size_2 = sb_size * 2, sb_size_3 = sb_size * 3;
-	if (blocks == 4) {
-		for (i = 0; i < sb_size; i++) {
-			row_0 = buffer[0];
-			row_1 = buffer[sb_size];
-			row_2 = buffer[sb_size_2];
-			row_3 = buffer[sb_size_3];
-
-			buffer[0] = memory[0] + 2 * memory[1] + row_0;
-			buffer[sb_size] = -memory[1] + 2 * row_0 - row_1;
-			buffer[sb_size_2] = row_0 + 2 * row_1 + row_2;
-			buffer[sb_size_3] = -row_1 + 2 * row_2 - row_3;
-
-			memory[0] = row_2;
-			memory[1] = row_3;
-
-			memory += 2;
-			buffer++;
+	int* db_0 = memory, * db_1 = memory + sb_size;
+	for (int j = 0; j < blocks >> 2; j++) {
+		int* row_0 = buffer, * row_1 = row_0 + sb_size;
+		int* row_2 = row_1 + sb_size, * row_3 = row_2 + sb_size;
+		int i = 0;
+#ifdef __SSE2__
+		for (; i + 4 <= sb_size; i += 4) {
+			__m128i d0 = _mm_loadu_si128((__m128i *) (db_0 + i));
+			__m128i d1 = _mm_loadu_si128((__m128i *) (db_1 + i));
+			__m128i r0 = _mm_loadu_si128((__m128i *) (row_0 + i));
+			__m128i r1 = _mm_loadu_si128((__m128i *) (row_1 + i));
+			__m128i r2 = _mm_loadu_si128((__m128i *) (row_2 + i));
+			__m128i r3 = _mm_loadu_si128((__m128i *) (row_3 + i));
+
+			_mm_storeu_si128((__m128i *) (row_0 + i),
+				_mm_add_epi32(_mm_add_epi32(d0, _mm_slli_epi32(d1, 1)), r0));
+			_mm_storeu_si128((__m128i *) (row_1 + i),
+				_mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r0, 1), d1), r1));
+			_mm_storeu_si128((__m128i *) (row_2 + i),
+				_mm_add_epi32(_mm_add_epi32(r0, _mm_slli_epi32(r1, 1)), r2));
+			_mm_storeu_si128((__m128i *) (row_3 + i),
+				_mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r2, 1), r1), r3));
+
+			_mm_storeu_si128((__m128i *) (db_0 + i), r2);
+			_mm_storeu_si128((__m128i *) (db_1 + i), r3);
 		}
-	} else {
-		for (i = 0; i < sb_size; i++) {
-			int* buff_ptr = buffer;
-			db_0 = memory[0]; db_1 = memory[1];
-			for (int j = 0; j < blocks >> 2; j++) {
-				row_0 = buff_ptr[0];  buff_ptr[0] = db_0 + 2 * db_1 + row_0;  buff_ptr += sb_size;
-				row_1 = buff_ptr[0];  buff_ptr[0] = -db_1 + 2 * row_0 - row_1;  buff_ptr += sb_size;
-				row_2 = buff_ptr[0];  buff_ptr[0] = row_0 + 2 * row_1 + row_2;  buff_ptr += sb_size;
-				row_3 = buff_ptr[0];  buff_ptr[0] = -row_1 + 2 * row_2 -
-					row_3;  buff_ptr += sb_size;
+#endif
+		for (; i < sb_size; i++) {
+			int r0 = row_0[i], r1 = row_1[i], r2 = row_2[i], r3 = row_3[i];
 
-				db_0 = row_2;
-				db_1 = row_3;
-			}
-			memory[0] = row_2;
-			memory[1] = row_3;
+			row_0[i] = db_0[i] + 2 * db_1[i] + r0;
+			row_1[i] = -db_1[i] + 2 * r0 - r1;
+			row_2[i] = r0 + 2 * r1 + r2;
+			row_3[i] = -r1 + 2 * r2 - r3;
 
-			memory += 2;
-			buffer++;
+			db_0[i] = r2;
+			db_1[i] = r3;
 		}
+		buffer += sb_size << 2;
 	}
 }
@@ -138,9 +138,43 @@ int BAMImporter::GetCycleSize(unsigned char Cycle)
 	return cycles[Cycle].FramesCount;
 }
 
+// records where each row starts, so clipped blits and pixel lookups
+// don't have to walk the frame from its first pixel
+static bool IndexRLERows(const unsigned char* rle, const unsigned char* end,
+			int width, int height, ieByte colorkey, RLERow* rows)
+{
+	const unsigned char* start = rle;
+	unsigned long pixel = 0;
+	int row = 0;
+	while (row < height) {
+		if (rle >= end) {
+			return false;
+		}
+		unsigned long count = 1;
+		int length = 1;
+		if (*rle == colorkey) {
+			if (rle + 1 >= end) {
+				return false;
+			}
+			count += rle[1];
+			length = 2;
+		}
+		// a transparent run may go on over several rows
+		while (row < height && (unsigned long) row * width < pixel + count) {
+			rows[row].offset = (ieDword) (rle - start);
+			rows[row].skip = (ieDword) (row * width - pixel);
+			row++;
+		}
+		pixel += count;
+		rle += length;
+	}
+	return true;
+}
+
 Sprite2D* BAMImporter::GetFrameInternal(unsigned short findex, unsigned char mode,
 			bool BAMsprite, const unsigned char* data,
-			AnimationFactory* datasrc)
+			AnimationFactory* datasrc,
+			const unsigned char* dataend, RLERow* rows)
 {
 	Sprite2D* spr = 0;
 
@@ -157,6 +191,10 @@ Sprite2D* BAMImporter::GetFrameInternal(unsigned short findex, unsigned char mod
 							   datasrc,
 							   palette,
 							   CompressedColorIndex);
+		if (RLECompressed && rows && IndexRLERows(framedata, dataend,
+				frames[findex].Width, frames[findex].Height, CompressedColorIndex, rows)) {
+			spr->rleRows = rows;
+		}
 	} else {
 		void* pixels = GetFramePixels(findex);
 		spr = core->GetVideoDriver()->CreateSprite8(
@@ -261,6 +299,8 @@ AnimationFactory* BAMImporter::GetAnimationFactory(const char* ResRef, unsigned
 
 	allowCompression = allowCompression && core->GetVideoDriver()->SupportsBAMSprites();
 	unsigned char* data = NULL;
+	unsigned char* dataend = NULL;
+	RLERow* rows = NULL;
 
 	if (allowCompression) {
 		str->Seek( DataStart, GEM_STREAM_START );
@@ -270,12 +310,30 @@ AnimationFactory* BAMImporter::GetAnimationFactory(const char* ResRef, unsigned
 		data = (unsigned char *) malloc(length);
 		str->Read( data, length );
 		af->SetFrameData(data);
+		dataend = data + length;
+
+		// one index for all the RLE frames, the factory frees it with the data
+		size_t rowcount = 0;
+		for (i = 0; i < FramesCount; ++i) {
+			if ((frames[i].FrameData & 0x80000000) == 0) {
+				rowcount += frames[i].Height;
+			}
+		}
+		if (rowcount) {
+			rows = (RLERow *) malloc(rowcount * sizeof(RLERow));
+			af->SetRowIndex(rows, rowcount);
+		}
 	}
 
 	for (i = 0; i < FramesCount; ++i) {
-		Sprite2D* frame = GetFrameInternal(i, mode, allowCompression, data, af);
+		bool RLECompressed = (frames[i].FrameData & 0x80000000) == 0;
+		Sprite2D* frame = GetFrameInternal(i, mode, allowCompression, data, af,
+			dataend, RLECompressed ? rows : NULL);
 		assert(!allowCompression || frame->BAM);
 		af->AddFrame(frame);
+		if (rows && RLECompressed) {
+			rows += frames[i].Height;
+		}
 	}
 	for (i = 0; i < CyclesCount; ++i) {
 		af->AddCycle( cycles[i] );
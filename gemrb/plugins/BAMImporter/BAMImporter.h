@@ -37,6 +37,7 @@ struct FrameEntry {
 };
 
 class Palette;
+struct RLERow;
 
 class BAMImporter : public AnimationMgr {
 private:
@@ -52,7 +53,8 @@ private:
 private:
 	Sprite2D* GetFrameInternal(unsigned short findex, unsigned char mode,
 							   bool BAMsprite, const unsigned char* data,
-							   AnimationFactory* datasrc);
+							   AnimationFactory* datasrc,
+							   const unsigned char* dataend = NULL, RLERow* rows = NULL);
 	void* GetFramePixels(unsigned short findex);
 	ieWord * CacheFLT(unsigned int &count);
 public:
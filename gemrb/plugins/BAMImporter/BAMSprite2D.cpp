@@ -97,6 +97,11 @@ Color BAMSprite2D::GetPixel(unsigned short x, unsigned short y) const
 	int skipcount = y * Width + x;
 
 	const ieByte *rle = (const ieByte*)pixels;
+	if (RLE && rleRows) {
+		// start at the run holding the row's first pixel
+		rle += rleRows[y].offset;
+		skipcount = rleRows[y].skip + x;
+	}
 	if (RLE) {
 		while (skipcount > 0) {
 			if (*rle++ == colorkey)
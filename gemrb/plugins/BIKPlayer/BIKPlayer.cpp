@@ -43,6 +43,11 @@
 
 #include <cassert>
 #include <cstdio>
+#include <time.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #if HAVE_UNISTD_H
 #include <unistd.h>
@@ -81,11 +86,14 @@ BIKPlayer::BIKPlayer(void)
 	memset(&header, 0, sizeof(header));
 	memset(s_coeffs_ptr, 0, sizeof(s_coeffs_ptr));
 	timer_last_sec = timer_last_usec = frame_wait = c_col_lastval = 0;
-	outputwidth = outputheight = video_frameskip = video_skippedframes = 0;
+	outputwidth = outputheight = video_skippedframes = 0;
 	s_frame_len = s_overlap_len = s_num_bands = s_block_size = 0;
 	video_rendered_frame = done = validVideo = s_audio = false;
 	s_channels = s_first = s_stream = s_root = 0;
 	s_bands = NULL;
+	memset(queue, 0, sizeof(queue));
+	queueHead = queueCount = 0;
+	decodeDone = decodeStop = false;
 }
 
 BIKPlayer::~BIKPlayer(void)
@@ -264,47 +272,31 @@ void BIKPlayer::timer_start()
 	get_current_time(timer_last_sec, timer_last_usec);
 }
 
-void BIKPlayer::timer_wait()
+//microseconds since timer_start
+long BIKPlayer::timer_elapsed()
 {
 	long sec, usec;
 	get_current_time(sec, usec);
-
-	while (sec > timer_last_sec) {
-		usec += 1000000;
-		timer_last_sec++;
-	}
-
-	//quick hack, we should rather use the rational time base as ffmpeg
-	frame_wait = v_timebase.num*1000000/v_timebase.den;
-	while (usec - timer_last_usec > (long)frame_wait) {
-		usec -= frame_wait;
-		video_frameskip++;
-	}
-
-	long to_sleep = frame_wait - (usec - timer_last_usec);
-#ifdef _WIN32
-	Sleep(to_sleep / 1000);
-#else
-	usleep(to_sleep);
-#endif
-
-	timer_start();
+	return (sec - timer_last_sec) * 1000000 + (usec - timer_last_usec);
 }
 
-bool BIKPlayer::next_frame()
+//reads the index-th frame into inbuff, returns its size without the audio size
+int BIKPlayer::read_frame(ieDword index, ieDword &audframesize)
 {
-	if (timer_last_sec) {
-		timer_wait();
-	}
-	if(frameCount>=header.framecount) {
-		return false;
-	}
-	binkframe frame = frames[frameCount++];
+	const binkframe &frame = frames[index];
 	str->Seek(frame.pos, GEM_STREAM_START);
-	ieDword audframesize;
 	str->ReadDword(&audframesize);
-	frame.size = str->Read( inbuff, frame.size - 4 );
-	if (s_stream > -1 && DecodeAudioFrame(inbuff, audframesize)) {
+	return str->Read( inbuff, frame.size - 4 );
+}
+
+//reads and decodes the index-th frame into out, on the decoder thread
+bool BIKPlayer::next_frame(ieDword index, bikqueuedframe &out)
+{
+	binkframe frame = frames[index];
+	ieDword audframesize;
+	frame.size = read_frame(index, audframesize);
+	out.samples_size = 0;
+	if (s_stream > -1 && DecodeAudioFrame(inbuff, audframesize, out)) {
 		//buggy frame, we stop immediately
 		//return false;
 	}
@@ -312,12 +304,49 @@ bool BIKPlayer::next_frame()
 		//buggy frame, we stop immediately
 		return false;
 	}
-	if (!timer_last_sec) {
-		timer_start();
-	}
+	out.number = index + 1;
 	return true;
 }
 
+void BIKPlayer::DecoderThread(void *self)
+{
+	((BIKPlayer *) self)->DecodeFrames();
+}
+
+/* Decodes ahead into the free slots of the queue. Each frame is decoded
+ * straight into its slot, with the previous slot as the reference frame.
+ * That one is never overwritten early, since the queue always keeps a slot
+ * between the oldest frame still shown and the one being decoded. */
+void BIKPlayer::DecodeFrames()
+{
+	for (ieDword i = 0; i < header.framecount; i++) {
+		queueLock.Lock();
+		while (queueCount == BIK_FRAME_QUEUE - 1 && !decodeStop) {
+			queueChanged.Wait(queueLock);
+		}
+		unsigned int slot = (queueHead + queueCount) % BIK_FRAME_QUEUE;
+		bool stop = decodeStop;
+		queueLock.Unlock();
+		if (stop) break;
+
+		c_pic = queue[slot].pic;
+		c_last = queue[(slot + BIK_FRAME_QUEUE - 1) % BIK_FRAME_QUEUE].pic;
+		if (!next_frame(i, queue[slot])) {
+			break;
+		}
+
+		queueLock.Lock();
+		queueCount++;
+		queueChanged.Signal();
+		queueLock.Unlock();
+	}
+
+	queueLock.Lock();
+	decodeDone = true;
+	queueChanged.Signal();
+	queueLock.Unlock();
+}
+
 int BIKPlayer::doPlay()
 {
 	int done = 0;
@@ -325,9 +354,9 @@ int BIKPlayer::doPlay()
 	//bink is always truecolor
 	g_truecolor = 1;
 
-	frame_wait = 0;
-	timer_last_sec = 0;
-	video_frameskip = 0;
+	//quick hack, we should rather use the rational time base as ffmpeg
+	frame_wait = v_timebase.num*1000000/v_timebase.den;
+	video_skippedframes = 0;
 
 	if (sound_init( core->GetAudioDrv()->CanPlay())) {
 		//sound couldn't be initialized
@@ -343,10 +372,83 @@ int BIKPlayer::doPlay()
 		return 2;
 	}
 
-	while (!done && next_frame()) {
+	if (core->MovieBenchmark) {
+		DecodeBenchmark();
+	}
+
+	queueHead = queueCount = 0;
+	decodeDone = decodeStop = false;
+	if (!decoder.Start(DecoderThread, this)) {
+		Log(ERROR, "BIKPlayer", "Couldn't start the decoder thread!");
+		video->DestroyMovieScreen();
+		return 3;
+	}
+
+	unsigned int dest_x = (outputwidth - header.width) >> 1;
+	unsigned int dest_y = (outputheight - header.height) >> 1;
+	bool started = false;
+	while (!done) {
+		queueLock.Lock();
+		while (!queueCount && !decodeDone) {
+			queueChanged.Wait(queueLock);
+		}
+		unsigned int ready = queueCount;
+		queueLock.Unlock();
+		if (!ready) break;
+
+		bikqueuedframe &frame = queue[queueHead];
+		//the audio is queued a frame ahead, like the decoder always did
+		if (frame.samples_size) {
+			queueBuffer(s_stream, 16, s_channels, frame.samples, frame.samples_size, header.samplerate);
+		}
+		if (!started) {
+			timer_start();
+			started = true;
+		}
+
+		//frames are due at fixed times from the start, so delays don't add up
+		long due = (long) (frame.number - 1) * (long) frame_wait;
+		long now = timer_elapsed();
+		if (now < due) {
+#ifdef _WIN32
+			Sleep((due - now) / 1000);
+#else
+			//usleep may refuse a second or more
+			struct timespec wait;
+			wait.tv_sec = (due - now) / 1000000;
+			wait.tv_nsec = ((due - now) % 1000000) * 1000;
+			nanosleep(&wait, NULL);
+#endif
+		}
+		frameCount = frame.number;
+		//too late: skip showing it if the next one is already decoded
+		if (now > due + (long) frame_wait && ready > 1) {
+			video_skippedframes++;
+		} else {
+			showFrame((ieByte **) frame.pic.data, (unsigned int *) frame.pic.linesize, header.width, header.height, header.width, header.height, dest_x, dest_y);
+		}
+
+		queueLock.Lock();
+		queueHead = (queueHead + 1) % BIK_FRAME_QUEUE;
+		queueCount--;
+		queueChanged.Signal();
+		queueLock.Unlock();
+
 		done = video->PollMovieEvents();
 	}
 
+	queueLock.Lock();
+	decodeStop = true;
+	queueChanged.Signal();
+	queueLock.Unlock();
+	decoder.Join();
+
+	if (started && frameCount) {
+		long elapsed = timer_elapsed();
+		Log(MESSAGE, "BIKPlayer", "Played %d frames in %ld ms (%.2f fps), skipped %d.",
+			frameCount, elapsed / 1000, frameCount * 1000000.0 / (elapsed ? elapsed : 1), video_skippedframes);
+	}
+
 	video->DestroyMovieScreen();
 	return 0;
 }
@@ -507,6 +609,32 @@ void BIKPlayer::ff_init_scantable(ScanTable *st, const uint8_t *src_scantable){
 	}
 }
 
+static inline void release_buffer(AVFrame *p)
+{
+	int i;
+
+	for(i=0;i<3;i++) {
+		av_freep((void **) &p->data[i]);
+	}
+}
+
+static inline void ff_fill_linesize(AVFrame *picture, int width)
+{
+	memset(picture->linesize, 0, sizeof(picture->linesize));
+	int w2 = (width + (1 << 1) - 1) >> 1;
+	picture->linesize[0] = width;
+	picture->linesize[1] = w2;
+	picture->linesize[2] = w2;
+}
+
+static inline void get_buffer(AVFrame *p, int width, int height)
+{
+	ff_fill_linesize(p, width);
+	for(int plane=0;plane<3;plane++) {
+		p->data[plane] = (uint8_t *) av_malloc(p->linesize[plane]*height);
+	}
+}
+
 int BIKPlayer::video_init(int w, int h)
 {
 	int bw, bh, blocks;
@@ -530,6 +658,17 @@ int BIKPlayer::video_init(int w, int h)
 		return 1;
 	}
 
+	//the frames are decoded straight into the queue slots
+	for (i = 0; i < BIK_FRAME_QUEUE; i++) {
+		get_buffer(&queue[i].pic, header.width, header.height);
+		for (int plane = 0; plane < 3; plane++) {
+			if (!queue[i].pic.data[plane]) {
+				return 2;
+			}
+			memset(queue[i].pic.data[plane], 0, queue[i].pic.linesize[plane]*header.height);
+		}
+	}
+
 	ff_init_scantable(&c_scantable, bink_scan);
 
 	bw = (header.width  + 7) >> 3;
@@ -559,38 +698,18 @@ int BIKPlayer::EndAudio()
 	return 0;
 }
 
-static inline void release_buffer(AVFrame *p)
-{
-	int i;
-
-	for(i=0;i<3;i++) {
-		av_freep((void **) &p->data[i]);
-	}
-}
-
-static inline void ff_fill_linesize(AVFrame *picture, int width)
-{
-	memset(picture->linesize, 0, sizeof(picture->linesize));
-	int w2 = (width + (1 << 1) - 1) >> 1;
-	picture->linesize[0] = width;
-	picture->linesize[1] = w2;
-	picture->linesize[2] = w2;
-}
-
-static inline void get_buffer(AVFrame *p, int width, int height)
-{
-	ff_fill_linesize(p, width);
-	for(int plane=0;plane<3;plane++) {
-		p->data[plane] = (uint8_t *) av_malloc(p->linesize[plane]*height);
-	}
-}
-
 int BIKPlayer::EndVideo()
 {
 	int i;
 
-	release_buffer(&c_pic);
-	release_buffer(&c_last);
+	//c_pic and c_last only point into the queue
+	memset(&c_pic, 0, sizeof(AVFrame));
+	memset(&c_last, 0, sizeof(AVFrame));
+	for (i = 0; i < BIK_FRAME_QUEUE; i++) {
+		release_buffer(&queue[i].pic);
+		av_freep((void **) &queue[i].samples);
+		queue[i].samples_alloc = 0;
+	}
 	for (i = 0; i < BINK_NB_SRC; i++) {
 		av_freep((void **) &c_bundle[i].data);
 	}
@@ -744,16 +863,24 @@ void BIKPlayer::DecodeBlock(short *out)
 }
 
 //audio samples
-int BIKPlayer::DecodeAudioFrame(void *data, int data_size)
+int BIKPlayer::DecodeAudioFrame(void *data, int data_size, bikqueuedframe &out)
 {
 	int bits = data_size*8;
 	s_gb.init_get_bits((uint8_t *) data, bits);
 
 	unsigned int reported_size = s_gb.get_bits_long(32);
-	ieWordSigned *samples = (ieWordSigned *) calloc(reported_size+s_block_size,1);
-	if (!samples) {
-		return -1;
+	//the buffer of the slot is reused, so it only grows
+	if (out.samples_alloc < reported_size+s_block_size) {
+		av_freep((void **) &out.samples);
+		out.samples_alloc = 0;
+		out.samples = (ieWordSigned *) av_malloc(reported_size+s_block_size);
+		if (!out.samples) {
+			return -1;
+		}
+		out.samples_alloc = reported_size+s_block_size;
 	}
+	ieWordSigned *samples = out.samples;
+	memset(samples, 0, reported_size+s_block_size);
 
 	ieWordSigned *outbuf = samples;
 	ieWordSigned *samples_end  = samples+reported_size/sizeof(ieWordSigned);
@@ -771,9 +898,8 @@ int BIKPlayer::DecodeAudioFrame(void *data, int data_size)
 	//ret is a better value here as it provides almost perfect sound.
 	//Original ffmpeg code produces worse results with reported_size.
 	//Ideally ret == reported_size
-	queueBuffer(s_stream, 16, s_channels, samples, ret, header.samplerate);
-
-	free(samples);
+	//it is queued by the presenting thread
+	out.samples_size = ret;
 	return reported_size!=ret;
 }
 
@@ -1300,7 +1426,7 @@ static inline void copy_block(DCTELEM block[64], const uint8_t *src, uint8_t *ds
 #define clear_block(block) memset( (block), 0, sizeof(DCTELEM)*64);
 
 //This replaces the j_rev_dct module
-static void bink_idct(DCTELEM *block)
+static void bink_idct_c(DCTELEM *block)
 {
 	int i, t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, tA, tB, tC;
 	int tblock[64];
@@ -1376,6 +1502,120 @@ static void bink_idct(DCTELEM *block)
 	}
 }
 
+#ifdef __SSE2__
+/* SSE2 has no 32 bit multiply, so emulate the low half with two 32x32->64 ones */
+static inline __m128i mullo_epi32(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+#define MUL11(x, c) _mm_srai_epi32(mullo_epi32((x), _mm_set1_epi32(c)), 11)
+
+/* one pass of bink_idct on four columns at once, v[] are the eight rows */
+static inline void bink_idct_pass_sse2(__m128i v[8])
+{
+	__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, tA, tB, tC;
+
+	t0 = _mm_add_epi32(v[0], v[4]);
+	t1 = _mm_sub_epi32(v[0], v[4]);
+	t2 = _mm_add_epi32(v[2], v[6]);
+	t3 = _mm_sub_epi32(v[2], v[6]);
+	t3 = _mm_sub_epi32(MUL11(t3, 0xB50), t2);
+
+	t4 = _mm_sub_epi32(t0, t2);
+	t5 = _mm_add_epi32(t0, t2);
+	t6 = _mm_add_epi32(t1, t3);
+	t7 = _mm_sub_epi32(t1, t3);
+
+	t0 = _mm_add_epi32(v[5], v[3]);
+	t1 = _mm_sub_epi32(v[5], v[3]);
+	t2 = _mm_add_epi32(v[1], v[7]);
+	t3 = _mm_sub_epi32(v[1], v[7]);
+
+	t8 = _mm_add_epi32(t2, t0);
+	t9 = MUL11(_mm_add_epi32(t3, t1), 0xEC8);
+	tA = _mm_sub_epi32(_mm_add_epi32(MUL11(t1, -0x14E8), t9), t8);
+	tB = _mm_sub_epi32(MUL11(_mm_sub_epi32(t2, t0), 0xB50), tA);
+	tC = _mm_sub_epi32(_mm_add_epi32(MUL11(t3, 0x8A9), tB), t9);
+
+	v[0] = _mm_add_epi32(t5, t8);
+	v[7] = _mm_sub_epi32(t5, t8);
+	v[1] = _mm_add_epi32(t6, tA);
+	v[6] = _mm_sub_epi32(t6, tA);
+	v[2] = _mm_add_epi32(t7, tB);
+	v[5] = _mm_sub_epi32(t7, tB);
+	v[4] = _mm_add_epi32(t4, tC);
+	v[3] = _mm_sub_epi32(t4, tC);
+}
+
+#undef MUL11
+
+static inline void transpose4x4_epi32(__m128i &a, __m128i &b, __m128i &c, __m128i &d)
+{
+	__m128i ab0 = _mm_unpacklo_epi32(a, b);
+	__m128i ab1 = _mm_unpackhi_epi32(a, b);
+	__m128i cd0 = _mm_unpacklo_epi32(c, d);
+	__m128i cd1 = _mm_unpackhi_epi32(c, d);
+	a = _mm_unpacklo_epi64(ab0, cd0);
+	b = _mm_unpackhi_epi64(ab0, cd0);
+	c = _mm_unpacklo_epi64(ab1, cd1);
+	d = _mm_unpackhi_epi64(ab1, cd1);
+}
+
+/* lo holds columns 0-3 of each row, hi columns 4-7 */
+static inline void transpose8x8_epi32(__m128i lo[8], __m128i hi[8])
+{
+	transpose4x4_epi32(lo[0], lo[1], lo[2], lo[3]);
+	transpose4x4_epi32(hi[0], hi[1], hi[2], hi[3]);
+	transpose4x4_epi32(lo[4], lo[5], lo[6], lo[7]);
+	transpose4x4_epi32(hi[4], hi[5], hi[6], hi[7]);
+	// swap the off-diagonal 4x4 blocks
+	for (int i = 0; i < 4; i++) {
+		__m128i tmp = hi[i];
+		hi[i] = lo[i + 4];
+		lo[i + 4] = tmp;
+	}
+}
+
+/* bit exact with the plain C version, including the int to short truncation */
+static void bink_idct_sse2(DCTELEM *block)
+{
+	__m128i lo[8], hi[8];
+	__m128i *rows = (__m128i *) block;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		__m128i row = _mm_loadu_si128(rows + i);
+		lo[i] = _mm_srai_epi32(_mm_unpacklo_epi16(row, row), 16);
+		hi[i] = _mm_srai_epi32(_mm_unpackhi_epi16(row, row), 16);
+	}
+
+	bink_idct_pass_sse2(lo);
+	bink_idct_pass_sse2(hi);
+	transpose8x8_epi32(lo, hi);
+	bink_idct_pass_sse2(lo);
+	bink_idct_pass_sse2(hi);
+	transpose8x8_epi32(lo, hi);
+
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (i = 0; i < 8; i++) {
+		__m128i l = _mm_srai_epi32(_mm_add_epi32(lo[i], round), 8);
+		__m128i h = _mm_srai_epi32(_mm_add_epi32(hi[i], round), 8);
+		// keep the low 16 bits like the scalar assignment does instead of saturating
+		l = _mm_srai_epi32(_mm_slli_epi32(l, 16), 16);
+		h = _mm_srai_epi32(_mm_slli_epi32(h, 16), 16);
+		_mm_storeu_si128(rows + i, _mm_packs_epi32(l, h));
+	}
+}
+
+static void (*bink_idct)(DCTELEM *block) = bink_idct_sse2;
+#else
+static void (*bink_idct)(DCTELEM *block) = bink_idct_c;
+#endif
+
 static void idct_put(uint8_t *dest, int line_size, DCTELEM *block)
 {
 	bink_idct(block);
@@ -1388,6 +1628,46 @@ static void idct_add(uint8_t *dest, int line_size, DCTELEM *block)
 	add_pixels_nonclamped(block, dest, line_size);
 }
 
+/* Decodes the video track as fast as possible, without sleeping, showing
+ * or decoding audio, once with each IDCT, and logs the decoding speed. */
+void BIKPlayer::DecodeBenchmark()
+{
+	void (*idcts[2])(DCTELEM *block) = { bink_idct_c, NULL };
+	const char *names[2] = { "scalar", "SSE2" };
+#ifdef __SSE2__
+	idcts[1] = bink_idct_sse2;
+#endif
+	void (*idct)(DCTELEM *block) = bink_idct;
+
+	for (int v = 0; v < 2 && idcts[v]; v++) {
+		bink_idct = idcts[v];
+		ieDword decoded = 0;
+		timer_start();
+		for (ieDword i = 0; i < header.framecount; i++) {
+			//two slots are enough, each frame only refers to the previous one
+			c_pic = queue[i & 1].pic;
+			c_last = queue[(i + 1) & 1].pic;
+			ieDword audframesize;
+			int size = read_frame(i, audframesize);
+			if (DecodeVideoFrame(inbuff + audframesize, size - audframesize)) {
+				break;
+			}
+			decoded++;
+		}
+		long elapsed = timer_elapsed();
+		Log(MESSAGE, "BIKPlayer", "Decoded %d frames in %ld ms with the %s IDCT (%.2f fps).",
+			decoded, elapsed / 1000, names[v], decoded * 1000000.0 / (elapsed ? elapsed : 1));
+	}
+	bink_idct = idct;
+
+	//playback starts from blank frames, like without the benchmark
+	for (int i = 0; i < 2; i++) {
+		for (int plane = 0; plane < 3; plane++) {
+			memset(queue[i].pic.data[plane], 0, queue[i].pic.linesize[plane]*header.height);
+		}
+	}
+}
+
 int BIKPlayer::DecodeVideoFrame(void *data, int data_size)
 {
 	int blk, bw, bh;
@@ -1405,7 +1685,6 @@ int BIKPlayer::DecodeVideoFrame(void *data, int data_size)
 	//this is compatible only with the BIKi version
 	v_gb.skip_bits(32);
 
-	get_buffer(&c_pic, header.width, header.height);
 	//plane order is YUV
 	for (plane = 0; plane < 3; plane++) {
 		const int stride = c_pic.linesize[plane];
@@ -1613,19 +1892,6 @@ int BIKPlayer::DecodeVideoFrame(void *data, int data_size)
 		v_gb.get_bits_align32();
 	}
 
-	if (video_frameskip) {
-		video_frameskip--;
-		video_skippedframes++;
-	} else {
-		unsigned int dest_x = (outputwidth - header.width) >> 1;
-		unsigned int dest_y = (outputheight - header.height) >> 1;
-		showFrame((ieByte **) c_pic.data, (unsigned int *) c_pic.linesize, header.width, header.height, header.width, header.height, dest_x, dest_y);
-	}
-
-	//release the old frame even when frame is skipped
-	release_buffer(&c_last);
-	memcpy(&c_last, &c_pic, sizeof(AVFrame));
-	memset(&c_pic, 0, sizeof(AVFrame));
 	return 0;
 }
 
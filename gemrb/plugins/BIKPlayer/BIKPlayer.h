@@ -27,6 +27,7 @@
 #include "win32def.h"
 
 #include "Interface.h"
+#include "System/Thread.h"
 
 // FIXME: This has to be included last, since it defines int*_t, which causes
 // mingw g++ 4.5.0 to choke.
@@ -144,6 +145,17 @@ typedef struct {
 	ieDword size;
 } binkframe;
 
+// how many decoded frames the decoder thread may run ahead of the display
+#define BIK_FRAME_QUEUE 4
+
+typedef struct {
+	ieDword number;       ///< 1 based frame number, for the subtitles
+	AVFrame pic;
+	ieWordSigned *samples;
+	unsigned int samples_size;  ///< in bytes
+	unsigned int samples_alloc;
+} bikqueuedframe;
+
 typedef struct Bundle {
 	  int     len;       ///< length of number of entries to decode (in bits)
 	  Tree    tree;      ///< Huffman tree-related data
@@ -165,6 +177,14 @@ private:
 	ieDword maxRow;
 	ieDword rowCount;
 	ieDword frameCount;
+
+	//the decoder thread fills this ring, the main thread presents from it
+	Thread decoder;
+	Mutex queueLock;
+	WaitCondition queueChanged;
+	bikqueuedframe queue[BIK_FRAME_QUEUE];
+	unsigned int queueHead, queueCount;
+	bool decodeDone, decodeStop;
 	
 	//audio context (consider packing it in a struct)
 	unsigned int s_frame_len;
@@ -197,7 +217,6 @@ private:
 	long timer_last_usec;
 	unsigned int frame_wait;
 	bool video_rendered_frame;
-	unsigned int video_frameskip;
 	bool done;
 	int outputwidth, outputheight;
 	unsigned int video_skippedframes;
@@ -215,9 +234,13 @@ private:
 
 private:
 	void timer_start();
-	void timer_wait();
+	long timer_elapsed();
 	void segment_video_play();
-	bool next_frame();
+	int read_frame(ieDword index, ieDword &audframesize);
+	bool next_frame(ieDword index, bikqueuedframe &out);
+	void DecodeBenchmark();
+	static void DecoderThread(void *self);
+	void DecodeFrames();
 	int doPlay();
 	unsigned int fileRead(unsigned int pos, void* buf, unsigned int count);
 	void showFrame(unsigned char** buf, unsigned int *strides, unsigned int bufw,
@@ -234,7 +257,7 @@ private:
 	void av_set_pts_info(AVRational &time_base, unsigned int pts_num, unsigned int pts_den);
 	int ReadHeader();
 	void DecodeBlock(short *out);
-	int DecodeAudioFrame(void *data, int data_size);
+	int DecodeAudioFrame(void *data, int data_size, bikqueuedframe &out);
 	inline int get_value(int bundle);
 	int read_dct_coeffs(DCTELEM block[64], const uint8_t *scan, bool is_intra);
 	int read_residue(DCTELEM block[64], int masks_count);
@@ -25,6 +25,7 @@
 #include "Interface.h"
 #include "GameScript/GameScript.h"
 #include "System/FileStream.h"
+#include "System/MemoryStream.h"
 
 using namespace GemRB;
 
@@ -47,7 +48,14 @@ bool DLGImporter::Open(DataStream* stream)
 		return false;
 	}
 	delete str;
-	str = stream;
+	// the states are read on demand for as long as the dialog is cached,
+	// so don't keep a file open for that
+	unsigned long length = stream->Remains();
+	void *data = malloc(length);
+	stream->Read(data, length);
+	str = new MemoryStream(stream->originalfile, data, length);
+	delete stream;
+
 	char Signature[8];
 	str->Read( Signature, 8 );
 	if (strnicmp( Signature, "DLG V1.0", 8 ) != 0) {
@@ -85,24 +93,29 @@ bool DLGImporter::Open(DataStream* stream)
 	return true;
 }
 
-Dialog* DLGImporter::GetDialog() const
+Dialog* DLGImporter::GetDialog()
 {
 	if(!Version) {
 		return NULL;
 	}
-	Dialog* d = new Dialog();
+	Dialog* d = new Dialog(this);
 	d->Flags = Flags;
 	d->TopLevelCount = StatesCount;
 	d->Order = (unsigned int *) calloc (StatesCount, sizeof(unsigned int) );
 	d->initialStates = (DialogState **) calloc (StatesCount, sizeof(DialogState *) );
+	// only the evaluation order is needed up front, the states are read
+	// when the dialog first asks for them
 	for (unsigned int i = 0; i < StatesCount; i++) {
-		DialogState* ds = GetDialogState( d, i );
-		d->initialStates[i] = ds;
+		ieDword TriggerIndex;
+		str->Seek( StatesOffset + ( i * 16 ) + 12, GEM_STREAM_START );
+		str->ReadDword( &TriggerIndex );
+		if (TriggerIndex<StatesCount)
+			d->Order[TriggerIndex] = i;
 	}
 	return d;
 }
 
-DialogState* DLGImporter::GetDialogState(Dialog *d, unsigned int index) const
+DialogState* DLGImporter::GetDialogState(unsigned int index) const
 {
 	DialogState* ds = new DialogState();
 	//16 = sizeof(State)
@@ -114,12 +127,20 @@ DialogState* DLGImporter::GetDialogState(Dialog *d, unsigned int index) const
 	str->ReadDword( &ds->transitionsCount );
 	str->ReadDword( &TriggerIndex );
 	ds->condition = GetStateTrigger( TriggerIndex );
-	ds->transitions = GetTransitions( FirstTransitionIndex, ds->transitionsCount );
-	if (TriggerIndex<StatesCount)
-		d->Order[TriggerIndex] = index;
+	ds->transitions = NULL;
 	return ds;
 }
 
+DialogTransition** DLGImporter::GetStateTransitions(unsigned int index) const
+{
+	str->Seek( StatesOffset + ( index * 16 ) + 4, GEM_STREAM_START );
+	ieDword  FirstTransitionIndex;
+	ieDword  TransitionsCount;
+	str->ReadDword( &FirstTransitionIndex );
+	str->ReadDword( &TransitionsCount );
+	return GetTransitions( FirstTransitionIndex, TransitionsCount );
+}
+
 DialogTransition** DLGImporter::GetTransitions(unsigned int firstIndex, unsigned int count) const
 {
 	DialogTransition** trans = ( DialogTransition** )
@@ -72,10 +72,11 @@ public:
 	DLGImporter(void);
 	~DLGImporter(void);
 	bool Open(DataStream* stream);
-	Dialog* GetDialog() const;
+	Dialog* GetDialog();
 	Condition* GetCondition(char *string) const;
+	DialogState* GetDialogState(unsigned int index) const;
+	DialogTransition** GetStateTransitions(unsigned int index) const;
 private:
-	DialogState* GetDialogState(Dialog *d, unsigned int index) const;
 	DialogTransition* GetTransition(unsigned int index) const;
 	Condition* GetStateTrigger(unsigned int index) const;
 	Condition* GetTransitionTrigger(unsigned int index) const;
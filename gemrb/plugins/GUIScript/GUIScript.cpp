@@ -47,6 +47,7 @@
 #include "Video.h"
 #include "WorldMap.h"
 #include "GameScript/GSUtils.h" //checkvariable
+#include "GameScript/ScriptProfiler.h"
 #include "GUI/Button.h"
 #include "GUI/EventMgr.h"
 #include "GUI/GameControl.h"
@@ -61,6 +62,7 @@
 #include "Scriptable/InfoPoint.h"
 #include "System/FileStream.h"
 #include "System/Logger/MessageWindowLogger.h"
+#include "System/StringBuffer.h"
 #include "System/VFS.h"
 
 #include <algorithm>
@@ -6187,6 +6189,70 @@ static PyObject* GemRB_DumpActor(PyObject * /*self*/, PyObject * args)
 	Py_RETURN_NONE;
 }
 
+PyDoc_STRVAR( GemRB_EnableScriptProfiler__doc,
+"===== EnableScriptProfiler =====\n\
+\n\
+**Prototype:** GemRB.EnableScriptProfiler (flag)\n\
+\n\
+**Description:** Turns the game script profiler on or off. It records call \n\
+counts and run times of scripts, response block conditions, triggers and \n\
+actions. Turning it on clears the previous results.\n\
+\n\
+**Parameters:** flag - boolean\n\
+\n\
+**Return value:** N/A\n\
+\n\
+**See also:** [[guiscript:DumpScriptProfile]]"
+);
+
+static PyObject* GemRB_EnableScriptProfiler(PyObject * /*self*/, PyObject* args)
+{
+	int Flag;
+
+	if (!PyArg_ParseTuple( args, "i", &Flag )) {
+		return AttributeError( GemRB_EnableScriptProfiler__doc );
+	}
+
+	ScriptProfiler::Enable( Flag != 0 );
+
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR( GemRB_DumpScriptProfile__doc,
+"===== DumpScriptProfile =====\n\
+\n\
+**Prototype:** GemRB.DumpScriptProfile ([limit, reset])\n\
+\n\
+**Description:** Prints the results of the game script profiler, the most \n\
+expensive entries first.\n\
+\n\
+**Parameters:**\n\
+  * limit - the number of rows per table, 0 for all (default: 20)\n\
+  * reset - clear the results afterwards (default: 0)\n\
+\n\
+**Return value:** string, the printed tables\n\
+\n\
+**See also:** [[guiscript:EnableScriptProfiler]]"
+);
+
+static PyObject* GemRB_DumpScriptProfile(PyObject * /*self*/, PyObject* args)
+{
+	int limit = 20;
+	int reset = 0;
+
+	if (!PyArg_ParseTuple( args, "|ii", &limit, &reset )) {
+		return AttributeError( GemRB_DumpScriptProfile__doc );
+	}
+
+	StringBuffer buffer;
+	ScriptProfiler::Dump(buffer, limit);
+	Log(MESSAGE, "ScriptProfiler", buffer);
+	if (reset) {
+		ScriptProfiler::Reset();
+	}
+	return PyString_FromString( buffer.get().c_str() );
+}
+
 PyDoc_STRVAR( GemRB_SaveCharacter__doc,
 "===== SaveCharacter =====\n\
 \n\
@@ -9920,7 +9986,7 @@ static PyObject* GemRB_MessageWindowDebug(PyObject * /*self*/, PyObject* args)
 	}
 
 	if (logLevel == -1) {
-		RemoveLogger(getMessageWindowLogger());
+		removeMessageWindowLogger();
 	} else {
 		// convert it to the internal representation
 		getMessageWindowLogger(true)->SetLogLevel((log_level)logLevel);
@@ -15364,7 +15430,9 @@ static PyMethodDef GemRBMethods[] = {
 	METHOD(DrawWindows, METH_NOARGS),
 	METHOD(DropDraggedItem, METH_VARARGS),
 	METHOD(DumpActor, METH_VARARGS),
+	METHOD(DumpScriptProfile, METH_VARARGS),
 	METHOD(EnableCheatKeys, METH_VARARGS),
+	METHOD(EnableScriptProfiler, METH_VARARGS),
 	METHOD(EndCutSceneMode, METH_NOARGS),
 	METHOD(EnterGame, METH_NOARGS),
 	METHOD(EnterStore, METH_VARARGS),
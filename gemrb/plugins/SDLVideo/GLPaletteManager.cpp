@@ -4,10 +4,46 @@
 #include <cstring>
 
 #include "GLPaletteManager.h"
+#include "GLTextureAtlas.h"
 #include "Palette.h"
 
 using namespace GemRB;
 
+GLuint GLPaletteManager::allocateRow()
+{
+	if (freeRows.empty())
+	{
+		GLuint texture = GLTextureAtlas::CreateTexture();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+#ifdef USE_GL
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, PALETTE_PAGE_ROWS, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		pages.push_back(texture);
+		// hand out the rows from the top
+		GLuint first = (GLuint) (pages.size() - 1) * PALETTE_PAGE_ROWS + 1;
+		for (GLuint row = first + PALETTE_PAGE_ROWS; row-- > first; )
+		{
+			freeRows.push_back(row);
+		}
+	}
+	GLuint row = freeRows.back();
+	freeRows.pop_back();
+	return row;
+}
+
+void GLPaletteManager::freeRow(GLuint row)
+{
+	// pending batches may still sample the row
+	releasedRows.push_back(row);
+}
+
+void GLPaletteManager::EndFrame()
+{
+	freeRows.insert(freeRows.end(), releasedRows.begin(), releasedRows.end());
+	releasedRows.clear();
+}
+
 GLuint GLPaletteManager::CreatePaletteTexture(Palette* palette, unsigned int colorKey, bool attached)
 {
 	const PaletteKey key(palette, colorKey);
@@ -27,13 +63,7 @@ GLuint GLPaletteManager::CreatePaletteTexture(Palette* palette, unsigned int col
 	if (currentTextures->find(key) == currentTextures->end())
 	{
 		// not found, we need to create it
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GLuint texture = allocateRow();
 		Color* colors = new Color[256];
 		memcpy(colors, palette->col, sizeof(Color)*256);
 		if (!palette->alpha)
@@ -50,7 +80,9 @@ GLuint GLPaletteManager::CreatePaletteTexture(Palette* palette, unsigned int col
 #ifdef USE_GL
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) colors);
+		glActiveTexture(GL_UPLOAD_UNIT);
+		glBindTexture(GL_TEXTURE_2D, GetPageTexture(texture));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (texture - 1) % PALETTE_PAGE_ROWS, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) colors);
 		delete[] colors;
 		palette->acquire();
 		currentTextures->insert(std::make_pair(key, texture));
@@ -86,7 +118,7 @@ void GLPaletteManager::RemovePaletteTexture(Palette* palette, unsigned int color
 		{
 			palette->release();
 			currentIndexes->erase(currentTextures->at(key));
-			glDeleteTextures(1, &(currentTextures->at(key)));
+			freeRow(currentTextures->at(key));
 			currentTextures->erase(key);
 		}
 	}
@@ -118,7 +150,7 @@ void GLPaletteManager::RemovePaletteTexture(GLuint texture, bool attached)
 		{
 			key.palette->release();
 			currentIndexes->erase(texture);
-			glDeleteTextures(1, &texture);
+			freeRow(texture);
 			currentTextures->erase(key);
 		}
 	}
@@ -144,7 +176,7 @@ void GLPaletteManager::ClearUnused(bool attached)
 		if (!it->first.palette->IsShared())
 		{
 			it->first.palette->release();
-			glDeleteTextures(1, &(currentTextures->at(it->first)));
+			freeRow(it->second);
 			currentIndexes->erase(it->second);
 			currentTextures->erase(it++);
 		}
@@ -160,7 +192,6 @@ void GLPaletteManager::Clear()
 	for(std::map<PaletteKey, GLuint, PaletteKey>::iterator it = textures.begin(); it != textures.end(); ++it)
 	{
 		it->first.palette->release();
-		glDeleteTextures(1, &(textures[it->first]));
 	}
 	textures.clear();
 	indexes.clear();
@@ -168,10 +199,17 @@ void GLPaletteManager::Clear()
 	for(std::map<PaletteKey, GLuint, PaletteKey>::iterator it = a_textures.begin(); it != a_textures.end(); ++it)
 	{
 		it->first.palette->release();
-		glDeleteTextures(1, &(a_textures[it->first]));
 	}
 	a_textures.clear();
 	a_indexes.clear();
+
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		GLTextureAtlas::DeleteTexture(pages[i]);
+	}
+	pages.clear();
+	freeRows.clear();
+	releasedRows.clear();
 }
 
 
@@ -2,8 +2,11 @@
 #define GLPALETTEMANAGER_H
 
 #include <map>
+#include <vector>
 
 #define PALETTE_INVALID_INDEX 256
+// palettes are rows of shared 256 x PALETTE_PAGE_ROWS textures
+#define PALETTE_PAGE_ROWS 256
 
 namespace GemRB
 {
@@ -39,11 +42,24 @@ namespace GemRB
 			std::map<PaletteKey, GLuint, PaletteKey> a_textures;
 			std::map<GLuint, PaletteKey> a_indexes;
 
+			std::vector<GLuint> pages;
+			std::vector<GLuint> freeRows;
+			std::vector<GLuint> releasedRows; // reusable after the frame
+
+			GLuint allocateRow();
+			void freeRow(GLuint row);
+
 		public:
+			// the "textures" handed out are row handles, 0 is none
 			GLuint CreatePaletteTexture(Palette* palette, unsigned int colorKey, bool attached = false);
+			GLuint GetPageTexture(GLuint row) const { return pages[(row - 1) / PALETTE_PAGE_ROWS]; }
+			GLfloat GetRowCoord(GLuint row) const { return (((row - 1) % PALETTE_PAGE_ROWS) + 0.5f) / PALETTE_PAGE_ROWS; }
+			unsigned int GetPageCount() const { return (unsigned int) pages.size(); }
 			void RemovePaletteTexture(Palette* palette, unsigned int colorKey, bool attached = false);
 			void RemovePaletteTexture(GLuint texture, bool attached = false);
 			void ClearUnused(bool attached = false);
+			/** recycles the rows released this frame, the batched sprites are drawn by now */
+			void EndFrame();
 			void Clear();
 			~GLPaletteManager();
 			GLPaletteManager();
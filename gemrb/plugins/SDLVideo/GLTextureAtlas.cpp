@@ -0,0 +1,306 @@
+
+#include "OpenGLEnv.h"
+
+#include "GLTextureAtlas.h"
+
+#include <cstring>
+
+using namespace GemRB;
+
+// how much taller than a sprite a shelf may be before it gets its own
+#define SHELF_SLACK 16
+
+unsigned int GLTextureAtlas::deletions = 0;
+std::vector<GLuint> GLTextureAtlas::released;
+
+GLTextureAtlas::GLTextureAtlas()
+{
+}
+
+GLTextureAtlas::~GLTextureAtlas()
+{
+	for (size_t i = 0; i < released.size(); i++)
+	{
+		DeleteTexture(released[i]);
+	}
+	released.clear();
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		if (pages[i].texture != 0) DeleteTexture(pages[i].texture);
+	}
+}
+
+GLuint GLTextureAtlas::CreateTexture()
+{
+	GLuint texture;
+	glActiveTexture(GL_UPLOAD_UNIT);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+void GLTextureAtlas::DeleteTexture(GLuint& texture)
+{
+	if (texture == 0) return;
+	glDeleteTextures(1, &texture);
+	texture = 0;
+	deletions++;
+}
+
+void GLTextureAtlas::ReleaseTexture(GLuint& texture)
+{
+	if (texture == 0) return;
+	released.push_back(texture);
+	texture = 0;
+}
+
+int GLTextureAtlas::createPage(GLenum format)
+{
+	// reuse a dropped page slot, so the indices held by the slots stay valid
+	size_t index = 0;
+	while (index < pages.size() && pages[index].texture != 0) index++;
+	if (index == pages.size()) pages.push_back(Page());
+
+	Page& page = pages[index];
+	page.format = format;
+	page.shelves.clear();
+	page.holes.clear();
+	page.used = 0;
+	page.live = 0;
+	page.texture = CreateTexture();
+
+	// start from a blank page, nearest sampling never reads past a sprite
+	// anyway, the padding only guards against rounding at the edges
+	int bpp = (format == GL_RGBA) ? 4 : 1;
+	GLubyte* blank = new GLubyte[ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * bpp];
+	memset(blank, 0, ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * bpp);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+#ifdef USE_GL
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+	glTexImage2D(GL_TEXTURE_2D, 0, format, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0, format, GL_UNSIGNED_BYTE, (GLvoid*) blank);
+	delete[] blank;
+	return (int) index;
+}
+
+bool GLTextureAtlas::place(Page& page, int w, int h, int& shelfIndex, int& x, int& y)
+{
+	// gaps left by freed sprites first
+	for (size_t i = 0; i < page.holes.size(); i++)
+	{
+		Hole& hole = page.holes[i];
+		Shelf& shelf = page.shelves[hole.shelf];
+		if (h <= shelf.height && shelf.height - h <= SHELF_SLACK && w <= hole.width)
+		{
+			shelfIndex = hole.shelf;
+			x = hole.x;
+			y = shelf.y;
+			shelf.live++;
+			hole.x += w;
+			hole.width -= w;
+			if (hole.width == 0) page.holes.erase(page.holes.begin() + i);
+			return true;
+		}
+	}
+	for (size_t i = 0; i < page.shelves.size(); i++)
+	{
+		Shelf& shelf = page.shelves[i];
+		if (h <= shelf.height && shelf.height - h <= SHELF_SLACK && shelf.x + w <= ATLAS_PAGE_SIZE)
+		{
+			shelfIndex = (int) i;
+			x = shelf.x;
+			y = shelf.y;
+			shelf.x += w;
+			shelf.live++;
+			return true;
+		}
+	}
+	if (page.used + h > ATLAS_PAGE_SIZE) return false;
+
+	Shelf shelf;
+	shelf.y = page.used;
+	shelf.height = h;
+	shelf.x = w;
+	shelf.live = 1;
+	page.shelves.push_back(shelf);
+	page.used += h;
+	shelfIndex = (int) page.shelves.size() - 1;
+	x = 0;
+	y = shelf.y;
+	return true;
+}
+
+// gives the space of a freed sprite back to its shelf
+void GLTextureAtlas::reclaim(const AtlasSlot& slot)
+{
+	Page& page = pages[slot.page];
+	Shelf& shelf = page.shelves[slot.shelf];
+	std::vector<Hole>& holes = page.holes;
+	size_t i;
+
+	page.live--;
+	if (--shelf.live == 0)
+	{
+		// the whole shelf is free again
+		shelf.x = 0;
+		for (i = holes.size(); i--; )
+		{
+			if (holes[i].shelf == slot.shelf) holes.erase(holes.begin() + i);
+		}
+		// and empty shelves at the bottom can take sprites of any height
+		while (!page.shelves.empty() && page.shelves.back().live == 0)
+		{
+			page.used -= page.shelves.back().height;
+			page.shelves.pop_back();
+		}
+		return;
+	}
+
+	Hole hole;
+	hole.shelf = slot.shelf;
+	hole.x = slot.x;
+	hole.width = slot.width;
+	// merge with the neighbouring gaps
+	for (i = holes.size(); i--; )
+	{
+		if (holes[i].shelf != slot.shelf) continue;
+		if (holes[i].x + holes[i].width == hole.x)
+		{
+			hole.x = holes[i].x;
+			hole.width += holes[i].width;
+			holes.erase(holes.begin() + i);
+		}
+		else if (hole.x + hole.width == holes[i].x)
+		{
+			hole.width += holes[i].width;
+			holes.erase(holes.begin() + i);
+		}
+	}
+	// a gap at the end of the shelf just shortens it
+	if (hole.x + hole.width == shelf.x)
+	{
+		shelf.x = hole.x;
+		return;
+	}
+	holes.push_back(hole);
+}
+
+AtlasSlot GLTextureAtlas::Allocate(GLenum format, int w, int h, const GLvoid* pixels)
+{
+	AtlasSlot slot;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, (format == GL_RGBA) ? 4 : 1);
+#ifdef USE_GL
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+
+	if (w > ATLAS_MAX_SPRITE || h > ATLAS_MAX_SPRITE)
+	{
+		slot.texture = CreateTexture();
+		slot.textureWidth = w;
+		slot.textureHeight = h;
+		glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+		return slot;
+	}
+
+	int paddedW = w + ATLAS_PADDING;
+	int paddedH = h + ATLAS_PADDING;
+	int shelf = 0, x = 0, y = 0;
+	int index = -1;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		if (pages[i].texture == 0 || pages[i].format != format) continue;
+		if (place(pages[i], paddedW, paddedH, shelf, x, y))
+		{
+			index = (int) i;
+			break;
+		}
+	}
+	if (index < 0)
+	{
+		index = createPage(format);
+		place(pages[index], paddedW, paddedH, shelf, x, y);
+	}
+
+	Page& page = pages[index];
+	page.live++;
+	slot.texture = page.texture;
+	slot.page = index;
+	slot.shelf = shelf;
+	slot.x = x;
+	slot.y = y;
+	slot.width = paddedW;
+	slot.textureWidth = ATLAS_PAGE_SIZE;
+	slot.textureHeight = ATLAS_PAGE_SIZE;
+
+	glActiveTexture(GL_UPLOAD_UNIT);
+	glBindTexture(GL_TEXTURE_2D, page.texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, GL_UNSIGNED_BYTE, pixels);
+	return slot;
+}
+
+void GLTextureAtlas::Free(AtlasSlot& slot)
+{
+	if (slot.texture == 0) return;
+	if (slot.page < 0)
+	{
+		ReleaseTexture(slot.texture);
+	}
+	else
+	{
+		// the texels stay until EndFrame, pending batches may still use them
+		freed.push_back(slot);
+	}
+	slot = AtlasSlot();
+}
+
+void GLTextureAtlas::EndFrame()
+{
+	for (size_t i = 0; i < released.size(); i++)
+	{
+		DeleteTexture(released[i]);
+	}
+	released.clear();
+
+	for (size_t i = 0; i < freed.size(); i++)
+	{
+		reclaim(freed[i]);
+	}
+	freed.clear();
+
+	bool spare[2] = { false, false };
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		Page& page = pages[i];
+		if (page.texture == 0 || page.live > 0) continue;
+		// keep one empty page of each format around, drop the rest
+		bool& hasSpare = spare[page.format == GL_RGBA];
+		if (hasSpare)
+		{
+			DeleteTexture(page.texture);
+			page.shelves.clear();
+			page.holes.clear();
+		}
+		else
+		{
+			// stale texels end up in the padding at worst, no need to clear
+			hasSpare = true;
+			page.shelves.clear();
+			page.holes.clear();
+			page.used = 0;
+		}
+	}
+}
+
+unsigned int GLTextureAtlas::GetPageCount() const
+{
+	unsigned int count = 0;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		if (pages[i].texture != 0) count++;
+	}
+	return count;
+}
@@ -0,0 +1,88 @@
+#ifndef GLTEXTUREATLAS_H
+#define GLTEXTUREATLAS_H
+
+#include <vector>
+
+// textures are only ever uploaded on this unit, so uploads don't disturb
+// the textures the driver has bound for drawing
+#define GL_UPLOAD_UNIT GL_TEXTURE3
+
+#define ATLAS_PAGE_SIZE 1024
+// sprites bigger than this (backgrounds, screenshots) get a texture of their own
+#define ATLAS_MAX_SPRITE 256
+// empty texels around each sprite
+#define ATLAS_PADDING 1
+
+namespace GemRB
+{
+	struct AtlasSlot
+	{
+		GLuint texture;
+		int page; // -1 for sprites with a texture of their own
+		int shelf;
+		int x, y;
+		int width; // including the padding
+		int textureWidth, textureHeight;
+
+		AtlasSlot() : texture(0), page(-1), shelf(0), x(0), y(0), width(0), textureWidth(0), textureHeight(0) {}
+	};
+
+	/**
+	 * Packs sprite textures into shared pages, so consecutive blits of
+	 * different sprites can go into one draw call. Pages are filled shelf
+	 * by shelf. Freed space is reused once the frame is drawn: emptied
+	 * shelves start over and gaps in the others go to a per-page free list.
+	 */
+	class GLTextureAtlas
+	{
+	private:
+		struct Shelf
+		{
+			int y, height, x;
+			int live; // sprites on the shelf
+		};
+		// a freed span of a shelf
+		struct Hole
+		{
+			int shelf, x, width;
+		};
+		struct Page
+		{
+			GLuint texture;
+			GLenum format;
+			std::vector<Shelf> shelves;
+			std::vector<Hole> holes;
+			int used; // height taken by the shelves
+			int live; // sprites on the page
+		};
+		std::vector<Page> pages;
+		// freed slots, their texels may still be drawn until EndFrame
+		std::vector<AtlasSlot> freed;
+		static unsigned int deletions;
+		static std::vector<GLuint> released;
+
+		bool place(Page& page, int w, int h, int& shelf, int& x, int& y);
+		void reclaim(const AtlasSlot& slot);
+		int createPage(GLenum format);
+	public:
+		GLTextureAtlas();
+		~GLTextureAtlas();
+
+		/** uploads GL_ALPHA or GL_RGBA pixels and returns where they ended up */
+		AtlasSlot Allocate(GLenum format, int w, int h, const GLvoid* pixels);
+		void Free(AtlasSlot& slot);
+		/** reuses the freed space and deletes the released textures, the batched sprites must be drawn by now */
+		void EndFrame();
+		unsigned int GetPageCount() const;
+
+		/** creates a texture bound on the upload unit */
+		static GLuint CreateTexture();
+		/** deletions may free up names the driver still thinks are bound */
+		static void DeleteTexture(GLuint& texture);
+		/** like DeleteTexture, but waits for EndFrame, since pending batches may still use it */
+		static void ReleaseTexture(GLuint& texture);
+		static unsigned int GetDeletionCount() { return deletions; }
+	};
+}
+
+#endif
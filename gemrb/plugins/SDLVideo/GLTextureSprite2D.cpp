@@ -7,6 +7,8 @@
 
 using namespace GemRB;
 
+GLTextureAtlas* GLTextureSprite2D::atlas = NULL;
+
 static Uint8 GetShiftValue(Uint32 value)
 {
 	for(unsigned int i=0; i<sizeof(value)*8; i+=8)
@@ -20,7 +22,6 @@ GLTextureSprite2D::GLTextureSprite2D (int Width, int Height, int Bpp, void* pixe
 										Uint32 bmask, Uint32 amask) : Sprite2D(Width, Height, Bpp, pixels)
 {
 	currentPalette = NULL;
-	glTexture = 0;
 	glPaletteTexture = 0;
 	glMaskTexture = 0;
 	colorKeyIndex = PALETTE_INVALID_INDEX;
@@ -40,7 +41,6 @@ GLTextureSprite2D::~GLTextureSprite2D()
 GLTextureSprite2D::GLTextureSprite2D(const GLTextureSprite2D &obj) : Sprite2D(obj)
 {
 	// copies only 8 bit sprites
-	glTexture = 0;
 	glMaskTexture = 0;
 	glPaletteTexture = 0;
 	currentPalette = NULL;
@@ -84,15 +84,13 @@ void GLTextureSprite2D::SetColorKey(ieDword index)
 	colorKeyIndex = index;
 	if(IsPaletted())
 	{
-		glDeleteTextures(1, &glMaskTexture);
+		GLTextureAtlas::ReleaseTexture(glMaskTexture);
 		if (glPaletteTexture != 0) paletteManager->RemovePaletteTexture(glPaletteTexture);
 		glPaletteTexture = 0;
-		glMaskTexture = 0;
 	}
-	else
+	else if (atlas)
 	{
-		glDeleteTextures(1, &glTexture);
-		glTexture = 0;
+		atlas->Free(textureSlot);
 	}
 }
 
@@ -122,13 +120,7 @@ Color GLTextureSprite2D::GetPixel(unsigned short x, unsigned short y) const
 void GLTextureSprite2D::createGlTexture()
 {
 	if (Bpp != 32 && Bpp != 8) return;
-	if (glTexture != 0) glDeleteTextures(1, &glTexture);
-	glGenTextures(1, &glTexture);
-	glBindTexture(GL_TEXTURE_2D, glTexture);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	atlas->Free(textureSlot);
 	if(Bpp == 32) // true color textures
 	{
 		int* buffer = new int[Width * Height];
@@ -143,20 +135,12 @@ void GLTextureSprite2D::createGlTexture()
 			if (src == colorKeyIndex) a = 0x00; // transparent
 			buffer[i] = r | (g << 8) | (b << 16) | (a << 24);
 		}
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-#ifdef USE_GL
-		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, Width, Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) buffer);
+		textureSlot = atlas->Allocate(GL_RGBA, Width, Height, (GLvoid*) buffer);
 		delete[] buffer;
 	}
 	else if(Bpp == 8) // indexed
 	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-#ifdef USE_GL
-		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, Width, Height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, (GLvoid*) pixels);
+		textureSlot = atlas->Allocate(GL_ALPHA, Width, Height, (GLvoid*) pixels);
 	}
 }
 
@@ -167,13 +151,8 @@ void GLTextureSprite2D::createGlTextureForPalette()
 
 void GLTextureSprite2D::createGLMaskTexture()
 {
-	glDeleteTextures(1, &glMaskTexture);
-	glGenTextures(1, &glMaskTexture);
-	glBindTexture(GL_TEXTURE_2D, glMaskTexture);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GLTextureAtlas::ReleaseTexture(glMaskTexture);
+	glMaskTexture = GLTextureAtlas::CreateTexture();
 	Uint8* mask = new Uint8[Width*Height];
 	for(int i=0; i<Width*Height; i++)
 	{
@@ -206,26 +185,26 @@ GLuint GLTextureSprite2D::GetMaskTexture()
 
 GLuint GLTextureSprite2D::GetTexture()
 {
-	if (glTexture != 0) return glTexture;
+	return GetTextureSlot().texture;
+}
+
+const AtlasSlot& GLTextureSprite2D::GetTextureSlot()
+{
+	if (textureSlot.texture != 0 || !atlas) return textureSlot;
 	if (Width > 0 && Height > 0)
 	{
 		createGlTexture();
 	}
-	return glTexture;
+	return textureSlot;
 }
 
 void GLTextureSprite2D::MakeUnused()
 {
-	if (glTexture != 0) 
-	{
-		glDeleteTextures(1, &glTexture);
-		glTexture = 0;
-	}
-	if (glMaskTexture != 0) 
+	if (textureSlot.texture != 0 && atlas)
 	{
-		glDeleteTextures(1, &glMaskTexture);
-		glMaskTexture = 0;
+		atlas->Free(textureSlot);
 	}
+	GLTextureAtlas::ReleaseTexture(glMaskTexture);
 	if (glPaletteTexture != 0)
 	{
 		paletteManager->RemovePaletteTexture(glPaletteTexture);
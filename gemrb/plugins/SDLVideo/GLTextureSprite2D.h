@@ -2,6 +2,7 @@
 #define GLTEXTURESPRITE2D_H
 
 #include "Sprite2D.h"
+#include "GLTextureAtlas.h"
 
 namespace GemRB 
 {
@@ -10,19 +11,22 @@ namespace GemRB
 	class GLTextureSprite2D : public Sprite2D 
 	{
 	private:
-		GLuint glTexture;
+		AtlasSlot textureSlot;
 		GLuint glPaletteTexture;
 		GLuint glMaskTexture;
 		Palette* currentPalette;
 		Uint32 rMask, gMask, bMask, aMask;
 		ieDword colorKeyIndex;
 		GLPaletteManager* paletteManager;
+		static GLTextureAtlas* atlas;
 
 		void createGlTexture();
 		void createGlTextureForPalette();
 		void createGLMaskTexture();
 	public:
 		GLuint GetTexture();
+		/** the texture and where in it the sprite is */
+		const AtlasSlot& GetTextureSlot();
 		GLuint GetPaletteTexture();
 		GLuint GetMaskTexture();
 		void SetPaletteTexture(int texture);
@@ -34,6 +38,7 @@ namespace GemRB
 		void SetColorKey(ieDword);
 		bool IsPaletted() const { return Bpp == 8; }
 		void SetPaletteManager(GLPaletteManager* manager) { paletteManager = manager; }
+		static void SetAtlas(GLTextureAtlas* textureAtlas) { atlas = textureAtlas; }
 		GLTextureSprite2D (int Width, int Height, int Bpp, void* pixels, Uint32 rmask=0, Uint32 gmask=0, Uint32 bmask=0, Uint32 amask=0);
 		~GLTextureSprite2D();
 		GLTextureSprite2D(const GLTextureSprite2D &obj);
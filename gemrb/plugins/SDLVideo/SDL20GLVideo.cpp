@@ -11,13 +11,16 @@
 #endif
 
 #include <algorithm>
+#include <cstddef>
 #include "SDL20GLVideo.h"
 #include "Interface.h"
 #include "Game.h" // for GetGlobalTint
 #include "GLTextureSprite2D.h"
+#include "GLTextureAtlas.h"
 #include "GLPaletteManager.h"
 #include "GLSLProgram.h"
 #include "Matrix.h"
+#include "SpriteCover.h"
 
 using namespace GemRB;
 
@@ -29,8 +32,13 @@ GLVideoDriver::~GLVideoDriver()
 	if (programPalSepia) programPalSepia->Release();
 	if (programRect) programRect->Release();
 	if (programEllipse) programEllipse->Release();
+	clearUnusedCovers(true);
+	glDeleteBuffers(1, &batchVertexBuffer);
+	glDeleteBuffers(1, &batchIndexBuffer);
 	delete paletteManager;
 	FreeBackgroundBuffer();
+	GLTextureSprite2D::SetAtlas(NULL);
+	delete textureAtlas;
 	SDL_GL_DeleteContext(context);
 }
 
@@ -127,11 +135,36 @@ int GLVideoDriver::CreateDisplay(int w, int h, int bpp, bool fs, const char* tit
 #endif
 	if (!createPrograms()) return GEM_ERROR;
 	paletteManager = new GLPaletteManager();
+	textureAtlas = new GLTextureAtlas();
+	GLTextureSprite2D::SetAtlas(textureAtlas);
 	glViewport(GLViewport.x, GLViewport.y, GLViewport.w, GLViewport.h);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_SCISSOR_TEST);
+
+	// every quad is two triangles over its four vertices
+	GLushort* indices = new GLushort[BATCH_QUADS*6];
+	for (GLushort i = 0; i < BATCH_QUADS; i++)
+	{
+		indices[i*6] = i*4;
+		indices[i*6 + 1] = i*4 + 1;
+		indices[i*6 + 2] = i*4 + 2;
+		indices[i*6 + 3] = i*4 + 2;
+		indices[i*6 + 4] = i*4 + 1;
+		indices[i*6 + 5] = i*4 + 3;
+	}
+	glGenBuffers(1, &batchIndexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batchIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*BATCH_QUADS*6, indices, GL_STATIC_DRAW);
+	delete[] indices;
+	glGenBuffers(1, &batchVertexBuffer);
+	batchVertices.reserve(BATCH_QUADS*4);
+	resetBoundTextures();
+
 	spritesPerFrame = 0;
+	drawCallsPerFrame = 0;
+	textureBindsPerFrame = 0;
+	frameCount = 0;
 	return GEM_OK;
 }
 
@@ -180,9 +213,9 @@ bool GLVideoDriver::createPrograms()
 		return false;
 	}
 	programPalGrayed->Use();
-	programPal->SetUniformValue("s_texture", 1, 0);
-	programPal->SetUniformValue("s_palette", 1, 1);
-	programPal->SetUniformValue("s_mask", 1, 2);
+	programPalGrayed->SetUniformValue("s_texture", 1, 0);
+	programPalGrayed->SetUniformValue("s_palette", 1, 1);
+	programPalGrayed->SetUniformValue("s_mask", 1, 2);
 	programPalGrayed->SetUniformMatrixValue("u_matrix", 4, 1, matrix);
 
 	programPalSepia = GLSLProgram::CreateFromFiles("Shaders/Sprite.glslv", "Shaders/SpritePalSepia.glslf");
@@ -193,9 +226,9 @@ bool GLVideoDriver::createPrograms()
 		return false;
 	}
 	programPalSepia->Use();
-	programPal->SetUniformValue("s_texture", 1, 0);
-	programPal->SetUniformValue("s_palette", 1, 1);
-	programPal->SetUniformValue("s_mask", 1, 2);;
+	programPalSepia->SetUniformValue("s_texture", 1, 0);
+	programPalSepia->SetUniformValue("s_palette", 1, 1);
+	programPalSepia->SetUniformValue("s_mask", 1, 2);
 	programPalSepia->SetUniformMatrixValue("u_matrix", 4, 1, matrix);
 	
 	programEllipse = GLSLProgram::CreateFromFiles("Shaders/Ellipse.glslv", "Shaders/Ellipse.glslf");
@@ -244,21 +277,26 @@ Sprite2D* GLVideoDriver::CreatePalettedSprite(int w, int h, int bpp, void* pixel
 
 Sprite2D* GLVideoDriver::CreateSprite8(int w, int h, void* pixels, Palette* palette, bool cK, int index)
 {
+	// interned palettes never change, so the sprites (and palette textures) can share them
+	if (palette && palette->IsInterned()) {
+		GLTextureSprite2D* spr = new GLTextureSprite2D(w, h, 8, pixels);
+		spr->SetPaletteManager(paletteManager);
+		spr->SetPalette(palette);
+		if (cK) spr->SetColorKey(index);
+		return spr;
+	}
 	return CreatePalettedSprite(w, h, 8, pixels, palette->col, cK, index);
 }
 
 void GLVideoDriver::GLBlitSprite(GLTextureSprite2D* spr, const Region& src, const Region& dst, Palette* attachedPal,
-								 unsigned int flags, const Color* tint, GLTextureSprite2D* mask)
+								 unsigned int flags, const Color* tint, GLuint maskTexture, const GLfloat* maskCoords)
 {
-	// TODO: clip dst to the screen?
 	if (dst.w <= 0 || dst.h <= 0 || src.w <= 0 || src.h <= 0)
 		return; // we already know blit fails
 
-	glViewport(dst.x, height - (dst.y + dst.h), dst.w, dst.h);
 	Region scissorRect = ClippedDrawingRect(dst);
-	glScissor(scissorRect.x, height - (scissorRect.y + scissorRect.h), scissorRect.w, scissorRect.h);
-	float hscale = 2.0f/(float)dst.w;
-	float vscale = 2.0f/(float)dst.h;
+	if (scissorRect.w <= 0 || scissorRect.h <= 0)
+		return; // nothing would be drawn
 
 	// color tint
 	Color colorTint;
@@ -271,124 +309,164 @@ void GLVideoDriver::GLBlitSprite(GLTextureSprite2D* spr, const Region& src, cons
 	// I think this way makes more sense, but I need to examine the behavior of the the functions passing flag parameters
 	flags |= spr->renderFlags;
 
-	GLfloat x = (GLfloat)src.x/(GLfloat)spr->Width;
-	GLfloat y = (GLfloat)src.y/(GLfloat)spr->Height;
-	GLfloat w = (GLfloat)src.w/(GLfloat)spr->Width;
-	GLfloat h = (GLfloat)src.h/(GLfloat)spr->Height;
-	GLfloat textureCoords[] = { /* lower left */ x, y, /* lower right */x + w, y,
-								/* top left */ x, y + h, /* top right */ x + w, y + h };
-
-	// FIXME: are there constants for accessing these coordinate indices?
-	GLfloat tmp;
-	if (flags&BLIT_MIRRORX) {
-		// swap lower left X with lower right X
-		tmp = textureCoords[0];
-		textureCoords[0] = textureCoords[2];
-		textureCoords[2] = tmp;
-		// swap top left X with top right X
-		tmp = textureCoords[4];
-		textureCoords[4] = textureCoords[6];
-		textureCoords[6] = tmp;
-	}
-	if (flags&BLIT_MIRRORY) {
-		// swap lower left Y with top left Y
-		tmp = textureCoords[1];
-		textureCoords[1] = textureCoords[5];
-		textureCoords[5] = tmp;
-		// swap lower right Y with top right Y
-		tmp = textureCoords[3];
-		textureCoords[3] = textureCoords[7];
-		textureCoords[7] = tmp;
-	}
-
-	// alpha modifier
-	GLfloat alphaModifier = flags & BLIT_HALFTRANS ? 0.5f : 1.0f;
-
-	// data
-	GLfloat data[] = 
-	{	    
-		-1.0f, 1.0f, textureCoords[0], textureCoords[1],
-		-1.0f + dst.w*hscale, 1.0f, textureCoords[2], textureCoords[3],
-		-1.0f, 1.0f - dst.h*vscale, textureCoords[4], textureCoords[5],
-		-1.0f + dst.w*hscale, 1.0f - dst.h*vscale, textureCoords[6], textureCoords[7]
-	};
-
 	// shader program selection
-	GLSLProgram* program;
-	GLuint palTexture;
+	SpriteBatchState state;
+	GLfloat paletteRow = 0.0f;
+	state.paletteTexture = 0;
 	if(spr->IsPaletted())
 	{
 		if (flags & BLIT_GREY)
-			program = programPalGrayed;
+			state.program = programPalGrayed;
 		else if (flags & BLIT_SEPIA)
-			program = programPalSepia;
+			state.program = programPalSepia;
 		else
-			program = programPal;
+			state.program = programPal;
 
-		glActiveTexture(GL_TEXTURE1);
+		GLuint row;
 		if (attachedPal) 
-			palTexture = paletteManager->CreatePaletteTexture(attachedPal, spr->GetColorKey(), true);
+			row = paletteManager->CreatePaletteTexture(attachedPal, spr->GetColorKey(), true);
 		else 
-			palTexture = spr->GetPaletteTexture();		
-		glBindTexture(GL_TEXTURE_2D, palTexture);
+			row = spr->GetPaletteTexture();
+		state.paletteTexture = paletteManager->GetPageTexture(row);
+		paletteRow = paletteManager->GetRowCoord(row);
 	}
 	else
 	{
-		program = program32;
+		state.program = program32;
 	}
-	useProgram(program);
 
-	glActiveTexture(GL_TEXTURE0);
-	GLuint texture = spr->GetTexture();
-	glBindTexture(GL_TEXTURE_2D, texture);
-	
-	if (mask)
-	{
-		glActiveTexture(GL_TEXTURE2);
-		GLuint maskTexture = ((GLTextureSprite2D*)mask)->GetMaskTexture();
-		glBindTexture(GL_TEXTURE_2D, maskTexture);
+	const AtlasSlot& slot = spr->GetTextureSlot();
+	state.texture = slot.texture;
+	state.maskTexture = maskTexture;
+	state.shadowMode = 1;
+	if (flags & BLIT_NOSHADOW) {
+		state.shadowMode = 0;
+	} else if (flags & BLIT_TRANSSHADOW) {
+		state.shadowMode = 2;
 	}
-	else
-	if(flags & BLIT_EXTERNAL_MASK) {} // used with external mask
-	else
+	state.scissor = scissorRect;
+
+	if (batchVertices.size() >= BATCH_QUADS*4 || (!batchVertices.empty() && state != batchState))
 	{
-		// disable 3rd texture
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		flushSprites();
+	}
+	batchState = state;
+
+	// texture coordinates of the corners, mirroring swaps them
+	GLfloat left = (GLfloat)(slot.x + src.x)/(GLfloat)slot.textureWidth;
+	GLfloat top = (GLfloat)(slot.y + src.y)/(GLfloat)slot.textureHeight;
+	GLfloat right = (GLfloat)(slot.x + src.x + src.w)/(GLfloat)slot.textureWidth;
+	GLfloat bottom = (GLfloat)(slot.y + src.y + src.h)/(GLfloat)slot.textureHeight;
+	if (flags&BLIT_MIRRORX) std::swap(left, right);
+	if (flags&BLIT_MIRRORY) std::swap(top, bottom);
+
+	SpriteVertex vertex;
+	vertex.paletteRow = paletteRow;
+	vertex.alphaModifier = flags & BLIT_HALFTRANS ? 0.5f : 1.0f;
+	vertex.r = (GLfloat)colorTint.r/255;
+	vertex.g = (GLfloat)colorTint.g/255;
+	vertex.b = (GLfloat)colorTint.b/255;
+	vertex.a = (GLfloat)colorTint.a/255;
+
+	// the masks aren't mirrored, they cover the screen area
+	static const GLfloat noMask[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	if (!maskCoords) maskCoords = noMask;
+
+	GLfloat x1 = -1.0f + (GLfloat)dst.x*2/width;
+	GLfloat x2 = -1.0f + (GLfloat)(dst.x + dst.w)*2/width;
+	GLfloat y1 = 1.0f - (GLfloat)dst.y*2/height;
+	GLfloat y2 = 1.0f - (GLfloat)(dst.y + dst.h)*2/height;
+
+	// top left, top right, bottom left, bottom right
+	vertex.x = x1; vertex.y = y1; vertex.u = left; vertex.v = top;
+	vertex.maskU = maskCoords[0]; vertex.maskV = maskCoords[1];
+	batchVertices.push_back(vertex);
+	vertex.x = x2; vertex.u = right; vertex.maskU = maskCoords[2];
+	batchVertices.push_back(vertex);
+	vertex.x = x1; vertex.y = y2; vertex.u = left; vertex.v = bottom;
+	vertex.maskU = maskCoords[0]; vertex.maskV = maskCoords[3];
+	batchVertices.push_back(vertex);
+	vertex.x = x2; vertex.u = right; vertex.maskU = maskCoords[2];
+	batchVertices.push_back(vertex);
+	spritesPerFrame++;
+}
+
+void GLVideoDriver::resetBoundTextures()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		boundTextures[i] = (GLuint) -1;
 	}
+	boundDeletions = GLTextureAtlas::GetDeletionCount();
+}
 
-	program->SetUniformValue("u_tint", COLOR_SIZE, (GLfloat)colorTint.r/255, (GLfloat)colorTint.g/255, (GLfloat)colorTint.b/255, (GLfloat)colorTint.a/255);
-	program->SetUniformValue("u_alphaModifier", 1, alphaModifier);
+void GLVideoDriver::bindTexture(unsigned int unit, GLuint texture)
+{
+	// a deleted name may have been handed out again
+	if (boundDeletions != GLTextureAtlas::GetDeletionCount()) resetBoundTextures();
+	if (boundTextures[unit] == texture) return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	boundTextures[unit] = texture;
+	textureBindsPerFrame++;
+}
 
-	GLint shadowMode = 1;
-	if (flags & BLIT_NOSHADOW) {
-		shadowMode = 0;
-	} else if (flags & BLIT_TRANSSHADOW) {
-		shadowMode = 2;
-	}
-	program->SetUniformValue("u_shadowMode", 1, shadowMode);
+void GLVideoDriver::flushSprites()
+{
+	if (batchVertices.empty()) return;
 
-	GLint a_position = program->GetAttribLocation("a_position");
-	GLint a_texCoord = program->GetAttribLocation("a_texCoord");
+	GLSLProgram* program = batchState.program;
+	useProgram(program);
+	glViewport(GLViewport.x, GLViewport.y, GLViewport.w, GLViewport.h);
+	const Region& scissorRect = batchState.scissor;
+	glScissor(scissorRect.x, height - (scissorRect.y + scissorRect.h), scissorRect.w, scissorRect.h);
 
-	GLuint buffer;
-	glGenBuffers(1, &buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+	bindTexture(0, batchState.texture);
+	if (program != program32)
+	{
+		bindTexture(1, batchState.paletteTexture);
+		// without a mask, the unbound unit samples as opaque
+		bindTexture(2, batchState.maskTexture);
+		program->SetUniformValue("u_shadowMode", 1, batchState.shadowMode);
+	}
 
-	glVertexAttribPointer(a_position, VERTEX_SIZE, GL_FLOAT, GL_FALSE, sizeof(GLfloat)*(VERTEX_SIZE + TEX_SIZE), 0);
-	glVertexAttribPointer(a_texCoord, TEX_SIZE, GL_FLOAT, GL_FALSE, sizeof(GLfloat)*(VERTEX_SIZE + TEX_SIZE), BUFFER_OFFSET(sizeof(GLfloat)*VERTEX_SIZE));
+	glBindBuffer(GL_ARRAY_BUFFER, batchVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteVertex)*batchVertices.size(), &batchVertices[0], GL_STREAM_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batchIndexBuffer);
 
-	glEnableVertexAttribArray(a_position);
-	glEnableVertexAttribArray(a_texCoord);
+	struct Attribute
+	{
+		const char* name;
+		GLint size;
+		size_t offset;
+	};
+	static const Attribute attributes[] = {
+		{ "a_position", VERTEX_SIZE, offsetof(SpriteVertex, x) },
+		{ "a_texCoord", TEX_SIZE, offsetof(SpriteVertex, u) },
+		{ "a_maskCoord", TEX_SIZE, offsetof(SpriteVertex, maskU) },
+		{ "a_paletteRow", 1, offsetof(SpriteVertex, paletteRow) },
+		{ "a_alphaModifier", 1, offsetof(SpriteVertex, alphaModifier) },
+		{ "a_tint", COLOR_SIZE, offsetof(SpriteVertex, r) }
+	};
+	const int attributeCount = sizeof(attributes)/sizeof(attributes[0]);
+	GLint locations[attributeCount];
+	for (int i = 0; i < attributeCount; i++)
+	{
+		// the compiler drops the attributes a program doesn't use
+		locations[i] = program->GetAttribLocation(attributes[i].name);
+		if (locations[i] < 0) continue;
+		glVertexAttribPointer(locations[i], attributes[i].size, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), BUFFER_OFFSET(attributes[i].offset));
+		glEnableVertexAttribArray(locations[i]);
+	}
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glDrawElements(GL_TRIANGLES, (GLsizei) (batchVertices.size()/4*6), GL_UNSIGNED_SHORT, 0);
+	drawCallsPerFrame++;
 
-	glDisableVertexAttribArray(a_texCoord);
-	glDisableVertexAttribArray(a_position);
-	
-	glDeleteBuffers(1, &buffer);
-	spritesPerFrame++;
+	for (int i = 0; i < attributeCount; i++)
+	{
+		if (locations[i] >= 0) glDisableVertexAttribArray(locations[i]);
+	}
+	batchVertices.clear();
 }
 
 void GLVideoDriver::BlitSprite(const Sprite2D* spr, const Region& src, const Region& dst, Palette* palette)
@@ -399,6 +477,7 @@ void GLVideoDriver::BlitSprite(const Sprite2D* spr, const Region& src, const Reg
 void GLVideoDriver::clearRect(const Region& rgn, const Color& color)
 {
 	if (SDL_ALPHA_TRANSPARENT == color.a) return;
+	flushSprites();
 	Region scissorRect = ClippedDrawingRect(rgn);
 	glScissor(scissorRect.x, height - scissorRect.y - scissorRect.h, scissorRect.w, scissorRect.h);
 	glClearColor(color.r/255, color.g/255, color.b/255, color.a/255);
@@ -408,6 +487,8 @@ void GLVideoDriver::clearRect(const Region& rgn, const Color& color)
 void GLVideoDriver::drawPolygon(Point* points, unsigned int count, const Color& color, PointDrawingMode mode)
 {
 	if (SDL_ALPHA_TRANSPARENT == color.a) return;
+	flushSprites();
+	drawCallsPerFrame++;
 	useProgram(programRect);
 	glViewport(GLViewport.x, GLViewport.y, GLViewport.w, GLViewport.h);
 	Region scissorRect = ClippedDrawingRect(Region(0, 0, width, height));
@@ -466,8 +547,18 @@ void GLVideoDriver::SetPixel(short x, short y, const Color& color, bool clipped)
 	clearRect(region, color);
 }
 
+// the back buffer isn't drawn, so the points go through SetPixel one by one
+void GLVideoDriver::PlotPoints(const Color& color, bool clipped)
+{
+	for (size_t i = 0; i < plotPoints.size(); i++) {
+		SetPixel(plotPoints[i].x, plotPoints[i].y, color, clipped);
+	}
+}
+
 void GLVideoDriver::drawEllipse(int cx /*center*/, int cy /*center*/, unsigned short xr, unsigned short yr, float thickness, const Color& color)
 {
+	flushSprites();
+	drawCallsPerFrame++;
 	glDisable(GL_SCISSOR_TEST);
 	const float support = 0.75;
 	useProgram(programEllipse);
@@ -565,8 +656,18 @@ void GLVideoDriver::BlitTile(const Sprite2D* spr, const Sprite2D* mask, int x, i
 		}
 	}
 
+	GLuint maskTexture = 0;
+	GLfloat maskCoords[4];
+	if (mask) {
+		maskTexture = ((GLTextureSprite2D*)mask)->GetMaskTexture();
+		maskCoords[0] = (GLfloat)src.x/mask->Width;
+		maskCoords[1] = (GLfloat)src.y/mask->Height;
+		maskCoords[2] = (GLfloat)(src.x + src.w)/mask->Width;
+		maskCoords[3] = (GLfloat)(src.y + src.h)/mask->Height;
+	}
+
 	GLBlitSprite((GLTextureSprite2D*)spr, src, dst,
-						NULL, blitFlags, (totint ? &tileTint : NULL), (GLTextureSprite2D*)mask);
+						NULL, blitFlags, (totint ? &tileTint : NULL), maskTexture, mask ? maskCoords : NULL);
 }
 
 void GLVideoDriver::BlitGameSprite(const Sprite2D* spr, int x, int y, unsigned int flags, Color tint,
@@ -581,41 +682,9 @@ void GLVideoDriver::BlitGameSprite(const Sprite2D* spr, int x, int y, unsigned i
 	}
 	GLTextureSprite2D* glSprite = (GLTextureSprite2D*)spr;
 	GLuint coverTexture = 0;
-
-	if(glSprite->IsPaletted())
+	if (glSprite->IsPaletted() && cover)
 	{
-		if (cover)
-		{
-			int trueX = cover->XPos - glSprite->XPos;
-			int trueY = cover->YPos - glSprite->YPos;
-			Uint8* data = new Uint8[glSprite->Width*glSprite->Height];
-			Uint8* coverPointer = &cover->pixels[trueY*glSprite->Width + trueX];
-			Uint8* dataPointer = data;
-			for(int h=0; h<glSprite->Height; h++)
-			{
-				for(int w=0; w<glSprite->Width; w++)
-				{
-					*dataPointer = !(*coverPointer) * 255;
-					dataPointer++;
-					coverPointer++;
-				}
-				coverPointer += cover->Width - glSprite->Width;
-			}
-			glActiveTexture(GL_TEXTURE2);
-			glGenTextures(1, &coverTexture);
-			glBindTexture(GL_TEXTURE_2D, coverTexture);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-#ifdef USE_GL
-			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, glSprite->Width, glSprite->Height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, (GLvoid*) data);
-			delete[] data;
-			flags |= BLIT_EXTERNAL_MASK;
-		}
+		coverTexture = getCoverTexture(cover);
 	}
 
 	int w = glSprite->Width, h = glSprite->Height, dx = 0, dy = 0;
@@ -630,15 +699,69 @@ void GLVideoDriver::BlitGameSprite(const Sprite2D* spr, int x, int y, unsigned i
 	Region src(dx, dy, w, h);
 	Region dst(tx + dx, ty + dy, w, h);
 
-	if (!(flags & BLIT_TINTED) || (tint.r == 0 && tint.g == 0 && tint.b == 0))
-		GLBlitSprite(glSprite, src, dst, palette, flags);
-	else
-		GLBlitSprite(glSprite, src, dst, palette, flags, &tint);
-	if (coverTexture != 0)
+	// the cover spans the whole sprite and then some
+	GLfloat maskCoords[4];
+	if (coverTexture)
 	{
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glDeleteTextures(1, &coverTexture);
+		int trueX = cover->XPos - glSprite->XPos;
+		int trueY = cover->YPos - glSprite->YPos;
+		maskCoords[0] = (GLfloat)(src.x + trueX)/cover->Width;
+		maskCoords[1] = (GLfloat)(src.y + trueY)/cover->Height;
+		maskCoords[2] = (GLfloat)(src.x + trueX + src.w)/cover->Width;
+		maskCoords[3] = (GLfloat)(src.y + trueY + src.h)/cover->Height;
+	}
+
+	const Color* totint = NULL;
+	if ((flags & BLIT_TINTED) && (tint.r != 0 || tint.g != 0 || tint.b != 0))
+		totint = &tint;
+	GLBlitSprite(glSprite, src, dst, palette, flags, totint, coverTexture, coverTexture ? maskCoords : NULL);
+}
+
+GLuint GLVideoDriver::getCoverTexture(const SpriteCover* cover)
+{
+	// covers are rebuilt for every actor and frame only when something moved,
+	// the rest of the time the same one comes back frame after frame
+	std::map<unsigned int, CoverTexture>::iterator it = coverTextures.find(cover->serial);
+	if (it != coverTextures.end())
+	{
+		it->second.lastFrame = frameCount;
+		return it->second.texture;
+	}
+
+	int size = cover->Width*cover->Height;
+	Uint8* data = new Uint8[size];
+	for(int i=0; i<size; i++)
+	{
+		data[i] = !cover->pixels[i] * 255;
+	}
+	CoverTexture coverTexture;
+	coverTexture.texture = GLTextureAtlas::CreateTexture();
+	coverTexture.lastFrame = frameCount;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+#ifdef USE_GL
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, cover->Width, cover->Height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, (GLvoid*) data);
+	delete[] data;
+	coverTextures[cover->serial] = coverTexture;
+	return coverTexture.texture;
+}
+
+void GLVideoDriver::clearUnusedCovers(bool all)
+{
+	// a cover unused for a frame was most likely replaced, its serial won't come back
+	std::map<unsigned int, CoverTexture>::iterator it = coverTextures.begin();
+	while (it != coverTextures.end())
+	{
+		if (all || it->second.lastFrame != frameCount)
+		{
+			GLTextureAtlas::DeleteTexture(it->second.texture);
+			coverTextures.erase(it++);
+		}
+		else
+		{
+			++it;
+		}
 	}
 }
 
@@ -777,16 +900,34 @@ void GLVideoDriver::DrawCircle(short cx, short cy, unsigned short r, const Color
 int GLVideoDriver::SwapBuffers()
 {	
 	int val = SDLVideoDriver::SwapBuffers();
+	// the cursor and tooltips are batched too
+	flushSprites();
 	SDL_GL_SwapWindow(window);
 	paletteManager->ClearUnused(true);
+	// everything batched is drawn now, so emptied pages and rows can be reused
+	textureAtlas->EndFrame();
+	paletteManager->EndFrame();
+	clearUnusedCovers(false);
+	frameCount++;
+	// the SDL side may have touched the texture units
+	resetBoundTextures();
 	core->RedrawAll();
+	if (frameCount % 300 == 0)
+	{
+		Log(DEBUG, "SDL 2 GL Driver", "%u sprites in %u draw calls, %u texture binds; %u atlas pages, %u palette pages",
+			spritesPerFrame, drawCallsPerFrame, textureBindsPerFrame, textureAtlas->GetPageCount(), paletteManager->GetPageCount());
+	}
 	spritesPerFrame = 0;
+	drawCallsPerFrame = 0;
+	textureBindsPerFrame = 0;
 	return val;
 }
 
 void GLVideoDriver::DestroyMovieScreen()
 {
+	flushSprites();
 	SDL20VideoDriver::DestroyMovieScreen();
+	resetBoundTextures();
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_SCISSOR_TEST);
@@ -796,6 +937,7 @@ Sprite2D* GLVideoDriver::GetScreenshot(Region r)
 {
 	unsigned int w = r.w ? r.w : width - r.x;
 	unsigned int h = r.h ? r.h : height - r.y;
+	flushSprites();
 	
 	Uint32* glPixels = (Uint32*)malloc( w * h * 4 );
 	Uint32* pixels = (Uint32*)malloc( w * h * 4 );
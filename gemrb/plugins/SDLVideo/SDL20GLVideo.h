@@ -4,18 +4,60 @@
 
 #include "SDL20Video.h"
 
+#include <map>
+#include <vector>
+
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 #define VERTEX_SIZE 2
 #define TEX_SIZE 2
 #define COLOR_SIZE 4
 
-#define BLIT_EXTERNAL_MASK 0x100
+// quads per sprite batch, the indices must fit into shorts
+#define BATCH_QUADS 2048
 
 namespace GemRB 
 {
 	class GLTextureSprite2D;
 	class GLPaletteManager;
 	class GLSLProgram;
+	class GLTextureAtlas;
+
+	struct SpriteVertex
+	{
+		GLfloat x, y;
+		GLfloat u, v;
+		GLfloat maskU, maskV;
+		GLfloat paletteRow;
+		GLfloat alphaModifier;
+		GLfloat r, g, b, a;
+	};
+
+	// consecutive blits with the same state go into one draw call
+	struct SpriteBatchState
+	{
+		GLSLProgram* program;
+		GLuint texture;
+		GLuint paletteTexture;
+		GLuint maskTexture;
+		GLint shadowMode;
+		Region scissor;
+
+		bool operator!=(const SpriteBatchState& other) const
+		{
+			return program != other.program || texture != other.texture
+				|| paletteTexture != other.paletteTexture || maskTexture != other.maskTexture
+				|| shadowMode != other.shadowMode
+				|| scissor.x != other.scissor.x || scissor.y != other.scissor.y
+				|| scissor.w != other.scissor.w || scissor.h != other.scissor.h;
+		}
+	};
+
+	// sprite covers only change when the actor moves, so their masks are kept
+	struct CoverTexture
+	{
+		GLuint texture;
+		unsigned int lastFrame;
+	};
 
 	enum PointDrawingMode
 	{
@@ -41,13 +83,30 @@ namespace GemRB
 		GLSLProgram* lastUsedProgram; // stores last used program to prevent switching if possible (switching may cause performance lack)
 
 		GLPaletteManager* paletteManager; // palette manager instance
+		GLTextureAtlas* textureAtlas; // shared pages for the sprite textures
+
+		std::vector<SpriteVertex> batchVertices;
+		SpriteBatchState batchState;
+		GLuint batchVertexBuffer;
+		GLuint batchIndexBuffer;
+		GLuint boundTextures[3]; // per texture unit, to skip redundant binds
+		unsigned int boundDeletions;
+		std::map<unsigned int, CoverTexture> coverTextures; // by cover serial
+		unsigned int frameCount;
+		Uint32 drawCallsPerFrame;
+		Uint32 textureBindsPerFrame;
 
 		GLTextureSprite2D *backgroundBuffer;
 		Region GLViewport;
 
 		void useProgram(GLSLProgram* program); // use this instead program->Use()
 		bool createPrograms();
-		void GLBlitSprite(GLTextureSprite2D* spr, const Region& src, const Region& dst, Palette* attachedPal = NULL, unsigned int flags = 0, const Color* tint = NULL, GLTextureSprite2D* mask = NULL);
+		void GLBlitSprite(GLTextureSprite2D* spr, const Region& src, const Region& dst, Palette* attachedPal = NULL, unsigned int flags = 0, const Color* tint = NULL, GLuint maskTexture = 0, const GLfloat* maskCoords = NULL);
+		void flushSprites();
+		void bindTexture(unsigned int unit, GLuint texture);
+		void resetBoundTextures();
+		GLuint getCoverTexture(const SpriteCover* cover);
+		void clearUnusedCovers(bool all);
 		void clearRect(const Region& rgn, const Color& color);
 		void drawEllipse(int cx, int cy, unsigned short xr, unsigned short yr, float thickness, const Color& color);
 		void drawPolygon(Point* points, unsigned int count, const Color& color, PointDrawingMode mode);
@@ -71,6 +130,7 @@ namespace GemRB
 		void DrawEllipse(short cx, short cy, unsigned short xr, unsigned short yr, const Color& color, bool clipped = true);
 		void DrawCircle(short cx, short cy, unsigned short r, const Color& color, bool clipped = true);
 		void SetPixel(short x, short y, const Color& color, bool clipped = true);
+		void PlotPoints(const Color& color, bool clipped);
 		/*void DrawEllipseSegment(short cx, short cy, unsigned short xr, unsigned short yr, const Color& color, double anglefrom, double angleto, bool drawlines = true, bool clipped = true);*/
 		void DestroyMovieScreen();
 		Sprite2D* GetScreenshot(Region r);
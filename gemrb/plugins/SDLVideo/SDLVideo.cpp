@@ -107,9 +107,9 @@ int SDLVideoDriver::SwapBuffers(void)
 {
 	unsigned long time;
 	time = GetTickCount();
-	if (( time - lastTime ) < 33) {
+	if (( time - lastTime ) < frameLimit) {
 #ifndef NOFPSLIMIT
-		SDL_Delay( 33 - (time - lastTime) );
+		SDL_Delay( frameLimit - (time - lastTime) );
 #endif
 		time = GetTickCount();
 	}
@@ -1036,10 +1036,23 @@ void SDLVideoDriver::DrawLine(short x1, short y1, short x2, short y2,
 		j -= decInc;
 	}
 }
-/** This functions Draws a Circle */
-void SDLVideoDriver::DrawCircle(short cx, short cy, unsigned short r,
-	const Color& color, bool clipped)
+// selection circles and markers come in a handful of sizes, so this only
+// guards against something drawing every size there is
+#define MAX_CACHED_OUTLINES 256
+// the largest radius SelfCheck compares with the old rasteriser
+#define OUTLINE_CHECK_RADIUS 64
+
+const SDLVideoDriver::Outline& SDLVideoDriver::GetCircleOutline(unsigned short r)
 {
+	std::map<unsigned short, Outline>::iterator it = circleOutlines.find(r);
+	if (it != circleOutlines.end()) {
+		return it->second;
+	}
+	if (circleOutlines.size() >= MAX_CACHED_OUTLINES) {
+		circleOutlines.clear();
+	}
+	Outline &outline = circleOutlines[r];
+
 	//Uses the Breshenham's Circle Algorithm
 	long x, y, xc, yc, re;
 
@@ -1049,18 +1062,8 @@ void SDLVideoDriver::DrawCircle(short cx, short cy, unsigned short r,
 	yc = 1;
 	re = 0;
 
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_LockSurface( disp );
-	}
 	while (x >= y) {
-		SetPixel( cx + ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy - ( short ) y, color, clipped );
-		SetPixel( cx + ( short ) x, cy - ( short ) y, color, clipped );
-		SetPixel( cx + ( short ) y, cy + ( short ) x, color, clipped );
-		SetPixel( cx - ( short ) y, cy + ( short ) x, color, clipped );
-		SetPixel( cx - ( short ) y, cy - ( short ) x, color, clipped );
-		SetPixel( cx + ( short ) y, cy - ( short ) x, color, clipped );
+		outline.push_back(Point((short) x, (short) y));
 
 		y++;
 		re += yc;
@@ -1072,58 +1075,24 @@ void SDLVideoDriver::DrawCircle(short cx, short cy, unsigned short r,
 			xc += 2;
 		}
 	}
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_UnlockSurface( disp );
-	}
+	return outline;
 }
 
-static double ellipseradius(unsigned short xr, unsigned short yr, double angle) {
-	double one = (xr * sin(angle));
-	double two = (yr * cos(angle));
-	return sqrt(xr*xr*yr*yr / (one*one + two*two));
-}
-
-/** This functions Draws an Ellipse Segment */
-void SDLVideoDriver::DrawEllipseSegment(short cx, short cy, unsigned short xr,
-	unsigned short yr, const Color& color, double anglefrom, double angleto, bool drawlines, bool clipped)
+const SDLVideoDriver::Outline& SDLVideoDriver::GetEllipseOutline(unsigned short xr, unsigned short yr)
 {
-	/* beware, dragons and clockwise angles be here! */
-	double radiusfrom = ellipseradius(xr, yr, anglefrom);
-	double radiusto = ellipseradius(xr, yr, angleto);
-	long xfrom = (long)round(radiusfrom * cos(anglefrom));
-	long yfrom = (long)round(radiusfrom * sin(anglefrom));
-	long xto = (long)round(radiusto * cos(angleto));
-	long yto = (long)round(radiusto * sin(angleto));
-
-	if (drawlines) {
-		// TODO: DrawLine's clipping code works differently to the clipping
-		// here so we add Viewport.x/Viewport.y as a hack for now
-		DrawLine(cx + Viewport.x, cy + Viewport.y,
-			cx + xfrom + Viewport.x, cy + yfrom + Viewport.y, color, clipped);
-		DrawLine(cx + Viewport.x, cy + Viewport.y,
-			cx + xto + Viewport.x, cy + yto + Viewport.y, color, clipped);
+	ieDword key = ((ieDword) xr << 16) | yr;
+	std::map<ieDword, Outline>::iterator it = ellipseOutlines.find(key);
+	if (it != ellipseOutlines.end()) {
+		return it->second;
 	}
-
-	// *Attempt* to calculate the correct x/y boundaries.
-	// TODO: this doesn't work very well - you can't actually bound many
-	// arcs this way (imagine a segment with a small piece cut out).
-	if (xfrom > xto) {
-		long tmp = xfrom; xfrom = xto; xto = tmp;
-	}
-	if (yfrom > yto) {
-		long tmp = yfrom; yfrom = yto; yto = tmp;
+	if (ellipseOutlines.size() >= MAX_CACHED_OUTLINES) {
+		ellipseOutlines.clear();
 	}
-	if (xfrom >= 0 && yto >= 0) xto = xr;
-	if (xto <= 0 && yto >= 0) xfrom = -xr;
-	if (yfrom >= 0 && xto >= 0) yto = yr;
-	if (yto <= 0 && xto >= 0) yfrom = -yr;
+	Outline &outline = ellipseOutlines[key];
 
 	//Uses Bresenham's Ellipse Algorithm
 	long x, y, xc, yc, ee, tas, tbs, sx, sy;
 
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_LockSurface( disp );
-	}
 	tas = 2 * xr * xr;
 	tbs = 2 * yr * yr;
 	x = xr;
@@ -1135,14 +1104,7 @@ void SDLVideoDriver::DrawEllipseSegment(short cx, short cy, unsigned short xr,
 	sy = 0;
 
 	while (sx >= sy) {
-		if (x >= xfrom && x <= xto && y >= yfrom && y <= yto)
-			SetPixel( cx + ( short ) x, cy + ( short ) y, color, clipped );
-		if (-x >= xfrom && -x <= xto && y >= yfrom && y <= yto)
-			SetPixel( cx - ( short ) x, cy + ( short ) y, color, clipped );
-		if (-x >= xfrom && -x <= xto && -y >= yfrom && -y <= yto)
-			SetPixel( cx - ( short ) x, cy - ( short ) y, color, clipped );
-		if (x >= xfrom && x <= xto && -y >= yfrom && -y <= yto)
-			SetPixel( cx + ( short ) x, cy - ( short ) y, color, clipped );
+		outline.push_back(Point((short) x, (short) y));
 		y++;
 		sy += tas;
 		ee += yc;
@@ -1164,14 +1126,7 @@ void SDLVideoDriver::DrawEllipseSegment(short cx, short cy, unsigned short xr,
 	sy = tas * yr;
 
 	while (sx <= sy) {
-		if (x >= xfrom && x <= xto && y >= yfrom && y <= yto)
-			SetPixel( cx + ( short ) x, cy + ( short ) y, color, clipped );
-		if (-x >= xfrom && -x <= xto && y >= yfrom && y <= yto)
-			SetPixel( cx - ( short ) x, cy + ( short ) y, color, clipped );
-		if (-x >= xfrom && -x <= xto && -y >= yfrom && -y <= yto)
-			SetPixel( cx - ( short ) x, cy - ( short ) y, color, clipped );
-		if (x >= xfrom && x <= xto && -y >= yfrom && -y <= yto)
-			SetPixel( cx + ( short ) x, cy - ( short ) y, color, clipped );
+		outline.push_back(Point((short) x, (short) y));
 		x++;
 		sx += tbs;
 		ee += xc;
@@ -1183,22 +1138,213 @@ void SDLVideoDriver::DrawEllipseSegment(short cx, short cy, unsigned short xr,
 			yc += tas;
 		}
 	}
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_UnlockSurface( disp );
+	return outline;
+}
+
+// mirrors the cached octant into plotPoints, in the order the old loop set them
+void SDLVideoDriver::OutlineCircle(short cx, short cy, unsigned short r)
+{
+	const Outline &outline = GetCircleOutline(r);
+	plotPoints.clear();
+	for (size_t i = 0; i < outline.size(); i++) {
+		short x = outline[i].x;
+		short y = outline[i].y;
+		plotPoints.push_back(Point(cx + x, cy + y));
+		plotPoints.push_back(Point(cx - x, cy + y));
+		plotPoints.push_back(Point(cx - x, cy - y));
+		plotPoints.push_back(Point(cx + x, cy - y));
+		plotPoints.push_back(Point(cx + y, cy + x));
+		plotPoints.push_back(Point(cx - y, cy + x));
+		plotPoints.push_back(Point(cx - y, cy - x));
+		plotPoints.push_back(Point(cx + y, cy - x));
 	}
 }
 
+// the same for the quadrant of an ellipse, keeping the points within the bounds
+void SDLVideoDriver::OutlineEllipse(short cx, short cy, unsigned short xr, unsigned short yr,
+	long xfrom, long xto, long yfrom, long yto)
+{
+	const Outline &outline = GetEllipseOutline(xr, yr);
+	plotPoints.clear();
+	for (size_t i = 0; i < outline.size(); i++) {
+		long x = outline[i].x;
+		long y = outline[i].y;
+		if (x >= xfrom && x <= xto && y >= yfrom && y <= yto)
+			plotPoints.push_back(Point(cx + ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && y >= yfrom && y <= yto)
+			plotPoints.push_back(Point(cx - ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && -y >= yfrom && -y <= yto)
+			plotPoints.push_back(Point(cx - ( short ) x, cy - ( short ) y));
+		if (x >= xfrom && x <= xto && -y >= yfrom && -y <= yto)
+			plotPoints.push_back(Point(cx + ( short ) x, cy - ( short ) y));
+	}
+}
+
+template<typename PixelType>
+static void PlotPixels(const std::vector<Point> &points, SDL_Surface *surface, Uint32 val,
+	short dx, short dy, int minx, int miny, int maxx, int maxy)
+{
+	Uint8 Bpp = surface->format->BytesPerPixel;
+	unsigned char *base = (unsigned char *) surface->pixels;
+	for (size_t i = 0; i < points.size(); i++) {
+		short x = points[i].x + dx;
+		short y = points[i].y + dy;
+		if (x < minx || y < miny || x >= maxx || y >= maxy) {
+			continue;
+		}
+		*(PixelType *) (base + (y * surface->w + x) * Bpp) = (PixelType) val;
+	}
+}
+
+// SetPixel for every point in plotPoints, with the colour mapped, the
+// clipping worked out and the back buffer locked once for all of them
+void SDLVideoDriver::PlotPoints(const Color& color, bool clipped)
+{
+	if (plotPoints.empty()) {
+		return;
+	}
+
+	short dx = 0, dy = 0;
+	int minx = 0, miny = 0, maxx = disp->w, maxy = disp->h;
+	if (clipped) {
+		dx = xCorr;
+		dy = yCorr;
+		minx = xCorr;
+		miny = yCorr;
+		maxx = xCorr + Viewport.w;
+		maxy = yCorr + Viewport.h;
+	}
+
+	SDL_PixelFormat* fmt = backBuf->format;
+	Uint32 val = SDL_MapRGBA( fmt, color.r, color.g, color.b, color.a );
+	SDL_LockSurface( backBuf );
+	switch (fmt->BytesPerPixel) {
+		case 1:
+			PlotPixels<Uint8>(plotPoints, backBuf, val, dx, dy, minx, miny, maxx, maxy);
+			break;
+		case 2:
+			PlotPixels<Uint16>(plotPoints, backBuf, val, dx, dy, minx, miny, maxx, maxy);
+			break;
+		case 4:
+			PlotPixels<Uint32>(plotPoints, backBuf, val, dx, dy, minx, miny, maxx, maxy);
+			break;
+		default:
+			// rare enough to leave to SetSurfacePixel
+			for (size_t i = 0; i < plotPoints.size(); i++) {
+				short x = plotPoints[i].x + dx;
+				short y = plotPoints[i].y + dy;
+				if (x < minx || y < miny || x >= maxx || y >= maxy) {
+					continue;
+				}
+				SetSurfacePixel(backBuf, x, y, color);
+			}
+			break;
+	}
+	SDL_UnlockSurface( backBuf );
+}
+
+/** This functions Draws a Circle */
+void SDLVideoDriver::DrawCircle(short cx, short cy, unsigned short r,
+	const Color& color, bool clipped)
+{
+	OutlineCircle(cx, cy, r);
+	PlotPoints(color, clipped);
+}
+
+static double ellipseradius(unsigned short xr, unsigned short yr, double angle) {
+	double one = (xr * sin(angle));
+	double two = (yr * cos(angle));
+	return sqrt(xr*xr*yr*yr / (one*one + two*two));
+}
+
+/** This functions Draws an Ellipse Segment */
+void SDLVideoDriver::DrawEllipseSegment(short cx, short cy, unsigned short xr,
+	unsigned short yr, const Color& color, double anglefrom, double angleto, bool drawlines, bool clipped)
+{
+	/* beware, dragons and clockwise angles be here! */
+	double radiusfrom = ellipseradius(xr, yr, anglefrom);
+	double radiusto = ellipseradius(xr, yr, angleto);
+	long xfrom = (long)round(radiusfrom * cos(anglefrom));
+	long yfrom = (long)round(radiusfrom * sin(anglefrom));
+	long xto = (long)round(radiusto * cos(angleto));
+	long yto = (long)round(radiusto * sin(angleto));
+
+	if (drawlines) {
+		// TODO: DrawLine's clipping code works differently to the clipping
+		// here so we add Viewport.x/Viewport.y as a hack for now
+		DrawLine(cx + Viewport.x, cy + Viewport.y,
+			cx + xfrom + Viewport.x, cy + yfrom + Viewport.y, color, clipped);
+		DrawLine(cx + Viewport.x, cy + Viewport.y,
+			cx + xto + Viewport.x, cy + yto + Viewport.y, color, clipped);
+	}
+
+	// *Attempt* to calculate the correct x/y boundaries.
+	// TODO: this doesn't work very well - you can't actually bound many
+	// arcs this way (imagine a segment with a small piece cut out).
+	if (xfrom > xto) {
+		long tmp = xfrom; xfrom = xto; xto = tmp;
+	}
+	if (yfrom > yto) {
+		long tmp = yfrom; yfrom = yto; yto = tmp;
+	}
+	if (xfrom >= 0 && yto >= 0) xto = xr;
+	if (xto <= 0 && yto >= 0) xfrom = -xr;
+	if (yfrom >= 0 && xto >= 0) yto = yr;
+	if (yto <= 0 && xto >= 0) yfrom = -yr;
+
+	OutlineEllipse(cx, cy, xr, yr, xfrom, xto, yfrom, yto);
+	PlotPoints(color, clipped);
+}
+
 
 /** This functions Draws an Ellipse */
 void SDLVideoDriver::DrawEllipse(short cx, short cy, unsigned short xr,
 	unsigned short yr, const Color& color, bool clipped)
+{
+	OutlineEllipse(cx, cy, xr, yr, -xr, xr, -yr, yr);
+	PlotPoints(color, clipped);
+}
+
+// the rasterisers the outline cache replaced, recording instead of drawing
+static void ReferenceCircle(std::vector<Point> &points, short cx, short cy, unsigned short r)
+{
+	//Uses the Breshenham's Circle Algorithm
+	long x, y, xc, yc, re;
+
+	x = r;
+	y = 0;
+	xc = 1 - ( 2 * r );
+	yc = 1;
+	re = 0;
+
+	while (x >= y) {
+		points.push_back(Point(cx + ( short ) x, cy + ( short ) y));
+		points.push_back(Point(cx - ( short ) x, cy + ( short ) y));
+		points.push_back(Point(cx - ( short ) x, cy - ( short ) y));
+		points.push_back(Point(cx + ( short ) x, cy - ( short ) y));
+		points.push_back(Point(cx + ( short ) y, cy + ( short ) x));
+		points.push_back(Point(cx - ( short ) y, cy + ( short ) x));
+		points.push_back(Point(cx - ( short ) y, cy - ( short ) x));
+		points.push_back(Point(cx + ( short ) y, cy - ( short ) x));
+
+		y++;
+		re += yc;
+		yc += 2;
+
+		if (( ( 2 * re ) + xc ) > 0) {
+			x--;
+			re += xc;
+			xc += 2;
+		}
+	}
+}
+
+static void ReferenceEllipse(std::vector<Point> &points, short cx, short cy, unsigned short xr,
+	unsigned short yr, long xfrom, long xto, long yfrom, long yto)
 {
 	//Uses Bresenham's Ellipse Algorithm
 	long x, y, xc, yc, ee, tas, tbs, sx, sy;
 
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_LockSurface( disp );
-	}
 	tas = 2 * xr * xr;
 	tbs = 2 * yr * yr;
 	x = xr;
@@ -1210,10 +1356,14 @@ void SDLVideoDriver::DrawEllipse(short cx, short cy, unsigned short xr,
 	sy = 0;
 
 	while (sx >= sy) {
-		SetPixel( cx + ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy - ( short ) y, color, clipped );
-		SetPixel( cx + ( short ) x, cy - ( short ) y, color, clipped );
+		if (x >= xfrom && x <= xto && y >= yfrom && y <= yto)
+			points.push_back(Point(cx + ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && y >= yfrom && y <= yto)
+			points.push_back(Point(cx - ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && -y >= yfrom && -y <= yto)
+			points.push_back(Point(cx - ( short ) x, cy - ( short ) y));
+		if (x >= xfrom && x <= xto && -y >= yfrom && -y <= yto)
+			points.push_back(Point(cx + ( short ) x, cy - ( short ) y));
 		y++;
 		sy += tas;
 		ee += yc;
@@ -1235,10 +1385,14 @@ void SDLVideoDriver::DrawEllipse(short cx, short cy, unsigned short xr,
 	sy = tas * yr;
 
 	while (sx <= sy) {
-		SetPixel( cx + ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy + ( short ) y, color, clipped );
-		SetPixel( cx - ( short ) x, cy - ( short ) y, color, clipped );
-		SetPixel( cx + ( short ) x, cy - ( short ) y, color, clipped );
+		if (x >= xfrom && x <= xto && y >= yfrom && y <= yto)
+			points.push_back(Point(cx + ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && y >= yfrom && y <= yto)
+			points.push_back(Point(cx - ( short ) x, cy + ( short ) y));
+		if (-x >= xfrom && -x <= xto && -y >= yfrom && -y <= yto)
+			points.push_back(Point(cx - ( short ) x, cy - ( short ) y));
+		if (x >= xfrom && x <= xto && -y >= yfrom && -y <= yto)
+			points.push_back(Point(cx + ( short ) x, cy - ( short ) y));
 		x++;
 		sx += tbs;
 		ee += xc;
@@ -1250,9 +1404,92 @@ void SDLVideoDriver::DrawEllipse(short cx, short cy, unsigned short xr,
 			yc += tas;
 		}
 	}
-	if (SDL_MUSTLOCK( disp )) {
-		SDL_UnlockSurface( disp );
+}
+
+bool SDLVideoDriver::SelfCheck()
+{
+	bool ok = true;
+	std::vector<Point> reference;
+
+	// the outlines against the old rasterisers, point by point
+	for (unsigned short a = 0; a <= OUTLINE_CHECK_RADIUS; a++) {
+		reference.clear();
+		ReferenceCircle(reference, 40, 30, a);
+		OutlineCircle(40, 30, a);
+		if (reference != plotPoints) {
+			Log(ERROR, "SDLVideo", "The outline of a circle with radius %d differs!", a);
+			ok = false;
+		}
+		// the loops never end for a 0x0 ellipse, in both versions
+		for (unsigned short b = a ? 0 : 3; b <= OUTLINE_CHECK_RADIUS; b += 3) {
+			reference.clear();
+			ReferenceEllipse(reference, -20, 15, a, b, -a, a, -b, b);
+			OutlineEllipse(-20, 15, a, b, -a, a, -b, b);
+			if (reference != plotPoints) {
+				Log(ERROR, "SDLVideo", "The outline of a %dx%d ellipse differs!", a, b);
+				ok = false;
+			}
+			// a quarter and a lopsided segment
+			reference.clear();
+			ReferenceEllipse(reference, 20, -15, a, b, 0, a, -b, 0);
+			OutlineEllipse(20, -15, a, b, 0, a, -b, 0);
+			if (reference != plotPoints) {
+				Log(ERROR, "SDLVideo", "The outline of a %dx%d ellipse segment differs!", a, b);
+				ok = false;
+			}
+			reference.clear();
+			ReferenceEllipse(reference, 0, 0, a, b, -a/3, a, -b, b/2);
+			OutlineEllipse(0, 0, a, b, -a/3, a, -b, b/2);
+			if (reference != plotPoints) {
+				Log(ERROR, "SDLVideo", "The outline of a %dx%d ellipse segment differs!", a, b);
+				ok = false;
+			}
+		}
+	}
+
+	// and PlotPoints against SetPixel, on blank copies of the back buffer,
+	// with circles hanging over the corners of the screen and the viewport
+	if (!backBuf) {
+		return ok;
+	}
+	SDL_Surface *target = backBuf;
+	SDL_PixelFormat *fmt = target->format;
+	SDL_Surface *expected = SDL_CreateRGBSurface(0, target->w, target->h, fmt->BitsPerPixel,
+		fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask);
+	SDL_Surface *actual = SDL_CreateRGBSurface(0, target->w, target->h, fmt->BitsPerPixel,
+		fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask);
+	if (!expected || !actual) {
+		if (expected) SDL_FreeSurface(expected);
+		if (actual) SDL_FreeSurface(actual);
+		return ok;
+	}
+	Color color = { 0x40, 0x80, 0xc0, 0xff };
+	Point centres[3] = { Point(5, 5), Point(Viewport.w - 5, Viewport.h - 5), Point(disp->w - 5, disp->h - 5) };
+	for (int clipped = 0; clipped < 2; clipped++) {
+		for (int c = 0; c < 3; c++) {
+			OutlineCircle(centres[c].x, centres[c].y, OUTLINE_CHECK_RADIUS);
+			backBuf = expected;
+			for (size_t i = 0; i < plotPoints.size(); i++) {
+				SDLVideoDriver::SetPixel(plotPoints[i].x, plotPoints[i].y, color, clipped != 0);
+			}
+			backBuf = actual;
+			SDLVideoDriver::PlotPoints(color, clipped != 0);
+		}
+	}
+	backBuf = target;
+
+	int rowSize = expected->w * expected->format->BytesPerPixel;
+	for (int y = 0; y < expected->h; y++) {
+		if (memcmp((char *) expected->pixels + y * expected->pitch,
+			(char *) actual->pixels + y * actual->pitch, rowSize)) {
+			Log(ERROR, "SDLVideo", "Plotted outlines differ from SetPixel in row %d!", y);
+			ok = false;
+			break;
+		}
 	}
+	SDL_FreeSurface(expected);
+	SDL_FreeSurface(actual);
+	return ok;
 }
 
 void SDLVideoDriver::DrawPolyline(Gem_Polygon* poly, const Color& color, bool fill)
@@ -26,6 +26,7 @@
 #include "GUI/EventMgr.h"
 #include "win32def.h"
 
+#include <map>
 #include <vector>
 #include <SDL.h>
 
@@ -65,6 +66,21 @@ protected:
 
 	String *subtitletext;
 	ieDword subtitlestrref;
+
+	// rasterised outlines, in the order the Bresenham loops visit them:
+	// the first quadrant of ellipses, the first octant of circles
+	typedef std::vector<Point> Outline;
+	std::map<ieDword, Outline> ellipseOutlines;
+	std::map<unsigned short, Outline> circleOutlines;
+	const Outline& GetEllipseOutline(unsigned short xr, unsigned short yr);
+	const Outline& GetCircleOutline(unsigned short r);
+	// the screen points of the outline being drawn
+	std::vector<Point> plotPoints;
+	void OutlineCircle(short cx, short cy, unsigned short r);
+	void OutlineEllipse(short cx, short cy, unsigned short xr, unsigned short yr,
+		long xfrom, long xto, long yfrom, long yto);
+	/** sets every point of plotPoints like SetPixel does */
+	virtual void PlotPoints(const Color& color, bool clipped);
 public:
 	SDLVideoDriver(void);
 	virtual ~SDLVideoDriver(void);
@@ -123,6 +139,8 @@ public:
 	/** This functions Draws an Ellipse */
 	virtual void DrawEllipse(short cx, short cy, unsigned short xr, unsigned short yr,
 		const Color& color, bool clipped = true);
+	/** compares the cached outlines with the old rasterisers */
+	virtual bool SelfCheck();
 	/** This function Draws a Polygon on the Screen */
 	virtual void DrawPolyline(Gem_Polygon* poly, const Color& color, bool fill = false);
 	virtual void DrawHLine(short x1, short y, short x2, const Color& color, bool clipped = false);
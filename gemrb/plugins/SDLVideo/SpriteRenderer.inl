@@ -339,8 +339,8 @@ static void BlitSpriteRLE_internal(SDL_Surface* target,
 
 
 	// Clipping strategy:
-	// Because we can't jump to the right spot in the RLE data,
-	// we have to process the full sprite.
+	// Unless the sprite has a row index, we can't jump to the right spot in
+	// the RLE data, so we have to process the full sprite.
 	// We fast-forward through the bits outside of the clipping rectangle.
 
 	// This is done line-by-line.
@@ -393,6 +393,24 @@ static void BlitSpriteRLE_internal(SDL_Surface* target,
 	const int yfactor = yflip ? -1 : 1;
 	const int xfactor = XFLIP ? -1 : 1;
 
+	// With a row index we can skip the rows above the clipping rectangle
+	// (below it when flipped) entirely. The run we land in may have started
+	// on an earlier row, so pix starts that many pixels back.
+
+	if (spr->rleRows) {
+		int skiprows = yflip ? (ty + height) - (clip.y + clip.h) : clip.y - ty;
+		if (skiprows > 0) {
+			const RLERow& row = spr->rleRows[skiprows];
+			srcdata += row.offset;
+			line += yfactor * skiprows * pitch;
+			pix += yfactor * skiprows * pitch - xfactor * (int)row.skip;
+			if (COVER)
+				coverpix += yfactor * skiprows * cover->Width - xfactor * (int)row.skip;
+			clipstartpix += yfactor * skiprows * pitch;
+			clipendpix += yfactor * skiprows * pitch;
+		}
+	}
+
 	while (line != end) {
 
 		// Fast-forward through the RLE data until we reach clipstartpix
@@ -24,6 +24,7 @@
 #include "win32def.h"
 
 #include "Interface.h"
+#include "Palette.h"
 #include "Sprite2D.h"
 #include "Video.h"
 
@@ -65,8 +66,7 @@ bool TISImporter::Open(DataStream* stream)
 	return true;
 }
 
-Tile* TISImporter::GetTile(unsigned short* indexes, int count,
-	unsigned short* secondary)
+Animation* TISImporter::GetAnimation(unsigned short* indexes, int count)
 {
 	Animation* ani = new Animation( count );
 	//pause key stops animation
@@ -76,20 +76,38 @@ Tile* TISImporter::GetTile(unsigned short* indexes, int count,
 	for (int i = 0; i < count; i++) {
 		ani->AddFrame( GetTile( indexes[i] ), i );
 	}
+	return ani;
+}
+
+Tile* TISImporter::GetTile(unsigned short* indexes, int count,
+	unsigned short* secondary)
+{
+	Animation* ani = GetAnimation( indexes, count );
 	if (secondary) {
-		Animation* sec = new Animation( count );
-		for (int i = 0; i < count; i++) {
-			sec->AddFrame( GetTile( secondary[i] ), i );
-		}
+		Animation* sec = GetAnimation( secondary, count );
 		return new Tile( ani, sec );
 	}
 	return new Tile( ani );
 }
 
+void TISImporter::LoadTile(Tile* tile)
+{
+	if (tile->IsLoaded() || tile->frames.empty()) {
+		return;
+	}
+	tile->anim[0] = GetAnimation( &tile->frames[0], (int) tile->frames.size() );
+	tile->anim[0]->fps = tile->fps;
+	tile->RestorePhase();
+	if (tile->secondary != 0xffff) {
+		tile->anim[1] = GetAnimation( &tile->secondary, 1 );
+		tile->anim[1]->fps = tile->fps;
+	}
+}
+
 Sprite2D* TISImporter::GetTile(int index)
 {
 	RevColor RevCol[256];
-	Color Palette[256];
+	Color Colors[256];
 	void* pixels = malloc( 4096 );
 	unsigned long pos = index *(1024+4096) + headerShift;
 	if(str->Size()<pos+1024+4096) {
@@ -106,22 +124,20 @@ Sprite2D* TISImporter::GetTile(int index)
 	
 		// original PS:T AR0609 and AR0612 report far more tiles than are actually present :(
 		memset(pixels, 0, 4096);
-		memset(Palette, 0, 256 * sizeof(Color));
-		Palette[0].g = 200;
-		Sprite2D* spr = core->GetVideoDriver()->CreatePalettedSprite( 64, 64, 8, pixels, Palette );
-		spr->XPos = spr->YPos = 0;
-		return spr;
+		memset(Colors, 0, 256 * sizeof(Color));
+		Colors[0].g = 200;
+		return CreateTile( pixels, Colors );
 	}
 	str->Seek( pos, GEM_STREAM_START );
 	str->Read( &RevCol, 1024 );
 	int transindex = 0;
 	bool transparent = false;
 	for (int i = 0; i < 256; i++) {
-		Palette[i].r = RevCol[i].r;
-		Palette[i].g = RevCol[i].g;
-		Palette[i].b = RevCol[i].b;
-		Palette[i].a = RevCol[i].a;
-		if (Palette[i].g==255 && !Palette[i].r && !Palette[i].b) {
+		Colors[i].r = RevCol[i].r;
+		Colors[i].g = RevCol[i].g;
+		Colors[i].b = RevCol[i].b;
+		Colors[i].a = RevCol[i].a;
+		if (Colors[i].g==255 && !Colors[i].r && !Colors[i].b) {
 			if (transparent) {
 				Log(ERROR, "TISImporter", "Tile has two green (transparent) palette entries");
 			} else {
@@ -131,7 +147,16 @@ Sprite2D* TISImporter::GetTile(int index)
 		}
 	}
 	str->Read( pixels, 4096 );
-	Sprite2D* spr = core->GetVideoDriver()->CreatePalettedSprite( 64, 64, 8, pixels, Palette, transparent, transindex );
+	return CreateTile( pixels, Colors, transparent, transindex );
+}
+
+// many tiles use the same colours, so their palettes are interned
+Sprite2D* TISImporter::CreateTile(void* pixels, const Color* colors, bool cK, int index)
+{
+	Palette* pal = new Palette( colors );
+	pal = pal->Intern();
+	Sprite2D* spr = core->GetVideoDriver()->CreateSprite8( 64, 64, pixels, pal, cK, index );
+	pal->release();
 	spr->XPos = spr->YPos = 0;
 	return spr;
 }
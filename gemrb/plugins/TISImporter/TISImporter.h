@@ -36,8 +36,11 @@ public:
 	bool Open(DataStream* stream);
 	Tile* GetTile(unsigned short* indexes, int count,
 		unsigned short* secondary = NULL);
+	void LoadTile(Tile* tile);
 	Sprite2D* GetTile(int index);
-public:
+private:
+	Animation* GetAnimation(unsigned short* indexes, int count);
+	Sprite2D* CreateTile(void* pixels, const Color* colors, bool cK = false, int index = 0);
 };
 
 }
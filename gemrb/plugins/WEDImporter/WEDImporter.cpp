@@ -127,13 +127,12 @@ int WEDImporter::AddOverlay(TileMap *tm, Overlay *overlays, bool rain)
 			res[len] = '\0';
 		}
 	}
-	DataStream* tisfile = gamedata->GetResource(res, IE_TIS_CLASS_ID);
-	if (!tisfile) {
+	if (!gamedata->Exists(res, IE_TIS_CLASS_ID)) {
 		return -1;
 	}
-	PluginHolder<TileSetMgr> tis(IE_TIS_CLASS_ID);
-	tis->Open( tisfile );
+	// the tileset is only opened while tiles are being loaded
 	TileOverlay *over = new TileOverlay( overlays->Width, overlays->Height );
+	over->SetTileSet( res );
 	for (int y = 0; y < overlays->Height; y++) {
 		for (int x = 0; x < overlays->Width; x++) {
 			str->Seek( overlays->TilemapOffset +
@@ -156,14 +155,13 @@ int WEDImporter::AddOverlay(TileMap *tm, Overlay *overlays, bool rain)
 			if( DataStream::IsEndianSwitch()) {
 				swab( (char*) indices, (char*) indices, count * sizeof(ieWord) );
 			}
+			// the pixels are only read once the tile gets near the viewport
 			Tile* tile;
 			if (secondary == 0xffff) {
-				tile = tis->GetTile( indices, count );
+				tile = new Tile( indices, count, secondary, animspeed );
 			} else {
-				tile = tis->GetTile( indices, 1, &secondary );
-				tile->anim[1]->fps = animspeed;
+				tile = new Tile( indices, 1, secondary, animspeed );
 			}
-			tile->anim[0]->fps = animspeed;
 			tile->om = overlaymask;
 			usedoverlays |= overlaymask;
 			over->AddTile( tile );